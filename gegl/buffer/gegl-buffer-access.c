@@ -561,6 +561,7 @@ gegl_buffer_iterate_read_simple (GeglBuffer          *buffer,
   gint bpx_size    = babl_format_get_bytes_per_pixel (format);
   gint tile_stride = px_size * tile_width;
   gint bufy        = 0;
+  gdouble pixel[16];
 
   gint width    = roi->width;
   gint height   = roi->height;
@@ -612,17 +613,36 @@ gegl_buffer_iterate_read_simple (GeglBuffer          *buffer,
           tp        = ((guchar *) tile_base) + (offsety * tile_width + offsetx) * px_size;
 
           y = bufy;
-          for (row = offsety;
-               row < tile_height && y < height;
-               row++, y++)
+          if (gegl_tile_is_uniform (tile) && bpx_size <= (gint) sizeof (pixel))
             {
+              /* converting one pixel converts them all */
               if (fish)
-                babl_process (fish, tp, bp, pixels);
+                babl_process (fish, tile_base, pixel, 1);
               else
-                memcpy (bp, tp, pixels * px_size);
+                memcpy (pixel, tile_base, px_size);
 
-              tp += tile_stride;
-              bp += buf_stride;
+              for (row = offsety;
+                   row < tile_height && y < height;
+                   row++, y++)
+                {
+                  gegl_memset_pattern (bp, pixel, bpx_size, pixels);
+                  bp += buf_stride;
+                }
+            }
+          else
+            {
+              for (row = offsety;
+                   row < tile_height && y < height;
+                   row++, y++)
+                {
+                  if (fish)
+                    babl_process (fish, tp, bp, pixels);
+                  else
+                    memcpy (bp, tp, pixels * px_size);
+
+                  tp += tile_stride;
+                  bp += buf_stride;
+                }
             }
 
           gegl_tile_unref (tile);
@@ -2005,19 +2025,45 @@ gegl_buffer_set_pattern (GeglBuffer          *buffer,
   gegl_free (pattern_data);
 }
 
-void
-gegl_buffer_set_color (GeglBuffer          *dst,
-                       const GeglRectangle *dst_rect,
-                       GeglColor           *color)
+static void
+gegl_buffer_set_color2 (GeglBuffer          *dst,
+                        const GeglRectangle *dst_rect,
+                        gconstpointer        pixel)
 {
   GeglBufferIterator *i;
-  gchar               pixel[128];
   gint                bpp;
 
+  if (dst_rect->width <= 0 ||
+      dst_rect->height <= 0)
+    return;
+
+  bpp = babl_format_get_bytes_per_pixel (dst->soft_format);
+
+  i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format,
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (i))
+    {
+      gegl_memset_pattern (i->data[0], pixel, bpp, i->length);
+    }
+}
+
+void
+gegl_buffer_set_color_from_pixel (GeglBuffer          *dst,
+                                  const GeglRectangle *dst_rect,
+                                  gconstpointer        pixel,
+                                  const Babl          *pixel_format)
+{
+  gdouble       buf_pixel[16];
+  GeglRectangle cow_rect;
+  gint          tile_width;
+  gint          tile_height;
+  gint          bpp;
+
   g_return_if_fail (GEGL_IS_BUFFER (dst));
-  g_return_if_fail (color);
+  g_return_if_fail (pixel);
 
-  gegl_color_get_pixel (color, dst->soft_format, pixel);
+  if (!pixel_format)
+    pixel_format = dst->soft_format;
 
   if (!dst_rect)
     {
@@ -2028,16 +2074,182 @@ gegl_buffer_set_color (GeglBuffer          *dst,
     return;
 
   bpp = babl_format_get_bytes_per_pixel (dst->soft_format);
+  g_return_if_fail (bpp <= (gint) sizeof (buf_pixel));
 
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully filled tiles are shared.
-   */
-  i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format,
-                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-  while (gegl_buffer_iterator_next (i))
+  if (pixel_format != dst->soft_format)
     {
-      gegl_memset_pattern (i->data[0], pixel, bpp, i->length);
+      babl_process (babl_fish (pixel_format, dst->soft_format),
+                    pixel, buf_pixel, 1);
+      pixel = buf_pixel;
+    }
+
+  if (g_object_get_data (G_OBJECT (dst), "is-linear"))
+    {
+      gegl_buffer_set_color2 (dst, dst_rect, pixel);
+      return;
+    }
+
+  tile_width  = dst->tile_width;
+  tile_height = dst->tile_height;
+
+  /* the tiles entirely within the rectangle */
+  cow_rect.x      = gegl_tile_indice (dst_rect->x + dst->shift_x + tile_width - 1,
+                                      tile_width);
+  cow_rect.y      = gegl_tile_indice (dst_rect->y + dst->shift_y + tile_height - 1,
+                                      tile_height);
+  cow_rect.width  = gegl_tile_indice (dst_rect->x + dst->shift_x + dst_rect->width,
+                                      tile_width) - cow_rect.x;
+  cow_rect.height = gegl_tile_indice (dst_rect->y + dst->shift_y + dst_rect->height,
+                                      tile_height) - cow_rect.y;
+
+  if (cow_rect.width <= 0 || cow_rect.height <= 0)
+    {
+      gegl_buffer_set_color2 (dst, dst_rect, pixel);
+      return;
+    }
+
+  {
+    GeglTileHandlerCache *cache = dst->tile_storage->cache;
+    GeglTile             *uniform_tile;
+    GeglRectangle         top, bottom, left, right;
+    gint                  tx, ty;
+
+    /* the tiles share the data of a single uniform tile, until they are
+     * written to
+     */
+    uniform_tile = gegl_tile_new_uniform (tile_width * tile_height * bpp,
+                                          pixel, bpp);
+
+    g_rec_mutex_lock (&dst->tile_storage->mutex);
+
+    for (ty = cow_rect.y; ty < cow_rect.y + cow_rect.height; ty++)
+      for (tx = cow_rect.x; tx < cow_rect.x + cow_rect.width; tx++)
+        {
+          GeglTile *dst_tile = gegl_tile_dup (uniform_tile);
+
+          dst_tile->rev++;
+
+          gegl_tile_handler_cache_insert (cache, dst_tile, tx, ty, 0);
+          gegl_tile_void_pyramid (dst_tile);
+
+          gegl_tile_unref (dst_tile);
+        }
+
+    g_rec_mutex_unlock (&dst->tile_storage->mutex);
+
+    gegl_tile_unref (uniform_tile);
+
+    /* in buffer coordinates from here on */
+    cow_rect.x      = cow_rect.x * tile_width  - dst->shift_x;
+    cow_rect.y      = cow_rect.y * tile_height - dst->shift_y;
+    cow_rect.width  = cow_rect.width  * tile_width;
+    cow_rect.height = cow_rect.height * tile_height;
+
+    if (gegl_cl_is_accelerated ())
+      gegl_buffer_cl_cache_invalidate (dst, &cow_rect);
+
+    gegl_buffer_emit_changed_signal (dst, &cow_rect);
+
+    top = *dst_rect;
+    top.height = cow_rect.y - dst_rect->y;
+
+    bottom = *dst_rect;
+    bottom.y = cow_rect.y + cow_rect.height;
+    bottom.height = (dst_rect->y + dst_rect->height) - bottom.y;
+
+    left = cow_rect;
+    left.x = dst_rect->x;
+    left.width = cow_rect.x - dst_rect->x;
+
+    right = cow_rect;
+    right.x = cow_rect.x + cow_rect.width;
+    right.width = (dst_rect->x + dst_rect->width) - right.x;
+
+    gegl_buffer_set_color2 (dst, &top, pixel);
+    gegl_buffer_set_color2 (dst, &bottom, pixel);
+    gegl_buffer_set_color2 (dst, &left, pixel);
+    gegl_buffer_set_color2 (dst, &right, pixel);
+  }
+}
+
+void
+gegl_buffer_set_color (GeglBuffer          *dst,
+                       const GeglRectangle *dst_rect,
+                       GeglColor           *color)
+{
+  gchar pixel[128];
+
+  g_return_if_fail (GEGL_IS_BUFFER (dst));
+  g_return_if_fail (color);
+
+  gegl_color_get_pixel (color, dst->soft_format, pixel);
+
+  gegl_buffer_set_color_from_pixel (dst, dst_rect, pixel, dst->soft_format);
+}
+
+gboolean
+gegl_buffer_get_uniform (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         const Babl          *format,
+                         gpointer             pixel)
+{
+  GeglTile *first = NULL;
+  gboolean  uniform = TRUE;
+  gint      tile_width  = buffer->tile_width;
+  gint      tile_height = buffer->tile_height;
+  gint      bpp = babl_format_get_bytes_per_pixel (buffer->soft_format);
+  gint      x0, y0, x1, y1;
+  gint      tx, ty;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  /* the abyss reads as zeros, whatever the tiles hold */
+  if (rect->width <= 0 || rect->height <= 0 ||
+      ! gegl_rectangle_contains (&buffer->abyss, rect))
+    return FALSE;
+
+  x0 = gegl_tile_indice (rect->x + buffer->shift_x, tile_width);
+  y0 = gegl_tile_indice (rect->y + buffer->shift_y, tile_height);
+  x1 = gegl_tile_indice (rect->x + buffer->shift_x + rect->width - 1, tile_width);
+  y1 = gegl_tile_indice (rect->y + buffer->shift_y + rect->height - 1, tile_height);
+
+  for (ty = y0; uniform && ty <= y1; ty++)
+    for (tx = x0; uniform && tx <= x1; tx++)
+      {
+        GeglTile *tile = gegl_buffer_get_tile (buffer, tx, ty, 0);
+
+        if (! tile)
+          {
+            uniform = FALSE;
+          }
+        else if (! first)
+          {
+            first   = tile;
+            uniform = gegl_tile_is_uniform (tile);
+          }
+        else
+          {
+            uniform = gegl_tile_is_uniform (tile) &&
+                      ! memcmp (gegl_tile_get_data (tile),
+                                gegl_tile_get_data (first), bpp);
+            gegl_tile_unref (tile);
+          }
+      }
+
+  if (uniform)
+    {
+      if (format == buffer->soft_format)
+        memcpy (pixel, gegl_tile_get_data (first), bpp);
+      else
+        babl_process (babl_fish (buffer->soft_format, format),
+                      gegl_tile_get_data (first), pixel, 1);
     }
+
+  if (first)
+    gegl_tile_unref (first);
+
+  return uniform;
 }
 
 GeglBuffer *
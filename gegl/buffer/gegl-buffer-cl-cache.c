@@ -102,6 +102,31 @@ gegl_buffer_cl_cache_release (cl_mem tex)
   return FALSE;
 }
 
+/* returns TRUE if all of @roi of @buffer is held by a valid device
+ * buffer, without taking a reference on it
+ */
+gboolean
+gegl_buffer_cl_cache_contains (GeglBuffer          *buffer,
+                               const GeglRectangle *roi)
+{
+  GList    *elem;
+  gboolean  found = FALSE;
+
+  g_mutex_lock (&cache_mutex);
+
+  for (elem=cache_entries; elem && !found; elem=elem->next)
+    {
+      CacheEntry *e = elem->data;
+      if (e->valid && e->buffer == buffer
+          && gegl_rectangle_contains (&e->roi, roi))
+        found = TRUE;
+    }
+
+  g_mutex_unlock (&cache_mutex);
+
+  return found;
+}
+
 void
 gegl_buffer_cl_cache_new (GeglBuffer            *buffer,
                           const GeglRectangle   *roi,
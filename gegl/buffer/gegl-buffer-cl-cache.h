@@ -35,6 +35,10 @@ gegl_buffer_cl_cache_get (GeglBuffer          *buffer,
 gboolean
 gegl_buffer_cl_cache_release (cl_mem tex);
 
+gboolean
+gegl_buffer_cl_cache_contains (GeglBuffer          *buffer,
+                               const GeglRectangle *roi);
+
 void
 gegl_buffer_cl_cache_new (GeglBuffer            *buffer,
                           const GeglRectangle   *roi,
@@ -30,6 +30,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-buffer-private.h"
 #include "gegl-buffer-index.h"
+#include "gegl-tile-backend-mmap.h"
 #include "gegl-debug.h"
 
 #include <glib/gprintf.h>
@@ -245,9 +246,28 @@ gegl_buffer_open (const gchar *path)
 GeglBuffer *
 gegl_buffer_load (const gchar *path)
 {
-  GeglBuffer *ret;
+  GeglBuffer      *ret;
+  GeglTileBackend *backend;
+  LoadInfo        *info;
 
-  LoadInfo *info = g_slice_new0 (LoadInfo);
+  /* serve the tiles straight from a mapping of the file when possible,
+   * this only reads the index; tiles are copied when they are modified.
+   */
+  backend = gegl_tile_backend_mmap_new (path);
+
+  if (backend)
+    {
+      GeglRectangle extent = gegl_tile_backend_get_extent (backend);
+
+      ret = gegl_buffer_new_for_backend (&extent, backend);
+      g_object_unref (backend);
+
+      GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "buffer mapped %s", path);
+
+      return ret;
+    }
+
+  info = g_slice_new0 (LoadInfo);
 
   info->path = g_strdup (path);
   info->i = g_open (info->path, O_RDONLY, 0770);
@@ -0,0 +1,231 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-buffer-types.h"
+#include "gegl-buffer-private.h"
+#include "gegl-buffer-cl-cache.h"
+#include "gegl-buffer-pool.h"
+#include "gegl-tile-source.h"
+#include "gegl-tile-storage.h"
+#include "opencl/gegl-cl.h"
+
+/* Operation contexts create an output buffer for every node on every
+ * request, and drop it again once the next node has read it.  Rather
+ * than finalizing such a buffer along with its tile storage and handler
+ * chain, its tiles are discarded and the empty buffer is kept for the
+ * next request asking for the same format.
+ *
+ * Recycled buffers only differ from new ones in the tile size they were
+ * created with, so format and tile size are all there is to match; the
+ * extent is simply set anew.  The pool holds at most
+ * gegl_config ()->buffer_pool_size buffers, the most recently released
+ * ones.
+ */
+
+static GMutex   pool_mutex;
+static GQueue   pool   = G_QUEUE_INIT;
+static guint64  hits   = 0;
+static guint64  misses = 0;
+
+static GQuark
+gegl_buffer_pool_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gegl-buffer-pool");
+
+  return quark;
+}
+
+/* drops the tiles of @buffer, at all zoom levels it has been read at */
+static void
+gegl_buffer_pool_void_tiles (GeglBuffer *buffer)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (buffer);
+  gint            x0, y0, x1, y1;
+  gint            z;
+
+  if (buffer->extent.width <= 0 || buffer->extent.height <= 0)
+    return;
+
+  x0 = gegl_tile_indice (buffer->extent.x + buffer->shift_x,
+                         buffer->tile_width);
+  y0 = gegl_tile_indice (buffer->extent.y + buffer->shift_y,
+                         buffer->tile_height);
+  x1 = gegl_tile_indice (buffer->extent.x + buffer->shift_x +
+                         buffer->extent.width - 1, buffer->tile_width);
+  y1 = gegl_tile_indice (buffer->extent.y + buffer->shift_y +
+                         buffer->extent.height - 1, buffer->tile_height);
+
+  for (z = 0; z <= buffer->tile_storage->seen_zoom; z++)
+    {
+      gint x, y;
+
+      for (y = y0; y <= y1; y++)
+        for (x = x0; x <= x1; x++)
+          gegl_tile_source_void (source, x, y, z);
+
+      x0 = gegl_tile_indice (x0, 2);
+      y0 = gegl_tile_indice (y0, 2);
+      x1 = gegl_tile_indice (x1, 2);
+      y1 = gegl_tile_indice (y1, 2);
+    }
+}
+
+GeglBuffer *
+gegl_buffer_pool_get (const GeglRectangle *extent,
+                      const Babl          *format)
+{
+  GeglConfig *config = gegl_config ();
+  GeglBuffer *buffer = NULL;
+  GList      *link;
+
+  g_mutex_lock (&pool_mutex);
+
+  for (link = pool.head; link; link = link->next)
+    {
+      GeglBuffer *candidate = link->data;
+
+      if (candidate->format      == format             &&
+          candidate->tile_width  == config->tile_width &&
+          candidate->tile_height == config->tile_height)
+        {
+          buffer = candidate;
+          g_queue_delete_link (&pool, link);
+          break;
+        }
+    }
+
+  if (buffer)
+    hits++;
+  else
+    misses++;
+
+  g_mutex_unlock (&pool_mutex);
+
+  if (buffer)
+    {
+      buffer->soft_format         = buffer->format;
+      buffer->abyss_tracks_extent = TRUE;
+      gegl_buffer_set_extent (buffer, extent);
+
+      return buffer;
+    }
+
+  buffer = gegl_buffer_new (extent, format);
+  g_object_set_qdata (G_OBJECT (buffer), gegl_buffer_pool_quark (),
+                      GINT_TO_POINTER (TRUE));
+
+  return buffer;
+}
+
+void
+gegl_buffer_pool_release (GeglBuffer *buffer)
+{
+  GeglBuffer *dropped = NULL;
+  gint        pool_size;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  pool_size = gegl_config ()->buffer_pool_size;
+
+  /* only buffers nobody else can see anymore are taken back */
+  if (pool_size <= 0                                                   ||
+      ! g_object_get_qdata (G_OBJECT (buffer), gegl_buffer_pool_quark ()) ||
+      g_atomic_int_get (&G_OBJECT (buffer)->ref_count) != 1            ||
+      buffer->changed_signal_connections)
+    {
+      g_object_unref (buffer);
+      return;
+    }
+
+  gegl_buffer_sample_cleanup (buffer);
+
+  if (gegl_cl_is_accelerated ())
+    gegl_buffer_cl_cache_invalidate (buffer, NULL);
+
+  _gegl_buffer_drop_hot_tile (buffer);
+  gegl_buffer_pool_void_tiles (buffer);
+
+  g_mutex_lock (&pool_mutex);
+
+  g_queue_push_head (&pool, buffer);
+  if (g_queue_get_length (&pool) > pool_size)
+    dropped = g_queue_pop_tail (&pool);
+
+  g_mutex_unlock (&pool_mutex);
+
+  if (dropped)
+    g_object_unref (dropped);
+}
+
+void
+gegl_buffer_pool_cleanup (void)
+{
+  GeglBuffer *buffer;
+
+  g_mutex_lock (&pool_mutex);
+
+  while ((buffer = g_queue_pop_head (&pool)))
+    {
+      g_mutex_unlock (&pool_mutex);
+      g_object_unref (buffer);
+      g_mutex_lock (&pool_mutex);
+    }
+
+  g_mutex_unlock (&pool_mutex);
+}
+
+guint64
+gegl_buffer_pool_get_hits (void)
+{
+  guint64 count;
+
+  g_mutex_lock (&pool_mutex);
+  count = hits;
+  g_mutex_unlock (&pool_mutex);
+
+  return count;
+}
+
+guint64
+gegl_buffer_pool_get_misses (void)
+{
+  guint64 count;
+
+  g_mutex_lock (&pool_mutex);
+  count = misses;
+  g_mutex_unlock (&pool_mutex);
+
+  return count;
+}
+
+void
+gegl_buffer_pool_reset_stats (void)
+{
+  g_mutex_lock (&pool_mutex);
+  hits   = 0;
+  misses = 0;
+  g_mutex_unlock (&pool_mutex);
+}
@@ -0,0 +1,50 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_BUFFER_POOL_H__
+#define __GEGL_BUFFER_POOL_H__
+
+#include <glib-object.h>
+#include "gegl-buffer.h"
+
+G_BEGIN_DECLS
+
+/* Returns a new reference to an empty buffer of @extent and @format,
+ * recycled from the pool when one with the same format and tile size is
+ * available.  Behaves like gegl_buffer_new () otherwise.
+ */
+GeglBuffer *gegl_buffer_pool_get            (const GeglRectangle *extent,
+                                             const Babl          *format);
+
+/* Drops a reference to @buffer.  Buffers that came from
+ * gegl_buffer_pool_get () go back to the pool when this was their last
+ * reference, their tiles are discarded.
+ */
+void        gegl_buffer_pool_release        (GeglBuffer          *buffer);
+
+/* frees the buffers held by the pool */
+void        gegl_buffer_pool_cleanup        (void);
+
+/* the number of gegl_buffer_pool_get () calls that were served from the
+ * pool, and that had to create a new buffer
+ */
+guint64     gegl_buffer_pool_get_hits       (void);
+guint64     gegl_buffer_pool_get_misses     (void);
+void        gegl_buffer_pool_reset_stats    (void);
+
+G_END_DECLS
+
+#endif
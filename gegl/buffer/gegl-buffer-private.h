@@ -141,6 +141,14 @@ GeglBuffer *      gegl_buffer_new_ram     (const GeglRectangle *extent,
 void              gegl_buffer_emit_changed_signal (GeglBuffer *buffer,
                                                    const GeglRectangle *rect);
 
+/* returns TRUE if all of @rect lies on uniform tiles of @buffer holding
+ * the same pixel, which is stored at @pixel in @format
+ */
+gboolean          gegl_buffer_get_uniform (GeglBuffer          *buffer,
+                                           const GeglRectangle *rect,
+                                           const Babl          *format,
+                                           gpointer             pixel);
+
 /* the instance size of a GeglTile is a bit large, and should if possible be
  * trimmed down
  */
@@ -168,10 +176,26 @@ struct _GeglTile
                                  * should in theory just have the values 0/1
                                  */
   gint             is_zero_tile:1;
+  gint             is_uniform:1; /* every pixel equals the first one, cleared
+                                  * when the tile is locked for writing
+                                  */
+  gint             read_only:1; /* the data is not writable, like a read-only
+                                 * mapping of a file, and is copied before the
+                                 * tile is written to even when not shared
+                                 */
+  gint             cached;      /* TRUE while the tile is held by the cache of
+                                 * its tile_storage
+                                 */
+  gint             touched;     /* set when handed out from the hot tiles of
+                                 * a thread, bypassing the cache; counts as a
+                                 * use of the tile when the cache looks for
+                                 * one to evict
+                                 */
 
-  /* the shared list is a doubly linked circular list */
-  GeglTile        *next_shared;
-  GeglTile        *prev_shared;
+  /* the number of tiles sharing data with this one, including itself,
+   * shared by all of them; NULL when the data has never been shared
+   */
+  gint            *n_clones;
 
   /* called when the tile is about to be destroyed */
   GDestroyNotify   destroy_notify;
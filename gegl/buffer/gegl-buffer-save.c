@@ -216,6 +216,10 @@ gegl_buffer_save (GeglBuffer          *buffer,
   info->path = g_strdup (path);
 
 #ifndef G_OS_WIN32
+  /* buffers loaded from the file may still have it mapped, replace the
+   * file rather than truncating it under them
+   */
+  g_unlink (info->path);
   info->o    = g_open (info->path, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
 #else
   info->o    = g_open (info->path, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
@@ -541,10 +541,21 @@ gegl_buffer_constructor (GType                  type,
 
           if (use_ram == TRUE)
             {
+              GeglTileCompression compression = GEGL_TILE_COMPRESSION_NONE;
+
+              /* when swapping is disabled, the RAM backend is where
+               * tiles evicted from the cache end up, keep them compressed
+               * there; buffers explicitly asking for RAM may be wrapping
+               * linear data, which has to stay in place.
+               */
+              if (! buffer->path)
+                compression = gegl_config ()->swap_compression;
+
               backend = g_object_new (GEGL_TYPE_TILE_BACKEND_RAM,
                                       "tile-width",  buffer->tile_width,
                                       "tile-height", buffer->tile_height,
                                       "format",      buffer->format,
+                                      "compression", compression,
                                       NULL);
             }
           else if (buffer->path)
@@ -1206,7 +1217,9 @@ gegl_buffer_get_tile (GeglBuffer *buffer,
                       gint        z)
 {
   GeglTileSource  *source  = (GeglTileSource*)buffer;
+  GeglTileStorage *tile_storage = buffer->tile_storage;
   GeglTile *tile;
+  gboolean  hot;
 
   static int threaded = -1;
 
@@ -1216,24 +1229,29 @@ gegl_buffer_get_tile (GeglBuffer *buffer,
   }
 
   g_assert (source);
+  g_assert (tile_storage);
 
-  if (threaded)
+  /* with OpenCL, the cache has to flush the OpenCL cache on every get */
+  hot = ! gegl_cl_is_accelerated ();
+
+  if (hot)
   {
-    GeglTileStorage *tile_storage = buffer->tile_storage;
-    g_assert (tile_storage);
+    tile = gegl_tile_storage_get_hot_tile (tile_storage, x, y, z);
+    if (tile)
+      return tile;
+  }
 
+  if (threaded)
     g_rec_mutex_lock (&tile_storage->mutex);
 
-    tile = gegl_tile_source_command (source, GEGL_TILE_GET,
-                                     x, y, z, NULL);
+  tile = gegl_tile_source_command (source, GEGL_TILE_GET,
+                                   x, y, z, NULL);
 
+  if (threaded)
     g_rec_mutex_unlock (&tile_storage->mutex);
-  }
-  else
-  {
-    return gegl_tile_source_command (source, GEGL_TILE_GET,
-                                     x, y, z, NULL);
-  }
+
+  if (hot && tile)
+    gegl_tile_storage_add_hot_tile (tile_storage, tile, x, y, z);
 
   return tile;
 }
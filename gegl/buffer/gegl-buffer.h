@@ -290,6 +290,23 @@ void            gegl_buffer_set_color         (GeglBuffer          *buffer,
                                                const GeglRectangle *rect,
                                                GeglColor           *color);
 
+/**
+ * gegl_buffer_set_color_from_pixel:
+ * @buffer: a #GeglBuffer
+ * @rect: a rectangular region to fill with a color.
+ * @pixel: pointer to the data of a single pixel
+ * @pixel_format: the babl format of the pixel, or NULL for the format of
+ * @buffer.
+ *
+ * Sets the region covered by rect to the provided pixel. The tiles
+ * entirely within the region share the data of a single uniform tile,
+ * until they are written to.
+ */
+void            gegl_buffer_set_color_from_pixel (GeglBuffer          *buffer,
+                                                  const GeglRectangle *rect,
+                                                  gconstpointer        pixel,
+                                                  const Babl          *pixel_format);
+
 
 /**
  * gegl_buffer_set_pattern:
@@ -0,0 +1,372 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-buffer-types.h"
+#include "gegl-buffer-private.h"
+#include "gegl-result-cache.h"
+#include "gegl-tile.h"
+#include "gegl-tile-source.h"
+#include "gegl-tile-storage.h"
+#include "gegl-tile-handler-cache.h"
+
+/* Node caches only serve the node they belong to. The result cache keeps
+ * rendered tiles under a key describing how they were computed instead,
+ * so that other nodes computing the same thing, in other graphs or for
+ * other requests, can pick them up.
+ *
+ * Stored tiles are copy-on-write clones of the tiles of the buffer they
+ * were rendered to, taking the data over when that buffer goes away. The
+ * least recently used tiles are dropped when the cache grows beyond its
+ * share of the tile cache size.
+ */
+
+typedef struct
+{
+  guint64   key;   /* the caller's key, mixed with the format and tile size */
+  gint      x;
+  gint      y;
+  gint      z;
+  GeglTile *tile;
+  GList     link;  /* in result_queue */
+} ResultItem;
+
+static GMutex          result_mutex;
+static GHashTable     *result_ht    = NULL;
+static GQueue          result_queue = G_QUEUE_INIT; /* most recently used first */
+static volatile gsize  result_total = 0;
+static guint64         hits         = 0;
+static guint64         misses       = 0;
+
+static guint
+result_item_hash (gconstpointer key)
+{
+  const ResultItem *item = key;
+
+  return (guint) (item->key ^ (item->key >> 32)) ^
+         (item->x * 73856093) ^ (item->y * 19349663) ^ (item->z * 83492791);
+}
+
+static gboolean
+result_item_equal (gconstpointer a,
+                   gconstpointer b)
+{
+  const ResultItem *item_a = a;
+  const ResultItem *item_b = b;
+
+  return item_a->key == item_b->key &&
+         item_a->x   == item_b->x   &&
+         item_a->y   == item_b->y   &&
+         item_a->z   == item_b->z;
+}
+
+/* tiles of different formats or sizes never stand in for each other */
+static guint64
+result_key (guint64     key,
+            const Babl *format,
+            gint        tile_width,
+            gint        tile_height)
+{
+  key ^= (guint64) (gsize) format * G_GUINT64_CONSTANT (0x9e3779b97f4a7c15);
+  key ^= ((guint64) tile_width << 32 | (guint32) tile_height) *
+         G_GUINT64_CONSTANT (0xc2b2ae3d27d4eb4f);
+
+  return key;
+}
+
+static inline gint
+floor_div (gint a,
+           gint b)
+{
+  return gegl_tile_indice (a, b);
+}
+
+static inline gint
+ceil_div (gint a,
+          gint b)
+{
+  return -floor_div (-a, b);
+}
+
+/* the range of tiles at @level touching @roi, or when @inner is set,
+ * lying entirely within it; the end is exclusive
+ */
+static void
+result_tile_range (const GeglRectangle *roi,
+                   gint                 level,
+                   gint                 tile_width,
+                   gint                 tile_height,
+                   gboolean             inner,
+                   gint                *x0,
+                   gint                *y0,
+                   gint                *x1,
+                   gint                *y1)
+{
+  gint factor = 1 << level;
+
+  if (inner)
+    {
+      *x0 = ceil_div  (ceil_div  (roi->x, factor), tile_width);
+      *y0 = ceil_div  (ceil_div  (roi->y, factor), tile_height);
+      *x1 = floor_div (floor_div (roi->x + roi->width, factor), tile_width);
+      *y1 = floor_div (floor_div (roi->y + roi->height, factor), tile_height);
+    }
+  else
+    {
+      *x0 = floor_div (floor_div (roi->x, factor), tile_width);
+      *y0 = floor_div (floor_div (roi->y, factor), tile_height);
+      *x1 = ceil_div  (ceil_div  (roi->x + roi->width, factor), tile_width);
+      *y1 = ceil_div  (ceil_div  (roi->y + roi->height, factor), tile_height);
+    }
+}
+
+/* the result mutex must be held */
+static void
+result_remove_item (ResultItem *item)
+{
+  g_queue_unlink (&result_queue, &item->link);
+  g_hash_table_remove (result_ht, item);
+  g_atomic_pointer_add (&result_total, - (gssize) item->tile->size);
+}
+
+static void
+result_free_item (ResultItem *item)
+{
+  gegl_tile_unref (item->tile);
+  g_slice_free (ResultItem, item);
+}
+
+void
+gegl_result_cache_store (guint64              key,
+                         GeglBuffer          *buffer,
+                         const GeglRectangle *roi,
+                         gint                 level)
+{
+  GSList        *evicted = NULL;
+  GeglRectangle  rect;
+  guint64        budget;
+  gint           x0, y0, x1, y1;
+  gint           x, y;
+
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (roi != NULL);
+
+  /* the tiles are looked up on the tile grid of new buffers */
+  if (buffer->shift_x || buffer->shift_y ||
+      buffer->tile_width  != gegl_config ()->tile_width ||
+      buffer->tile_height != gegl_config ()->tile_height)
+    return;
+
+  budget = gegl_config ()->tile_cache_size / GEGL_RESULT_CACHE_SHARE;
+  if (budget == 0)
+    return;
+
+  /* what is written outside of the extent is lost */
+  if (! gegl_rectangle_intersect (&rect, roi, gegl_buffer_get_extent (buffer)))
+    return;
+
+  result_tile_range (&rect, level, buffer->tile_width, buffer->tile_height,
+                     TRUE, &x0, &y0, &x1, &y1);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  key = result_key (key, buffer->format,
+                    buffer->tile_width, buffer->tile_height);
+
+  for (y = y0; y < y1; y++)
+    for (x = x0; x < x1; x++)
+      {
+        GeglTile   *tile = gegl_buffer_get_tile (buffer, x, y, level);
+        ResultItem *item;
+        ResultItem *old;
+
+        if (! tile)
+          continue;
+
+        item       = g_slice_new0 (ResultItem);
+        item->key  = key;
+        item->x    = x;
+        item->y    = y;
+        item->z    = level;
+        item->tile = gegl_tile_dup (tile);
+        item->link.data = item;
+
+        /* the clone belongs to no buffer, and is never written back */
+        item->tile->tile_storage = NULL;
+        gegl_tile_mark_as_stored (item->tile);
+        gegl_tile_unref (tile);
+
+        g_mutex_lock (&result_mutex);
+
+        if (! result_ht)
+          result_ht = g_hash_table_new (result_item_hash, result_item_equal);
+
+        old = g_hash_table_lookup (result_ht, item);
+        if (old)
+          {
+            result_remove_item (old);
+            evicted = g_slist_prepend (evicted, old);
+          }
+
+        g_hash_table_insert (result_ht, item, item);
+        g_queue_push_head_link (&result_queue, &item->link);
+        g_atomic_pointer_add (&result_total, (gssize) item->tile->size);
+
+        while ((guint64) (gsize) g_atomic_pointer_get (&result_total) > budget &&
+               result_queue.tail)
+          {
+            ResultItem *last = result_queue.tail->data;
+
+            result_remove_item (last);
+            evicted = g_slist_prepend (evicted, last);
+          }
+
+        g_mutex_unlock (&result_mutex);
+      }
+
+  /* dropping the last reference frees the data, do that unlocked */
+  g_slist_free_full (evicted, (GDestroyNotify) result_free_item);
+}
+
+GeglBuffer *
+gegl_result_cache_fetch (guint64              key,
+                         const GeglRectangle *roi,
+                         gint                 level,
+                         const Babl          *format)
+{
+  GeglBuffer           *buffer;
+  GeglTileHandlerCache *cache;
+  GeglTile            **tiles;
+  ResultItem            lookup = { 0, };
+  gint                  tile_width  = gegl_config ()->tile_width;
+  gint                  tile_height = gegl_config ()->tile_height;
+  gint                  x0, y0, x1, y1;
+  gint                  x, y;
+  gint                  n_tiles;
+  gint                  i;
+
+  g_return_val_if_fail (roi != NULL, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+
+  if (roi->width <= 0 || roi->height <= 0)
+    return NULL;
+
+  result_tile_range (roi, level, tile_width, tile_height,
+                     FALSE, &x0, &y0, &x1, &y1);
+
+  n_tiles    = (x1 - x0) * (y1 - y0);
+  tiles      = g_new (GeglTile *, n_tiles);
+  lookup.key = result_key (key, format, tile_width, tile_height);
+  lookup.z   = level;
+
+  g_mutex_lock (&result_mutex);
+
+  for (i = 0, y = y0; y < y1; y++)
+    for (x = x0; x < x1; x++, i++)
+      {
+        ResultItem *item;
+
+        lookup.x = x;
+        lookup.y = y;
+
+        item = result_ht ? g_hash_table_lookup (result_ht, &lookup) : NULL;
+        if (! item)
+          {
+            misses++;
+            g_mutex_unlock (&result_mutex);
+
+            while (i--)
+              gegl_tile_unref (tiles[i]);
+            g_free (tiles);
+
+            return NULL;
+          }
+
+        g_queue_unlink (&result_queue, &item->link);
+        g_queue_push_head_link (&result_queue, &item->link);
+
+        tiles[i] = gegl_tile_dup (item->tile);
+      }
+
+  hits++;
+  g_mutex_unlock (&result_mutex);
+
+  buffer = gegl_buffer_new (roi, format);
+  cache  = buffer->tile_storage->cache;
+
+  for (i = 0, y = y0; y < y1; y++)
+    for (x = x0; x < x1; x++, i++)
+      {
+        /* differs from the stored revision, the tile is written to the
+         * buffer's backend if it gets evicted from the tile cache */
+        tiles[i]->rev++;
+        gegl_tile_handler_cache_insert (cache, tiles[i], x, y, level);
+        gegl_tile_unref (tiles[i]);
+      }
+
+  g_free (tiles);
+
+  return buffer;
+}
+
+void
+gegl_result_cache_cleanup (void)
+{
+  GList *link;
+
+  g_mutex_lock (&result_mutex);
+
+  while ((link = g_queue_pop_head_link (&result_queue)))
+    result_free_item (link->data);
+
+  g_clear_pointer (&result_ht, g_hash_table_destroy);
+  result_total = 0;
+
+  g_mutex_unlock (&result_mutex);
+}
+
+guint64
+gegl_result_cache_get_total (void)
+{
+  return (gsize) g_atomic_pointer_get (&result_total);
+}
+
+guint64
+gegl_result_cache_get_hits (void)
+{
+  return hits;
+}
+
+guint64
+gegl_result_cache_get_misses (void)
+{
+  return misses;
+}
+
+void
+gegl_result_cache_reset_stats (void)
+{
+  g_mutex_lock (&result_mutex);
+  hits   = 0;
+  misses = 0;
+  g_mutex_unlock (&result_mutex);
+}
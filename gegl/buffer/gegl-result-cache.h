@@ -0,0 +1,61 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_RESULT_CACHE_H__
+#define __GEGL_RESULT_CACHE_H__
+
+#include <glib-object.h>
+#include "gegl-buffer.h"
+
+G_BEGIN_DECLS
+
+/* the result cache may take up to this fraction of the tile cache size,
+ * the tile cache makes do with what is left
+ */
+#define GEGL_RESULT_CACHE_SHARE 4
+
+/* Keeps the tiles of @buffer at @level that lie entirely within @roi,
+ * under @key, sharing their data with @buffer until either is written to.
+ * @key identifies everything the content of the tiles depends on, apart
+ * from the tile coordinates, level and format.
+ */
+void        gegl_result_cache_store       (guint64              key,
+                                           GeglBuffer          *buffer,
+                                           const GeglRectangle *roi,
+                                           gint                 level);
+
+/* Returns a new buffer of @format holding the tiles stored under @key
+ * covering @roi at @level, or NULL if any of them is missing.
+ */
+GeglBuffer *gegl_result_cache_fetch       (guint64              key,
+                                           const GeglRectangle *roi,
+                                           gint                 level,
+                                           const Babl          *format);
+
+/* drops all stored tiles */
+void        gegl_result_cache_cleanup     (void);
+
+/* the approximate amount of bytes stored, and the number of fetches that
+ * found all tiles and that did not
+ */
+guint64     gegl_result_cache_get_total   (void);
+guint64     gegl_result_cache_get_hits    (void);
+guint64     gegl_result_cache_get_misses  (void);
+void        gegl_result_cache_reset_stats (void);
+
+G_END_DECLS
+
+#endif
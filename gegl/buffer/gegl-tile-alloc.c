@@ -0,0 +1,487 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-tile-alloc.h"
+
+/* Tile data comes in few sizes, tile width times tile height times the
+ * bytes per pixel of a handful of formats, and lots of blocks of each.
+ * Blocks are rounded up to size classes of 2^n and 3 * 2^(n-1) bytes,
+ * from 4 KiB to 512 KiB, and carved from slabs of about 2 MiB that are
+ * never returned as a whole; larger sizes are allocated directly.
+ *
+ * Each block is preceded by a header of GEGL_TILE_ALLOC_ALIGN bytes
+ * telling which class it belongs to.  Freed blocks go to a small per
+ * thread cache first, and from there in batches to the free list of
+ * their class.  When the tile cache trims, the pages of free blocks
+ * beyond what is to be retained are given back to the system with
+ * madvise (); such released blocks are still reused, after the resident
+ * ones.  A trim that releases anything also tells the threads to flush
+ * their caches into the free lists the next time they allocate or free,
+ * for the next trim to find.
+ *
+ * With the tile-huge-pages config option, slabs are aligned to 2 MiB
+ * and the kernel is asked to back them with transparent huge pages.
+ */
+
+#define N_SIZE_CLASSES       15
+#define SMALLEST_CLASS_SHIFT 12
+#define SLAB_SIZE            (2 * 1024 * 1024)
+#define MIN_SLAB_BLOCKS      4
+#define THREAD_CACHE_SIZE    (1024 * 1024)
+#define DIRECT               N_SIZE_CLASSES
+#define HEADER_MAGIC         0x67746c61
+
+typedef struct _BlockHeader BlockHeader;
+
+struct _BlockHeader
+{
+  BlockHeader *next;       /* in the free lists */
+  gpointer     mem;        /* the g_malloc () block of direct allocations */
+  gsize        size;       /* the size of direct allocations */
+  guint32      size_class;
+  guint32      magic;
+};
+
+G_STATIC_ASSERT (sizeof (BlockHeader) <= GEGL_TILE_ALLOC_ALIGN);
+
+#define BLOCK_HEADER(data)   ((BlockHeader *) ((guchar *) (data) - GEGL_TILE_ALLOC_ALIGN))
+#define BLOCK_DATA(header)   ((gpointer) ((guchar *) (header) + GEGL_TILE_ALLOC_ALIGN))
+
+typedef struct
+{
+  GMutex       mutex;
+  BlockHeader *free;        /* freed blocks, with their pages resident */
+  BlockHeader *released;    /* freed blocks whose pages were given back */
+  guchar      *slab;        /* the part of the newest slab not carved yet */
+  gint         slab_blocks;
+} SizeClass;
+
+typedef struct
+{
+  BlockHeader *blocks[N_SIZE_CLASSES];
+  gint         n_blocks[N_SIZE_CLASSES];
+  gint         generation; /* of the last trim the cache was flushed for */
+} ThreadCache;
+
+static void thread_cache_destroy (gpointer data);
+
+static SizeClass      size_classes[N_SIZE_CLASSES];
+static GPrivate       thread_cache_key = G_PRIVATE_INIT (thread_cache_destroy);
+
+static volatile gint  trim_generation = 0;
+static volatile gsize reserved_bytes = 0;
+static volatile gsize in_use_bytes   = 0;
+static volatile gsize free_bytes     = 0; /* in the free lists */
+static volatile gsize released_bytes = 0;
+
+static inline gsize
+class_size (gint size_class)
+{
+  gint shift = SMALLEST_CLASS_SHIFT + size_class / 2;
+
+  if (size_class & 1)
+    return (gsize) 3 << (shift - 1);
+  else
+    return (gsize) 1 << shift;
+}
+
+static inline gint
+size_class_for (gsize size)
+{
+  gint i;
+
+  for (i = 0; i < N_SIZE_CLASSES; i++)
+    if (size <= class_size (i))
+      return i;
+
+  return DIRECT;
+}
+
+/* the number of blocks of a class a thread keeps for itself */
+static inline gint
+thread_cache_limit (gint size_class)
+{
+  return MAX (2, THREAD_CACHE_SIZE / class_size (size_class));
+}
+
+static guchar *
+slab_new (gsize size)
+{
+  guchar *mem;
+
+#if defined (G_OS_UNIX) && defined (MAP_ANONYMOUS)
+  if (gegl_config ()->tile_huge_pages)
+    {
+      gsize   mapped = size + SLAB_SIZE;
+      guchar *start;
+      guchar *end;
+
+      mem = mmap (NULL, mapped, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mem == MAP_FAILED)
+        g_error ("%s: failed to map %" G_GSIZE_FORMAT " bytes",
+                 G_STRLOC, mapped);
+
+      /* keep the 2 MiB aligned part */
+      start = (guchar *) (((guintptr) mem + SLAB_SIZE - 1) &
+                          ~((guintptr) SLAB_SIZE - 1));
+      end   = mem + mapped;
+
+      if (start > mem)
+        munmap (mem, start - mem);
+      if (end > start + size)
+        munmap (start + size, end - (start + size));
+
+      mem = start;
+
+#ifdef MADV_HUGEPAGE
+      madvise (mem, size, MADV_HUGEPAGE);
+#endif
+    }
+  else
+    {
+      mem = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mem == MAP_FAILED)
+        g_error ("%s: failed to map %" G_GSIZE_FORMAT " bytes",
+                 G_STRLOC, size);
+    }
+#else
+  mem = g_malloc (size + GEGL_TILE_ALLOC_ALIGN);
+  mem = (guchar *) (((guintptr) mem + GEGL_TILE_ALLOC_ALIGN - 1) &
+                    ~((guintptr) GEGL_TILE_ALLOC_ALIGN - 1));
+#endif
+
+  g_atomic_pointer_add (&reserved_bytes, size);
+
+  return mem;
+}
+
+/* gives the pages entirely within the data of @header back */
+static void
+block_release_pages (BlockHeader *header,
+                     gsize        size)
+{
+#if defined (G_OS_UNIX) && defined (MADV_DONTNEED)
+  static gsize page_size = 0;
+  guintptr     start;
+  guintptr     end;
+
+  if (G_UNLIKELY (page_size == 0))
+    page_size = sysconf (_SC_PAGESIZE);
+
+  start = ((guintptr) BLOCK_DATA (header) + page_size - 1) & ~(page_size - 1);
+  end   = ((guintptr) BLOCK_DATA (header) + size) & ~(page_size - 1);
+
+  if (end > start)
+    madvise ((gpointer) start, end - start, MADV_DONTNEED);
+#endif
+}
+
+/* moves @n blocks from the thread cache to the free list of the class */
+static void
+thread_cache_flush (ThreadCache *cache,
+                    gint         size_class,
+                    gint         n)
+{
+  SizeClass   *klass = &size_classes[size_class];
+  BlockHeader *first = cache->blocks[size_class];
+  BlockHeader *last  = first;
+  gint         i;
+
+  if (n <= 0 || ! first)
+    return;
+
+  for (i = 1; i < n && last->next; i++)
+    last = last->next;
+
+  cache->blocks[size_class]    = last->next;
+  cache->n_blocks[size_class] -= i;
+
+  g_mutex_lock (&klass->mutex);
+  last->next  = klass->free;
+  klass->free = first;
+  g_mutex_unlock (&klass->mutex);
+
+  g_atomic_pointer_add (&free_bytes, i * class_size (size_class));
+}
+
+static ThreadCache *
+thread_cache_get (void)
+{
+  ThreadCache *cache = g_private_get (&thread_cache_key);
+  gint         generation = g_atomic_int_get (&trim_generation);
+
+  if (G_UNLIKELY (! cache))
+    {
+      cache = g_new0 (ThreadCache, 1);
+      cache->generation = generation;
+      g_private_set (&thread_cache_key, cache);
+    }
+  else if (G_UNLIKELY (cache->generation != generation))
+    {
+      gint i;
+
+      for (i = 0; i < N_SIZE_CLASSES; i++)
+        thread_cache_flush (cache, i, cache->n_blocks[i]);
+
+      cache->generation = generation;
+    }
+
+  return cache;
+}
+
+static void
+thread_cache_destroy (gpointer data)
+{
+  ThreadCache *cache = data;
+  gint         i;
+
+  for (i = 0; i < N_SIZE_CLASSES; i++)
+    thread_cache_flush (cache, i, cache->n_blocks[i]);
+
+  g_free (cache);
+}
+
+/* takes a block from the class, refilling the thread cache from the free
+ * list while at it
+ */
+static BlockHeader *
+size_class_alloc (ThreadCache *cache,
+                  gint         size_class)
+{
+  SizeClass   *klass = &size_classes[size_class];
+  gsize        size  = class_size (size_class);
+  BlockHeader *header;
+
+  g_mutex_lock (&klass->mutex);
+
+  if (klass->free)
+    {
+      gint refill = thread_cache_limit (size_class) / 2;
+      gint n      = 1;
+
+      header      = klass->free;
+      klass->free = header->next;
+
+      while (klass->free && refill--)
+        {
+          BlockHeader *extra = klass->free;
+
+          klass->free = extra->next;
+          extra->next = cache->blocks[size_class];
+          cache->blocks[size_class] = extra;
+          cache->n_blocks[size_class]++;
+          n++;
+        }
+
+      g_atomic_pointer_add (&free_bytes, -(gssize) (n * size));
+    }
+  else if (klass->released)
+    {
+      header          = klass->released;
+      klass->released = header->next;
+
+      g_atomic_pointer_add (&released_bytes, -(gssize) size);
+    }
+  else
+    {
+      if (klass->slab_blocks == 0)
+        {
+          gsize stride = size + GEGL_TILE_ALLOC_ALIGN;
+
+          klass->slab_blocks = MAX (MIN_SLAB_BLOCKS, SLAB_SIZE / stride);
+          klass->slab        = slab_new (klass->slab_blocks * stride);
+        }
+
+      header              = (BlockHeader *) klass->slab;
+      header->size_class  = size_class;
+      header->magic       = HEADER_MAGIC;
+      header->mem         = NULL;
+      header->size        = size;
+
+      klass->slab        += size + GEGL_TILE_ALLOC_ALIGN;
+      klass->slab_blocks -= 1;
+    }
+
+  g_mutex_unlock (&klass->mutex);
+
+  return header;
+}
+
+static gpointer
+direct_alloc (gsize size)
+{
+  guchar      *mem;
+  BlockHeader *header;
+
+  mem    = g_malloc (size + 2 * GEGL_TILE_ALLOC_ALIGN);
+  header = (BlockHeader *) (((guintptr) mem + GEGL_TILE_ALLOC_ALIGN - 1) &
+                            ~((guintptr) GEGL_TILE_ALLOC_ALIGN - 1));
+
+  header->size_class = DIRECT;
+  header->magic      = HEADER_MAGIC;
+  header->mem        = mem;
+  header->size       = size;
+
+  g_atomic_pointer_add (&in_use_bytes, size);
+
+  return BLOCK_DATA (header);
+}
+
+gpointer
+gegl_tile_alloc (gsize size)
+{
+  gint         size_class = size_class_for (size);
+  ThreadCache *cache;
+  BlockHeader *header;
+
+  if (size_class == DIRECT)
+    return direct_alloc (size);
+
+  cache  = thread_cache_get ();
+  header = cache->blocks[size_class];
+
+  if (header)
+    {
+      cache->blocks[size_class] = header->next;
+      cache->n_blocks[size_class]--;
+    }
+  else
+    {
+      header = size_class_alloc (cache, size_class);
+    }
+
+  g_atomic_pointer_add (&in_use_bytes, class_size (size_class));
+
+  return BLOCK_DATA (header);
+}
+
+gpointer
+gegl_tile_alloc0 (gsize size)
+{
+  gpointer data = gegl_tile_alloc (size);
+
+  memset (data, 0, size);
+
+  return data;
+}
+
+void
+gegl_tile_free (gpointer data)
+{
+  BlockHeader *header;
+  ThreadCache *cache;
+  gint         size_class;
+
+  if (! data)
+    return;
+
+  header = BLOCK_HEADER (data);
+
+  g_return_if_fail (header->magic == HEADER_MAGIC);
+
+  size_class = header->size_class;
+
+  if (size_class == DIRECT)
+    {
+      g_atomic_pointer_add (&in_use_bytes, -(gssize) header->size);
+      g_free (header->mem);
+      return;
+    }
+
+  g_atomic_pointer_add (&in_use_bytes, -(gssize) class_size (size_class));
+
+  cache = thread_cache_get ();
+
+  header->next = cache->blocks[size_class];
+  cache->blocks[size_class] = header;
+  cache->n_blocks[size_class]++;
+
+  if (cache->n_blocks[size_class] > thread_cache_limit (size_class))
+    thread_cache_flush (cache, size_class, cache->n_blocks[size_class] / 2);
+}
+
+void
+gegl_tile_alloc_trim (gsize retain)
+{
+  gint i;
+
+  if ((gsize) g_atomic_pointer_get (&free_bytes) <= retain)
+    return;
+
+  /* the blocks held by the threads are trimmed the next time around */
+  g_atomic_int_inc (&trim_generation);
+
+  /* largest blocks first, they give back the most pages each */
+  for (i = N_SIZE_CLASSES - 1; i >= 0; i--)
+    {
+      SizeClass *klass = &size_classes[i];
+      gsize      size  = class_size (i);
+
+      g_mutex_lock (&klass->mutex);
+
+      while (klass->free &&
+             (gsize) g_atomic_pointer_get (&free_bytes) > retain)
+        {
+          BlockHeader *header = klass->free;
+
+          klass->free = header->next;
+
+          block_release_pages (header, size);
+
+          header->next    = klass->released;
+          klass->released = header;
+
+          g_atomic_pointer_add (&free_bytes, -(gssize) size);
+          g_atomic_pointer_add (&released_bytes, size);
+        }
+
+      g_mutex_unlock (&klass->mutex);
+    }
+}
+
+guint64
+gegl_tile_alloc_get_reserved (void)
+{
+  return (gsize) g_atomic_pointer_get (&reserved_bytes);
+}
+
+guint64
+gegl_tile_alloc_get_in_use (void)
+{
+  return (gsize) g_atomic_pointer_get (&in_use_bytes);
+}
+
+guint64
+gegl_tile_alloc_get_released (void)
+{
+  return (gsize) g_atomic_pointer_get (&released_bytes);
+}
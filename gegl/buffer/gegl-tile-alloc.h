@@ -0,0 +1,53 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_ALLOC_H__
+#define __GEGL_TILE_ALLOC_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* the alignment of the memory returned by gegl_tile_alloc () */
+#define GEGL_TILE_ALLOC_ALIGN 64
+
+/* Allocates @size bytes of tile data, aligned to GEGL_TILE_ALLOC_ALIGN
+ * bytes.  The memory has to be freed with gegl_tile_free ().
+ */
+gpointer gegl_tile_alloc                  (gsize    size);
+
+/* like gegl_tile_alloc (), with the memory cleared */
+gpointer gegl_tile_alloc0                 (gsize    size);
+
+void     gegl_tile_free                   (gpointer data);
+
+/* Gives the pages of free blocks back to the system, keeping about
+ * @retain bytes of free blocks at hand.  Called when the tile cache
+ * trims.
+ */
+void     gegl_tile_alloc_trim             (gsize    retain);
+
+/* bytes of address space taken from the system, bytes handed out in
+ * blocks currently allocated, and bytes of free blocks whose pages have
+ * been given back
+ */
+guint64  gegl_tile_alloc_get_reserved     (void);
+guint64  gegl_tile_alloc_get_in_use       (void);
+guint64  gegl_tile_alloc_get_released     (void);
+
+G_END_DECLS
+
+#endif
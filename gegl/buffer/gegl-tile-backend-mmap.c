@@ -0,0 +1,444 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-buffer-backend.h"
+#include "gegl-tile-backend.h"
+#include "gegl-tile-backend-mmap.h"
+#include "gegl-buffer-index.h"
+#include "gegl-debug.h"
+
+/* We need the private header so we can check the ref_count of tiles */
+#include "gegl-buffer-private.h"
+
+typedef struct _MmapEntry MmapEntry;
+
+struct _MmapEntry
+{
+  gint      x;
+  gint      y;
+  gint      z;
+  guint64   offset; /* of the tile data in the file */
+  gboolean  mapped; /* whether tile holds the data of the file */
+  GeglTile *tile;
+};
+
+G_DEFINE_TYPE (GeglTileBackendMmap, gegl_tile_backend_mmap, GEGL_TYPE_TILE_BACKEND)
+#define parent_class gegl_tile_backend_mmap_parent_class
+
+
+static inline MmapEntry *
+lookup_entry (GeglTileBackendMmap *self,
+              gint                 x,
+              gint                 y,
+              gint                 z)
+{
+  MmapEntry key;
+
+  key.x = x;
+  key.y = y;
+  key.z = z;
+
+  return g_hash_table_lookup (self->entries, &key);
+}
+
+static MmapEntry *
+add_entry (GeglTileBackendMmap *self,
+           gint                 x,
+           gint                 y,
+           gint                 z)
+{
+  MmapEntry *entry = g_slice_new0 (MmapEntry);
+
+  entry->x = x;
+  entry->y = y;
+  entry->z = z;
+
+  g_hash_table_insert (self->entries, entry, entry);
+
+  return entry;
+}
+
+static void
+entry_drop_tile (MmapEntry *entry)
+{
+  if (entry->tile)
+    {
+      /* Mark as stored to prevent an attempt to store by tile_unref */
+      gegl_tile_mark_as_stored (entry->tile);
+      gegl_tile_unref (entry->tile);
+      entry->tile = NULL;
+    }
+
+  entry->mapped = FALSE;
+}
+
+static GeglTile *
+get_tile (GeglTileSource *tile_store,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileBackendMmap *self  = GEGL_TILE_BACKEND_MMAP (tile_store);
+  MmapEntry           *entry = lookup_entry (self, x, y, z);
+
+  if (! entry)
+    return NULL;
+
+  if (entry->mapped && ! entry->tile)
+    {
+      GeglTileBackend *backend = GEGL_TILE_BACKEND (self);
+      gchar           *data    = g_mapped_file_get_contents (self->file);
+
+      /* the tile pointing into the mapping stays with the entry, and every
+       * tile handed out shares its data.  The mapping is read-only, so
+       * locking any of them for writing makes it take a private copy, even
+       * the last one left once the entry dropped its own.  The tiles keep
+       * the mapping alive.
+       */
+      entry->tile = gegl_tile_new_bare ();
+      gegl_tile_set_data_full (entry->tile,
+                               data + entry->offset,
+                               gegl_tile_backend_get_tile_size (backend),
+                               (GDestroyNotify) g_mapped_file_unref,
+                               g_mapped_file_ref (self->file));
+      entry->tile->read_only = 1;
+      gegl_tile_mark_as_stored (entry->tile);
+    }
+
+  if (entry->mapped)
+    {
+      GeglTile *tile = gegl_tile_dup (entry->tile);
+
+      gegl_tile_mark_as_stored (tile);
+
+      return tile;
+    }
+
+  return gegl_tile_ref (entry->tile);
+}
+
+static gboolean
+set_tile (GeglTileSource *store,
+          GeglTile       *tile,
+          gint            x,
+          gint            y,
+          gint            z)
+{
+  GeglTileBackendMmap *self   = GEGL_TILE_BACKEND_MMAP (store);
+  MmapEntry           *entry  = lookup_entry (self, x, y, z);
+  gboolean             is_dup = FALSE;
+
+  if (entry && entry->tile == tile)
+    {
+      gegl_tile_mark_as_stored (tile);
+      return TRUE;
+    }
+
+  if (tile->ref_count == 0)
+    {
+      /* We've been handed a dead tile to store, duplicate it while it's
+       * still safe, as in the RAM backend.
+       */
+      tile = gegl_tile_dup (tile);
+
+      tile->x = x;
+      tile->y = y;
+      tile->z = z;
+
+      is_dup = TRUE;
+    }
+
+  /* modified tiles are kept in memory, the file is never written to */
+  if (! entry)
+    entry = add_entry (self, x, y, z);
+  else
+    entry_drop_tile (entry);
+
+  entry->tile = tile;
+
+  if (! is_dup)
+    gegl_tile_ref (entry->tile);
+
+  gegl_tile_mark_as_stored (entry->tile);
+
+  return TRUE;
+}
+
+static gpointer
+gegl_tile_backend_mmap_command (GeglTileSource  *tile_store,
+                                GeglTileCommand  command,
+                                gint             x,
+                                gint             y,
+                                gint             z,
+                                gpointer         data)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (tile_store);
+
+  switch (command)
+    {
+      case GEGL_TILE_GET:
+        return get_tile (tile_store, x, y, z);
+
+      case GEGL_TILE_SET:
+        set_tile (tile_store, data, x, y, z);
+        return NULL;
+
+      case GEGL_TILE_IDLE:
+        return NULL;
+
+      case GEGL_TILE_VOID:
+        {
+          MmapEntry *entry = lookup_entry (self, x, y, z);
+
+          if (entry)
+            g_hash_table_remove (self->entries, entry);
+        }
+        return NULL;
+
+      case GEGL_TILE_EXIST:
+        return GINT_TO_POINTER (lookup_entry (self, x, y, z) != NULL);
+
+      case GEGL_TILE_FLUSH:
+        return NULL;
+
+      default:
+        g_assert (command < GEGL_TILE_LAST_COMMAND &&
+                  command >= 0);
+    }
+  return NULL;
+}
+
+/* walks the index of the file, which is a linked list of blocks, without
+ * touching the tile data.
+ */
+static gboolean
+gegl_tile_backend_mmap_read_index (GeglTileBackendMmap *self,
+                                   guint64              next)
+{
+  const gchar *contents  = g_mapped_file_get_contents (self->file);
+  gsize        length    = g_mapped_file_get_length (self->file);
+  gint         tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  gsize        max_items = length / sizeof (GeglBufferBlock);
+  gsize        n_items   = 0;
+
+  while (next)
+    {
+      GeglBufferBlock block;
+
+      if (next + sizeof (GeglBufferBlock) > length || n_items++ > max_items)
+        return FALSE;
+
+      /* items are not necessarily aligned in the file */
+      memcpy (&block, contents + next, sizeof (GeglBufferBlock));
+
+      if (block.flags == GEGL_FLAG_TILE || block.flags == GEGL_FLAG_FREE_TILE)
+        {
+          GeglBufferTile item;
+          gsize          item_size = MIN (block.length, sizeof (GeglBufferTile));
+          MmapEntry     *entry;
+
+          if (item_size < sizeof (GeglBufferBlock) || next + item_size > length)
+            return FALSE;
+
+          memset (&item, 0, sizeof (GeglBufferTile));
+          memcpy (&item, contents + next, item_size);
+
+          if (item.offset + tile_size > length)
+            return FALSE;
+
+          entry = lookup_entry (self, item.x, item.y, item.z);
+          if (! entry)
+            entry = add_entry (self, item.x, item.y, item.z);
+
+          entry->offset = item.offset;
+          entry->mapped = TRUE;
+        }
+      else
+        {
+          g_warning ("skipping unknown type of entry flags=%i", block.flags);
+        }
+
+      next = block.next;
+    }
+
+  return TRUE;
+}
+
+GeglTileBackend *
+gegl_tile_backend_mmap_new (const gchar *path)
+{
+  GeglTileBackendMmap *self;
+  GMappedFile         *file;
+  GeglBufferHeader     header;
+  const Babl          *format;
+  GeglRectangle        extent;
+  GError              *error = NULL;
+
+  file = g_mapped_file_new (path, FALSE, &error);
+
+  if (! file)
+    {
+      GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "failed to map %s: %s", path, error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  if (g_mapped_file_get_length (file) < sizeof (GeglBufferHeader))
+    {
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  memcpy (&header, g_mapped_file_get_contents (file), sizeof (GeglBufferHeader));
+
+  if (memcmp (header.magic, "GEGL", 4) != 0)
+    {
+      g_warning ("Magic is wrong! %s", header.magic);
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  header.description[sizeof (header.description) - 1] = '\0';
+  format = babl_format (header.description);
+
+  if (! format ||
+      babl_format_get_bytes_per_pixel (format) != header.bytes_per_pixel)
+    {
+      g_mapped_file_unref (file);
+      return NULL;
+    }
+
+  self = g_object_new (GEGL_TYPE_TILE_BACKEND_MMAP,
+                       "tile-width",  header.tile_width,
+                       "tile-height", header.tile_height,
+                       "format",      format,
+                       NULL);
+  self->file = file;
+
+  if (! gegl_tile_backend_mmap_read_index (self, header.next))
+    {
+      g_warning ("%s: corrupt GeglBuffer index in '%s'", G_STRFUNC, path);
+      g_object_unref (self);
+      return NULL;
+    }
+
+  extent.x      = 0;
+  extent.y      = 0;
+  extent.width  = header.width;
+  extent.height = header.height;
+  gegl_tile_backend_set_extent (GEGL_TILE_BACKEND (self), &extent);
+
+  GEGL_NOTE (GEGL_DEBUG_BUFFER_LOAD, "mapped %s with %i tiles", path,
+             g_hash_table_size (self->entries));
+
+  return GEGL_TILE_BACKEND (self);
+}
+
+static void
+gegl_tile_backend_mmap_finalize (GObject *object)
+{
+  GeglTileBackendMmap *self = GEGL_TILE_BACKEND_MMAP (object);
+
+  g_hash_table_unref (self->entries);
+
+  if (self->file)
+    g_mapped_file_unref (self->file);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static guint
+mmap_entry_hash_func (gconstpointer key)
+{
+  const MmapEntry *e = key;
+  guint            hash;
+  gint             i;
+  gint             srcA = e->x;
+  gint             srcB = e->y;
+  gint             srcC = e->z;
+
+  /* interleave the 10 least significant bits of all coordinates,
+   * this gives us Z-order / morton order of the space and should
+   * work well as a hash
+   */
+  hash = 0;
+  for (i = 9; i >= 0; i--)
+    {
+#define ADD_BIT(bit)    do { hash |= (((bit) != 0) ? 1 : 0); hash <<= 1; } while (0)
+      ADD_BIT (srcA & (1 << i));
+      ADD_BIT (srcB & (1 << i));
+      ADD_BIT (srcC & (1 << i));
+#undef ADD_BIT
+    }
+  return hash;
+}
+
+static gboolean
+mmap_entry_equal_func (gconstpointer a,
+                       gconstpointer b)
+{
+  const MmapEntry *ea = a;
+  const MmapEntry *eb = b;
+
+  return ea->x == eb->x &&
+         ea->y == eb->y &&
+         ea->z == eb->z;
+}
+
+static void
+mmap_entry_free_func (gpointer data)
+{
+  MmapEntry *entry = data;
+
+  entry_drop_tile (entry);
+
+  g_slice_free (MmapEntry, entry);
+}
+
+static void
+gegl_tile_backend_mmap_constructed (GObject *object)
+{
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+
+  gegl_tile_backend_set_flush_on_destroy (GEGL_TILE_BACKEND (object), FALSE);
+}
+
+static void
+gegl_tile_backend_mmap_class_init (GeglTileBackendMmapClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gegl_tile_backend_mmap_constructed;
+  gobject_class->finalize    = gegl_tile_backend_mmap_finalize;
+}
+
+static void
+gegl_tile_backend_mmap_init (GeglTileBackendMmap *self)
+{
+  GEGL_TILE_SOURCE (self)->command = gegl_tile_backend_mmap_command;
+
+  self->entries = g_hash_table_new_full (mmap_entry_hash_func,
+                                         mmap_entry_equal_func,
+                                         NULL,
+                                         mmap_entry_free_func);
+}
@@ -0,0 +1,63 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_BACKEND_MMAP_H__
+#define __GEGL_TILE_BACKEND_MMAP_H__
+
+#include "gegl-tile-backend.h"
+
+/***
+ * GeglTileBackendMmap is a GeglTileBackend serving the tiles of a saved
+ * GeglBuffer file straight from a read-only memory mapping.  Tiles share
+ * the mapped pages until they are written to, modified tiles are kept in
+ * RAM and the file is never changed.
+ */
+
+G_BEGIN_DECLS
+
+#define GEGL_TYPE_TILE_BACKEND_MMAP            (gegl_tile_backend_mmap_get_type ())
+#define GEGL_TILE_BACKEND_MMAP(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmap))
+#define GEGL_TILE_BACKEND_MMAP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+#define GEGL_IS_TILE_BACKEND_MMAP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_IS_TILE_BACKEND_MMAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEGL_TYPE_TILE_BACKEND_MMAP))
+#define GEGL_TILE_BACKEND_MMAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_BACKEND_MMAP, GeglTileBackendMmapClass))
+
+typedef struct _GeglTileBackendMmap      GeglTileBackendMmap;
+typedef struct _GeglTileBackendMmapClass GeglTileBackendMmapClass;
+
+struct _GeglTileBackendMmap
+{
+  GeglTileBackend  parent_instance;
+
+  GMappedFile     *file;
+  GHashTable      *entries;
+};
+
+struct _GeglTileBackendMmapClass
+{
+  GeglTileBackendClass parent_class;
+};
+
+GType             gegl_tile_backend_mmap_get_type (void) G_GNUC_CONST;
+
+/* maps the GeglBuffer file at @path, returns NULL if it can not be mapped
+ * or is not a valid GeglBuffer file.
+ */
+GeglTileBackend * gegl_tile_backend_mmap_new      (const gchar *path);
+
+G_END_DECLS
+
+#endif
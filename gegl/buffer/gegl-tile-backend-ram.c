@@ -24,6 +24,7 @@
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-ram.h"
+#include "gegl-tile-compression.h"
 
 /* We need the private header so we can check the ref_count of tiles */
 #include "gegl-buffer-private.h"
@@ -32,9 +33,11 @@ typedef struct _RamEntry RamEntry;
 
 struct _RamEntry
 {
-  gint    x;
-  gint    y;
+  gint      x;
+  gint      y;
   GeglTile *tile;
+  guchar   *compressed;
+  gint      compressed_size;
 };
 
 G_DEFINE_TYPE (GeglTileBackendRam, gegl_tile_backend_ram, GEGL_TYPE_TILE_BACKEND)
@@ -65,6 +68,13 @@ void gegl_tile_backend_ram_stats (void)
   /* FIXME: Stats disabled for now as there's nothing meaningful to report */
 }
 
+static inline gint
+ram_entry_bpp (GeglTileBackendRam *self)
+{
+  return babl_format_get_bytes_per_pixel (
+           gegl_tile_backend_get_format (GEGL_TILE_BACKEND (self)));
+}
+
 static inline RamEntry *
 lookup_entry (GeglTileBackendRam *self,
               gint                x,
@@ -75,6 +85,7 @@ lookup_entry (GeglTileBackendRam *self,
   key.x = x;
   key.y = y;
   key.tile = NULL;
+  key.compressed = NULL;
 
   return g_hash_table_lookup (self->entries, &key);
 }
@@ -90,13 +101,73 @@ get_tile (GeglTileSource *tile_store,
   if (z == 0)
     {
       RamEntry *entry = lookup_entry (tile_backend_ram, x, y);
-      if (entry)
-        return gegl_tile_ref (entry->tile);
+
+      if (entry && entry->tile)
+        {
+          return gegl_tile_ref (entry->tile);
+        }
+      else if (entry)
+        {
+          GeglTileBackend *backend = GEGL_TILE_BACKEND (tile_store);
+          GeglTile        *tile;
+
+          tile = gegl_tile_new (gegl_tile_backend_get_tile_size (backend));
+
+          if (! gegl_tile_decompress (tile_backend_ram->compression,
+                                      ram_entry_bpp (tile_backend_ram),
+                                      entry->compressed, entry->compressed_size,
+                                      gegl_tile_get_data (tile),
+                                      gegl_tile_backend_get_tile_size (backend)))
+            g_warning ("corrupt compressed tile data in RAM backend");
+
+          gegl_tile_mark_as_stored (tile);
+
+          return tile;
+        }
     }
 
   return NULL;
 }
 
+/* keeps a compressed copy of the tile data instead of the tile, returns
+ * FALSE if the data does not compress
+ */
+static gboolean
+set_tile_compressed (GeglTileBackendRam *self,
+                     RamEntry           *entry,
+                     GeglTile           *tile)
+{
+  gint    tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
+  guchar *compressed;
+  gsize   compressed_size;
+
+  compressed = g_malloc (tile_size);
+
+  if (! gegl_tile_compress (self->compression, ram_entry_bpp (self),
+                            gegl_tile_get_data (tile), tile_size,
+                            compressed, &compressed_size))
+    {
+      g_free (compressed);
+      return FALSE;
+    }
+
+  g_free (entry->compressed);
+  entry->compressed      = g_realloc (compressed, compressed_size);
+  entry->compressed_size = compressed_size;
+
+  if (entry->tile)
+    {
+      /* Mark as stored to prevent a recursive attempt to store by tile_unref */
+      gegl_tile_mark_as_stored (entry->tile);
+      gegl_tile_unref (entry->tile);
+      entry->tile = NULL;
+    }
+
+  gegl_tile_mark_as_stored (tile);
+
+  return TRUE;
+}
+
 static
 gboolean set_tile (GeglTileSource *store,
                    GeglTile       *tile,
@@ -113,6 +184,20 @@ gboolean set_tile (GeglTileSource *store,
 
   entry = lookup_entry (tile_backend_ram, x, y);
 
+  if (tile_backend_ram->compression != GEGL_TILE_COMPRESSION_NONE)
+    {
+      if (!entry)
+        {
+          entry = g_slice_new0 (RamEntry);
+          entry->x = x;
+          entry->y = y;
+          g_hash_table_insert (tile_backend_ram->entries, entry, entry);
+        }
+
+      if (set_tile_compressed (tile_backend_ram, entry, tile))
+        return TRUE;
+    }
+
   if (tile->ref_count == 0)
     {
       /* We've been handed a dead tile to store, this happens
@@ -134,10 +219,9 @@ gboolean set_tile (GeglTileSource *store,
 
   if (!entry)
     {
-      entry = g_slice_new (RamEntry);
+      entry = g_slice_new0 (RamEntry);
       entry->x = x;
       entry->y = y;
-      entry->tile = NULL;
       g_hash_table_insert (tile_backend_ram->entries, entry, entry);
     }
   else if (entry->tile == tile)
@@ -145,13 +229,15 @@ gboolean set_tile (GeglTileSource *store,
       gegl_tile_mark_as_stored (tile);
       return TRUE;
     }
-  else
+  else if (entry->tile)
     {
       /* Mark as stored to prevent a recursive attempt to store by tile_unref */
       gegl_tile_mark_as_stored (entry->tile);
       gegl_tile_unref (entry->tile);
     }
 
+  g_clear_pointer (&entry->compressed, g_free);
+
   entry->tile = tile;
 
   if (!is_dup)
@@ -200,7 +286,8 @@ gboolean exist_tile (GeglTileSource *store,
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_COMPRESSION
 };
 
 static gpointer
@@ -243,8 +330,14 @@ set_property (GObject       *object,
               const GValue  *value,
               GParamSpec    *pspec)
 {
+  GeglTileBackendRam *self = GEGL_TILE_BACKEND_RAM (object);
+
   switch (property_id)
     {
+      case PROP_COMPRESSION:
+        self->compression = g_value_get_enum (value);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -257,8 +350,14 @@ get_property (GObject    *object,
               GValue     *value,
               GParamSpec *pspec)
 {
+  GeglTileBackendRam *self = GEGL_TILE_BACKEND_RAM (object);
+
   switch (property_id)
     {
+      case PROP_COMPRESSION:
+        g_value_set_enum (value, self->compression);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -326,6 +425,7 @@ ram_entry_free_func (gpointer data)
       gegl_tile_unref (entry->tile);
       entry->tile = NULL;
     }
+  g_free (entry->compressed);
   g_slice_free (RamEntry, entry);
 }
 
@@ -346,6 +446,15 @@ gegl_tile_backend_ram_class_init (GeglTileBackendRamClass *klass)
   gobject_class->set_property = set_property;
   gobject_class->constructed  = gegl_tile_backend_ram_constructed;
   gobject_class->finalize     = gegl_tile_backend_ram_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_COMPRESSION,
+                                   g_param_spec_enum ("compression",
+                                                      "Compression",
+                                                      "How tiles are compressed while no one else holds them",
+                                                      GEGL_TYPE_TILE_COMPRESSION,
+                                                      GEGL_TILE_COMPRESSION_NONE,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -39,9 +39,12 @@ typedef struct _GeglTileBackendRamClass GeglTileBackendRamClass;
 
 struct _GeglTileBackendRam
 {
-  GeglTileBackend  parent_instance;
+  GeglTileBackend      parent_instance;
 
-  GHashTable      *entries;
+  GHashTable          *entries;
+
+  /* when set, tiles are kept compressed while no one else holds them */
+  GeglTileCompression  compression;
 };
 
 struct _GeglTileBackendRamClass
@@ -23,6 +23,10 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -40,6 +44,7 @@
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-swap.h"
+#include "gegl-tile-compression.h"
 #include "gegl-debug.h"
 #include "gegl-config.h"
 
@@ -52,34 +57,60 @@
 
 #endif
 
+#if !defined (HAVE_PWRITEV) || !defined (HAVE_SYS_UIO_H)
+#undef HAVE_PWRITEV
+#endif
+
+/* the most writes a writer thread takes from the queue at once, the tiles
+ * of a batch are placed next to each other and written with one syscall.
+ */
+#define GEGL_SWAP_MAX_BATCH          64
+
+/* the most writer threads, the actual number depends on the number of
+ * processing threads.
+ */
+#define GEGL_SWAP_MAX_WRITER_THREADS 4
+
+/* the number of tiles to read ahead of a sequential run of reads */
+#define GEGL_SWAP_READ_AHEAD         16
+
 
 G_DEFINE_TYPE (GeglTileBackendSwap, gegl_tile_backend_swap, GEGL_TYPE_TILE_BACKEND)
 
 static GObjectClass * parent_class = NULL;
 
 
-typedef enum
-{
-  OP_WRITE,
-  OP_TRUNCATE,
-} ThreadOp;
+typedef struct _ThreadParams ThreadParams;
 
 typedef struct
 {
-  guint64  offset;
-  GList   *link;
-  gint     x;
-  gint     y;
-  gint     z;
+  guint64              offset;
+  gint                 length;      /* stored bytes, 0 until written */
+  GeglTileCompression  compression; /* of the stored bytes */
+  GList               *link;        /* queued write, if any */
+  ThreadParams        *writing;     /* write in progress, if any */
+  gint                 x;
+  gint                 y;
+  gint                 z;
+  guchar              *uniform;     /* the pixel of a uniform tile, which
+                                     * is kept here instead of in the file */
+  gint                 reading;     /* reads in progress, the extent is not
+                                     * freed until they are done */
 } SwapEntry;
 
-typedef struct
+struct _ThreadParams
 {
-  SwapEntry *entry;
-  gint       length;
-  GeglTile  *tile;
-  ThreadOp   operation;
-} ThreadParams;
+  SwapEntry           *entry;
+  gint                 length;
+  gint                 bpp;
+  GeglTile            *tile;
+  GeglTileCompression  compression;
+
+  /* filled in by the writer thread */
+  guint64              offset;
+  guchar              *data;
+  gint                 stored_length;
+};
 
 typedef struct
 {
@@ -88,8 +119,9 @@ typedef struct
 } SwapGap;
 
 
-static void        gegl_tile_backend_swap_push_queue    (ThreadParams *params);
-static void        gegl_tile_backend_swap_write         (ThreadParams *params);
+static gint        gegl_tile_backend_swap_pop_batch     (ThreadParams         **batch);
+static void        gegl_tile_backend_swap_write_batch   (ThreadParams         **batch,
+                                                         gint                   n_params);
 static gpointer    gegl_tile_backend_swap_writer_thread (gpointer ignored);
 static void        gegl_tile_backend_swap_entry_read    (GeglTileBackendSwap   *self,
                                                          SwapEntry             *entry,
@@ -100,12 +132,12 @@ static void        gegl_tile_backend_swap_entry_write   (GeglTileBackendSwap   *
 static SwapEntry * gegl_tile_backend_swap_entry_create  (gint                   x,
                                                          gint                   y,
                                                          gint                   z);
-static guint64     gegl_tile_backend_swap_find_offset   (gint                   tile_size);
-static SwapGap *   gegl_tile_backend_swap_gap_new       (guint64                start,
+static guint64     gegl_tile_backend_swap_find_offset   (guint64                length,
+                                                         guint64                grow);
+static void        gegl_tile_backend_swap_free_extent   (guint64                start,
                                                          guint64                end);
 static void        gegl_tile_backend_swap_entry_destroy (GeglTileBackendSwap   *self,
                                                          SwapEntry             *entry);
-static void        gegl_tile_backend_swap_resize        (guint64 size);
 static SwapEntry * gegl_tile_backend_swap_lookup_entry  (GeglTileBackendSwap   *self,
                                                          gint                   x,
                                                          gint                   y,
@@ -146,191 +178,504 @@ static void        gegl_tile_backend_swap_init          (GeglTileBackendSwap *se
 void               gegl_tile_backend_swap_cleanup       (void);
 
 
-static gchar   *path       = NULL;
-static gint     in_fd      = -1;
-static gint     out_fd     = -1;
-static guint64  in_offset  = 0;
-static guint64  out_offset = 0;
-static GList   *gap_list   = NULL;
-static guint64  total      = 0;
+static gchar   *path          = NULL;
+static gint     in_fd         = -1;
+static gint     out_fd        = -1;
+static guint64  total         = 0;
+static guint64  file_size     = 0;
+#if defined (HAVE_POSIX_FADVISE) && defined (POSIX_FADV_WILLNEED)
+static guint64  read_next     = 0;
+static guint64  read_ahead_to = 0;
+#endif
+
+/* the free extents of the swap file, indexed both by start offset, for
+ * merging neighbours when space is freed, and by size, for finding the
+ * best fitting extent when allocating.
+ */
+static GTree   *gaps_by_start = NULL;
+static GTree   *gaps_by_size  = NULL;
+static GMutex   gap_mutex;
+
+static GThread  *writer_threads[GEGL_SWAP_MAX_WRITER_THREADS];
+static gint      n_writer_threads = 0;
+static GQueue   *queue            = NULL;
+static gboolean  exit_thread      = FALSE;
+static GMutex    mutex;
+static GCond     queue_cond;
+static GCond     written_cond;
+static GCond     read_cond;
+
+/* protects file_size and the read ahead state, and serializes seeking
+ * on systems without positioned I/O
+ */
+static GMutex    io_mutex;
+
+
+static gssize
+gegl_tile_backend_swap_pread (guchar  *dest,
+                              gsize    length,
+                              guint64  offset)
+{
+#ifdef HAVE_PREAD
+  return pread (in_fd, dest, length, offset);
+#else
+  gssize byte_read = -1;
 
-static GThread      *writer_thread = NULL;
-static GQueue       *queue         = NULL;
-static ThreadParams *in_progress   = NULL;
-static gboolean      exit_thread   = FALSE;
-static GMutex        mutex;
-static GCond         queue_cond;
+  g_mutex_lock (&io_mutex);
 
+  if (lseek (in_fd, offset, SEEK_SET) >= 0)
+    byte_read = read (in_fd, dest, length);
 
+  g_mutex_unlock (&io_mutex);
+
+  return byte_read;
+#endif
+}
+
+static gssize
+gegl_tile_backend_swap_pwrite (const guchar *src,
+                               gsize         length,
+                               guint64       offset)
+{
+#ifdef HAVE_PWRITE
+  return pwrite (out_fd, src, length, offset);
+#else
+  gssize wrote = -1;
+
+  g_mutex_lock (&io_mutex);
+
+  if (lseek (out_fd, offset, SEEK_SET) >= 0)
+    wrote = write (out_fd, src, length);
+
+  g_mutex_unlock (&io_mutex);
+
+  return wrote;
+#endif
+}
+
+/* grows the swap file to the allocated size before writing past its end,
+ * the file is grown in steps of several tiles to keep it contiguous.
+ */
 static void
-gegl_tile_backend_swap_push_queue (ThreadParams *params)
+gegl_tile_backend_swap_grow (guint64 end)
 {
-  g_mutex_lock (&mutex);
+  g_mutex_lock (&io_mutex);
 
-  g_queue_push_tail (queue, params);
+  if (end > file_size)
+    {
+      guint64 size;
 
-  if (params->operation == OP_WRITE)
-    params->entry->link = g_queue_peek_tail_link (queue);
+      g_mutex_lock (&gap_mutex);
+      size = MAX (total, end);
+      g_mutex_unlock (&gap_mutex);
 
-  /* wake up the writer thread */
-  g_cond_signal (&queue_cond);
+      if (ftruncate (out_fd, size) != 0)
+        g_warning ("failed to resize swap file: %s", g_strerror (errno));
+      else
+        file_size = size;
+    }
 
-  g_mutex_unlock (&mutex);
+  g_mutex_unlock (&io_mutex);
 }
 
+/* writes a run of tiles which have been placed next to each other in the
+ * file
+ */
 static void
-gegl_tile_backend_swap_write (ThreadParams *params)
+gegl_tile_backend_swap_write_run (ThreadParams **batch,
+                                  gint           n_params)
 {
-  gint    to_be_written = params->length;
-  guint64 offset        = params->entry->offset;
+  guint64 offset        = batch[0]->offset;
+  gsize   to_be_written = 0;
+  gint    i;
+
+  for (i = 0; i < n_params; i++)
+    to_be_written += batch[i]->stored_length;
 
-  if (out_offset != offset)
+#ifdef HAVE_PWRITEV
+  {
+    struct iovec  iov[GEGL_SWAP_MAX_BATCH];
+    struct iovec *first = iov;
+    gint          n_iov = n_params;
+
+    for (i = 0; i < n_params; i++)
+      {
+        iov[i].iov_base = batch[i]->data;
+        iov[i].iov_len  = batch[i]->stored_length;
+      }
+
+    while (to_be_written > 0)
+      {
+        gssize wrote = pwritev (out_fd, first, n_iov, offset);
+
+        if (wrote <= 0)
+          {
+            g_message ("unable to write tile data to swap: "
+                       "%s (%d/%d bytes written)",
+                       g_strerror (errno), (gint) wrote, (gint) to_be_written);
+            break;
+          }
+
+        to_be_written -= wrote;
+        offset        += wrote;
+
+        /* skip what was written of a partial write */
+        while (n_iov > 0 && wrote >= (gssize) first->iov_len)
+          {
+            wrote -= first->iov_len;
+            first++;
+            n_iov--;
+          }
+
+        if (n_iov > 0)
+          {
+            first->iov_base  = (guchar *) first->iov_base + wrote;
+            first->iov_len  -= wrote;
+          }
+      }
+  }
+#else
+  for (i = 0; i < n_params; i++)
     {
-      if (lseek (out_fd, offset, SEEK_SET) < 0)
+      guchar *data    = batch[i]->data;
+      gint    length  = batch[i]->stored_length;
+      gint    written = 0;
+
+      offset = batch[i]->offset;
+
+      while (written < length)
         {
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
-          return;
+          gssize wrote = gegl_tile_backend_swap_pwrite (data + written,
+                                                        length - written,
+                                                        offset + written);
+
+          if (wrote <= 0)
+            {
+              g_message ("unable to write tile data to swap: "
+                         "%s (%d/%d bytes written)",
+                         g_strerror (errno), (gint) wrote, length - written);
+              break;
+            }
+
+          written += wrote;
         }
-      out_offset = offset;
     }
+#endif
+}
+
+/* writes the tiles of a batch, sorted by offset; every run of adjacent
+ * tiles is written with a single syscall
+ */
+static void
+gegl_tile_backend_swap_write_batch (ThreadParams **batch,
+                                    gint           n_params)
+{
+  ThreadParams *last = batch[n_params - 1];
+  gint          first;
+  gint          i;
 
-  while (to_be_written > 0)
+  gegl_tile_backend_swap_grow (last->offset + last->stored_length);
+
+  for (first = 0; first < n_params; first = i)
     {
-      gint wrote;
-      wrote = write (out_fd,
-                     gegl_tile_get_data (params->tile) + params->length
-                     - to_be_written,
-                     to_be_written);
-      if (wrote <= 0)
+      for (i = first + 1;
+           i < n_params &&
+           batch[i]->offset == batch[i - 1]->offset + batch[i - 1]->stored_length;
+           i++);
+
+      gegl_tile_backend_swap_write_run (batch + first, i - first);
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote %i tiles at %i",
+             n_params, (gint) batch[0]->offset);
+}
+
+static gint
+gegl_tile_backend_swap_compare_offset (gconstpointer a,
+                                       gconstpointer b)
+{
+  const ThreadParams *pa = *(ThreadParams * const *) a;
+  const ThreadParams *pb = *(ThreadParams * const *) b;
+
+  if (pa->offset < pb->offset)
+    return -1;
+  else if (pa->offset > pb->offset)
+    return 1;
+
+  return 0;
+}
+
+/* waits for the reads of @entry in progress, so that its extent can be
+ * freed.  Has to be called with mutex held.
+ */
+static void
+gegl_tile_backend_swap_wait_reads (SwapEntry *entry)
+{
+  while (entry->reading)
+    g_cond_wait (&read_cond, &mutex);
+}
+
+/* takes up to GEGL_SWAP_MAX_BATCH writes from the queue, skipping writes
+ * of entries that are being written by another thread, which are picked up
+ * once that write is done.  Has to be called with mutex held.
+ */
+static gint
+gegl_tile_backend_swap_pop_batch (ThreadParams **batch)
+{
+  GList *link     = queue->head;
+  gint   n_params = 0;
+
+  while (link && n_params < GEGL_SWAP_MAX_BATCH)
+    {
+      GList        *next   = link->next;
+      ThreadParams *params = link->data;
+
+      if (! params->entry->writing)
         {
-          g_message ("unable to write tile data to self: "
-                     "%s (%d/%d bytes written)",
-                     g_strerror (errno), wrote, to_be_written);
-          break;
+          g_queue_delete_link (queue, link);
+
+          params->entry->link    = NULL;
+          params->entry->writing = params;
+
+          batch[n_params++] = params;
         }
 
-      to_be_written -= wrote;
-      out_offset    += wrote;
+      link = next;
     }
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "writer thread wrote at %i", (gint)offset);
+  return n_params;
 }
 
 static gpointer
 gegl_tile_backend_swap_writer_thread (gpointer ignored)
 {
+  ThreadParams *batch[GEGL_SWAP_MAX_BATCH];
+  guint64       old_offsets[GEGL_SWAP_MAX_BATCH];
+  gint          old_lengths[GEGL_SWAP_MAX_BATCH];
+
   while (TRUE)
     {
-      ThreadParams *params;
+      gint n_params = 0;
+      gint i;
 
       g_mutex_lock (&mutex);
 
-      while (g_queue_is_empty (queue) && !exit_thread)
+      while (! exit_thread &&
+             ! (n_params = gegl_tile_backend_swap_pop_batch (batch)))
         g_cond_wait (&queue_cond, &mutex);
 
       if (exit_thread)
         {
+          for (i = 0; i < n_params; i++)
+            {
+              batch[i]->entry->writing = NULL;
+              g_queue_push_head (queue, batch[i]);
+              batch[i]->entry->link = g_queue_peek_head_link (queue);
+            }
+
           g_mutex_unlock (&mutex);
           GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "exiting writer thread");
           return NULL;
         }
 
-      params = (ThreadParams *)g_queue_pop_head (queue);
-      if (params->operation == OP_WRITE)
-        {
-          in_progress = params;
-          params->entry->link = NULL;
-        }
-
       g_mutex_unlock (&mutex);
 
-      switch (params->operation)
+      /* compress the tiles, and find them a place each; the best fitting
+       * free extents are reused first, tiles placed where the file grows
+       * end up next to each other
+       */
+      for (i = 0; i < n_params; i++)
         {
-        case OP_WRITE:
-          gegl_tile_backend_swap_write (params);
-          break;
-        case OP_TRUNCATE:
-          if (ftruncate (out_fd, total) != 0)
-            g_warning ("failed to resize swap file: %s", g_strerror (errno));
-          break;
+          ThreadParams *params = batch[i];
+          guchar       *data   = gegl_tile_get_data (params->tile);
+          gsize         compressed_size;
+
+          params->data          = data;
+          params->stored_length = params->length;
+
+          if (params->compression != GEGL_TILE_COMPRESSION_NONE)
+            {
+              guchar *compressed = g_malloc (params->length);
+
+              if (gegl_tile_compress (params->compression, params->bpp,
+                                      data, params->length,
+                                      compressed, &compressed_size))
+                {
+                  params->data          = compressed;
+                  params->stored_length = compressed_size;
+                }
+              else
+                {
+                  g_free (compressed);
+                  params->compression = GEGL_TILE_COMPRESSION_NONE;
+                }
+            }
+
+          params->offset = gegl_tile_backend_swap_find_offset (params->stored_length,
+                                                               32 * params->length);
         }
 
+      qsort (batch, n_params, sizeof (ThreadParams *),
+             gegl_tile_backend_swap_compare_offset);
+
+      gegl_tile_backend_swap_write_batch (batch, n_params);
+
       g_mutex_lock (&mutex);
 
-      in_progress = NULL;
+      for (i = 0; i < n_params; i++)
+        {
+          ThreadParams *params = batch[i];
+          SwapEntry    *entry  = params->entry;
+
+          /* remember the previous place of the tile, to be freed once
+           * nothing reads from it anymore
+           */
+          gegl_tile_backend_swap_wait_reads (entry);
 
-      if (params->operation == OP_WRITE)
-        gegl_tile_unref (params->tile);
+          old_offsets[i] = entry->offset;
+          old_lengths[i] = entry->length;
 
-      g_slice_free (ThreadParams, params);
+          entry->offset      = params->offset;
+          entry->length      = params->stored_length;
+          entry->compression = params->compression;
+          entry->writing     = NULL;
+
+          if (params->data != gegl_tile_get_data (params->tile))
+            g_free (params->data);
+
+          gegl_tile_unref (params->tile);
+          g_slice_free (ThreadParams, params);
+        }
+
+      /* writes skipped for being in progress can be taken now, and
+       * entries waiting to be destroyed can go.
+       */
+      g_cond_broadcast (&queue_cond);
+      g_cond_broadcast (&written_cond);
 
       g_mutex_unlock (&mutex);
+
+      for (i = 0; i < n_params; i++)
+        if (old_lengths[i])
+          gegl_tile_backend_swap_free_extent (old_offsets[i],
+                                              old_offsets[i] + old_lengths[i]);
     }
 
   return NULL;
 }
 
+/* hints the kernel to read ahead when the reads walk the file forward */
+static void
+gegl_tile_backend_swap_read_ahead (guint64 offset,
+                                   gint    length)
+{
+#if defined (HAVE_POSIX_FADVISE) && defined (POSIX_FADV_WILLNEED)
+  gboolean advise = FALSE;
+
+  g_mutex_lock (&io_mutex);
+
+  if (offset == read_next && offset + length >= read_ahead_to)
+    {
+      read_ahead_to = offset + length + (guint64) length * GEGL_SWAP_READ_AHEAD;
+      advise        = TRUE;
+    }
+
+  read_next = offset + length;
+
+  g_mutex_unlock (&io_mutex);
+
+  if (advise)
+    posix_fadvise (in_fd, offset + length,
+                   (off_t) length * GEGL_SWAP_READ_AHEAD, POSIX_FADV_WILLNEED);
+#endif
+}
+
 static void
 gegl_tile_backend_swap_entry_read (GeglTileBackendSwap *self,
                                    SwapEntry           *entry,
                                    guchar              *dest)
 {
-  gint    tile_size  = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-  gint    to_be_read = tile_size;
-  guint64 offset     = entry->offset;
+  GeglTileBackend     *backend   = GEGL_TILE_BACKEND (self);
+  gint                 tile_size = gegl_tile_backend_get_tile_size (backend);
+  gint                 length;
+  gint                 to_be_read;
+  guint64              offset;
+  GeglTileCompression  compression;
+  guchar              *buf;
 
   gegl_tile_backend_swap_ensure_exist ();
 
-  if (entry->link || in_progress)
+  g_mutex_lock (&mutex);
+
+  if (entry->link || entry->writing)
     {
-      ThreadParams *queued_op = NULL;
-      g_mutex_lock (&mutex);
+      ThreadParams *queued_op;
 
+      /* a queued write is newer than one in progress */
       if (entry->link)
         queued_op = entry->link->data;
-      else if (in_progress && in_progress->entry == entry)
-        queued_op = in_progress;
-
-      if (queued_op)
-        {
-          memcpy (dest, gegl_tile_get_data (queued_op->tile), to_be_read);
-          g_mutex_unlock (&mutex);
+      else
+        queued_op = entry->writing;
 
-          GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from queue", entry->x, entry->y, entry->z);
+      memcpy (dest, gegl_tile_get_data (queued_op->tile), tile_size);
+      g_mutex_unlock (&mutex);
 
-          return;
-        }
+      GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from queue", entry->x, entry->y, entry->z);
 
-      g_mutex_unlock (&mutex);
+      return;
     }
 
-  if (in_offset != offset)
-    {
-      if (lseek (in_fd, offset, SEEK_SET) < 0)
-        {
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
-          return;
-        }
-      in_offset = offset;
-    }
+  offset      = entry->offset;
+  length      = entry->length;
+  compression = entry->compression;
+
+  /* keeps the extent from being freed, and reused, while it is read */
+  entry->reading++;
+
+  g_mutex_unlock (&mutex);
+
+  gegl_tile_backend_swap_read_ahead (offset, length);
+
+  if (compression == GEGL_TILE_COMPRESSION_NONE)
+    buf = dest;
+  else
+    buf = g_malloc (length);
+
+  to_be_read = length;
 
   while (to_be_read > 0)
     {
-      GError *error = NULL;
-      gint    byte_read;
+      gssize byte_read;
 
-      byte_read = read (in_fd, dest + tile_size - to_be_read, to_be_read);
+      byte_read = gegl_tile_backend_swap_pread (buf + length - to_be_read,
+                                                to_be_read,
+                                                offset + length - to_be_read);
       if (byte_read <= 0)
         {
           g_message ("unable to read tile data from swap: "
-                     "%s (%d/%d bytes read) %s",
-                     g_strerror (errno), byte_read, to_be_read, error?error->message:"--");
-          return;
+                     "%s (%d/%d bytes read)",
+                     g_strerror (errno), (gint) byte_read, to_be_read);
+          break;
         }
       to_be_read -= byte_read;
-      in_offset  += byte_read;
     }
 
+  if (buf != dest)
+    {
+      if (to_be_read == 0 &&
+          ! gegl_tile_decompress (compression,
+                                  babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (backend)),
+                                  buf, length, dest, tile_size))
+        g_warning ("corrupt compressed tile data in swap");
+
+      g_free (buf);
+    }
+
+  g_mutex_lock (&mutex);
+  if (--entry->reading == 0)
+    g_cond_broadcast (&read_cond);
+  g_mutex_unlock (&mutex);
+
   GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "read entry %i, %i, %i from %i", entry->x, entry->y, entry->z, (gint)offset);
 }
 
@@ -344,34 +689,36 @@ gegl_tile_backend_swap_entry_write (GeglTileBackendSwap *self,
 
   gegl_tile_backend_swap_ensure_exist ();
 
+  g_mutex_lock (&mutex);
+
   if (entry->link)
     {
-      g_mutex_lock (&mutex);
+      params = entry->link->data;
+      gegl_tile_unref (params->tile);
+      params->tile = gegl_tile_dup (tile);
+      g_mutex_unlock (&mutex);
 
-      if (entry->link)
-        {
-          params = entry->link->data;
-          gegl_tile_unref (params->tile);
-          params->tile = gegl_tile_dup (tile);
-          g_mutex_unlock (&mutex);
+      GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "tile %i, %i, %i is already enqueued, changed data", entry->x, entry->y, entry->z);
 
-          GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "tile %i, %i, %i at %i is already enqueued, changed data", entry->x, entry->y, entry->z, (gint)entry->offset);
+      return;
+    }
 
-          return;
-        }
+  params              = g_slice_new0 (ThreadParams);
+  params->length      = length;
+  params->bpp         = babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (GEGL_TILE_BACKEND (self)));
+  params->tile        = gegl_tile_dup (tile);
+  params->entry       = entry;
+  params->compression = gegl_config ()->swap_compression;
 
-      g_mutex_unlock (&mutex);
-    }
+  g_queue_push_tail (queue, params);
+  entry->link = g_queue_peek_tail_link (queue);
 
-  params            = g_slice_new0 (ThreadParams);
-  params->operation = OP_WRITE;
-  params->length    = length;
-  params->tile      = gegl_tile_dup (tile);
-  params->entry     = entry;
+  /* wake up a writer thread */
+  g_cond_signal (&queue_cond);
 
-  gegl_tile_backend_swap_push_queue (params);
+  g_mutex_unlock (&mutex);
 
-  GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "pushed write of entry %i, %i, %i at %i", entry->x, entry->y, entry->z, (gint)entry->offset);
+  GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "pushed write of entry %i, %i, %i", entry->x, entry->y, entry->z);
 }
 
 static SwapEntry *
@@ -381,191 +728,301 @@ gegl_tile_backend_swap_entry_create (gint x,
 {
   SwapEntry *entry = g_slice_new0 (SwapEntry);
 
-  entry->x    = x;
-  entry->y    = y;
-  entry->z    = z;
-  entry->link = NULL;
+  entry->x           = x;
+  entry->y           = y;
+  entry->z           = z;
+  entry->length      = 0;
+  entry->compression = GEGL_TILE_COMPRESSION_NONE;
+  entry->link        = NULL;
+  entry->writing     = NULL;
 
   return entry;
 }
 
-static guint64
-gegl_tile_backend_swap_find_offset (gint tile_size)
+static gint
+gegl_tile_backend_swap_gap_compare_start (gconstpointer a,
+                                          gconstpointer b)
 {
-  SwapGap *gap;
-  guint64  offset;
+  const SwapGap *ga = a;
+  const SwapGap *gb = b;
 
-  if (gap_list)
-    {
-      GList *link = gap_list;
+  if (ga->start < gb->start)
+    return -1;
+  else if (ga->start > gb->start)
+    return 1;
 
-      while (link)
-        {
-          guint64 length;
+  return 0;
+}
 
-          gap    = link->data;
-          length = gap->end - gap->start;
+static gint
+gegl_tile_backend_swap_gap_compare_size (gconstpointer a,
+                                         gconstpointer b)
+{
+  const SwapGap *ga = a;
+  const SwapGap *gb = b;
+  guint64        la = ga->end - ga->start;
+  guint64        lb = gb->end - gb->start;
 
-          if (length > tile_size)
-            {
-              offset = gap->start;
-              gap->start += tile_size;
+  if (la < lb)
+    return -1;
+  else if (la > lb)
+    return 1;
 
-              return offset;
-            }
-          else if (length == tile_size)
-            {
-              offset = gap->start;
-              g_slice_free (SwapGap, gap);
-              gap_list = g_list_delete_link (gap_list, link);
+  return gegl_tile_backend_swap_gap_compare_start (a, b);
+}
 
-              return offset;
-            }
+/* g_tree_search() functions locating the gap ending, or starting, at
+ * the given offset
+ */
+static gint
+gegl_tile_backend_swap_gap_search_end (gconstpointer key,
+                                       gconstpointer data)
+{
+  const SwapGap *gap    = key;
+  guint64        offset = *(const guint64 *) data;
 
-          link = link->next;
-        }
-    }
+  if (offset < gap->end)
+    return -1;
+  else if (offset > gap->end)
+    return 1;
 
-  offset = total;
+  return 0;
+}
 
-  gegl_tile_backend_swap_resize (total + 32 * tile_size);
+static gint
+gegl_tile_backend_swap_gap_search_start (gconstpointer key,
+                                         gconstpointer data)
+{
+  const SwapGap *gap    = key;
+  guint64        offset = *(const guint64 *) data;
 
-  gap = gegl_tile_backend_swap_gap_new (offset + tile_size, total);
-  gap_list = g_list_append (gap_list, gap);
+  if (offset < gap->start)
+    return -1;
+  else if (offset > gap->start)
+    return 1;
 
-  return offset;
+  return 0;
 }
 
-static SwapGap *
-gegl_tile_backend_swap_gap_new (guint64 start,
-                                guint64 end)
+typedef struct
+{
+  guint64  length;
+  SwapGap *gap;
+} GapSearch;
+
+/* descends towards the smallest gap that is large enough, remembering it
+ * on the way since g_tree_search() only returns exact matches.
+ */
+static gint
+gegl_tile_backend_swap_gap_search_fit (gconstpointer key,
+                                       gconstpointer data)
+{
+  const SwapGap *gap    = key;
+  GapSearch     *search = (GapSearch *) data;
+
+  if (gap->end - gap->start >= search->length)
+    {
+      search->gap = (SwapGap *) gap;
+      return -1;
+    }
+
+  return 1;
+}
+
+static void
+gegl_tile_backend_swap_gap_insert (guint64 start,
+                                   guint64 end)
 {
   SwapGap *gap = g_slice_new (SwapGap);
 
   gap->start = start;
-  gap->end = end;
+  gap->end   = end;
 
-  return gap;
+  g_tree_insert (gaps_by_start, gap, gap);
+  g_tree_insert (gaps_by_size, gap, gap);
 }
 
 static void
-gegl_tile_backend_swap_entry_destroy (GeglTileBackendSwap *self,
-                                      SwapEntry           *entry)
+gegl_tile_backend_swap_gap_remove (SwapGap *gap)
 {
-  guint64  start, end;
-  gint     tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-  GList   *hlink;
+  g_tree_remove (gaps_by_size, gap);
+  g_tree_remove (gaps_by_start, gap);
 
-  if (entry->link)
+  g_slice_free (SwapGap, gap);
+}
+
+/* allocates @length bytes of the swap file, growing it by at least @grow
+ * bytes when no free extent is large enough
+ */
+static guint64
+gegl_tile_backend_swap_find_offset (guint64 length,
+                                    guint64 grow)
+{
+  GapSearch search = {length, NULL};
+  guint64   offset;
+
+  g_mutex_lock (&gap_mutex);
+
+  g_tree_search (gaps_by_size, gegl_tile_backend_swap_gap_search_fit, &search);
+
+  if (search.gap)
     {
-      GList *link;
+      SwapGap *gap = search.gap;
 
-      g_mutex_lock (&mutex);
+      offset = gap->start;
 
-      if ((link = entry->link))
+      if (gap->end - gap->start == length)
         {
-          ThreadParams *queued_op = link->data;
-          g_queue_delete_link (queue, link);
-          gegl_tile_unref (queued_op->tile);
-          g_slice_free (ThreadParams, queued_op);
+          gegl_tile_backend_swap_gap_remove (gap);
         }
+      else
+        {
+          /* shrinking a gap from below keeps its place in the start
+           * ordered tree, but it has to be moved in the size ordered one
+           */
+          g_tree_remove (gaps_by_size, gap);
+          gap->start += length;
+          g_tree_insert (gaps_by_size, gap, gap);
+        }
+    }
+  else
+    {
+      offset = total;
+      total += MAX (length, grow);
 
-      g_mutex_unlock (&mutex);
+      if (offset + length < total)
+        gegl_tile_backend_swap_gap_insert (offset + length, total);
+
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "grew swap to %i", (gint)total);
     }
 
-  start = entry->offset;
-  end = start + tile_size;
+  g_mutex_unlock (&gap_mutex);
 
-  if ((hlink = gap_list))
-    while (hlink)
-      {
-        GList *llink = hlink->prev;
-        SwapGap *lgap, *hgap;
+  return offset;
+}
 
-        if (llink)
-          lgap = llink->data;
+static void
+gegl_tile_backend_swap_free_extent (guint64 start,
+                                    guint64 end)
+{
+  SwapGap *lower;
+  SwapGap *upper;
 
-        hgap = hlink->data;
+  g_mutex_lock (&gap_mutex);
 
-        /* attempt to merge lower, upper and this gap */
-        if (llink != NULL && lgap->end == start &&
-            hgap->start == end)
-          {
-            llink->next = hlink->next;
-            if (hlink->next)
-              hlink->next->prev = llink;
-            lgap->end = hgap->end;
-
-            g_slice_free (SwapGap, hgap);
-            hlink->next = NULL;
-            hlink->prev = NULL;
-            g_list_free (hlink);
-            break;
-          }
-        /* attempt to merge with upper gap */
-        else if (hgap->start == end)
-          {
-            hgap->start = start;
-            break;
-          }
-        /* attempt to merge with lower gap */
-        else if (llink != NULL && lgap->end == start)
-          {
-            lgap->end = end;
-            break;
-          }
-        /* create new gap */
-        else if (hgap->start > end)
-          {
-            lgap = gegl_tile_backend_swap_gap_new (start, end);
-            gap_list = g_list_insert_before (gap_list, hlink, lgap);
-            break;
-          }
+  lower = g_tree_search (gaps_by_start, gegl_tile_backend_swap_gap_search_end, &start);
+  upper = g_tree_search (gaps_by_start, gegl_tile_backend_swap_gap_search_start, &end);
 
-        /* if there's no more elements in the list after this */
-        else if (hlink->next == NULL)
-          {
-            /* attempt to merge with the last gap */
-            if (hgap->end == start)
-              {
-                hgap->end = end;
-              }
-            /* create a new gap in the end of the list */
-            else
-              {
-                GList *new_link;
-                hgap = gegl_tile_backend_swap_gap_new (start, end);
-                new_link = g_list_alloc ();
-                new_link->next = NULL;
-                new_link->prev = hlink;
-                new_link->data = hgap;
-                hlink->next = new_link;
-              }
-            break;
-          }
+  if (lower && upper)
+    {
+      end = upper->end;
+      gegl_tile_backend_swap_gap_remove (upper);
 
-        hlink = hlink->next;
-      }
+      g_tree_remove (gaps_by_size, lower);
+      lower->end = end;
+      g_tree_insert (gaps_by_size, lower, lower);
+    }
+  else if (lower)
+    {
+      g_tree_remove (gaps_by_size, lower);
+      lower->end = end;
+      g_tree_insert (gaps_by_size, lower, lower);
+    }
+  else if (upper)
+    {
+      /* growing a gap downwards into the freed space keeps its place
+       * in the start ordered tree
+       */
+      g_tree_remove (gaps_by_size, upper);
+      upper->start = start;
+      g_tree_insert (gaps_by_size, upper, upper);
+    }
   else
-    gap_list = g_list_prepend (NULL,
-                               gegl_tile_backend_swap_gap_new (start, end));
+    {
+      gegl_tile_backend_swap_gap_insert (start, end);
+    }
+
+  g_mutex_unlock (&gap_mutex);
+}
+
+static void
+gegl_tile_backend_swap_entry_destroy (GeglTileBackendSwap *self,
+                                      SwapEntry           *entry)
+{
+  g_mutex_lock (&mutex);
+
+  if (entry->link)
+    {
+      ThreadParams *queued_op = entry->link->data;
+
+      g_queue_delete_link (queue, entry->link);
+      gegl_tile_unref (queued_op->tile);
+      g_slice_free (ThreadParams, queued_op);
+
+      entry->link = NULL;
+    }
+
+  /* the space can not be reused while it is still being written to, or
+   * read from
+   */
+  while (entry->writing)
+    g_cond_wait (&written_cond, &mutex);
+
+  gegl_tile_backend_swap_wait_reads (entry);
+
+  g_mutex_unlock (&mutex);
+
+  if (entry->length)
+    gegl_tile_backend_swap_free_extent (entry->offset, entry->offset + entry->length);
+
+  g_free (entry->uniform);
 
   g_hash_table_remove (self->index, entry);
   g_slice_free (SwapEntry, entry);
 }
 
+/* keeps the pixel of a uniform tile in the entry, dropping what was
+ * written or queued for it
+ */
 static void
-gegl_tile_backend_swap_resize (guint64 size)
+gegl_tile_backend_swap_entry_write_uniform (GeglTileBackendSwap *self,
+                                            SwapEntry           *entry,
+                                            GeglTile            *tile)
 {
-  ThreadParams *params;
+  gint bpp = babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (GEGL_TILE_BACKEND (self)));
+
+  g_mutex_lock (&mutex);
 
-  total = size;
-  params = g_slice_new0 (ThreadParams);
-  params->operation = OP_TRUNCATE;
+  if (entry->link)
+    {
+      ThreadParams *queued_op = entry->link->data;
 
-  gegl_tile_backend_swap_push_queue (params);
+      g_queue_delete_link (queue, entry->link);
+      gegl_tile_unref (queued_op->tile);
+      g_slice_free (ThreadParams, queued_op);
+
+      entry->link = NULL;
+    }
 
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "pushed resize to %i", (gint)total);
+  while (entry->writing)
+    g_cond_wait (&written_cond, &mutex);
+
+  gegl_tile_backend_swap_wait_reads (entry);
+
+  g_mutex_unlock (&mutex);
+
+  if (entry->length)
+    {
+      gegl_tile_backend_swap_free_extent (entry->offset, entry->offset + entry->length);
+      entry->length = 0;
+    }
+
+  if (! entry->uniform)
+    entry->uniform = g_malloc (bpp);
+
+  memcpy (entry->uniform, gegl_tile_get_data (tile), bpp);
+
+  GEGL_NOTE(GEGL_DEBUG_TILE_BACKEND, "kept uniform entry %i, %i, %i", entry->x, entry->y, entry->z);
 }
 
 static SwapEntry *
@@ -574,7 +1031,7 @@ gegl_tile_backend_swap_lookup_entry (GeglTileBackendSwap *self,
                                      gint                 y,
                                      gint                 z)
 {
-  SwapEntry key = {0, NULL, x, y, z};
+  SwapEntry key = {0, 0, GEGL_TILE_COMPRESSION_NONE, NULL, NULL, x, y, z};
 
   return g_hash_table_lookup (self->index, &key);
 }
@@ -597,7 +1054,18 @@ gegl_tile_backend_swap_get_tile (GeglTileSource *self,
     return NULL;
 
   tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
-  tile      = gegl_tile_new (tile_size);
+
+  if (entry->uniform)
+    {
+      gint bpp = babl_format_get_bytes_per_pixel (gegl_tile_backend_get_format (GEGL_TILE_BACKEND (self)));
+
+      tile = gegl_tile_new_uniform (tile_size, entry->uniform, bpp);
+      gegl_tile_mark_as_stored (tile);
+
+      return tile;
+    }
+
+  tile = gegl_tile_new (tile_size);
   gegl_tile_mark_as_stored (tile);
 
   gegl_tile_backend_swap_entry_read (tile_backend_swap, entry, gegl_tile_get_data (tile));
@@ -624,12 +1092,19 @@ gegl_tile_backend_swap_set_tile (GeglTileSource *self,
 
   if (entry == NULL)
     {
-      entry          = gegl_tile_backend_swap_entry_create (x, y, z);
-      entry->offset  = gegl_tile_backend_swap_find_offset (gegl_tile_backend_get_tile_size (backend));
+      entry = gegl_tile_backend_swap_entry_create (x, y, z);
       g_hash_table_insert (tile_backend_swap->index, entry, entry);
     }
 
-  gegl_tile_backend_swap_entry_write (tile_backend_swap, entry, tile);
+  if (gegl_tile_is_uniform (tile))
+    {
+      gegl_tile_backend_swap_entry_write_uniform (tile_backend_swap, entry, tile);
+    }
+  else
+    {
+      g_clear_pointer (&entry->uniform, g_free);
+      gegl_tile_backend_swap_entry_write (tile_backend_swap, entry, tile);
+    }
 
   gegl_tile_mark_as_stored (tile);
 
@@ -808,10 +1283,21 @@ gegl_tile_backend_swap_ensure_exist (void)
     }
 }
 
+static gboolean
+gegl_tile_backend_swap_gap_free (gpointer key,
+                                 gpointer value,
+                                 gpointer data)
+{
+  g_slice_free (SwapGap, key);
+
+  return FALSE;
+}
+
 static void
 gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  gint          i;
 
   parent_class = g_type_class_peek_parent (klass);
 
@@ -819,40 +1305,61 @@ gegl_tile_backend_swap_class_init (GeglTileBackendSwapClass *klass)
   gobject_class->finalize     = gegl_tile_backend_swap_finalize;
 
   queue         = g_queue_new ();
-  writer_thread = g_thread_new ("swap writer",
-                                gegl_tile_backend_swap_writer_thread,
-                                NULL);
+  gaps_by_start = g_tree_new (gegl_tile_backend_swap_gap_compare_start);
+  gaps_by_size  = g_tree_new (gegl_tile_backend_swap_gap_compare_size);
+
+  n_writer_threads = CLAMP (gegl_config_threads () / 2,
+                            1, GEGL_SWAP_MAX_WRITER_THREADS);
+
+  for (i = 0; i < n_writer_threads; i++)
+    writer_threads[i] = g_thread_new ("swap writer",
+                                      gegl_tile_backend_swap_writer_thread,
+                                      NULL);
 }
 
 void
 gegl_tile_backend_swap_cleanup (void)
 {
+  gint i;
+
+  /* the writer threads are started with the class, whether or not a swap
+   * file was ever opened
+   */
+  g_mutex_lock (&mutex);
+  exit_thread = TRUE;
+  g_cond_broadcast (&queue_cond);
+  g_mutex_unlock (&mutex);
+
+  for (i = 0; i < n_writer_threads; i++)
+    g_thread_join (writer_threads[i]);
+
+  n_writer_threads = 0;
+
   if (in_fd != -1 && out_fd != -1)
     {
-      exit_thread = TRUE;
-      g_cond_signal (&queue_cond);
-      g_thread_join (writer_thread);
-
       if (g_queue_get_length (queue) != 0)
         g_warning ("tile-backend-swap writer queue wasn't empty before freeing\n");
 
       g_queue_free (queue);
 
-      if (gap_list)
-        {
-          SwapGap *gap = gap_list->data;
+      if (g_tree_nnodes (gaps_by_start) > 1)
+        g_warning ("tile-backend-swap free extent tree had more than one element\n");
 
-          if (gap_list->next)
-            g_warning ("tile-backend-swap gap list had more than one element\n");
+      if (g_tree_nnodes (gaps_by_start) == 1)
+        {
+          GapSearch search = {0, NULL};
 
-          g_warn_if_fail (gap->start == 0 && gap->end == total);
+          g_tree_search (gaps_by_size, gegl_tile_backend_swap_gap_search_fit, &search);
 
-          g_slice_free (SwapGap, gap_list->data);
-          g_list_free (gap_list);
+          g_warn_if_fail (search.gap->start == 0 && search.gap->end == total);
         }
-      else
+      else if (g_tree_nnodes (gaps_by_start) == 0)
         g_warn_if_fail (total == 0);
 
+      g_tree_foreach (gaps_by_start, gegl_tile_backend_swap_gap_free, NULL);
+      g_tree_destroy (gaps_by_start);
+      g_tree_destroy (gaps_by_size);
+
       close (in_fd);
       close (out_fd);
 
@@ -0,0 +1,566 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "gegl-tile-compression.h"
+
+/* All codecs work on the tile with its bytes regrouped into planes, the
+ * first byte of every pixel, then the second and so on.  Flat areas then
+ * turn into long runs, and so do the low mantissa bytes of float pixels
+ * holding 8 bit data.
+ */
+
+/* runs of 3 to 130 repeated bytes, and literal runs of 1 to 128 bytes */
+#define RLE_MIN_RUN      3
+#define RLE_MAX_RUN      (0x7f + RLE_MIN_RUN)
+#define RLE_MAX_LITERAL  0x80
+
+#define LZ_HASH_BITS     12
+#define LZ_MIN_MATCH     4
+#define LZ_MAX_OFFSET    0xffff
+
+static GMutex  stats_mutex;
+static guint64 input_bytes  = 0;
+static guint64 output_bytes = 0;
+
+
+static void
+shuffle (const guchar *src,
+         guchar       *dst,
+         gsize         size,
+         gint          bpp)
+{
+  gsize n_pixels = size / bpp;
+  gsize i;
+  gint  b;
+
+  for (b = 0; b < bpp; b++)
+    {
+      const guchar *s = src + b;
+      guchar       *d = dst + b * n_pixels;
+
+      for (i = 0; i < n_pixels; i++, s += bpp)
+        d[i] = *s;
+    }
+
+  memcpy (dst + n_pixels * bpp, src + n_pixels * bpp, size - n_pixels * bpp);
+}
+
+static void
+unshuffle (const guchar *src,
+           guchar       *dst,
+           gsize         size,
+           gint          bpp)
+{
+  gsize n_pixels = size / bpp;
+  gsize i;
+  gint  b;
+
+  for (b = 0; b < bpp; b++)
+    {
+      const guchar *s = src + b * n_pixels;
+      guchar       *d = dst + b;
+
+      for (i = 0; i < n_pixels; i++, d += bpp)
+        *d = s[i];
+    }
+
+  memcpy (dst + n_pixels * bpp, src + n_pixels * bpp, size - n_pixels * bpp);
+}
+
+static gboolean
+rle_compress (const guchar *src,
+              gsize         size,
+              guchar       *dst,
+              gsize         max_size,
+              gsize        *out_size)
+{
+  guchar *out     = dst;
+  guchar *out_end = dst + max_size;
+  gsize   i       = 0;
+
+  while (i < size)
+    {
+      gsize run = 1;
+
+      while (i + run < size && run < RLE_MAX_RUN && src[i + run] == src[i])
+        run++;
+
+      if (run >= RLE_MIN_RUN)
+        {
+          if (out + 2 > out_end)
+            return FALSE;
+
+          *out++ = 0x80 | (run - RLE_MIN_RUN);
+          *out++ = src[i];
+          i += run;
+        }
+      else
+        {
+          gsize start = i;
+          gsize length;
+
+          /* extend the literal up to the next run worth encoding */
+          while (i < size && i - start < RLE_MAX_LITERAL)
+            {
+              if (i + 2 < size &&
+                  src[i] == src[i + 1] && src[i] == src[i + 2])
+                break;
+              i++;
+            }
+
+          length = i - start;
+
+          if (out + 1 + length > out_end)
+            return FALSE;
+
+          *out++ = length - 1;
+          memcpy (out, src + start, length);
+          out += length;
+        }
+    }
+
+  *out_size = out - dst;
+
+  return TRUE;
+}
+
+static gboolean
+rle_decompress (const guchar *src,
+                gsize         size,
+                guchar       *dst,
+                gsize         dst_size)
+{
+  const guchar *in      = src;
+  const guchar *in_end  = src + size;
+  guchar       *out     = dst;
+  guchar       *out_end = dst + dst_size;
+
+  while (in < in_end)
+    {
+      guchar control = *in++;
+
+      if (control & 0x80)
+        {
+          gsize run = (control & 0x7f) + RLE_MIN_RUN;
+
+          if (in >= in_end || out + run > out_end)
+            return FALSE;
+
+          memset (out, *in++, run);
+          out += run;
+        }
+      else
+        {
+          gsize length = control + 1;
+
+          if (in + length > in_end || out + length > out_end)
+            return FALSE;
+
+          memcpy (out, in, length);
+          in  += length;
+          out += length;
+        }
+    }
+
+  return out == out_end;
+}
+
+static inline guint32
+lz_read32 (const guchar *p)
+{
+  guint32 v;
+
+  memcpy (&v, p, sizeof (v));
+
+  return v;
+}
+
+static inline guint
+lz_hash (guint32 v)
+{
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* writes the part of a length that does not fit its 4 bit field */
+static inline guchar *
+lz_write_length (guchar *out,
+                 guchar *out_end,
+                 gsize   length)
+{
+  while (length >= 255)
+    {
+      if (out >= out_end)
+        return NULL;
+
+      *out++  = 255;
+      length -= 255;
+    }
+
+  if (out >= out_end)
+    return NULL;
+
+  *out++ = length;
+
+  return out;
+}
+
+static inline const guchar *
+lz_read_length (const guchar *in,
+                const guchar *in_end,
+                gsize        *length)
+{
+  guchar c;
+
+  do
+    {
+      if (in >= in_end)
+        return NULL;
+
+      c        = *in++;
+      *length += c;
+    }
+  while (c == 255);
+
+  return in;
+}
+
+/* emits a sequence of literals, followed by a match unless @match_length
+ * is 0, which ends the stream
+ */
+static guchar *
+lz_write_sequence (guchar       *out,
+                   guchar       *out_end,
+                   const guchar *literals,
+                   gsize         n_literals,
+                   gsize         offset,
+                   gsize         match_length)
+{
+  gsize lit_field   = MIN (n_literals, 15);
+  gsize match_field = match_length ? MIN (match_length - LZ_MIN_MATCH, 15) : 0;
+
+  if (out >= out_end)
+    return NULL;
+
+  *out++ = (lit_field << 4) | match_field;
+
+  if (lit_field == 15 &&
+      ! (out = lz_write_length (out, out_end, n_literals - 15)))
+    return NULL;
+
+  if (out + n_literals > out_end)
+    return NULL;
+
+  memcpy (out, literals, n_literals);
+  out += n_literals;
+
+  if (! match_length)
+    return out;
+
+  if (out + 2 > out_end)
+    return NULL;
+
+  *out++ = offset & 0xff;
+  *out++ = offset >> 8;
+
+  if (match_field == 15 &&
+      ! (out = lz_write_length (out, out_end, match_length - LZ_MIN_MATCH - 15)))
+    return NULL;
+
+  return out;
+}
+
+static gboolean
+lz_compress (const guchar *src,
+             gsize         size,
+             guchar       *dst,
+             gsize         max_size,
+             gsize        *out_size)
+{
+  gint    table[1 << LZ_HASH_BITS];
+  guchar *out     = dst;
+  guchar *out_end = dst + max_size;
+  gsize   anchor  = 0;
+  gsize   i       = 0;
+
+  memset (table, 0xff, sizeof (table));
+
+  while (i + LZ_MIN_MATCH <= size)
+    {
+      guint32 v   = lz_read32 (src + i);
+      guint   h   = lz_hash (v);
+      gint    ref = table[h];
+
+      table[h] = i;
+
+      if (ref >= 0 && i - ref <= LZ_MAX_OFFSET &&
+          lz_read32 (src + ref) == v)
+        {
+          gsize length = LZ_MIN_MATCH;
+
+          while (i + length < size && src[ref + length] == src[i + length])
+            length++;
+
+          out = lz_write_sequence (out, out_end, src + anchor, i - anchor,
+                                   i - ref, length);
+          if (! out)
+            return FALSE;
+
+          i     += length;
+          anchor = i;
+        }
+      else
+        {
+          i++;
+        }
+    }
+
+  out = lz_write_sequence (out, out_end, src + anchor, size - anchor, 0, 0);
+  if (! out)
+    return FALSE;
+
+  *out_size = out - dst;
+
+  return TRUE;
+}
+
+static gboolean
+lz_decompress (const guchar *src,
+               gsize         size,
+               guchar       *dst,
+               gsize         dst_size)
+{
+  const guchar *in      = src;
+  const guchar *in_end  = src + size;
+  guchar       *out     = dst;
+  guchar       *out_end = dst + dst_size;
+
+  while (TRUE)
+    {
+      guchar  token;
+      gsize   n_literals;
+      gsize   length;
+      gsize   offset;
+      guchar *ref;
+
+      if (in >= in_end)
+        return FALSE;
+
+      token      = *in++;
+      n_literals = token >> 4;
+
+      if (n_literals == 15 && ! (in = lz_read_length (in, in_end, &n_literals)))
+        return FALSE;
+
+      if (in + n_literals > in_end || out + n_literals > out_end)
+        return FALSE;
+
+      memcpy (out, in, n_literals);
+      in  += n_literals;
+      out += n_literals;
+
+      if (out == out_end)
+        return in == in_end;
+
+      if (in + 2 > in_end)
+        return FALSE;
+
+      offset = in[0] | (in[1] << 8);
+      in += 2;
+
+      length = token & 0x0f;
+
+      if (length == 15 && ! (in = lz_read_length (in, in_end, &length)))
+        return FALSE;
+
+      length += LZ_MIN_MATCH;
+
+      if (offset == 0 || offset > (gsize) (out - dst) || out + length > out_end)
+        return FALSE;
+
+      /* matches may overlap their own output */
+      ref = out - offset;
+      while (length--)
+        *out++ = *ref++;
+    }
+}
+
+static gboolean
+zlib_convert (GConverter   *converter,
+              const guchar *src,
+              gsize         size,
+              guchar       *dst,
+              gsize         max_size,
+              gsize        *out_size)
+{
+  GConverterResult result;
+  gsize            bytes_read;
+  gsize            bytes_written;
+
+  result = g_converter_convert (converter, src, size, dst, max_size,
+                                G_CONVERTER_INPUT_AT_END,
+                                &bytes_read, &bytes_written, NULL);
+
+  if (result != G_CONVERTER_FINISHED || bytes_read != size)
+    return FALSE;
+
+  *out_size = bytes_written;
+
+  return TRUE;
+}
+
+gboolean
+gegl_tile_compress (GeglTileCompression  compression,
+                    gint                 bpp,
+                    const guchar        *data,
+                    gsize                size,
+                    guchar              *compressed,
+                    gsize               *compressed_size)
+{
+  guchar   *shuffled;
+  gboolean  success = FALSE;
+
+  if (compression == GEGL_TILE_COMPRESSION_NONE || size == 0)
+    return FALSE;
+
+  shuffled = g_malloc (size);
+  shuffle (data, shuffled, size, MAX (bpp, 1));
+
+  /* leave at least a byte of gain, or the tile is better stored as is */
+  switch (compression)
+    {
+      case GEGL_TILE_COMPRESSION_RLE:
+        success = rle_compress (shuffled, size, compressed, size - 1,
+                                compressed_size);
+        break;
+
+      case GEGL_TILE_COMPRESSION_FAST:
+        success = lz_compress (shuffled, size, compressed, size - 1,
+                               compressed_size);
+        break;
+
+      case GEGL_TILE_COMPRESSION_ZLIB:
+        {
+          GZlibCompressor *compressor;
+
+          compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, 6);
+          success = zlib_convert (G_CONVERTER (compressor), shuffled, size,
+                                  compressed, size - 1, compressed_size);
+          g_object_unref (compressor);
+        }
+        break;
+
+      default:
+        break;
+    }
+
+  g_free (shuffled);
+
+  g_mutex_lock (&stats_mutex);
+  input_bytes  += size;
+  output_bytes += success ? *compressed_size : size;
+  g_mutex_unlock (&stats_mutex);
+
+  return success;
+}
+
+gboolean
+gegl_tile_decompress (GeglTileCompression  compression,
+                      gint                 bpp,
+                      const guchar        *compressed,
+                      gsize                compressed_size,
+                      guchar              *data,
+                      gsize                size)
+{
+  guchar   *shuffled;
+  gboolean  success = FALSE;
+
+  shuffled = g_malloc (size);
+
+  switch (compression)
+    {
+      case GEGL_TILE_COMPRESSION_RLE:
+        success = rle_decompress (compressed, compressed_size, shuffled, size);
+        break;
+
+      case GEGL_TILE_COMPRESSION_FAST:
+        success = lz_decompress (compressed, compressed_size, shuffled, size);
+        break;
+
+      case GEGL_TILE_COMPRESSION_ZLIB:
+        {
+          GZlibDecompressor *decompressor;
+          gsize              decompressed_size = 0;
+
+          decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+          success = zlib_convert (G_CONVERTER (decompressor),
+                                  compressed, compressed_size,
+                                  shuffled, size, &decompressed_size) &&
+                    decompressed_size == size;
+          g_object_unref (decompressor);
+        }
+        break;
+
+      default:
+        break;
+    }
+
+  if (success)
+    unshuffle (shuffled, data, size, MAX (bpp, 1));
+
+  g_free (shuffled);
+
+  return success;
+}
+
+guint64
+gegl_tile_compression_get_input_bytes (void)
+{
+  guint64 bytes;
+
+  g_mutex_lock (&stats_mutex);
+  bytes = input_bytes;
+  g_mutex_unlock (&stats_mutex);
+
+  return bytes;
+}
+
+guint64
+gegl_tile_compression_get_output_bytes (void)
+{
+  guint64 bytes;
+
+  g_mutex_lock (&stats_mutex);
+  bytes = output_bytes;
+  g_mutex_unlock (&stats_mutex);
+
+  return bytes;
+}
+
+void
+gegl_tile_compression_reset_stats (void)
+{
+  g_mutex_lock (&stats_mutex);
+  input_bytes  = 0;
+  output_bytes = 0;
+  g_mutex_unlock (&stats_mutex);
+}
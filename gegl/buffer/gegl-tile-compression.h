@@ -0,0 +1,56 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_COMPRESSION_H__
+#define __GEGL_TILE_COMPRESSION_H__
+
+#include <glib-object.h>
+#include "gegl-enums.h"
+
+G_BEGIN_DECLS
+
+/* Compresses @size bytes of tile @data made of @bpp byte pixels into
+ * @compressed, which has room for @size bytes.  Returns FALSE, leaving
+ * the tile to be stored uncompressed, if compression is disabled or does
+ * not make the data smaller.
+ */
+gboolean gegl_tile_compress                        (GeglTileCompression  compression,
+                                                    gint                 bpp,
+                                                    const guchar        *data,
+                                                    gsize                size,
+                                                    guchar              *compressed,
+                                                    gsize               *compressed_size);
+
+/* Decompresses @compressed_size bytes produced by gegl_tile_compress()
+ * into the @size bytes of @data.  Returns FALSE if the data is corrupt.
+ */
+gboolean gegl_tile_decompress                      (GeglTileCompression  compression,
+                                                    gint                 bpp,
+                                                    const guchar        *compressed,
+                                                    gsize                compressed_size,
+                                                    guchar              *data,
+                                                    gsize                size);
+
+/* totals of the bytes passed to and produced by gegl_tile_compress(),
+ * including the tiles that ended up stored uncompressed
+ */
+guint64  gegl_tile_compression_get_input_bytes     (void);
+guint64  gegl_tile_compression_get_output_bytes    (void);
+void     gegl_tile_compression_reset_stats         (void);
+
+G_END_DECLS
+
+#endif
@@ -27,31 +27,69 @@
 #include "gegl-buffer.h"
 #include "gegl-buffer-private.h"
 #include "gegl-tile.h"
+#include "gegl-tile-alloc.h"
+#include "gegl-result-cache.h"
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-storage.h"
 #include "gegl-debug.h"
 
 #include "gegl-buffer-cl-cache.h"
 
-/*
-#define GEGL_DEBUG_CACHE_HITS
-*/
-
 typedef struct CacheItem
 {
   GeglTileHandlerCache *handler; /* The specific handler that cached this item*/
   GeglTile *tile;                /* The tile */
-  GList     link;                /*  Link in the cache_queue, to avoid
+  GList     link;                /*  Link in the shard's queue, to avoid
                                   *  queue lookups involving g_list_find() */
+  GList     handler_link;        /*  Link in the handler's list of items
+                                  *  living in the same shard */
 
   gint      x;                   /* The coordinates this tile was cached for */
   gint      y;
   gint      z;
+
+  gboolean  in_probation;        /* TRUE if the item is in the 2Q probation
+                                  * queue rather than in the main queue */
 } CacheItem;
 
 #define LINK_GET_ITEM(link) \
         ((CacheItem *) ((guchar *) link - G_STRUCT_OFFSET (CacheItem, link)))
 
+/* The global tile cache is split in GEGL_TILE_HANDLER_CACHE_SHARDS
+ * independent shards, each with its own lock, hash table and LRU queue.
+ * Which shard a tile lives in is decided by a hash of (handler, x, y, z),
+ * so threads working on different tiles rarely contend for the same lock.
+ * The byte budget (tile-cache-size) is global, and is enforced by trimming
+ * the shards in turn.
+ *
+ * Which tile of a shard is evicted depends on the tile-cache-policy:
+ *
+ * GEGL_TILE_CACHE_POLICY_LRU evicts the least recently used tile.
+ *
+ * GEGL_TILE_CACHE_POLICY_2Q (Johnson & Shasha) keeps tiles that have only
+ * been seen once in a FIFO probation queue, which is evicted from first as
+ * long as it holds more than CACHE_2Q_PROBATION_PERCENTAGE of the shard.
+ * The keys of tiles evicted from probation are remembered as ghosts, and a
+ * tile that is fetched again while its ghost is remembered goes straight to
+ * the main LRU queue. A single sequential pass over a large buffer thus only
+ * cycles through the probation queue, and leaves the working set alone.
+ */
+typedef struct CacheShard
+{
+  GMutex      mutex;
+  GQueue      queue;           /* most recently used items at the head */
+  GQueue      probation;       /* 2Q: items seen once, newest at the head */
+  GQueue      ghosts;          /* 2Q: keys recently evicted from probation */
+  GHashTable *ht;
+  GHashTable *ghost_ht;
+  guint64     total;           /* bytes stored in this shard */
+  guint64     probation_total; /* bytes stored in the probation queue */
+
+  guint64     hits;
+  guint64     misses;
+  guint64     evictions;
+} __attribute__ ((__aligned__ (64))) CacheShard; /* on separate cache lines */
+
 
 static void       gegl_tile_handler_cache_dispose    (GObject              *object);
 static gboolean   gegl_tile_handler_cache_wash       (GeglTileHandlerCache *cache);
@@ -64,7 +102,8 @@ static gpointer   gegl_tile_handler_cache_command    (GeglTileSource       *tile
 static GeglTile * gegl_tile_handler_cache_get_tile   (GeglTileHandlerCache *cache,
                                                       gint                  x,
                                                       gint                  y,
-                                                      gint                  z);
+                                                      gint                  z,
+                                                      gboolean              record);
 static gboolean   gegl_tile_handler_cache_has_tile   (GeglTileHandlerCache *cache,
                                                       gint                  x,
                                                       gint                  y,
@@ -82,17 +121,29 @@ static void       gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cach
                                                       gint                  x,
                                                       gint                  y,
                                                       gint                  z);
+static guint      gegl_tile_handler_cache_hashfunc   (gconstpointer         key);
+static gboolean   gegl_tile_handler_cache_equalfunc  (gconstpointer         a,
+                                                      gconstpointer         b);
 
 
-static GMutex       mutex                 = { 0, };
-static GQueue      *cache_queue           = NULL;
-static GHashTable  *cache_ht              = NULL;
+static CacheShard   cache_shards[GEGL_TILE_HANDLER_CACHE_SHARDS];
+static gboolean     cache_initialized     = FALSE;
 static gint         cache_wash_percentage = 20;
-static guint64      cache_total           = 0; /* approximate amount of bytes stored */
-#ifdef GEGL_DEBUG_CACHE_HITS
-static gint         cache_hits            = 0;
-static gint         cache_misses          = 0;
-#endif
+static GMutex       cache_evict_mutex;         /* with cache_evict_cond, to */
+static GCond        cache_evict_cond;          /* wait for the evictions of */
+                                               /* a handler to finish */
+static gint         cache_trim_shard      = 0; /* round-robin start for trimming */
+static gint         cache_wash_shard      = 0; /* round-robin start for washing */
+static gint         cache_alloc_trims     = 0; /* inserts over the size, for */
+                                               /* trimming the allocator */
+
+/* the tile allocator is trimmed once every this many inserts that found
+ * the cache full
+ */
+#define CACHE_ALLOC_TRIM_INTERVAL     64
+
+#define CACHE_2Q_PROBATION_PERCENTAGE 25
+#define CACHE_2Q_GHOST_PERCENTAGE     50 /* of the number of resident items */
 
 
 G_DEFINE_TYPE (GeglTileHandlerCache, gegl_tile_handler_cache, GEGL_TYPE_TILE_HANDLER)
@@ -109,15 +160,87 @@ gegl_tile_handler_cache_class_init (GeglTileHandlerCacheClass *class)
 static void
 gegl_tile_handler_cache_init (GeglTileHandlerCache *cache)
 {
+  gint i;
+
   ((GeglTileSource*)cache)->command = gegl_tile_handler_cache_command;
   gegl_tile_cache_init ();
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+    g_queue_init (&cache->items[i]);
+}
+
+static guint64
+cache_sum_shards (glong offset)
+{
+  guint64 sum = 0;
+  gint    i;
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+    sum += G_STRUCT_MEMBER (guint64, &cache_shards[i], offset);
+
+  return sum;
+}
+
+/* the amount of bytes stored, summed from the shards rather than kept
+ * in a global of its own which every insert and eviction would contend on
+ */
+static inline guint64
+cache_total_get (void)
+{
+  return cache_sum_shards (G_STRUCT_OFFSET (CacheShard, total));
+}
+
+static inline guint
+cache_shard_index (GeglTileHandlerCache *handler,
+                   gint                  x,
+                   gint                  y,
+                   gint                  z)
+{
+  CacheItem key;
+
+  key.x       = x;
+  key.y       = y;
+  key.z       = z;
+  key.handler = handler;
+
+  /* fibonacci hashing; the low bits of the table hash are not well
+   * distributed, so we pick the shard from the high bits of the product.
+   */
+  return ((gegl_tile_handler_cache_hashfunc (&key) * 2654435769u) >> 16) &
+         (GEGL_TILE_HANDLER_CACHE_SHARDS - 1);
+}
+
+/* removes an item from its shard, the shard lock must be held; the
+ * reference held on item->tile is passed on to the caller.
+ */
+static inline void
+cache_shard_remove_item (CacheShard *shard,
+                         CacheItem  *item)
+{
+  GeglTileHandlerCache *handler = item->handler;
+  guint                 index   = shard - cache_shards;
+
+  shard->total -= item->tile->size;
+
+  if (item->in_probation)
+    {
+      shard->probation_total -= item->tile->size;
+      g_queue_unlink (&shard->probation, &item->link);
+    }
+  else
+    {
+      g_queue_unlink (&shard->queue, &item->link);
+    }
+  g_queue_unlink (&handler->items[index], &item->handler_link);
+  g_hash_table_remove (shard->ht, item);
+  g_atomic_int_add (&handler->count, -1);
+  g_atomic_int_set (&item->tile->cached, FALSE);
 }
 
 static void
 gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
 {
-  CacheItem            *item;
-  GSList               *iter;
+  gint i;
 
   if (cache->tile_storage->hot_tile)
     {
@@ -125,29 +248,54 @@ gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
       cache->tile_storage->hot_tile = NULL;
     }
 
-  if (!cache->count)
+  if (!g_atomic_int_get (&cache->count))
     return;
 
-  g_mutex_lock (&mutex);
-  {
-    for (iter = cache->items; iter; iter = cache->items)
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
     {
-      item = iter->data;
-      if (item->tile)
+      CacheShard *shard = &cache_shards[i];
+      GList      *link;
+      GSList     *tiles = NULL;
+
+      g_mutex_lock (&shard->mutex);
+      while ((link = g_queue_peek_head_link (&cache->items[i])))
         {
-          cache_total -= item->tile->size;
-          gegl_tile_mark_as_stored (item->tile); // to avoid saving 
-          gegl_tile_unref (item->tile);
-          cache->count--;
+          CacheItem *item = link->data;
+
+          cache_shard_remove_item (shard, item);
+          tiles = g_slist_prepend (tiles, item->tile);
+          g_slice_free (CacheItem, item);
+        }
+      g_mutex_unlock (&shard->mutex);
+
+      while (tiles)
+        {
+          GeglTile *tile = tiles->data;
+
+          gegl_tile_mark_as_stored (tile); // to avoid saving
+          gegl_tile_unref (tile);
+          tiles = g_slist_delete_link (tiles, tiles);
         }
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
-      g_hash_table_remove (cache_ht, item);
-      g_slice_free (CacheItem, item);
     }
-  }
+}
+
+/* drops all tiles of @cache, and waits for the ones other threads are
+ * evicting to be let go of; once it returns, no tile of @cache will be
+ * stored back through its tile storage by the cache anymore.  Called by
+ * the tile storage before it is torn down.
+ */
+void
+gegl_tile_handler_cache_drop (GeglTileHandlerCache *cache)
+{
+  /* evictions pick their tile under the shard lock, so those not waited
+   * for below can not pick any once reinit removed them all
+   */
+  gegl_tile_handler_cache_reinit (cache);
 
-  g_mutex_unlock (&mutex);
+  g_mutex_lock (&cache_evict_mutex);
+  while (g_atomic_int_get (&cache->evicting))
+    g_cond_wait (&cache_evict_cond, &cache_evict_mutex);
+  g_mutex_unlock (&cache_evict_mutex);
 }
 
 static void
@@ -178,17 +326,9 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   if (G_UNLIKELY (gegl_cl_is_accelerated ()))
     gegl_buffer_cl_cache_flush2 (cache, NULL);
 
-  tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
+  tile = gegl_tile_handler_cache_get_tile (cache, x, y, z, TRUE);
   if (tile)
-    {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      cache_hits++;
-#endif
-      return tile;
-    }
-#ifdef GEGL_DEBUG_CACHE_HITS
-  cache_misses++;
-#endif
+    return tile;
 
   if (source)
     tile = gegl_tile_source_get_tile (source, x, y, z);
@@ -199,6 +339,44 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   return tile;
 }
 
+static void
+gegl_tile_handler_cache_flush (GeglTileHandlerCache *cache)
+{
+  gint i;
+
+  if (!g_atomic_int_get (&cache->count))
+    return;
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+    {
+      CacheShard *shard = &cache_shards[i];
+      GSList     *dirty = NULL;
+      GList      *link;
+
+      /* collect the dirty tiles under the shard lock, but store them
+       * without holding it, storing can involve I/O.
+       */
+      g_mutex_lock (&shard->mutex);
+      for (link = g_queue_peek_head_link (&cache->items[i]); link; link = link->next)
+        {
+          CacheItem *item = link->data;
+
+          if (item->tile != NULL && !gegl_tile_is_stored (item->tile))
+            dirty = g_slist_prepend (dirty, gegl_tile_ref (item->tile));
+        }
+      g_mutex_unlock (&shard->mutex);
+
+      while (dirty)
+        {
+          GeglTile *tile = dirty->data;
+
+          gegl_tile_store (tile);
+          gegl_tile_unref (tile);
+          dirty = g_slist_delete_link (dirty, dirty);
+        }
+    }
+}
+
 static gpointer
 gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
                                  GeglTileCommand  command,
@@ -213,27 +391,10 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   switch (command)
     {
       case GEGL_TILE_FLUSH:
-        {
-          GList     *link;
+        if (gegl_cl_is_accelerated ())
+          gegl_buffer_cl_cache_flush2 (cache, NULL);
 
-          if (gegl_cl_is_accelerated ())
-            gegl_buffer_cl_cache_flush2 (cache, NULL);
-
-          if (cache->count)
-            {
-              for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
-                {
-                  CacheItem *item = LINK_GET_ITEM (link);
-                  GeglTile  *tile = item->tile;
-
-                  if (tile != NULL &&
-                      item->handler == cache)
-                    {
-                      gegl_tile_store (tile);
-                    }
-                }
-            }
-        }
+        gegl_tile_handler_cache_flush (cache);
         break;
       case GEGL_TILE_GET:
         /* XXX: we should perhaps store a NIL result, and place the empty
@@ -274,41 +435,66 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   return gegl_tile_handler_source_command (handler, command, x, y, z, data);
 }
 
-/* write the least recently used dirty tile to disk if it
- * is in the wash_percentage (20%) least recently used tiles,
- * calling this function in an idle handler distributes the
- * tile flushing overhead over time.
+/* returns a new reference to the least recently used dirty tile of queue
+ * if it is within the wash_percentage (20%) least recently used tiles.
  */
-gboolean
-gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
+static GeglTile *
+cache_queue_find_dirty (GQueue *queue)
 {
-  GeglTile  *last_dirty = NULL;
-  guint      count      = 0;
-  gint       length     = g_queue_get_length (cache_queue);
-  gint       wash_tiles = cache_wash_percentage * length / 100;
-  GList     *link;
+  gint   count      = 0;
+  gint   wash_tiles = cache_wash_percentage * g_queue_get_length (queue) / 100;
+  GList *link;
 
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  for (link = g_queue_peek_tail_link (queue);
+       link && count < wash_tiles;
+       link = link->prev, count++)
     {
       CacheItem *item = LINK_GET_ITEM (link);
-      GeglTile  *tile = item->tile;
 
-      count++;
-      if (!gegl_tile_is_stored (tile))
-        if (count > length - wash_tiles)
-          last_dirty = tile;
+      if (!gegl_tile_is_stored (item->tile))
+        return gegl_tile_ref (item->tile);
     }
 
-  if (last_dirty != NULL)
+  return NULL;
+}
+
+/* write the least recently used dirty tile to disk if it
+ * is in the wash_percentage (20%) least recently used tiles
+ * of a shard, calling this function in an idle handler distributes
+ * the tile flushing overhead over time.
+ */
+gboolean
+gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
+{
+  gint start = g_atomic_int_add (&cache_wash_shard, 1);
+  gint i;
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
     {
-      gegl_tile_store (last_dirty);
-      return TRUE;
+      CacheShard *shard      = &cache_shards[(start + i) &
+                                             (GEGL_TILE_HANDLER_CACHE_SHARDS - 1)];
+      GeglTile   *last_dirty = NULL;
+
+      g_mutex_lock (&shard->mutex);
+      last_dirty = cache_queue_find_dirty (&shard->probation);
+      if (!last_dirty)
+        last_dirty = cache_queue_find_dirty (&shard->queue);
+      g_mutex_unlock (&shard->mutex);
+
+      if (last_dirty != NULL)
+        {
+          gegl_tile_store (last_dirty);
+          gegl_tile_unref (last_dirty);
+          return TRUE;
+        }
     }
+
   return FALSE;
 }
 
 static inline CacheItem *
-cache_lookup (GeglTileHandlerCache *cache,
+cache_lookup (CacheShard           *shard,
+              GeglTileHandlerCache *cache,
               gint                  x,
               gint                  y,
               gint                  z)
@@ -320,39 +506,71 @@ cache_lookup (GeglTileHandlerCache *cache,
   key.z       = z;
   key.handler = cache;
 
-  return g_hash_table_lookup (cache_ht, &key);
+  return g_hash_table_lookup (shard->ht, &key);
 }
 
-/* returns the requested Tile if it is in the cache, NULL otherwize.
+/* returns the requested Tile if it is in the cache, NULL otherwize,
+ * when record is TRUE the lookup is accounted for in the hit/miss
+ * statistics.
  */
 static GeglTile *
 gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
                                   gint                  x,
                                   gint                  y,
-                                  gint                  z)
+                                  gint                  z,
+                                  gboolean              record)
 {
-  CacheItem *result;
+  CacheShard *shard;
+  CacheItem  *result;
+  GeglTile   *tile = NULL;
 
-  if (cache->count == 0)
+  if (!record && g_atomic_int_get (&cache->count) == 0)
     return NULL;
 
-  g_mutex_lock (&mutex);
-  result = cache_lookup (cache, x, y, z);
+  shard = &cache_shards[cache_shard_index (cache, x, y, z)];
+
+  g_mutex_lock (&shard->mutex);
+  result = cache_lookup (shard, cache, x, y, z);
   if (result)
     {
-      g_queue_unlink (cache_queue, &result->link);
-      g_queue_push_head_link (cache_queue, &result->link);
-      g_mutex_unlock (&mutex);
-      while (result->tile == NULL)
-      {
+      if (result->in_probation)
+        {
+          /* in 2Q, hits on probation do not reorder it, a tile only gets
+           * promoted if it is fetched again after having been evicted.
+           * Items left over from a policy change are promoted right away.
+           */
+          if (gegl_config ()->tile_cache_policy != GEGL_TILE_CACHE_POLICY_2Q)
+            {
+              g_queue_unlink (&shard->probation, &result->link);
+              shard->probation_total -= result->tile->size;
+              result->in_probation = FALSE;
+              g_queue_push_head_link (&shard->queue, &result->link);
+            }
+        }
+      else
+        {
+          g_queue_unlink (&shard->queue, &result->link);
+          g_queue_push_head_link (&shard->queue, &result->link);
+        }
+
+      g_atomic_int_set (&result->tile->touched, FALSE);
+
+      if (record)
+        shard->hits++;
+
+      if (result->tile == NULL)
         g_printerr ("NULL tile in %s %p %i %i %i %p\n", __FUNCTION__, result, result->x, result->y, result->z,
-                result->tile);
-        return NULL;
-      }
-      return gegl_tile_ref (result->tile);
+                    result->tile);
+      else
+        tile = gegl_tile_ref (result->tile);
     }
-  g_mutex_unlock (&mutex);
-  return NULL;
+  else if (record)
+    {
+      shard->misses++;
+    }
+  g_mutex_unlock (&shard->mutex);
+
+  return tile;
 }
 
 static gboolean
@@ -361,7 +579,7 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
                                   gint                  y,
                                   gint                  z)
 {
-  GeglTile *tile = gegl_tile_handler_cache_get_tile (cache, x, y, z);
+  GeglTile *tile = gegl_tile_handler_cache_get_tile (cache, x, y, z, FALSE);
 
   if (tile)
     {
@@ -372,31 +590,166 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
   return FALSE;
 }
 
-static gboolean
-gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
+/* remembers the key of an item evicted from probation, so that the tile
+ * goes straight to the main queue if it is fetched again soon.
+ */
+static void
+cache_shard_add_ghost (CacheShard *shard,
+                       CacheItem  *evicted)
 {
-  GList *link;
+  CacheItem *ghost;
+  guint      max_ghosts;
+
+  if (g_hash_table_lookup (shard->ghost_ht, evicted))
+    return;
+
+  ghost = g_slice_new0 (CacheItem);
+  ghost->handler   = evicted->handler;
+  ghost->x         = evicted->x;
+  ghost->y         = evicted->y;
+  ghost->z         = evicted->z;
+  ghost->link.data = ghost;
 
-  link = g_queue_pop_tail_link (cache_queue);
+  g_queue_push_head_link (&shard->ghosts, &ghost->link);
+  g_hash_table_insert (shard->ghost_ht, ghost, ghost);
 
-  if (link != NULL)
+  max_ghosts = (g_queue_get_length (&shard->queue) +
+                g_queue_get_length (&shard->probation)) *
+               CACHE_2Q_GHOST_PERCENTAGE / 100 + 1;
+
+  while (g_queue_get_length (&shard->ghosts) > max_ghosts)
     {
-      CacheItem *last_writable = LINK_GET_ITEM (link);
-      GeglTile *tile = last_writable->tile;
-      GeglTileStorage *storage = tile->tile_storage;
+      GList *link = g_queue_pop_tail_link (&shard->ghosts);
 
-      last_writable->handler->items = g_slist_remove (last_writable->handler->items, last_writable);
-      g_hash_table_remove (cache_ht, last_writable);
-      cache_total -= tile->size;
+      ghost = LINK_GET_ITEM (link);
+      g_hash_table_remove (shard->ghost_ht, ghost);
+      g_slice_free (CacheItem, ghost);
+    }
+}
+
+/* picks the item to evict from a shard according to the cache policy,
+ * the shard lock must be held.
+ */
+static CacheItem *
+cache_shard_pick_victim (CacheShard *shard)
+{
+  GList *link = NULL;
+
+  if (! g_queue_is_empty (&shard->probation) &&
+      (g_queue_is_empty (&shard->queue) ||
+       gegl_config ()->tile_cache_policy != GEGL_TILE_CACHE_POLICY_2Q ||
+       shard->probation_total >
+         shard->total * CACHE_2Q_PROBATION_PERCENTAGE / 100))
+    {
+      link = g_queue_peek_tail_link (&shard->probation);
+    }
+  else
+    {
+      link = g_queue_peek_tail_link (&shard->queue);
+    }
+
+  return link ? LINK_GET_ITEM (link) : NULL;
+}
+
+/* evicts a tile from one shard, shards are visited round-robin so that
+ * the eviction pressure is spread over all of them, twice when the tiles
+ * in line have been used through the hot tiles.
+ * No shard lock may be held by the caller.
+ */
+static gboolean
+gegl_tile_handler_cache_trim (void)
+{
+  gint start = g_atomic_int_add (&cache_trim_shard, 1);
+  gint i;
 
-      if (storage && storage->hot_tile == tile)
+  for (i = 0; i < 2 * GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+    {
+      CacheShard           *shard = &cache_shards[(start + i) &
+                                                  (GEGL_TILE_HANDLER_CACHE_SHARDS - 1)];
+      CacheItem            *last_writable;
+      GeglTileHandlerCache *handler;
+      GeglTile             *tile;
+      GeglTileStorage      *storage;
+
+      g_mutex_lock (&shard->mutex);
+      last_writable = cache_shard_pick_victim (shard);
+
+      if (last_writable == NULL)
         {
-          storage->hot_tile = NULL;
-          gegl_tile_unref (tile);
+          g_mutex_unlock (&shard->mutex);
+          continue;
+        }
+
+      /* a tile used through the hot tiles since the cache last saw it is
+       * given the move to the front a cache hit would have given it, and
+       * the next shard is tried.  That clears the mark, so the second
+       * round over the shards does evict.
+       */
+      if (g_atomic_int_get (&last_writable->tile->touched) &&
+          (! last_writable->in_probation ||
+           gegl_config ()->tile_cache_policy != GEGL_TILE_CACHE_POLICY_2Q))
+        {
+          g_atomic_int_set (&last_writable->tile->touched, FALSE);
+
+          if (last_writable->in_probation)
+            {
+              g_queue_unlink (&shard->probation, &last_writable->link);
+              shard->probation_total -= last_writable->tile->size;
+              last_writable->in_probation = FALSE;
+            }
+          else
+            {
+              g_queue_unlink (&shard->queue, &last_writable->link);
+            }
+          g_queue_push_head_link (&shard->queue, &last_writable->link);
+
+          g_mutex_unlock (&shard->mutex);
+          continue;
         }
 
+      handler = last_writable->handler;
+      tile    = last_writable->tile;
+      storage = tile->tile_storage;
+
+      /* keeps gegl_tile_handler_cache_drop() from returning, and the
+       * storage from being torn down, until the tile is let go of below
+       */
+      g_atomic_int_inc (&handler->evicting);
+
+      if (last_writable->in_probation &&
+          gegl_config ()->tile_cache_policy == GEGL_TILE_CACHE_POLICY_2Q)
+        cache_shard_add_ghost (shard, last_writable);
+
+      cache_shard_remove_item (shard, last_writable);
+      shard->evictions++;
+
+      if (storage &&
+          g_atomic_pointer_compare_and_exchange (&storage->hot_tile, tile, NULL))
+        {
+          gegl_tile_unref (tile);
+        }
+      g_mutex_unlock (&shard->mutex);
+
+      /* the threads' hot tiles must not keep an evicted tile from being
+       * written back
+       */
+      if (storage)
+        gegl_tile_storage_drop_hot_tile (storage, tile,
+                                         last_writable->x,
+                                         last_writable->y,
+                                         last_writable->z);
+
+      /* dropping the last reference might write the tile to the backend,
+       * do that outside the shard lock.
+       */
       gegl_tile_unref (tile);
       g_slice_free (CacheItem, last_writable);
+
+      g_mutex_lock (&cache_evict_mutex);
+      if (g_atomic_int_dec_and_test (&handler->evicting))
+        g_cond_broadcast (&cache_evict_cond);
+      g_mutex_unlock (&cache_evict_mutex);
+
       return TRUE;
     }
 
@@ -409,24 +762,32 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
                                     gint                  y,
                                     gint                  z)
 {
-  CacheItem *item;
+  CacheShard *shard;
+  CacheItem  *item;
+
+  if (g_atomic_int_get (&cache->count) == 0)
+    return;
+
+  shard = &cache_shards[cache_shard_index (cache, x, y, z)];
+
+  g_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
+  if (item)
+    cache_shard_remove_item (shard, item);
+  g_mutex_unlock (&shard->mutex);
 
-  g_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
   if (item)
     {
-      cache_total -= item->tile->size;
+      /* the hot tiles must not keep it alive either */
+      gegl_tile_storage_drop_hot_tile (cache->tile_storage, item->tile,
+                                       x, y, z);
+
       item->tile->tile_storage = NULL;
       gegl_tile_mark_as_stored (item->tile); /* to cheat it out of being stored */
       gegl_tile_unref (item->tile);
 
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
-
-      g_hash_table_remove (cache_ht, item);
       g_slice_free (CacheItem, item);
     }
-  g_mutex_unlock (&mutex);
 }
 
 
@@ -436,27 +797,31 @@ gegl_tile_handler_cache_void (GeglTileHandlerCache *cache,
                               gint                  y,
                               gint                  z)
 {
-  CacheItem *item;
+  CacheShard *shard;
+  CacheItem  *item;
+
+  if (g_atomic_int_get (&cache->count) == 0)
+    return;
+
+  shard = &cache_shards[cache_shard_index (cache, x, y, z)];
 
-  g_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
+  g_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
   if (item)
-    {
-      cache_total -= item->tile->size;
-      g_queue_unlink (cache_queue, &item->link);
-      cache->items = g_slist_remove (cache->items, item);
-      g_hash_table_remove (cache_ht, item);
-      cache->count--;
-    }
-  g_mutex_unlock (&mutex);
+    cache_shard_remove_item (shard, item);
+  g_mutex_unlock (&shard->mutex);
 
   if (item)
     {
+      /* the hot tiles must not keep it alive either */
+      gegl_tile_storage_drop_hot_tile (cache->tile_storage, item->tile,
+                                       x, y, z);
+
       gegl_tile_void (item->tile);
       gegl_tile_unref (item->tile);
-    }
 
-  g_slice_free (CacheItem, item);
+      g_slice_free (CacheItem, item);
+    }
 }
 
 void
@@ -466,16 +831,24 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
                                 gint                  y,
                                 gint                  z)
 {
-  CacheItem *item = g_slice_new (CacheItem);
-
-  item->handler   = cache;
-  item->tile      = gegl_tile_ref (tile);
-  item->link.data = item;
-  item->link.next = NULL;
-  item->link.prev = NULL;
-  item->x         = x;
-  item->y         = y;
-  item->z         = z;
+  CacheItem  *item   = g_slice_new (CacheItem);
+  guint       index  = cache_shard_index (cache, x, y, z);
+  CacheShard *shard  = &cache_shards[index];
+  gboolean    use_2q = gegl_config ()->tile_cache_policy ==
+                       GEGL_TILE_CACHE_POLICY_2Q;
+
+  item->handler           = cache;
+  item->tile              = gegl_tile_ref (tile);
+  item->link.data         = item;
+  item->link.next         = NULL;
+  item->link.prev         = NULL;
+  item->handler_link.data = item;
+  item->handler_link.next = NULL;
+  item->handler_link.prev = NULL;
+  item->x                 = x;
+  item->y                 = y;
+  item->z                 = z;
+  item->in_probation      = FALSE;
 
   tile->x = x;
   tile->y = y;
@@ -487,24 +860,64 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
 
   /* XXX: this is a window when the tile is a zero tile during update */
 
-  g_mutex_lock (&mutex);
-  cache_total  += item->tile->size;
-  g_queue_push_head_link (cache_queue, &item->link);
+  g_mutex_lock (&shard->mutex);
+  shard->total += item->tile->size;
 
-  cache->count ++;
+  if (use_2q)
+    {
+      CacheItem *ghost = g_hash_table_lookup (shard->ghost_ht, item);
 
-  cache->items = g_slist_prepend (cache->items, item);
-  g_hash_table_insert (cache_ht, item, item);
+      if (ghost)
+        {
+          /* seen again shortly after eviction, part of the working set */
+          g_queue_unlink (&shard->ghosts, &ghost->link);
+          g_hash_table_remove (shard->ghost_ht, ghost);
+          g_slice_free (CacheItem, ghost);
+        }
+      else
+        {
+          item->in_probation = TRUE;
+        }
+    }
+
+  if (item->in_probation)
+    {
+      shard->probation_total += item->tile->size;
+      g_queue_push_head_link (&shard->probation, &item->link);
+    }
+  else
+    {
+      g_queue_push_head_link (&shard->queue, &item->link);
+    }
+  g_queue_push_head_link (&cache->items[index], &item->handler_link);
+  g_hash_table_insert (shard->ht, item, item);
+  g_atomic_int_inc (&cache->count);
+  g_atomic_int_set (&tile->cached, TRUE);
+  g_mutex_unlock (&shard->mutex);
+
+  /* the size of the tile cache is shared with the result cache */
+  if (cache_total_get () +
+      gegl_result_cache_get_total () <= gegl_config()->tile_cache_size)
+    return;
 
-  while (cache_total > gegl_config()->tile_cache_size)
+  while (cache_total_get () +
+         gegl_result_cache_get_total () > gegl_config()->tile_cache_size)
     {
-#ifdef GEGL_DEBUG_CACHE_HITS
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:"G_GUINT64_FORMAT" > cache_size:"G_GUINT64_FORMAT, cache_total, gegl_config()->tile_cache_size);
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (cache_queue));
-#endif
-      gegl_tile_handler_cache_trim (cache);
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:%"G_GUINT64_FORMAT" > cache_size:%"G_GUINT64_FORMAT,
+                cache_total_get (), gegl_config()->tile_cache_size);
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "hit:%"G_GUINT64_FORMAT" miss:%"G_GUINT64_FORMAT" evictions:%"G_GUINT64_FORMAT,
+                gegl_tile_handler_cache_get_hits (),
+                gegl_tile_handler_cache_get_misses (),
+                gegl_tile_handler_cache_get_evictions ());
+      if (!gegl_tile_handler_cache_trim ())
+        break;
     }
-  g_mutex_unlock (&mutex);
+
+  /* the evicted tiles' data is free now, hand what is beyond a fraction
+   * of the cache size back to the system now and then
+   */
+  if (g_atomic_int_add (&cache_alloc_trims, 1) % CACHE_ALLOC_TRIM_INTERVAL == 0)
+    gegl_tile_alloc_trim (gegl_config()->tile_cache_size / 8);
 }
 
 GeglTileHandler *
@@ -558,22 +971,100 @@ gegl_tile_handler_cache_equalfunc (gconstpointer a,
 void
 gegl_tile_cache_init (void)
 {
-  if (cache_queue == NULL)
-    cache_queue = g_queue_new ();
-  if (cache_ht == NULL)
-    cache_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc, gegl_tile_handler_cache_equalfunc);
+  static GMutex init_mutex = { 0, };
+  gint          i;
+
+  if (g_atomic_int_get (&cache_initialized))
+    return;
+
+  g_mutex_lock (&init_mutex);
+  if (!cache_initialized)
+    {
+      for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+        {
+          g_queue_init (&cache_shards[i].queue);
+          g_queue_init (&cache_shards[i].probation);
+          g_queue_init (&cache_shards[i].ghosts);
+          cache_shards[i].ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                                 gegl_tile_handler_cache_equalfunc);
+          cache_shards[i].ghost_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                                       gegl_tile_handler_cache_equalfunc);
+          cache_shards[i].total           = 0;
+          cache_shards[i].probation_total = 0;
+        }
+      g_atomic_int_set (&cache_initialized, TRUE);
+    }
+  g_mutex_unlock (&init_mutex);
 }
 
 void
 gegl_tile_cache_destroy (void)
 {
-  if (cache_queue)
+  gint i;
+
+  if (!cache_initialized)
+    return;
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
+    {
+      CacheShard *shard = &cache_shards[i];
+
+      GList      *link;
+
+      g_mutex_lock (&shard->mutex);
+      while (g_queue_pop_head_link (&shard->queue));
+      while (g_queue_pop_head_link (&shard->probation));
+      while ((link = g_queue_pop_head_link (&shard->ghosts)))
+        g_slice_free (CacheItem, LINK_GET_ITEM (link));
+      g_hash_table_destroy (shard->ht);
+      g_hash_table_destroy (shard->ghost_ht);
+      shard->ht              = NULL;
+      shard->ghost_ht        = NULL;
+      shard->total           = 0;
+      shard->probation_total = 0;
+      g_mutex_unlock (&shard->mutex);
+    }
+
+  cache_initialized = FALSE;
+}
+
+guint64
+gegl_tile_handler_cache_get_total (void)
+{
+  return cache_total_get ();
+}
+
+guint64
+gegl_tile_handler_cache_get_hits (void)
+{
+  return cache_sum_shards (G_STRUCT_OFFSET (CacheShard, hits));
+}
+
+guint64
+gegl_tile_handler_cache_get_misses (void)
+{
+  return cache_sum_shards (G_STRUCT_OFFSET (CacheShard, misses));
+}
+
+guint64
+gegl_tile_handler_cache_get_evictions (void)
+{
+  return cache_sum_shards (G_STRUCT_OFFSET (CacheShard, evictions));
+}
+
+void
+gegl_tile_handler_cache_reset_stats (void)
+{
+  gint i;
+
+  for (i = 0; i < GEGL_TILE_HANDLER_CACHE_SHARDS; i++)
     {
-      while (g_queue_pop_head_link (cache_queue));
-      g_queue_free (cache_queue);
+      CacheShard *shard = &cache_shards[i];
+
+      g_mutex_lock (&shard->mutex);
+      shard->hits      = 0;
+      shard->misses    = 0;
+      shard->evictions = 0;
+      g_mutex_unlock (&shard->mutex);
     }
-  if (cache_ht)
-    g_hash_table_destroy (cache_ht);
-  cache_queue = NULL;
-  cache_ht = NULL;
 }
@@ -33,6 +33,11 @@
 #define GEGL_TILE_HANDLER_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_TILE_HANDLER_CACHE, GeglTileHandlerCacheClass))
 
 
+/* number of independently locked partitions of the global tile cache,
+ * must be a power of two.
+ */
+#define GEGL_TILE_HANDLER_CACHE_SHARDS 16
+
 typedef struct _GeglTileHandlerCache      GeglTileHandlerCache;
 typedef struct _GeglTileHandlerCacheClass GeglTileHandlerCacheClass;
 
@@ -40,8 +45,10 @@ struct _GeglTileHandlerCache
 {
   GeglTileHandler  parent_instance;
   GeglTileStorage *tile_storage;
-  GSList          *items;
-  int              count; /* number of items held by cache */
+  GQueue           items[GEGL_TILE_HANDLER_CACHE_SHARDS]; /* items held by cache,
+                                                            per shard */
+  gint             count; /* number of items held by cache */
+  gint             evicting; /* tiles being evicted by other threads */
 };
 
 struct _GeglTileHandlerCacheClass
@@ -57,5 +64,13 @@ void              gegl_tile_handler_cache_insert   (GeglTileHandlerCache *cache,
                                                     gint                  x,
                                                     gint                  y,
                                                     gint                  z);
+void              gegl_tile_handler_cache_drop     (GeglTileHandlerCache *cache);
+
+/* statistics of the global tile cache, exposed through GeglStats */
+guint64           gegl_tile_handler_cache_get_total     (void);
+guint64           gegl_tile_handler_cache_get_hits      (void);
+guint64           gegl_tile_handler_cache_get_misses    (void);
+guint64           gegl_tile_handler_cache_get_evictions (void);
+void              gegl_tile_handler_cache_reset_stats   (void);
 
 #endif
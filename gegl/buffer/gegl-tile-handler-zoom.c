@@ -26,6 +26,7 @@
 #include "gegl-types.h"
 #include "gegl-buffer-types.h"
 #include "gegl-buffer-private.h"
+#include "gegl-utils.h"
 #include "gegl-tile-handler.h"
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-handler-private.h"
@@ -78,6 +79,30 @@ static inline void set_half (GeglTile   * dst_tile,
   gegl_downscale_2x2 (format, width, height, src_data, width * bpp, dst_data, width * bpp);
 }
 
+/* returns TRUE if the four source tiles are uniform with the same pixel,
+ * which is then also the pixel of the downscaled tile
+ */
+static gboolean
+is_uniform (GeglTile   *source_tile[2][2],
+            const Babl *format)
+{
+  gint bpp = babl_format_get_bytes_per_pixel (format);
+  gint i, j;
+
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 2; j++)
+      {
+        if (! source_tile[i][j] || ! source_tile[i][j]->is_uniform)
+          return FALSE;
+
+        if (memcmp (gegl_tile_get_data (source_tile[i][j]),
+                    gegl_tile_get_data (source_tile[0][0]), bpp))
+          return FALSE;
+      }
+
+  return TRUE;
+}
+
 static GeglTile *
 get_tile (GeglTileSource *gegl_tile_source,
           gint            x,
@@ -134,19 +159,35 @@ get_tile (GeglTileSource *gegl_tile_source,
 
     gegl_tile_lock (tile);
 
-    for (i = 0; i < 2; i++)
-      for (j = 0; j < 2; j++)
-        {
-          if (source_tile[i][j])
-            {
-              set_half (tile, source_tile[i][j], tile_width, tile_height, format, i, j);
-              gegl_tile_unref (source_tile[i][j]);
-            }
-          else
+    if (is_uniform (source_tile, format))
+      {
+        gint bpp = babl_format_get_bytes_per_pixel (format);
+
+        gegl_memset_pattern (gegl_tile_get_data (tile),
+                             gegl_tile_get_data (source_tile[0][0]),
+                             bpp, tile_width * tile_height);
+        tile->is_uniform = 1;
+
+        for (i = 0; i < 2; i++)
+          for (j = 0; j < 2; j++)
+            gegl_tile_unref (source_tile[i][j]);
+      }
+    else
+      {
+        for (i = 0; i < 2; i++)
+          for (j = 0; j < 2; j++)
             {
-              set_blank (tile, tile_width, tile_height, format, i, j);
+              if (source_tile[i][j])
+                {
+                  set_half (tile, source_tile[i][j], tile_width, tile_height, format, i, j);
+                  gegl_tile_unref (source_tile[i][j]);
+                }
+              else
+                {
+                  set_blank (tile, tile_width, tile_height, format, i, j);
+                }
             }
-        }
+      }
     gegl_tile_unlock (tile);
   }
 
@@ -47,6 +47,34 @@ enum
 
 guint gegl_tile_storage_signals[LAST_SIGNAL] = { 0 };
 
+/* the number of hot tiles of each thread, must be a power of two */
+#define HOT_TILES 32
+
+typedef struct
+{
+  GeglTileStorage *storage;
+  GeglTile        *tile;
+  gint             x;
+  gint             y;
+  gint             z;
+} HotTile;
+
+typedef struct
+{
+  GMutex   mutex;  /* only contended when tiles are dropped by other threads */
+  HotTile  tiles[HOT_TILES];
+  guint64  hits;
+  guint64  misses;
+} HotTiles;
+
+static void hot_tiles_free (gpointer data);
+
+static GPrivate  hot_tiles_private = G_PRIVATE_INIT (hot_tiles_free);
+static GMutex    hot_tiles_mutex;          /* protects the following */
+static GSList   *hot_tiles_list   = NULL;  /* the hot tiles of all threads */
+static guint64   hot_tiles_hits   = 0;     /* statistics of exited threads */
+static guint64   hot_tiles_misses = 0;
+
 GeglTileStorage *
 gegl_tile_storage_new (GeglTileBackend *backend)
 {
@@ -101,6 +129,7 @@ gegl_tile_storage_add_handler (GeglTileStorage *tile_storage,
 
   g_return_if_fail (GEGL_IS_TILE_HANDLER (handler));
 
+  g_atomic_int_inc (&tile_storage->n_user_handlers);
   gegl_tile_handler_chain_add (chain, handler);
 
   /* FIXME: Move the handler to before the cache and other custom handlers */
@@ -124,6 +153,256 @@ gegl_tile_storage_remove_handler (GeglTileStorage *tile_storage,
   g_object_unref (handler);
 
   gegl_tile_handler_chain_bind (chain);
+  g_atomic_int_add (&tile_storage->n_user_handlers, -1);
+}
+
+static inline guint
+hot_tile_index (GeglTileStorage *tile_storage,
+                gint             x,
+                gint             y,
+                gint             z)
+{
+  guint hash = (guint) x * 73856093u ^
+               (guint) y * 19349663u ^
+               (guint) z * 83492791u ^
+               (guint) (GPOINTER_TO_SIZE (tile_storage) >> 4);
+
+  return (hash ^ (hash >> 16)) & (HOT_TILES - 1);
+}
+
+static HotTiles *
+hot_tiles_get (void)
+{
+  HotTiles *hot = g_private_get (&hot_tiles_private);
+
+  if (G_UNLIKELY (! hot))
+    {
+      hot = g_new0 (HotTiles, 1);
+      g_mutex_init (&hot->mutex);
+      g_private_set (&hot_tiles_private, hot);
+
+      g_mutex_lock (&hot_tiles_mutex);
+      hot_tiles_list = g_slist_prepend (hot_tiles_list, hot);
+      g_mutex_unlock (&hot_tiles_mutex);
+    }
+
+  return hot;
+}
+
+/* called when a thread exits */
+static void
+hot_tiles_free (gpointer data)
+{
+  HotTiles *hot = data;
+  gint      i;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  hot_tiles_list    = g_slist_remove (hot_tiles_list, hot);
+  hot_tiles_hits   += hot->hits;
+  hot_tiles_misses += hot->misses;
+  g_mutex_unlock (&hot_tiles_mutex);
+
+  /* the tiles are either still cached, or were voided and won't be
+   * stored; evicted tiles have been dropped already.
+   */
+  for (i = 0; i < HOT_TILES; i++)
+    if (hot->tiles[i].tile)
+      gegl_tile_unref (hot->tiles[i].tile);
+
+  g_mutex_clear (&hot->mutex);
+  g_free (hot);
+}
+
+GeglTile *
+gegl_tile_storage_get_hot_tile (GeglTileStorage *tile_storage,
+                                gint             x,
+                                gint             y,
+                                gint             z)
+{
+  HotTiles *hot;
+  HotTile  *entry;
+  GeglTile *tile = NULL;
+
+  if (g_atomic_int_get (&tile_storage->n_user_handlers))
+    return NULL;
+
+  hot   = hot_tiles_get ();
+  entry = &hot->tiles[hot_tile_index (tile_storage, x, y, z)];
+
+  g_mutex_lock (&hot->mutex);
+  if (entry->storage == tile_storage &&
+      entry->x == x && entry->y == y && entry->z == z &&
+      g_atomic_int_get (&entry->tile->cached))
+    {
+      tile = gegl_tile_ref (entry->tile);
+      g_atomic_int_set (&tile->touched, TRUE);
+      hot->hits++;
+    }
+  else
+    {
+      hot->misses++;
+    }
+  g_mutex_unlock (&hot->mutex);
+
+  return tile;
+}
+
+void
+gegl_tile_storage_add_hot_tile (GeglTileStorage *tile_storage,
+                                GeglTile        *tile,
+                                gint             x,
+                                gint             y,
+                                gint             z)
+{
+  HotTiles *hot;
+  HotTile  *entry;
+  GeglTile *old_tile;
+
+  if (g_atomic_int_get (&tile_storage->n_user_handlers) ||
+      ! g_atomic_int_get (&tile->cached))
+    return;
+
+  hot   = hot_tiles_get ();
+  entry = &hot->tiles[hot_tile_index (tile_storage, x, y, z)];
+
+  g_mutex_lock (&hot->mutex);
+  old_tile       = entry->tile;
+  entry->storage = tile_storage;
+  entry->tile    = gegl_tile_ref (tile);
+  entry->x       = x;
+  entry->y       = y;
+  entry->z       = z;
+  g_mutex_unlock (&hot->mutex);
+
+  if (old_tile)
+    gegl_tile_unref (old_tile);
+}
+
+void
+gegl_tile_storage_drop_hot_tile (GeglTileStorage *tile_storage,
+                                 GeglTile        *tile,
+                                 gint             x,
+                                 gint             y,
+                                 gint             z)
+{
+  guint   index   = hot_tile_index (tile_storage, x, y, z);
+  gint    dropped = 0;
+  GSList *iter;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  for (iter = hot_tiles_list; iter; iter = iter->next)
+    {
+      HotTiles *hot   = iter->data;
+      HotTile  *entry = &hot->tiles[index];
+
+      g_mutex_lock (&hot->mutex);
+      if (entry->tile == tile)
+        {
+          entry->storage = NULL;
+          entry->tile    = NULL;
+          dropped++;
+        }
+      g_mutex_unlock (&hot->mutex);
+    }
+  g_mutex_unlock (&hot_tiles_mutex);
+
+  /* the caller still holds a reference */
+  while (dropped--)
+    gegl_tile_unref (tile);
+}
+
+/* drops all tiles of @tile_storage from the hot tiles of all threads */
+static void
+gegl_tile_storage_drop_hot_tiles (GeglTileStorage *tile_storage)
+{
+  GSList *tiles = NULL;
+  GSList *iter;
+  gint    i;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  for (iter = hot_tiles_list; iter; iter = iter->next)
+    {
+      HotTiles *hot = iter->data;
+
+      g_mutex_lock (&hot->mutex);
+      for (i = 0; i < HOT_TILES; i++)
+        if (hot->tiles[i].storage == tile_storage)
+          {
+            tiles = g_slist_prepend (tiles, hot->tiles[i].tile);
+            hot->tiles[i].storage = NULL;
+            hot->tiles[i].tile    = NULL;
+          }
+      g_mutex_unlock (&hot->mutex);
+    }
+  g_mutex_unlock (&hot_tiles_mutex);
+
+  g_slist_free_full (tiles, (GDestroyNotify) gegl_tile_unref);
+}
+
+guint64
+gegl_tile_storage_get_hot_hits (void)
+{
+  guint64  hits;
+  GSList  *iter;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  hits = hot_tiles_hits;
+  for (iter = hot_tiles_list; iter; iter = iter->next)
+    hits += ((HotTiles *) iter->data)->hits;
+  g_mutex_unlock (&hot_tiles_mutex);
+
+  return hits;
+}
+
+guint64
+gegl_tile_storage_get_hot_misses (void)
+{
+  guint64  misses;
+  GSList  *iter;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  misses = hot_tiles_misses;
+  for (iter = hot_tiles_list; iter; iter = iter->next)
+    misses += ((HotTiles *) iter->data)->misses;
+  g_mutex_unlock (&hot_tiles_mutex);
+
+  return misses;
+}
+
+void
+gegl_tile_storage_reset_hot_stats (void)
+{
+  GSList *iter;
+
+  g_mutex_lock (&hot_tiles_mutex);
+  hot_tiles_hits   = 0;
+  hot_tiles_misses = 0;
+  for (iter = hot_tiles_list; iter; iter = iter->next)
+    {
+      HotTiles *hot = iter->data;
+
+      g_mutex_lock (&hot->mutex);
+      hot->hits   = 0;
+      hot->misses = 0;
+      g_mutex_unlock (&hot->mutex);
+    }
+  g_mutex_unlock (&hot_tiles_mutex);
+}
+
+static void
+gegl_tile_storage_dispose (GObject *object)
+{
+  GeglTileStorage *self = GEGL_TILE_STORAGE (object);
+
+  gegl_tile_storage_drop_hot_tiles (self);
+
+  /* the cache is the last handler of the chain to be disposed, tiles it
+   * evicts in other threads meanwhile would be stored through the rest
+   */
+  if (self->cache)
+    gegl_tile_handler_cache_drop (self->cache);
+
+  (*G_OBJECT_CLASS (parent_class)->dispose)(object);
 }
 
 static void
@@ -142,6 +421,7 @@ gegl_tile_storage_class_init (GeglTileStorageClass *class)
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
   parent_class                = g_type_class_peek_parent (class);
+  gobject_class->dispose      = gegl_tile_storage_dispose;
   gobject_class->finalize     = gegl_tile_storage_finalize;
 
   gegl_tile_storage_signals[CHANGED] =
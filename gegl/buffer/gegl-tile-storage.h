@@ -50,6 +50,9 @@ struct _GeglTileStorage
 
   GeglTile      *hot_tile; /* cached tile for speeding up gegl_buffer_get_pixel
                               and gegl_buffer_set_pixel (1x1 sized gets/sets)*/
+  gint           n_user_handlers; /* handlers added in front of the cache,
+                                     tiles are not taken from the per-thread
+                                     hot tiles while there are any */
 };
 
 struct _GeglTileStorageClass
@@ -65,4 +68,39 @@ gegl_tile_storage_new (GeglTileBackend *backend);
 void gegl_tile_storage_add_handler (GeglTileStorage *tile_storage, GeglTileHandler *handler);
 void gegl_tile_storage_remove_handler (GeglTileStorage *tile_storage, GeglTileHandler *handler);
 
+/* Every thread keeps the tiles it fetched most recently, of any storage,
+ * in a small direct mapped table, which gegl_buffer_get_tile() consults
+ * before walking the handler chain. An entry is only used while its tile
+ * is held by the storage's cache.
+ */
+
+/* returns a new reference to the tile at @x, @y, @z if it is among the
+ * calling thread's hot tiles, NULL otherwise.
+ */
+GeglTile * gegl_tile_storage_get_hot_tile  (GeglTileStorage *tile_storage,
+                                            gint             x,
+                                            gint             y,
+                                            gint             z);
+/* makes @tile, just fetched through the handler chain, one of the calling
+ * thread's hot tiles.
+ */
+void       gegl_tile_storage_add_hot_tile  (GeglTileStorage *tile_storage,
+                                            GeglTile        *tile,
+                                            gint             x,
+                                            gint             y,
+                                            gint             z);
+/* drops @tile from the hot tiles of all threads, called when the cache
+ * evicts it so that its memory is released.
+ */
+void       gegl_tile_storage_drop_hot_tile (GeglTileStorage *tile_storage,
+                                            GeglTile        *tile,
+                                            gint             x,
+                                            gint             y,
+                                            gint             z);
+
+/* statistics of the hot tiles, exposed through GeglStats */
+guint64    gegl_tile_storage_get_hot_hits    (void);
+guint64    gegl_tile_storage_get_hot_misses  (void);
+void       gegl_tile_storage_reset_hot_stats (void);
+
 #endif
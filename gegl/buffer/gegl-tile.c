@@ -34,10 +34,14 @@
 #include "gegl-buffer-private.h"
 #include "gegl-tile-source.h"
 #include "gegl-tile-storage.h"
+#include "gegl-tile-alloc.h"
 
-static GMutex cowmutex = { 0, }; /* copy on write is maintained in a doubly linked
-                                  * list, which must be protected by a mutex
-                                  */
+/* Tiles made with gegl_tile_dup() share their data until one of them is
+ * written to. The tiles sharing the same data also share a counter of
+ * their number, allocated on the first duplication; a tile without one
+ * owns its data alone. The counter is only ever changed atomically, so
+ * neither duplicating a tile nor giving it a copy of its own takes a lock.
+ */
 
 GeglTile *gegl_tile_ref (GeglTile *tile)
 {
@@ -47,6 +51,45 @@ GeglTile *gegl_tile_ref (GeglTile *tile)
 
 static int free_data_directly;
 
+static void
+gegl_tile_free_data (gpointer       data,
+                     GDestroyNotify destroy_notify,
+                     gpointer       destroy_notify_data)
+{
+  if (destroy_notify)
+    {
+      if (destroy_notify == (void*)&free_data_directly)
+        gegl_free (data);
+      else
+        destroy_notify (destroy_notify_data);
+    }
+}
+
+/* the counter of the tiles sharing the data of @tile, created when it is
+ * shared for the first time
+ */
+static gint *
+gegl_tile_get_n_clones (GeglTile *tile)
+{
+  gint *n_clones = g_atomic_pointer_get (&tile->n_clones);
+
+  if (G_UNLIKELY (! n_clones))
+    {
+      n_clones  = g_slice_new (gint);
+      *n_clones = 1;
+
+      /* duplicated from another thread at the same time */
+      if (! g_atomic_pointer_compare_and_exchange (&tile->n_clones,
+                                                   NULL, n_clones))
+        {
+          g_slice_free (gint, n_clones);
+          n_clones = g_atomic_pointer_get (&tile->n_clones);
+        }
+    }
+
+  return n_clones;
+}
+
 void gegl_tile_unref (GeglTile *tile)
 {
   if (!g_atomic_int_dec_and_test (&tile->ref_count))
@@ -58,30 +101,20 @@ void gegl_tile_unref (GeglTile *tile)
    */
   gegl_tile_store (tile);
 
-  g_mutex_lock (&cowmutex);
   if (tile->data)
     {
-      if (tile->next_shared == tile)
-        { /* no clones */
-          g_mutex_unlock (&cowmutex);
-          if (tile->destroy_notify)
-            {
-              if (tile->destroy_notify == (void*)&free_data_directly)
-                gegl_free (tile->data);
-              else
-                tile->destroy_notify (tile->destroy_notify_data);
-            }
-          tile->data = NULL;
-        }
-      else
+      /* the last of the tiles sharing the data frees it */
+      if (! tile->n_clones || g_atomic_int_dec_and_test (tile->n_clones))
         {
-          tile->prev_shared->next_shared = tile->next_shared;
-          tile->next_shared->prev_shared = tile->prev_shared;
-          g_mutex_unlock (&cowmutex);
+          if (tile->n_clones)
+            g_slice_free (gint, tile->n_clones);
+
+          gegl_tile_free_data (tile->data,
+                               tile->destroy_notify,
+                               tile->destroy_notify_data);
         }
+      tile->data = NULL;
     }
-  else
-    g_mutex_unlock (&cowmutex);
 
   g_slice_free (GeglTile, tile);
 }
@@ -97,9 +130,7 @@ gegl_tile_new_bare (void)
   tile->rev          = 1;
   tile->lock         = 0;
   tile->data         = NULL;
-
-  tile->next_shared = tile;
-  tile->prev_shared = tile;
+  tile->n_clones     = NULL;
 
   tile->destroy_notify = (void*)&free_data_directly;
   tile->destroy_notify_data = NULL;
@@ -112,23 +143,19 @@ gegl_tile_dup (GeglTile *src)
 {
   GeglTile *tile = gegl_tile_new_bare ();
 
-  g_mutex_lock (&cowmutex);
+  tile->n_clones = gegl_tile_get_n_clones (src);
+  g_atomic_int_inc (tile->n_clones);
 
   tile->tile_storage = src->tile_storage;
   tile->data         = src->data;
   tile->size         = src->size;
   tile->is_zero_tile = src->is_zero_tile;
+  tile->is_uniform   = src->is_uniform;
+  tile->read_only    = src->read_only;
 
   tile->destroy_notify      = src->destroy_notify;
   tile->destroy_notify_data = src->destroy_notify_data;
 
-  tile->next_shared              = src->next_shared;
-  src->next_shared               = tile;
-  tile->prev_shared              = src;
-  tile->next_shared->prev_shared = tile;
-
-  g_mutex_unlock (&cowmutex);
-
   return tile;
 }
 
@@ -137,9 +164,25 @@ gegl_tile_new (gint size)
 {
   GeglTile *tile = gegl_tile_new_bare ();
 
-  tile->data = gegl_malloc (size);
+  tile->data = gegl_tile_alloc (size);
   tile->size = size;
 
+  tile->destroy_notify      = (GDestroyNotify) gegl_tile_free;
+  tile->destroy_notify_data = tile->data;
+
+  return tile;
+}
+
+GeglTile *
+gegl_tile_new_uniform (gint          size,
+                       gconstpointer pixel,
+                       gint          bpp)
+{
+  GeglTile *tile = gegl_tile_new (size);
+
+  gegl_memset_pattern (tile->data, pixel, bpp, size / bpp);
+  tile->is_uniform = 1;
+
   return tile;
 }
 
@@ -147,41 +190,52 @@ static gpointer
 gegl_memdup (gpointer src, gsize size)
 {
   gpointer ret;
-  ret = gegl_malloc (size);
+  ret = gegl_tile_alloc (size);
   memcpy (ret, src, size);
   return ret;
 }
 
+/* gives @tile a copy of its data of its own, when it shares it with other
+ * tiles or its data can not be written to; called with the tile locked for
+ * writing
+ */
 static void
 gegl_tile_unclone (GeglTile *tile)
 {
-  g_mutex_lock (&cowmutex);
-  if (tile->next_shared != tile)
+  gint *n_clones = tile->n_clones;
+
+  if ((n_clones && g_atomic_int_get (n_clones) > 1) || tile->read_only)
     {
-      tile->prev_shared->next_shared = tile->next_shared;
-      tile->next_shared->prev_shared = tile->prev_shared;
-      tile->prev_shared              = tile;
-      tile->next_shared              = tile;
-      g_mutex_unlock (&cowmutex);
+      gpointer       data                = tile->data;
+      GDestroyNotify destroy_notify      = tile->destroy_notify;
+      gpointer       destroy_notify_data = tile->destroy_notify_data;
 
       /* the tile data is shared with other tiles,
        * create a local copy
        */
       if (tile->is_zero_tile)
         {
-          tile->data = gegl_calloc (tile->size, 1);
+          tile->data = gegl_tile_alloc0 (tile->size);
           tile->is_zero_tile = 0;
         }
       else
         {
-          tile->data = gegl_memdup (tile->data, tile->size);
+          tile->data = gegl_memdup (data, tile->size);
+        }
+      tile->destroy_notify           = (GDestroyNotify) gegl_tile_free;
+      tile->destroy_notify_data      = tile->data;
+      tile->n_clones                 = NULL;
+      tile->read_only                = 0;
+
+      /* the other tiles may have let go of the data while it was copied,
+       * leaving it to this one to free
+       */
+      if (! n_clones || g_atomic_int_dec_and_test (n_clones))
+        {
+          if (n_clones)
+            g_slice_free (gint, n_clones);
+          gegl_tile_free_data (data, destroy_notify, destroy_notify_data);
         }
-      tile->destroy_notify           = (void*)&free_data_directly;
-      tile->destroy_notify_data      = NULL;
-    }
-  else
-    {
-      g_mutex_unlock (&cowmutex);
     }
 }
 
@@ -199,6 +253,9 @@ gegl_tile_lock (GeglTile *tile)
   }
 
   gegl_tile_unclone (tile);
+
+  /* whatever gets written, the pixels can no longer be assumed equal */
+  tile->is_uniform = 0;
 }
 
 static void
@@ -213,7 +270,7 @@ _gegl_tile_void_pyramid (GeglTileSource *source,
   _gegl_tile_void_pyramid (source, x/2, y/2, z+1);
 }
 
-static void
+void
 gegl_tile_void_pyramid (GeglTile *tile)
 {
   if (tile->tile_storage &&
@@ -302,12 +359,21 @@ guchar *gegl_tile_get_data (GeglTile *tile)
   return tile->data;
 }
 
+gboolean gegl_tile_is_uniform (GeglTile *tile)
+{
+  return tile->is_uniform != 0;
+}
+
 void gegl_tile_set_data (GeglTile *tile,
                          gpointer  pixel_data,
                          gint      pixel_data_size)
 {
-  tile->data = pixel_data;
-  tile->size = pixel_data_size;
+  tile->data                = pixel_data;
+  tile->size                = pixel_data_size;
+  tile->read_only           = 0;
+  /* the old data had its own way of being freed */
+  tile->destroy_notify      = (void*)&free_data_directly;
+  tile->destroy_notify_data = NULL;
 }
 
 void gegl_tile_set_data_full (GeglTile      *tile,
@@ -318,6 +384,7 @@ void gegl_tile_set_data_full (GeglTile      *tile,
 {
   tile->data                = pixel_data;
   tile->size                = pixel_data_size;
+  tile->read_only           = 0;
   tile->destroy_notify      = destroy_notify;
   tile->destroy_notify_data = destroy_notify_data;
 }
@@ -24,6 +24,12 @@
 
 GeglTile   * gegl_tile_new            (gint             size);
 GeglTile   * gegl_tile_new_bare       (void);
+/* a tile of @size bytes with every pixel set to the @bpp bytes at @pixel,
+ * marked as uniform
+ */
+GeglTile   * gegl_tile_new_uniform    (gint              size,
+                                       gconstpointer     pixel,
+                                       gint              bpp);
 GeglTile   * gegl_tile_ref            (GeglTile         *tile);
 
 void         gegl_tile_unref          (GeglTile         *tile);
@@ -43,6 +49,10 @@ void         gegl_tile_mark_as_stored (GeglTile         *tile);
 gboolean     gegl_tile_is_stored      (GeglTile         *tile);
 gboolean     gegl_tile_store          (GeglTile         *tile);
 void         gegl_tile_void           (GeglTile         *tile);
+/* voids the tiles of the mipmap levels above @tile, which no longer match
+ * its contents
+ */
+void         gegl_tile_void_pyramid   (GeglTile         *tile);
 GeglTile    *gegl_tile_dup            (GeglTile         *tile);
 
 void         gegl_tile_set_rev        (GeglTile         *tile,
@@ -50,6 +60,8 @@ void         gegl_tile_set_rev        (GeglTile         *tile,
 guint        gegl_tile_get_rev        (GeglTile         *tile);
 
 guchar      *gegl_tile_get_data       (GeglTile         *tile);
+/* whether every pixel of @tile is known to equal the first one */
+gboolean     gegl_tile_is_uniform     (GeglTile         *tile);
 void         gegl_tile_set_data       (GeglTile         *tile,
                                        gpointer          pixel_data,
                                        gint              pixel_data_size);
@@ -27,9 +27,34 @@
 
 #include "gegl-types.h"
 #include "gegl-algorithms.h"
+#include "gegl-cpuaccel.h"
 
 #include <math.h>
 
+typedef void (* GeglDownscale2x2Func) (gint    bpp,
+                                       gint    src_width,
+                                       gint    src_height,
+                                       guchar *src_data,
+                                       gint    src_rowstride,
+                                       guchar *dst_data,
+                                       gint    dst_rowstride);
+
+typedef void (* GeglResampleFunc) (guchar              *dest_buf,
+                                   const guchar        *source_buf,
+                                   const GeglRectangle *dst_rect,
+                                   const GeglRectangle *src_rect,
+                                   gint                 s_rowstride,
+                                   gdouble              scale,
+                                   gint                 bpp,
+                                   gint                 d_rowstride);
+
+static GeglDownscale2x2Func gegl_downscale_2x2_get_simd      (const Babl *comp_type,
+                                                              gint        bpp);
+static GeglResampleFunc     gegl_resample_boxfilter_get_simd (const Babl *comp_type,
+                                                              gint        bpp);
+static GeglResampleFunc     gegl_resample_bilinear_get_simd  (const Babl *comp_type,
+                                                              gint        bpp);
+
 void gegl_downscale_2x2 (const Babl *format,
                          gint    src_width,
                          gint    src_height,
@@ -40,8 +65,11 @@ void gegl_downscale_2x2 (const Babl *format,
 {
   const gint  bpp = babl_format_get_bytes_per_pixel (format);
   const Babl *comp_type = babl_format_get_type (format, 0);
+  GeglDownscale2x2Func simd = gegl_downscale_2x2_get_simd (comp_type, bpp);
 
-  if (comp_type == babl_type ("float"))
+  if (simd)
+    simd (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
+  else if (comp_type == babl_type ("float"))
     gegl_downscale_2x2_float (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
   else if (comp_type == babl_type ("u8"))
     gegl_downscale_2x2_u8 (bpp, src_width, src_height, src_data, src_rowstride, dst_data, dst_rowstride);
@@ -95,8 +123,12 @@ void gegl_resample_boxfilter (guchar              *dest_buf,
 {
   const Babl *comp_type  = babl_format_get_type (format, 0);
   const gint bpp = babl_format_get_bytes_per_pixel (format);
+  GeglResampleFunc simd = gegl_resample_boxfilter_get_simd (comp_type, bpp);
 
-  if (comp_type == babl_type ("u8"))
+  if (simd)
+    simd (dest_buf, source_buf, dst_rect, src_rect,
+          s_rowstride, scale, bpp, d_rowstride);
+  else if (comp_type == babl_type ("u8"))
     gegl_resample_boxfilter_u8 (dest_buf, source_buf, dst_rect, src_rect,
                                 s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("u16"))
@@ -127,8 +159,12 @@ void gegl_resample_bilinear (guchar              *dest_buf,
 {
   const Babl *comp_type  = babl_format_get_type (format, 0);
   const gint bpp = babl_format_get_bytes_per_pixel (format);
+  GeglResampleFunc simd = gegl_resample_bilinear_get_simd (comp_type, bpp);
 
-  if (comp_type == babl_type ("u8"))
+  if (simd)
+    simd (dest_buf, source_buf, dst_rect, src_rect,
+          s_rowstride, scale, bpp, d_rowstride);
+  else if (comp_type == babl_type ("u8"))
     gegl_resample_bilinear_u8 (dest_buf, source_buf, dst_rect, src_rect,
                                s_rowstride, scale, bpp, d_rowstride);
   else if (comp_type == babl_type ("u16"))
@@ -314,3 +350,170 @@ gegl_resample_nearest (guchar              *dst,
 #undef BILINEAR_TYPE
 #undef BILINEAR_ROUND
 
+/* Vector versions of the above for the formats most buffers and mipmaps
+ * are in: 2x2 downscales of four float (RGBA float, RaGaBaA float, ...),
+ * one float (Y float, ...) and four u8 (R'G'B'A u8, ...) components, and
+ * boxfilter and bilinear resampling of four floats.  They are written with
+ * GCC vector extensions, compiled for each instruction set through the
+ * target attribute and picked at run time from gegl_cpu_accel_get_support ().
+ */
+#if defined(ARCH_X86) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+
+typedef gfloat  gegl_algorithms_v4sf __attribute__ ((vector_size (16)));
+typedef gint32  gegl_algorithms_v4si __attribute__ ((vector_size (16)));
+typedef guint32 gegl_algorithms_v4su __attribute__ ((vector_size (16)));
+typedef gfloat  gegl_algorithms_v8sf __attribute__ ((vector_size (32)));
+typedef gint32  gegl_algorithms_v8si __attribute__ ((vector_size (32)));
+typedef guint32 gegl_algorithms_v8su __attribute__ ((vector_size (32)));
+
+#ifdef __clang__
+#define SHUFFLE4(a, b, i0, i1, i2, i3) \
+  __builtin_shufflevector ((a), (b), i0, i1, i2, i3)
+#define SHUFFLE8(a, b, i0, i1, i2, i3, i4, i5, i6, i7) \
+  __builtin_shufflevector ((a), (b), i0, i1, i2, i3, i4, i5, i6, i7)
+#else
+#define SHUFFLE4(a, b, i0, i1, i2, i3) \
+  __builtin_shuffle ((a), (b), (gegl_algorithms_v4si) {i0, i1, i2, i3})
+#define SHUFFLE8(a, b, i0, i1, i2, i3, i4, i5, i6, i7) \
+  __builtin_shuffle ((a), (b), (gegl_algorithms_v8si) {i0, i1, i2, i3, i4, i5, i6, i7})
+#endif
+
+#define DOWNSCALE_SIMD_TARGET       __attribute__ ((target ("sse2")))
+#define DOWNSCALE_SIMD_FLOATS       4
+#define DOWNSCALE_SIMD_VF           gegl_algorithms_v4sf
+#define DOWNSCALE_SIMD_VU           gegl_algorithms_v4su
+#define DOWNSCALE_SIMD_EVEN(a, b)   SHUFFLE4 (a, b, 0, 2, 4, 6)
+#define DOWNSCALE_SIMD_ODD(a, b)    SHUFFLE4 (a, b, 1, 3, 5, 7)
+#define DOWNSCALE_SIMD_ORDER(v)     (v)
+#define DOWNSCALE_SIMD_EVEN_PIXELS(a, b) (a)
+#define DOWNSCALE_SIMD_ODD_PIXELS(a, b)  (b)
+#define DOWNSCALE_SIMD_RGBA_FLOAT   gegl_downscale_2x2_rgba_float_sse2
+#define DOWNSCALE_SIMD_Y_FLOAT      gegl_downscale_2x2_y_float_sse2
+#define DOWNSCALE_SIMD_RGBA_U8      gegl_downscale_2x2_rgba_u8_sse2
+#include "gegl-algorithms-2x2-downscale-simd.inc"
+#undef DOWNSCALE_SIMD_TARGET
+#undef DOWNSCALE_SIMD_FLOATS
+#undef DOWNSCALE_SIMD_VF
+#undef DOWNSCALE_SIMD_VU
+#undef DOWNSCALE_SIMD_EVEN
+#undef DOWNSCALE_SIMD_ODD
+#undef DOWNSCALE_SIMD_ORDER
+#undef DOWNSCALE_SIMD_EVEN_PIXELS
+#undef DOWNSCALE_SIMD_ODD_PIXELS
+#undef DOWNSCALE_SIMD_RGBA_FLOAT
+#undef DOWNSCALE_SIMD_Y_FLOAT
+#undef DOWNSCALE_SIMD_RGBA_U8
+
+#define DOWNSCALE_SIMD_TARGET       __attribute__ ((target ("avx2")))
+#define DOWNSCALE_SIMD_FLOATS       8
+#define DOWNSCALE_SIMD_VF           gegl_algorithms_v8sf
+#define DOWNSCALE_SIMD_VU           gegl_algorithms_v8su
+#define DOWNSCALE_SIMD_EVEN(a, b)   SHUFFLE8 (a, b, 0, 2, 8, 10, 4, 6, 12, 14)
+#define DOWNSCALE_SIMD_ODD(a, b)    SHUFFLE8 (a, b, 1, 3, 9, 11, 5, 7, 13, 15)
+#define DOWNSCALE_SIMD_ORDER(v)     SHUFFLE8 (v, v, 0, 1, 4, 5, 2, 3, 6, 7)
+#define DOWNSCALE_SIMD_Y_FLOAT      gegl_downscale_2x2_y_float_avx2
+#define DOWNSCALE_SIMD_RGBA_U8      gegl_downscale_2x2_rgba_u8_avx2
+#include "gegl-algorithms-2x2-downscale-simd.inc"
+#undef DOWNSCALE_SIMD_TARGET
+#undef DOWNSCALE_SIMD_FLOATS
+#undef DOWNSCALE_SIMD_VF
+#undef DOWNSCALE_SIMD_VU
+#undef DOWNSCALE_SIMD_EVEN
+#undef DOWNSCALE_SIMD_ODD
+#undef DOWNSCALE_SIMD_ORDER
+#undef DOWNSCALE_SIMD_EVEN_PIXELS
+#undef DOWNSCALE_SIMD_ODD_PIXELS
+#undef DOWNSCALE_SIMD_RGBA_FLOAT
+#undef DOWNSCALE_SIMD_Y_FLOAT
+#undef DOWNSCALE_SIMD_RGBA_U8
+
+#undef SHUFFLE4
+#undef SHUFFLE8
+
+#define RESAMPLE_SIMD_TARGET         __attribute__ ((target ("sse2")))
+#define RESAMPLE_SIMD_LOAD(src)      ({ gegl_algorithms_v4sf v; memcpy (&v, (src), sizeof (v)); v; })
+#define RESAMPLE_SIMD_STORE(dst, v)  memcpy ((dst), &(v), sizeof (v))
+#define RESAMPLE_SIMD_BOXFILTER      gegl_resample_boxfilter_rgba_float_sse2
+#define RESAMPLE_SIMD_BILINEAR       gegl_resample_bilinear_rgba_float_sse2
+#include "gegl-algorithms-resample-simd.inc"
+#undef RESAMPLE_SIMD_TARGET
+#undef RESAMPLE_SIMD_LOAD
+#undef RESAMPLE_SIMD_STORE
+#undef RESAMPLE_SIMD_BOXFILTER
+#undef RESAMPLE_SIMD_BILINEAR
+
+static GeglDownscale2x2Func
+gegl_downscale_2x2_get_simd (const Babl *comp_type,
+                             gint        bpp)
+{
+  GeglCpuAccelFlags accel = gegl_cpu_accel_get_support ();
+  gboolean          avx2  = (accel & GEGL_CPU_ACCEL_X86_AVX2) != 0;
+
+  if (! (accel & GEGL_CPU_ACCEL_X86_SSE2))
+    return NULL;
+
+  /* two pixels per AVX2 vector need lane crossing shuffles, which makes
+   * them slower than one pixel per SSE2 vector
+   */
+  if (comp_type == babl_type ("float") && bpp == 4 * sizeof (gfloat))
+    return gegl_downscale_2x2_rgba_float_sse2;
+  else if (comp_type == babl_type ("float") && bpp == sizeof (gfloat))
+    return avx2 ? gegl_downscale_2x2_y_float_avx2 : gegl_downscale_2x2_y_float_sse2;
+  else if (comp_type == babl_type ("u8") && bpp == 4)
+    return avx2 ? gegl_downscale_2x2_rgba_u8_avx2 : gegl_downscale_2x2_rgba_u8_sse2;
+
+  return NULL;
+}
+
+static GeglResampleFunc
+gegl_resample_boxfilter_get_simd (const Babl *comp_type,
+                                  gint        bpp)
+{
+  if (! (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_SSE2))
+    return NULL;
+
+  if (comp_type == babl_type ("float") && bpp == 4 * sizeof (gfloat))
+    return gegl_resample_boxfilter_rgba_float_sse2;
+
+  return NULL;
+}
+
+static GeglResampleFunc
+gegl_resample_bilinear_get_simd (const Babl *comp_type,
+                                 gint        bpp)
+{
+  if (! (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_SSE2))
+    return NULL;
+
+  if (comp_type == babl_type ("float") && bpp == 4 * sizeof (gfloat))
+    return gegl_resample_bilinear_rgba_float_sse2;
+
+  return NULL;
+}
+
+#else
+
+static GeglDownscale2x2Func
+gegl_downscale_2x2_get_simd (const Babl *comp_type,
+                             gint        bpp)
+{
+  return NULL;
+}
+
+static GeglResampleFunc
+gegl_resample_boxfilter_get_simd (const Babl *comp_type,
+                                  gint        bpp)
+{
+  return NULL;
+}
+
+static GeglResampleFunc
+gegl_resample_bilinear_get_simd (const Babl *comp_type,
+                                 gint        bpp)
+{
+  return NULL;
+}
+
+#endif
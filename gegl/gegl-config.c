@@ -38,12 +38,19 @@ enum
   PROP_0,
   PROP_QUALITY,
   PROP_TILE_CACHE_SIZE,
+  PROP_TILE_CACHE_POLICY,
+  PROP_BUFFER_POOL_SIZE,
+  PROP_TILE_HUGE_PAGES,
+  PROP_RESULT_CACHE,
   PROP_CHUNK_SIZE,
   PROP_SWAP,
+  PROP_SWAP_COMPRESSION,
   PROP_TILE_WIDTH,
   PROP_TILE_HEIGHT,
   PROP_THREADS,
   PROP_USE_OPENCL,
+  PROP_OPENCL_CACHE,
+  PROP_OPENCL_CACHE_DIR,
   PROP_QUEUE_SIZE,
   PROP_APPLICATION_LICENSE
 };
@@ -64,6 +71,22 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_uint64 (value, config->tile_cache_size);
         break;
 
+      case PROP_TILE_CACHE_POLICY:
+        g_value_set_enum (value, config->tile_cache_policy);
+        break;
+
+      case PROP_BUFFER_POOL_SIZE:
+        g_value_set_int (value, config->buffer_pool_size);
+        break;
+
+      case PROP_TILE_HUGE_PAGES:
+        g_value_set_boolean (value, config->tile_huge_pages);
+        break;
+
+      case PROP_RESULT_CACHE:
+        g_value_set_boolean (value, config->result_cache);
+        break;
+
       case PROP_CHUNK_SIZE:
         g_value_set_int (value, config->chunk_size);
         break;
@@ -84,6 +107,10 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_string (value, config->swap);
         break;
 
+      case PROP_SWAP_COMPRESSION:
+        g_value_set_enum (value, config->swap_compression);
+        break;
+
       case PROP_THREADS:
         g_value_set_int (value, _gegl_threads);
         break;
@@ -92,6 +119,14 @@ gegl_config_get_property (GObject    *gobject,
         g_value_set_boolean (value, gegl_cl_is_accelerated());
         break;
 
+      case PROP_OPENCL_CACHE:
+        g_value_set_boolean (value, config->opencl_cache);
+        break;
+
+      case PROP_OPENCL_CACHE_DIR:
+        g_value_set_string (value, config->opencl_cache_dir);
+        break;
+
       case PROP_QUEUE_SIZE:
         g_value_set_int (value, config->queue_size);
         break;
@@ -119,6 +154,18 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_TILE_CACHE_SIZE:
         config->tile_cache_size = g_value_get_uint64 (value);
         break;
+      case PROP_TILE_CACHE_POLICY:
+        config->tile_cache_policy = g_value_get_enum (value);
+        break;
+      case PROP_BUFFER_POOL_SIZE:
+        config->buffer_pool_size = g_value_get_int (value);
+        break;
+      case PROP_TILE_HUGE_PAGES:
+        config->tile_huge_pages = g_value_get_boolean (value);
+        break;
+      case PROP_RESULT_CACHE:
+        config->result_cache = g_value_get_boolean (value);
+        break;
       case PROP_CHUNK_SIZE:
         config->chunk_size = g_value_get_int (value);
         break;
@@ -136,12 +183,23 @@ gegl_config_set_property (GObject      *gobject,
           g_free (config->swap);
         config->swap = g_value_dup_string (value);
         break;
+      case PROP_SWAP_COMPRESSION:
+        config->swap_compression = g_value_get_enum (value);
+        break;
       case PROP_THREADS:
         _gegl_threads = g_value_get_int (value);
         return;
       case PROP_USE_OPENCL:
         config->use_opencl = g_value_get_boolean (value);
         break;
+      case PROP_OPENCL_CACHE:
+        config->opencl_cache = g_value_get_boolean (value);
+        break;
+      case PROP_OPENCL_CACHE_DIR:
+        if (config->opencl_cache_dir)
+          g_free (config->opencl_cache_dir);
+        config->opencl_cache_dir = g_value_dup_string (value);
+        break;
       case PROP_QUEUE_SIZE:
         config->queue_size = g_value_get_int (value);
         break;
@@ -164,6 +222,9 @@ gegl_config_finalize (GObject *gobject)
   if (config->swap)
     g_free (config->swap);
 
+  if (config->opencl_cache_dir)
+    g_free (config->opencl_cache_dir);
+
   if (config->application_license)
     g_free (config->application_license);
 
@@ -206,6 +267,39 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_POLICY,
+                                   g_param_spec_enum ("tile-cache-policy",
+                                                      "Tile Cache policy",
+                                                      "which tiles are evicted when the tile cache is full, 2q resists large sequential passes",
+                                                      GEGL_TYPE_TILE_CACHE_POLICY,
+                                                      GEGL_TILE_CACHE_POLICY_LRU,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_BUFFER_POOL_SIZE,
+                                   g_param_spec_int ("buffer-pool-size",
+                                                     "Buffer pool size",
+                                                     "the number of released node output buffers kept for reuse, 0 disables recycling",
+                                                     0, G_MAXINT, 32,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_HUGE_PAGES,
+                                   g_param_spec_boolean ("tile-huge-pages",
+                                                         "Tile huge pages",
+                                                         "back tile data with transparent huge pages where the system supports them",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_RESULT_CACHE,
+                                   g_param_spec_boolean ("result-cache",
+                                                         "Result cache",
+                                                         "share rendered tiles between nodes computing the same thing, in a part of the tile cache",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
                                    g_param_spec_int ("chunk-size",
                                                      "Chunk size",
@@ -230,6 +324,15 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_COMPRESSION,
+                                   g_param_spec_enum ("swap-compression",
+                                                      "Swap compression",
+                                                      "how tiles are compressed when swapped out, or kept in RAM when swap is \"RAM\"",
+                                                      GEGL_TYPE_TILE_COMPRESSION,
+                                                      GEGL_TILE_COMPRESSION_NONE,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_THREADS,
                                    g_param_spec_int ("threads",
                                                      "Number of threads",
@@ -246,6 +349,22 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                          G_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_OPENCL_CACHE,
+                                   g_param_spec_boolean ("opencl-cache",
+                                                         "OpenCL cache",
+                                                         "keep built OpenCL programs on disk for later runs",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_OPENCL_CACHE_DIR,
+                                   g_param_spec_string ("opencl-cache-dir",
+                                                        "OpenCL cache directory",
+                                                        "where built OpenCL programs are kept",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
                                    g_param_spec_int ("queue-size",
                                                      "Queue size",
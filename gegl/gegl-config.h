@@ -36,12 +36,19 @@ struct _GeglConfig
   GObject  parent_instance;
 
   gchar   *swap;
+  GeglTileCompression swap_compression;
   guint64  tile_cache_size;
+  GeglTileCachePolicy tile_cache_policy;
+  gint     buffer_pool_size;
+  gboolean tile_huge_pages;
+  gboolean result_cache;
   gint     chunk_size; /* The size of elements being processed at once */
   gdouble  quality;
   gint     tile_width;
   gint     tile_height;
   gboolean use_opencl;
+  gboolean opencl_cache;
+  gchar   *opencl_cache_dir;
   gint     queue_size;
   gchar   *application_license;
 };
@@ -128,3 +128,55 @@ gegl_sampler_type_get_type (void)
 
   return etype;
 }
+
+GType
+gegl_tile_cache_policy_get_type (void)
+{
+  static GType etype = 0;
+
+  if (etype == 0)
+    {
+      static GEnumValue values[] = {
+        { GEGL_TILE_CACHE_POLICY_LRU, N_("LRU"), "lru" },
+        { GEGL_TILE_CACHE_POLICY_2Q,  N_("2Q"),  "2q"  },
+        { 0, NULL, NULL }
+      };
+      gint i;
+
+      for (i = 0; i < G_N_ELEMENTS (values); i++)
+        if (values[i].value_name)
+          values[i].value_name =
+            dgettext (GETTEXT_PACKAGE, values[i].value_name);
+
+      etype = g_enum_register_static ("GeglTileCachePolicy", values);
+    }
+
+  return etype;
+}
+
+GType
+gegl_tile_compression_get_type (void)
+{
+  static GType etype = 0;
+
+  if (etype == 0)
+    {
+      static GEnumValue values[] = {
+        { GEGL_TILE_COMPRESSION_NONE, N_("None"), "none" },
+        { GEGL_TILE_COMPRESSION_RLE,  N_("RLE"),  "rle"  },
+        { GEGL_TILE_COMPRESSION_FAST, N_("Fast"), "fast" },
+        { GEGL_TILE_COMPRESSION_ZLIB, N_("Zlib"), "zlib" },
+        { 0, NULL, NULL }
+      };
+      gint i;
+
+      for (i = 0; i < G_N_ELEMENTS (values); i++)
+        if (values[i].value_name)
+          values[i].value_name =
+            dgettext (GETTEXT_PACKAGE, values[i].value_name);
+
+      etype = g_enum_register_static ("GeglTileCompression", values);
+    }
+
+  return etype;
+}
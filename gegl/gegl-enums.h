@@ -82,6 +82,28 @@ GType gegl_sampler_type_get_type (void) G_GNUC_CONST;
 
 #define GEGL_TYPE_SAMPLER_TYPE (gegl_sampler_type_get_type ())
 
+
+typedef enum {
+  GEGL_TILE_CACHE_POLICY_LRU,
+  GEGL_TILE_CACHE_POLICY_2Q
+} GeglTileCachePolicy;
+
+GType gegl_tile_cache_policy_get_type (void) G_GNUC_CONST;
+
+#define GEGL_TYPE_TILE_CACHE_POLICY (gegl_tile_cache_policy_get_type ())
+
+
+typedef enum {
+  GEGL_TILE_COMPRESSION_NONE,
+  GEGL_TILE_COMPRESSION_RLE,
+  GEGL_TILE_COMPRESSION_FAST,
+  GEGL_TILE_COMPRESSION_ZLIB
+} GeglTileCompression;
+
+GType gegl_tile_compression_get_type (void) G_GNUC_CONST;
+
+#define GEGL_TYPE_TILE_COMPRESSION (gegl_tile_compression_get_type ())
+
 G_END_DECLS
 
 #endif /* __GEGL_ENUMS_H__ */
@@ -98,10 +98,13 @@ guint gegl_debug_flags = 0;
 #include "operation/gegl-operations.h"
 #include "operation/gegl-extension-handler-private.h"
 #include "buffer/gegl-buffer-private.h"
+#include "buffer/gegl-buffer-pool.h"
+#include "buffer/gegl-result-cache.h"
 #include "buffer/gegl-buffer-iterator-private.h"
 #include "buffer/gegl-tile-backend-ram.h"
 #include "buffer/gegl-tile-backend-file.h"
 #include "gegl-config.h"
+#include "gegl-stats.h"
 #include "graph/gegl-node-private.h"
 #include "gegl-random-private.h"
 
@@ -112,6 +115,7 @@ static gboolean  gegl_post_parse_hook (GOptionContext *context,
 
 
 static GeglConfig   *config = NULL;
+static GeglStats    *stats  = NULL;
 
 static GeglModuleDB *module_db   = NULL;
 
@@ -319,11 +323,17 @@ static void gegl_config_set_defaults (GeglConfig *config)
                                      GEGL_LIBRARY,
                                      "swap",
                                      NULL);
+  gchar *cl_cache_dir = g_build_filename (g_get_user_cache_dir (),
+                                          GEGL_LIBRARY,
+                                          "opencl",
+                                          NULL);
   g_object_set (config,
-                "swap", swapdir,
+                "swap",             swapdir,
+                "opencl-cache-dir", cl_cache_dir,
                 NULL);
 
   g_free (swapdir);
+  g_free (cl_cache_dir);
 }
 
 static void gegl_config_parse_env (GeglConfig *config)
@@ -345,6 +355,53 @@ static void gegl_config_parse_env (GeglConfig *config)
   if (g_getenv ("GEGL_CACHE_SIZE"))
     config->tile_cache_size = atoll(g_getenv("GEGL_CACHE_SIZE"))* 1024*1024;
 
+  if (g_getenv ("GEGL_TILE_CACHE_POLICY"))
+    {
+      const gchar *policy = g_getenv ("GEGL_TILE_CACHE_POLICY");
+
+      if (g_ascii_strcasecmp (policy, "lru") == 0)
+        config->tile_cache_policy = GEGL_TILE_CACHE_POLICY_LRU;
+      else if (g_ascii_strcasecmp (policy, "2q") == 0)
+        config->tile_cache_policy = GEGL_TILE_CACHE_POLICY_2Q;
+      else
+        g_warning ("Unknown value for GEGL_TILE_CACHE_POLICY: %s", policy);
+    }
+
+  if (g_getenv ("GEGL_BUFFER_POOL_SIZE"))
+    config->buffer_pool_size = atoi (g_getenv ("GEGL_BUFFER_POOL_SIZE"));
+
+  if (g_getenv ("GEGL_TILE_HUGE_PAGES"))
+    {
+      const gchar *huge_pages = g_getenv ("GEGL_TILE_HUGE_PAGES");
+
+      config->tile_huge_pages = ! (g_str_equal (huge_pages, "0") ||
+                                   g_ascii_strcasecmp (huge_pages, "no") == 0);
+    }
+
+  if (g_getenv ("GEGL_RESULT_CACHE"))
+    {
+      const gchar *result_cache = g_getenv ("GEGL_RESULT_CACHE");
+
+      config->result_cache = ! (g_str_equal (result_cache, "0") ||
+                                g_ascii_strcasecmp (result_cache, "no") == 0);
+    }
+
+  if (g_getenv ("GEGL_SWAP_COMPRESSION"))
+    {
+      const gchar *compression = g_getenv ("GEGL_SWAP_COMPRESSION");
+      GEnumClass  *enum_class  = g_type_class_ref (GEGL_TYPE_TILE_COMPRESSION);
+      GEnumValue  *enum_value;
+
+      enum_value = g_enum_get_value_by_nick (enum_class, compression);
+
+      if (enum_value)
+        config->swap_compression = enum_value->value;
+      else
+        g_warning ("Unknown value for GEGL_SWAP_COMPRESSION: %s", compression);
+
+      g_type_class_unref (enum_class);
+    }
+
   if (g_getenv ("GEGL_CHUNK_SIZE"))
     config->chunk_size = atoi(g_getenv("GEGL_CHUNK_SIZE"));
 
@@ -387,6 +444,19 @@ static void gegl_config_parse_env (GeglConfig *config)
         g_warning ("Unknown value for GEGL_USE_OPENCL: %s", opencl_env);
     }
 
+  if (g_getenv ("GEGL_CL_CACHE"))
+    {
+      const char *cache_env = g_getenv ("GEGL_CL_CACHE");
+
+      if (g_ascii_strcasecmp (cache_env, "no") == 0)
+        g_object_set (config, "opencl-cache", FALSE, NULL);
+      else
+        g_object_set (config,
+                      "opencl-cache",     TRUE,
+                      "opencl-cache-dir", cache_env,
+                      NULL);
+    }
+
   if (g_getenv ("GEGL_SWAP"))
     g_object_set (config, "swap", g_getenv ("GEGL_SWAP"), NULL);
 }
@@ -401,6 +471,15 @@ GeglConfig *gegl_config (void)
   return config;
 }
 
+GeglStats *gegl_stats (void)
+{
+  /* may be asked for from any thread */
+  if (g_once_init_enter (&stats))
+    g_once_init_leave (&stats, g_object_new (GEGL_TYPE_STATS, NULL));
+
+  return stats;
+}
+
 static void swap_clean (void)
 {
   const gchar  *swap_dir = gegl_swap_dir ();
@@ -439,6 +518,7 @@ static void swap_clean (void)
 }
 
 void gegl_temp_buffer_free (void);
+void gegl_parallel_cleanup (void);
 
 void
 gegl_exit (void)
@@ -451,6 +531,11 @@ gegl_exit (void)
 
   GEGL_INSTRUMENT_START()
 
+  /* the worker threads may still hold tiles and per thread data */
+  gegl_parallel_cleanup ();
+
+  gegl_buffer_pool_cleanup ();
+  gegl_result_cache_cleanup ();
   gegl_tile_backend_swap_cleanup ();
   gegl_tile_cache_destroy ();
   gegl_operation_gtype_cleanup ();
@@ -466,6 +551,12 @@ gegl_exit (void)
       module_db = NULL;
     }
 
+  if (stats != NULL)
+    {
+      g_object_unref (stats);
+      stats = NULL;
+    }
+
   babl_exit ();
 
   GEGL_INSTRUMENT_END ("gegl", "gegl_exit")
@@ -94,6 +94,24 @@ void          gegl_load_module_directory (const gchar *path);
  */
 GeglConfig   *gegl_config                (void);
 
+/**
+ * gegl_stats:
+ *
+ * Returns a GeglStats object with properties that can be read to monitor
+ * GEGL statistics, like the hit and miss counts of the tile cache.
+ *
+ * Return value: (transfer none): a #GeglStats
+ */
+GeglStats    *gegl_stats                 (void);
+
+/**
+ * gegl_stats_reset:
+ * @stats: a #GeglStats
+ *
+ * Resets the cumulative counters of @stats to zero.
+ */
+void          gegl_stats_reset           (GeglStats *stats);
+
 G_END_DECLS
 
 #endif /* __GEGL_INIT_H__ */
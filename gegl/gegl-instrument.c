@@ -42,6 +42,9 @@ gboolean gegl_instrument_enabled = FALSE;
 
 static Timing *root = NULL;
 
+/* timings may be recorded from several threads at once */
+static GRecMutex timing_mutex;
+
 static Timing *iter_next (Timing *iter)
 {
   if (iter->children)
@@ -112,6 +115,8 @@ real_gegl_instrument (const gchar *parent_name,
   Timing *iter;
   Timing *parent;
 
+  g_rec_mutex_lock (&timing_mutex);
+
   if (root == NULL)
     {
       root       = g_slice_new0 (Timing);
@@ -134,6 +139,8 @@ real_gegl_instrument (const gchar *parent_name,
       parent->children = iter;
     }
   iter->usecs += usecs;
+
+  g_rec_mutex_unlock (&timing_mutex);
 }
 
 
@@ -297,8 +304,11 @@ gegl_instrument_utf8 (void)
 {
   GString *s = g_string_new ("");
   gchar   *ret;
-  Timing  *iter = root;
+  Timing  *iter;
+
+  g_rec_mutex_lock (&timing_mutex);
 
+  iter = root;
   sort_children (root);
 
   while (iter)
@@ -343,6 +353,8 @@ gegl_instrument_utf8 (void)
       iter = iter_next (iter);
     }
 
+  g_rec_mutex_unlock (&timing_mutex);
+
   ret = g_strdup (s->str);
   g_string_free (s, TRUE);
   return ret;
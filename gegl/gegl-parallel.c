@@ -0,0 +1,381 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-parallel.h"
+
+/* A slot holds the range of tasks [begin, end) not yet started by one of
+ * the threads participating in a job. The owner takes tasks from the front
+ * of its slot, thieves take the upper half of the range.
+ */
+typedef struct
+{
+  GMutex mutex;
+  gint   begin;
+  gint   end;
+} GeglParallelSlot;
+
+typedef struct
+{
+  GeglParallelForFunc func;
+  gpointer            user_data;
+  gint                n_slots;
+  gint                next_slot; /* next slot to be claimed by a worker */
+  gint                n_active;  /* workers that have not left the job yet */
+  GeglParallelSlot    slots[GEGL_MAX_THREADS];
+} GeglParallelJob;
+
+typedef struct
+{
+  const GeglRectangle     *area;
+  GeglParallelForAreaFunc  func;
+  gpointer                 user_data;
+  gboolean                 horizontal;
+  gint                     stride;
+  gint                     first_unit;
+  gint                     n_units;
+  gint                     n_tasks;
+} GeglParallelAreaData;
+
+static GMutex   pool_mutex;       /* protects everything below */
+static GCond    pool_cond;        /* signalled when a job is queued */
+static GCond    pool_done_cond;   /* signalled when a job loses its last worker */
+static GQueue   pool_jobs        = G_QUEUE_INIT; /* jobs with unclaimed slots */
+static GThread *pool_workers[GEGL_MAX_THREADS];
+static gint     pool_n_workers   = 0;
+static gboolean pool_shutdown    = FALSE;  /* workers are to exit when idle */
+
+static GPrivate in_parallel      = G_PRIVATE_INIT (NULL);
+
+
+static gboolean
+gegl_parallel_slot_pop (GeglParallelSlot *slot,
+                        gint             *task)
+{
+  gboolean found = FALSE;
+
+  g_mutex_lock (&slot->mutex);
+  if (slot->begin < slot->end)
+    {
+      *task = slot->begin++;
+      found = TRUE;
+    }
+  g_mutex_unlock (&slot->mutex);
+
+  return found;
+}
+
+/* moves the upper half of the largest remaining range of another slot into
+ * the (empty) slot self, returns FALSE when there is nothing left to steal.
+ */
+static gboolean
+gegl_parallel_job_steal (GeglParallelJob *job,
+                         gint             self)
+{
+  while (TRUE)
+    {
+      GeglParallelSlot *victim    = NULL;
+      gint              remaining = 0;
+      gint              begin;
+      gint              end;
+      gint              i;
+
+      /* unlocked reads, the choice is re-validated under the lock */
+      for (i = 0; i < job->n_slots; i++)
+        {
+          gint slot_remaining;
+
+          if (i == self)
+            continue;
+
+          slot_remaining = g_atomic_int_get (&job->slots[i].end) -
+                           g_atomic_int_get (&job->slots[i].begin);
+
+          if (slot_remaining > remaining)
+            {
+              remaining = slot_remaining;
+              victim    = &job->slots[i];
+            }
+        }
+
+      if (! victim)
+        return FALSE;
+
+      g_mutex_lock (&victim->mutex);
+      remaining = victim->end - victim->begin;
+      if (remaining <= 0)
+        {
+          g_mutex_unlock (&victim->mutex);
+          continue;
+        }
+      begin       = victim->begin + remaining / 2;
+      end         = victim->end;
+      victim->end = begin;
+      g_mutex_unlock (&victim->mutex);
+
+      g_mutex_lock (&job->slots[self].mutex);
+      job->slots[self].begin = begin;
+      job->slots[self].end   = end;
+      g_mutex_unlock (&job->slots[self].mutex);
+
+      return TRUE;
+    }
+}
+
+static void
+gegl_parallel_job_run (GeglParallelJob *job,
+                       gint             self)
+{
+  gint task;
+
+  do
+    {
+      while (gegl_parallel_slot_pop (&job->slots[self], &task))
+        job->func (task, job->user_data);
+    }
+  while (gegl_parallel_job_steal (job, self));
+}
+
+static gpointer
+gegl_parallel_worker (gpointer data)
+{
+  g_private_set (&in_parallel, GINT_TO_POINTER (TRUE));
+
+  g_mutex_lock (&pool_mutex);
+
+  while (TRUE)
+    {
+      GeglParallelJob *job = g_queue_peek_head (&pool_jobs);
+      gint             slot;
+
+      if (! job)
+        {
+          if (pool_shutdown)
+            break;
+
+          g_cond_wait (&pool_cond, &pool_mutex);
+          continue;
+        }
+
+      slot = job->next_slot++;
+      if (job->next_slot >= job->n_slots)
+        g_queue_pop_head (&pool_jobs);
+      job->n_active++;
+
+      g_mutex_unlock (&pool_mutex);
+
+      gegl_parallel_job_run (job, slot);
+
+      g_mutex_lock (&pool_mutex);
+
+      if (--job->n_active == 0)
+        g_cond_broadcast (&pool_done_cond);
+    }
+
+  g_mutex_unlock (&pool_mutex);
+
+  return NULL;
+}
+
+/* must be called with pool_mutex held */
+static void
+gegl_parallel_ensure_workers (gint n_workers)
+{
+  n_workers = MIN (n_workers, GEGL_MAX_THREADS - 1);
+
+  while (pool_n_workers < n_workers)
+    {
+      pool_workers[pool_n_workers++] = g_thread_new ("gegl-worker",
+                                                     gegl_parallel_worker,
+                                                     NULL);
+    }
+}
+
+/* called from gegl_exit(), before anything the workers might still be
+ * using is torn down; lets the idle workers exit and joins them.  The
+ * pool is started again by the next gegl_parallel_for().
+ */
+void gegl_parallel_cleanup (void);
+void
+gegl_parallel_cleanup (void)
+{
+  gint n_workers;
+  gint i;
+
+  g_mutex_lock (&pool_mutex);
+  pool_shutdown = TRUE;
+  g_cond_broadcast (&pool_cond);
+  n_workers = pool_n_workers;
+  g_mutex_unlock (&pool_mutex);
+
+  for (i = 0; i < n_workers; i++)
+    g_thread_join (pool_workers[i]);
+
+  g_mutex_lock (&pool_mutex);
+  pool_n_workers = 0;
+  pool_shutdown  = FALSE;
+  g_mutex_unlock (&pool_mutex);
+}
+
+void
+gegl_parallel_for (gint                n,
+                   GeglParallelForFunc func,
+                   gpointer            user_data)
+{
+  GeglParallelJob job;
+  gint            n_slots;
+  gint            i;
+
+  g_return_if_fail (func != NULL);
+
+  if (n <= 0)
+    return;
+
+  n_slots = MIN (n, MIN (gegl_config_threads (), GEGL_MAX_THREADS));
+
+  if (n_slots <= 1 || g_private_get (&in_parallel))
+    {
+      for (i = 0; i < n; i++)
+        func (i, user_data);
+      return;
+    }
+
+  job.func      = func;
+  job.user_data = user_data;
+  job.n_slots   = n_slots;
+  job.next_slot = 1; /* slot 0 belongs to the calling thread */
+  job.n_active  = 0;
+
+  for (i = 0; i < n_slots; i++)
+    {
+      g_mutex_init (&job.slots[i].mutex);
+      job.slots[i].begin = (gint64) n * i / n_slots;
+      job.slots[i].end   = (gint64) n * (i + 1) / n_slots;
+    }
+
+  g_mutex_lock (&pool_mutex);
+  gegl_parallel_ensure_workers (n_slots - 1);
+  g_queue_push_tail (&pool_jobs, &job);
+  g_cond_broadcast (&pool_cond);
+  g_mutex_unlock (&pool_mutex);
+
+  g_private_set (&in_parallel, GINT_TO_POINTER (TRUE));
+  gegl_parallel_job_run (&job, 0);
+  g_private_set (&in_parallel, NULL);
+
+  /* all tasks have been started, make sure no further workers join and
+   * wait for the ones still busy with their last task.
+   */
+  g_mutex_lock (&pool_mutex);
+  g_queue_remove (&pool_jobs, &job);
+  while (job.n_active > 0)
+    g_cond_wait (&pool_done_cond, &pool_mutex);
+  g_mutex_unlock (&pool_mutex);
+
+  for (i = 0; i < n_slots; i++)
+    g_mutex_clear (&job.slots[i].mutex);
+}
+
+static inline gint
+gegl_parallel_floor_div (gint a,
+                         gint b)
+{
+  return a >= 0 ? a / b : ((a + 1) / b) - 1;
+}
+
+static void
+gegl_parallel_area_task (gint     i,
+                         gpointer user_data)
+{
+  GeglParallelAreaData *data  = user_data;
+  GeglRectangle         roi   = *data->area;
+  gint                  start = data->horizontal ? roi.x : roi.y;
+  gint                  end   = start + (data->horizontal ? roi.width : roi.height);
+  gint                  begin_unit;
+  gint                  end_unit;
+
+  begin_unit = data->first_unit + (gint64) data->n_units * i / data->n_tasks;
+  end_unit   = data->first_unit + (gint64) data->n_units * (i + 1) / data->n_tasks;
+
+  start = MAX (start, begin_unit * data->stride);
+  end   = MIN (end,   end_unit   * data->stride);
+
+  if (data->horizontal)
+    {
+      roi.x     = start;
+      roi.width = end - start;
+    }
+  else
+    {
+      roi.y      = start;
+      roi.height = end - start;
+    }
+
+  data->func (&roi, data->user_data);
+}
+
+void
+gegl_parallel_for_area (const GeglRectangle     *area,
+                        GeglParallelForAreaFunc  func,
+                        gpointer                 user_data)
+{
+  GeglParallelAreaData data;
+  gint                 threads = gegl_config_threads ();
+  gint                 start;
+  gint                 length;
+
+  g_return_if_fail (area != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (area->width <= 0 || area->height <= 0)
+    return;
+
+  data.area       = area;
+  data.func       = func;
+  data.user_data  = user_data;
+  data.horizontal = area->width > area->height;
+
+  if (data.horizontal)
+    {
+      start       = area->x;
+      length      = area->width;
+      data.stride = gegl_config ()->tile_width;
+    }
+  else
+    {
+      start       = area->y;
+      length      = area->height;
+      data.stride = gegl_config ()->tile_height;
+    }
+
+  data.stride     = MAX (data.stride, 1);
+  data.first_unit = gegl_parallel_floor_div (start, data.stride);
+  data.n_units    = gegl_parallel_floor_div (start + length - 1, data.stride) -
+                    data.first_unit + 1;
+
+  if (threads <= 1 || g_private_get (&in_parallel))
+    data.n_tasks = 1;
+  else
+    data.n_tasks = MIN (data.n_units, threads * GEGL_PARALLEL_TASKS_PER_THREAD);
+
+  gegl_parallel_for (data.n_tasks, gegl_parallel_area_task, &data);
+}
@@ -0,0 +1,78 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_PARALLEL_H__
+#define __GEGL_PARALLEL_H__
+
+#include "gegl-types.h"
+
+G_BEGIN_DECLS
+
+/***
+ * Parallel processing:
+ *
+ * GEGL keeps a single process-wide pool of gegl_config_threads() worker
+ * threads, shared by all operations. Work is submitted as a number of
+ * independent tasks; each participating thread starts out with a
+ * contiguous range of tasks and steals half of the remaining range of
+ * another thread when it runs out, which keeps the load balanced when the
+ * cost per task varies. The calling thread takes part in the work, and
+ * blocks until all tasks are done.
+ *
+ * Calls made from within a task are executed serially in the calling
+ * thread.
+ */
+
+/* the number of tasks gegl_parallel_for_area() aims for per thread */
+#define GEGL_PARALLEL_TASKS_PER_THREAD 4
+
+typedef void (*GeglParallelForFunc)     (gint                 i,
+                                         gpointer             user_data);
+
+typedef void (*GeglParallelForAreaFunc) (const GeglRectangle *area,
+                                         gpointer             user_data);
+
+/**
+ * gegl_parallel_for:
+ * @n: the number of tasks
+ * @func: the function to call for each task
+ * @user_data: user data passed to @func
+ *
+ * Calls @func once for each integer in the range [0, @n), distributing the
+ * calls over the worker threads, and returns once all calls are done.
+ */
+void gegl_parallel_for      (gint                     n,
+                             GeglParallelForFunc      func,
+                             gpointer                 user_data);
+
+/**
+ * gegl_parallel_for_area:
+ * @area: the area to process
+ * @func: the function to call for each part of @area
+ * @user_data: user data passed to @func
+ *
+ * Splits @area into bands along its longest side and calls @func for each
+ * of them, distributing the calls over the worker threads. Band boundaries
+ * are aligned to the default tile grid, so that no tile is shared between
+ * two bands.
+ */
+void gegl_parallel_for_area (const GeglRectangle     *area,
+                             GeglParallelForAreaFunc  func,
+                             gpointer                 user_data);
+
+G_END_DECLS
+
+#endif /* __GEGL_PARALLEL_H__ */
@@ -31,6 +31,7 @@
 #include <gegl-types.h>
 #include <gegl-paramspecs.h>
 #include <gegl-audio-fragment.h>
+#include <gegl-parallel.h>
 
 G_BEGIN_DECLS
 
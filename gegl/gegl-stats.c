@@ -0,0 +1,298 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-stats.h"
+
+#include "buffer/gegl-tile-handler-cache.h"
+#include "buffer/gegl-tile-storage.h"
+#include "buffer/gegl-tile-compression.h"
+#include "buffer/gegl-buffer-pool.h"
+#include "buffer/gegl-tile-alloc.h"
+#include "buffer/gegl-result-cache.h"
+#include "process/gegl-processor-private.h"
+
+G_DEFINE_TYPE (GeglStats, gegl_stats, G_TYPE_OBJECT)
+
+enum
+{
+  PROP_0,
+  PROP_TILE_CACHE_TOTAL,
+  PROP_TILE_CACHE_HITS,
+  PROP_TILE_CACHE_MISSES,
+  PROP_TILE_CACHE_EVICTIONS,
+  PROP_TILE_CACHE_HOT_HITS,
+  PROP_TILE_CACHE_HOT_MISSES,
+  PROP_TILE_COMPRESSION_INPUT,
+  PROP_TILE_COMPRESSION_OUTPUT,
+  PROP_BUFFER_POOL_HITS,
+  PROP_BUFFER_POOL_MISSES,
+  PROP_TILE_ALLOC_RESERVED,
+  PROP_TILE_ALLOC_IN_USE,
+  PROP_TILE_ALLOC_RELEASED,
+  PROP_PROCESSOR_PIXELS_REQUESTED,
+  PROP_PROCESSOR_PIXELS_RENDERED,
+  PROP_RESULT_CACHE_TOTAL,
+  PROP_RESULT_CACHE_HITS,
+  PROP_RESULT_CACHE_MISSES
+};
+
+static void
+gegl_stats_get_property (GObject    *gobject,
+                         guint       property_id,
+                         GValue     *value,
+                         GParamSpec *pspec)
+{
+  switch (property_id)
+    {
+      case PROP_TILE_CACHE_TOTAL:
+        g_value_set_uint64 (value, gegl_tile_handler_cache_get_total ());
+        break;
+
+      case PROP_TILE_CACHE_HITS:
+        /* the hot tiles are in front of the cache, and only hold cached
+         * tiles
+         */
+        g_value_set_uint64 (value, gegl_tile_handler_cache_get_hits () +
+                                   gegl_tile_storage_get_hot_hits ());
+        break;
+
+      case PROP_TILE_CACHE_MISSES:
+        g_value_set_uint64 (value, gegl_tile_handler_cache_get_misses ());
+        break;
+
+      case PROP_TILE_CACHE_EVICTIONS:
+        g_value_set_uint64 (value, gegl_tile_handler_cache_get_evictions ());
+        break;
+
+      case PROP_TILE_CACHE_HOT_HITS:
+        g_value_set_uint64 (value, gegl_tile_storage_get_hot_hits ());
+        break;
+
+      case PROP_TILE_CACHE_HOT_MISSES:
+        g_value_set_uint64 (value, gegl_tile_storage_get_hot_misses ());
+        break;
+
+      case PROP_TILE_COMPRESSION_INPUT:
+        g_value_set_uint64 (value, gegl_tile_compression_get_input_bytes ());
+        break;
+
+      case PROP_TILE_COMPRESSION_OUTPUT:
+        g_value_set_uint64 (value, gegl_tile_compression_get_output_bytes ());
+        break;
+
+      case PROP_BUFFER_POOL_HITS:
+        g_value_set_uint64 (value, gegl_buffer_pool_get_hits ());
+        break;
+
+      case PROP_BUFFER_POOL_MISSES:
+        g_value_set_uint64 (value, gegl_buffer_pool_get_misses ());
+        break;
+
+      case PROP_TILE_ALLOC_RESERVED:
+        g_value_set_uint64 (value, gegl_tile_alloc_get_reserved ());
+        break;
+
+      case PROP_TILE_ALLOC_IN_USE:
+        g_value_set_uint64 (value, gegl_tile_alloc_get_in_use ());
+        break;
+
+      case PROP_TILE_ALLOC_RELEASED:
+        g_value_set_uint64 (value, gegl_tile_alloc_get_released ());
+        break;
+
+      case PROP_PROCESSOR_PIXELS_REQUESTED:
+        g_value_set_uint64 (value, gegl_processor_get_pixels_requested ());
+        break;
+
+      case PROP_PROCESSOR_PIXELS_RENDERED:
+        g_value_set_uint64 (value, gegl_processor_get_pixels_rendered ());
+        break;
+
+      case PROP_RESULT_CACHE_TOTAL:
+        g_value_set_uint64 (value, gegl_result_cache_get_total ());
+        break;
+
+      case PROP_RESULT_CACHE_HITS:
+        g_value_set_uint64 (value, gegl_result_cache_get_hits ());
+        break;
+
+      case PROP_RESULT_CACHE_MISSES:
+        g_value_set_uint64 (value, gegl_result_cache_get_misses ());
+        break;
+
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
+        break;
+    }
+}
+
+static void
+gegl_stats_class_init (GeglStatsClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->get_property = gegl_stats_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_TOTAL,
+                                   g_param_spec_uint64 ("tile-cache-total",
+                                                        "Tile Cache total",
+                                                        "Total size of tile cache in bytes",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_HITS,
+                                   g_param_spec_uint64 ("tile-cache-hits",
+                                                        "Tile Cache hits",
+                                                        "Number of tile requests served from the tile cache, including the per-thread hot tiles",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_MISSES,
+                                   g_param_spec_uint64 ("tile-cache-misses",
+                                                        "Tile Cache misses",
+                                                        "Number of tile requests not found in the tile cache",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_EVICTIONS,
+                                   g_param_spec_uint64 ("tile-cache-evictions",
+                                                        "Tile Cache evictions",
+                                                        "Number of tiles evicted from the tile cache to stay within tile-cache-size",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_HOT_HITS,
+                                   g_param_spec_uint64 ("tile-cache-hot-hits",
+                                                        "Hot tile hits",
+                                                        "Number of tiles found among the per-thread hot tiles, without walking the tile handler chain",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_CACHE_HOT_MISSES,
+                                   g_param_spec_uint64 ("tile-cache-hot-misses",
+                                                        "Hot tile misses",
+                                                        "Number of tiles not found among the per-thread hot tiles",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_COMPRESSION_INPUT,
+                                   g_param_spec_uint64 ("tile-compression-input",
+                                                        "Tile compression input",
+                                                        "Bytes of tile data passed through swap-compression",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_COMPRESSION_OUTPUT,
+                                   g_param_spec_uint64 ("tile-compression-output",
+                                                        "Tile compression output",
+                                                        "Bytes of tile data stored after swap-compression",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_BUFFER_POOL_HITS,
+                                   g_param_spec_uint64 ("buffer-pool-hits",
+                                                        "Buffer pool hits",
+                                                        "Number of node output buffers recycled from the buffer pool",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_BUFFER_POOL_MISSES,
+                                   g_param_spec_uint64 ("buffer-pool-misses",
+                                                        "Buffer pool misses",
+                                                        "Number of node output buffers that had to be created anew",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_ALLOC_RESERVED,
+                                   g_param_spec_uint64 ("tile-alloc-reserved",
+                                                        "Tile allocator reserved",
+                                                        "Bytes of slabs taken from the system for tile data",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_ALLOC_IN_USE,
+                                   g_param_spec_uint64 ("tile-alloc-in-use",
+                                                        "Tile allocator in use",
+                                                        "Bytes of tile data currently allocated",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_ALLOC_RELEASED,
+                                   g_param_spec_uint64 ("tile-alloc-released",
+                                                        "Tile allocator released",
+                                                        "Bytes of free tile data whose pages were given back to the system",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_PROCESSOR_PIXELS_REQUESTED,
+                                   g_param_spec_uint64 ("processor-pixels-requested",
+                                                        "Processor pixels requested",
+                                                        "Pixels of the rectangles processors were asked to render, counted at the start of every pass",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_PROCESSOR_PIXELS_RENDERED,
+                                   g_param_spec_uint64 ("processor-pixels-rendered",
+                                                        "Processor pixels rendered",
+                                                        "Pixels processors actually rendered, only the damaged parts of their rectangles",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_RESULT_CACHE_TOTAL,
+                                   g_param_spec_uint64 ("result-cache-total",
+                                                        "Result cache total",
+                                                        "Bytes of rendered tiles kept for nodes computing the same thing",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_RESULT_CACHE_HITS,
+                                   g_param_spec_uint64 ("result-cache-hits",
+                                                        "Result cache hits",
+                                                        "Number of node requests served from the result cache instead of being rendered",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_RESULT_CACHE_MISSES,
+                                   g_param_spec_uint64 ("result-cache-misses",
+                                                        "Result cache misses",
+                                                        "Number of node requests the result cache could not serve",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE));
+}
+
+static void
+gegl_stats_init (GeglStats *self)
+{
+}
+
+void
+gegl_stats_reset (GeglStats *stats)
+{
+  g_return_if_fail (GEGL_IS_STATS (stats));
+
+  gegl_tile_handler_cache_reset_stats ();
+  gegl_tile_storage_reset_hot_stats ();
+  gegl_tile_compression_reset_stats ();
+  gegl_buffer_pool_reset_stats ();
+  gegl_processor_reset_stats ();
+  gegl_result_cache_reset_stats ();
+}
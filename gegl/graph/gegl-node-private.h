@@ -81,6 +81,11 @@ struct _GeglNode
 
   gint            passthrough;
 
+  /* Tells the results of this node apart when they can not be described
+   * by its operation and inputs, renewed whenever the node is invalidated
+   */
+  gint            serial;
+
   /*< private >*/
   GeglNodePrivate *priv;
 };
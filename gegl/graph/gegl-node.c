@@ -35,6 +35,8 @@
 #include "gegl-visitable.h"
 #include "gegl-config.h"
 
+#include "buffer/gegl-region.h"
+
 #include "graph/gegl-visitor.h"
 
 #include "operation/gegl-operation.h"
@@ -202,6 +204,14 @@ gegl_node_class_init (GeglNodeClass *klass)
                   GEGL_TYPE_RECTANGLE);
 }
 
+static gint
+gegl_node_next_serial (void)
+{
+  static volatile gint serial = 0;
+
+  return g_atomic_int_add (&serial, 1) + 1;
+}
+
 static void
 gegl_node_init (GeglNode *self)
 {
@@ -215,6 +225,7 @@ gegl_node_init (GeglNode *self)
   self->operation   = NULL;
   self->is_graph    = FALSE;
   self->cache       = NULL;
+  self->serial      = gegl_node_next_serial ();
   g_mutex_init (&self->mutex);
 
 }
@@ -617,6 +628,7 @@ gegl_node_invalidated (GeglNode            *node,
       gegl_cache_invalidate (node->cache, rect);
     }
   node->valid_have_rect = FALSE;
+  g_atomic_int_set (&node->serial, gegl_node_next_serial ());
 
   g_signal_emit (node, gegl_node_signals[INVALIDATED], 0,
                  rect, NULL);
@@ -963,6 +975,120 @@ gegl_node_apply_roi (GeglNode            *self,
     }
 }
 
+typedef struct
+{
+  const GeglRectangle *roi;
+  const Babl          *format;
+  GeglBuffer          *buffer;
+  guchar              *destination_buf;
+  gint                 rowstride;
+} BlitData;
+
+static void
+gegl_node_blit_tile (GeglBuffer          *result,
+                     const GeglRectangle *tile,
+                     gpointer             user_data)
+{
+  BlitData *data = user_data;
+
+  if (data->buffer)
+    {
+      gegl_buffer_copy (result, tile, GEGL_ABYSS_NONE, data->buffer, tile);
+    }
+  else if (data->destination_buf)
+    {
+      gint    bpp = babl_format_get_bytes_per_pixel (data->format);
+      guchar *dst = data->destination_buf +
+                    (tile->y - data->roi->y) * data->rowstride +
+                    (tile->x - data->roi->x) * bpp;
+
+      gegl_buffer_get (result, tile, 1.0, data->format, dst,
+                       data->rowstride, GEGL_ABYSS_NONE);
+    }
+}
+
+/* Renders roi tile by tile into either buffer or destination_buf, returns
+ * FALSE when the graph does not lend itself to tiled rendering.  Rendering
+ * into destination_buf needs a format and a resolved rowstride, without
+ * them the layout of the pixels is only known from the result.
+ */
+static gboolean
+gegl_node_blit_tiled (GeglNode            *self,
+                      const GeglRectangle *roi,
+                      gint                 level,
+                      const Babl          *format,
+                      GeglBuffer          *buffer,
+                      gpointer             destination_buf,
+                      gint                 rowstride)
+{
+  GeglEvalManager *eval_manager = gegl_node_get_eval_manager (self);
+  GeglRectangle    bbox         = gegl_eval_manager_get_bounding_box (eval_manager);
+  BlitData         data;
+
+  if (destination_buf && (! format || rowstride == GEGL_AUTO_ROWSTRIDE))
+    return FALSE;
+
+  data.roi             = roi;
+  data.format          = format;
+  data.buffer          = buffer;
+  data.destination_buf = destination_buf;
+  data.rowstride       = rowstride;
+
+  if (! gegl_eval_manager_apply_tiled (eval_manager, roi, level,
+                                       gegl_node_blit_tile, &data))
+    return FALSE;
+
+  /* the tiles only cover the part of roi inside the bounding box, the
+   * rest is cleared like the abyss of a result would be */
+  if (! gegl_rectangle_contains (&bbox, roi))
+    {
+      if (buffer)
+        {
+          GeglRegion    *region = gegl_region_rectangle (roi);
+          GeglRegion    *inside = gegl_region_rectangle (&bbox);
+          GeglRectangle *rectangles;
+          gint           n_rectangles;
+          gint           i;
+
+          gegl_region_subtract (region, inside);
+          gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+
+          for (i = 0; i < n_rectangles; i++)
+            gegl_buffer_clear (buffer, &rectangles[i]);
+
+          g_free (rectangles);
+          gegl_region_destroy (inside);
+          gegl_region_destroy (region);
+        }
+      else if (destination_buf)
+        {
+          gint          bpp = babl_format_get_bytes_per_pixel (format);
+          GeglRectangle inside;
+          gint          y;
+
+          gegl_rectangle_intersect (&inside, &bbox, roi);
+
+          for (y = roi->y; y < roi->y + roi->height; y++)
+            {
+              guchar *row = (guchar *) destination_buf + (y - roi->y) * rowstride;
+
+              if (y < inside.y || y >= inside.y + inside.height || inside.width == 0)
+                {
+                  memset (row, 0, roi->width * bpp);
+                }
+              else
+                {
+                  memset (row, 0, (inside.x - roi->x) * bpp);
+                  memset (row + (inside.x + inside.width - roi->x) * bpp, 0,
+                          (roi->x + roi->width - inside.x - inside.width) * bpp);
+                }
+            }
+        }
+    }
+
+  return TRUE;
+}
+
 void
 gegl_node_blit_buffer (GeglNode            *self,
                        GeglBuffer          *buffer,
@@ -985,6 +1111,12 @@ gegl_node_blit_buffer (GeglNode            *self,
   else
     request = gegl_node_get_bounding_box (self);
 
+  /* the tiles are copied without an abyss, the area outside the bounding
+   * box is cleared */
+  if (abyss_policy == GEGL_ABYSS_NONE &&
+      gegl_node_blit_tiled (self, &request, level, NULL, buffer, NULL, 0))
+    return;
+
   result = gegl_eval_manager_apply (eval_manager, &request, level);
 
   if (result)
@@ -1031,6 +1163,10 @@ gegl_node_blit (GeglNode            *self,
         }
       else
         {
+          if (gegl_node_blit_tiled (self, roi, 0, format, NULL,
+                                    destination_buf, rowstride))
+            return;
+
           buffer = gegl_node_apply_roi (self, roi, 0);
         }
       if (buffer && destination_buf)
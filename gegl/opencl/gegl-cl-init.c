@@ -29,6 +29,7 @@
 #undef __GEGL_CL_INIT_MAIN__
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gmodule.h>
 #include <string.h>
 #include <stdio.h>
@@ -37,6 +38,8 @@
 #include "gegl-cl-color.h"
 #include "opencl/random.cl.h"
 
+#include "gegl.h"
+#include "gegl/gegl-config.h"
 #include "gegl/gegl-debug.h"
 
 GQuark gegl_opencl_error_quark (void);
@@ -149,6 +152,7 @@ typedef struct
   char platform_version[1024];
   char platform_ext    [1024];
   char device_name     [1024];
+  char driver_version  [1024];
 }
 GeglClState;
 
@@ -285,6 +289,119 @@ gegl_cl_has_extension (const char *extension_name)
   return gegl_cl_device_has_extension (cl_state.device, extension_name);
 }
 
+/* Returns the file in the opencl-cache-dir a program built from @sources
+ * with @options is cached in, or NULL if opencl-cache is off.  Anything
+ * that can make a binary unusable is part of the name, so stale binaries
+ * are never looked up.
+ */
+static gchar *
+gegl_cl_program_cache_path (const char   *sources[],
+                            const size_t  lengths[],
+                            gint          n_sources,
+                            const char   *options)
+{
+  GChecksum *checksum;
+  gchar     *name;
+  gchar     *path;
+  gint       i;
+
+  if (!gegl_config ()->opencl_cache || !gegl_config ()->opencl_cache_dir)
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  /* the terminating zeros keep the fields apart */
+  g_checksum_update (checksum, (const guchar *) cl_state.platform_name,
+                     strlen (cl_state.platform_name) + 1);
+  g_checksum_update (checksum, (const guchar *) cl_state.platform_version,
+                     strlen (cl_state.platform_version) + 1);
+  g_checksum_update (checksum, (const guchar *) cl_state.device_name,
+                     strlen (cl_state.device_name) + 1);
+  g_checksum_update (checksum, (const guchar *) cl_state.driver_version,
+                     strlen (cl_state.driver_version) + 1);
+  g_checksum_update (checksum, (const guchar *) (options ? options : ""),
+                     strlen (options ? options : "") + 1);
+
+  for (i = 0; i < n_sources; i++)
+    g_checksum_update (checksum, (const guchar *) sources[i], lengths[i]);
+
+  name = g_strconcat (g_checksum_get_string (checksum), ".bin", NULL);
+  path = g_build_filename (gegl_config ()->opencl_cache_dir, name, NULL);
+
+  g_checksum_free (checksum);
+  g_free (name);
+
+  return path;
+}
+
+static cl_program
+gegl_cl_program_cache_load (const gchar *path)
+{
+  gchar      *binary = NULL;
+  gsize       length = 0;
+  size_t      binary_length;
+  cl_int      binary_status = CL_SUCCESS;
+  cl_int      errcode = CL_SUCCESS;
+  cl_program  program;
+
+  if (!g_file_get_contents (path, &binary, &length, NULL))
+    return NULL;
+
+  binary_length = length;
+
+  program = gegl_clCreateProgramWithBinary (gegl_cl_get_context (),
+                                            1, &cl_state.device,
+                                            &binary_length,
+                                            (const unsigned char **) &binary,
+                                            &binary_status, &errcode);
+  g_free (binary);
+
+  if (errcode != CL_SUCCESS || binary_status != CL_SUCCESS)
+    {
+      GEGL_NOTE (GEGL_DEBUG_OPENCL, "Ignoring cached program %s: %s",
+                 path, gegl_cl_errstring (errcode != CL_SUCCESS ? errcode
+                                                                : binary_status));
+      if (program)
+        gegl_clReleaseProgram (program);
+      return NULL;
+    }
+
+  return program;
+}
+
+static void
+gegl_cl_program_cache_store (cl_program   program,
+                             const gchar *path)
+{
+  size_t          binary_length = 0;
+  unsigned char  *binary;
+  cl_int          errcode;
+  GError         *error = NULL;
+
+  errcode = gegl_clGetProgramInfo (program, CL_PROGRAM_BINARY_SIZES,
+                                   sizeof (size_t), &binary_length, NULL);
+  if (errcode != CL_SUCCESS || binary_length == 0)
+    return;
+
+  binary = g_malloc (binary_length);
+
+  errcode = gegl_clGetProgramInfo (program, CL_PROGRAM_BINARIES,
+                                   sizeof (unsigned char *), &binary, NULL);
+
+  /* g_file_set_contents () writes a temporary file and renames it, so
+   * concurrent processes never see a partially written binary.
+   */
+  if (errcode == CL_SUCCESS &&
+      g_mkdir_with_parents (gegl_config ()->opencl_cache_dir, S_IRUSR | S_IWUSR | S_IXUSR) == 0 &&
+      ! g_file_set_contents (path, (const gchar *) binary, binary_length, &error))
+    {
+      GEGL_NOTE (GEGL_DEBUG_OPENCL, "Could not cache program: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_free (binary);
+}
+
 #ifdef G_OS_WIN32
 
 #include <windows.h>
@@ -477,8 +594,10 @@ gegl_cl_init_load_functions (GError **error)
   CL_LOAD_FUNCTION (clCreateContextFromType)
   CL_LOAD_FUNCTION (clCreateCommandQueue)
   CL_LOAD_FUNCTION (clCreateProgramWithSource)
+  CL_LOAD_FUNCTION (clCreateProgramWithBinary)
   CL_LOAD_FUNCTION (clBuildProgram)
   CL_LOAD_FUNCTION (clGetProgramBuildInfo)
+  CL_LOAD_FUNCTION (clGetProgramInfo)
 
   CL_LOAD_FUNCTION (clCreateKernel)
   CL_LOAD_FUNCTION (clSetKernelArg)
@@ -609,7 +728,8 @@ gegl_cl_init_load_device_info (cl_platform_id   platform,
   gegl_clGetPlatformInfo (platform, CL_PLATFORM_VERSION,    sizeof(cl_state.platform_version), cl_state.platform_version, NULL);
   gegl_clGetPlatformInfo (platform, CL_PLATFORM_EXTENSIONS, sizeof(cl_state.platform_ext),     cl_state.platform_ext,     NULL);
 
-  gegl_clGetDeviceInfo (device, CL_DEVICE_NAME, sizeof(cl_state.device_name), cl_state.device_name, NULL);
+  gegl_clGetDeviceInfo (device, CL_DEVICE_NAME,    sizeof(cl_state.device_name),    cl_state.device_name,    NULL);
+  gegl_clGetDeviceInfo (device, CL_DRIVER_VERSION, sizeof(cl_state.driver_version), cl_state.driver_version, NULL);
 
   gegl_clGetDeviceInfo (device, CL_DEVICE_IMAGE_SUPPORT,      sizeof(cl_bool),  &cl_state.image_support,    NULL);
   gegl_clGetDeviceInfo (device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &cl_state.max_mem_alloc,    NULL);
@@ -632,6 +752,7 @@ gegl_cl_init_load_device_info (cl_platform_id   platform,
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Version: %s",             cl_state.platform_version);
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Extensions: %s",          cl_state.platform_ext);
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Default Device Name: %s", cl_state.device_name);
+  GEGL_NOTE (GEGL_DEBUG_OPENCL, "Driver Version: %s",      cl_state.driver_version);
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Max Alloc: %lu bytes",    (unsigned long)cl_state.max_mem_alloc);
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Local Mem: %lu bytes",    (unsigned long)cl_state.local_mem_size);
   GEGL_NOTE (GEGL_DEBUG_OPENCL, "Iteration size: (%lu, %lu)",
@@ -807,16 +928,43 @@ gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[]
       size_t  s = 0;
       cl_int  build_errcode;
       guint   kernel_n = 0;
+      gchar  *cache_path;
+      gboolean from_cache = FALSE;
 
       while (kernel_name[++kernel_n] != NULL);
 
       cl_data = (GeglClRunData *) g_new (GeglClRunData, 1);
+      cl_data->program = NULL;
 
-      cl_data->program = gegl_clCreateProgramWithSource (gegl_cl_get_context (), 2, sources,
-                                                         lengths, &errcode);
-      CL_CHECK_ONLY (errcode);
+      cache_path = gegl_cl_program_cache_path (sources, lengths, 2, NULL);
+
+      if (cache_path)
+        cl_data->program = gegl_cl_program_cache_load (cache_path);
+
+      if (cl_data->program)
+        {
+          build_errcode = gegl_clBuildProgram (cl_data->program, 0, NULL, NULL, NULL, NULL);
+
+          if (build_errcode == CL_SUCCESS)
+            {
+              GEGL_NOTE (GEGL_DEBUG_OPENCL, "Loaded cached program %s", cache_path);
+              from_cache = TRUE;
+            }
+          else
+            {
+              gegl_clReleaseProgram (cl_data->program);
+              cl_data->program = NULL;
+            }
+        }
 
-      build_errcode = gegl_clBuildProgram (cl_data->program, 0, NULL, NULL, NULL, NULL);
+      if (! from_cache)
+        {
+          cl_data->program = gegl_clCreateProgramWithSource (gegl_cl_get_context (), 2, sources,
+                                                             lengths, &errcode);
+          CL_CHECK_ONLY (errcode);
+
+          build_errcode = gegl_clBuildProgram (cl_data->program, 0, NULL, NULL, NULL, NULL);
+        }
 
       errcode = gegl_clGetProgramBuildInfo (cl_data->program,
                                             gegl_cl_get_device (),
@@ -844,6 +992,7 @@ gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[]
                                         gegl_cl_errstring (build_errcode),
                                         msg);
           g_free (msg);
+          g_free (cache_path);
           return NULL;
         }
       else
@@ -856,6 +1005,11 @@ gegl_cl_compile_and_build (const char *program_source, const char *kernel_name[]
           g_free (msg);
         }
 
+      if (cache_path && ! from_cache)
+        gegl_cl_program_cache_store (cl_data->program, cache_path);
+
+      g_free (cache_path);
+
       cl_data->kernel = g_new (cl_kernel, kernel_n);
       cl_data->work_group_size = g_new (size_t, kernel_n);
 
@@ -84,8 +84,10 @@ t_clCreateContext           gegl_clCreateContext           = NULL;
 t_clCreateContextFromType   gegl_clCreateContextFromType   = NULL;
 t_clCreateCommandQueue      gegl_clCreateCommandQueue      = NULL;
 t_clCreateProgramWithSource gegl_clCreateProgramWithSource = NULL;
+t_clCreateProgramWithBinary gegl_clCreateProgramWithBinary = NULL;
 t_clBuildProgram            gegl_clBuildProgram            = NULL;
 t_clGetProgramBuildInfo     gegl_clGetProgramBuildInfo     = NULL;
+t_clGetProgramInfo          gegl_clGetProgramInfo          = NULL;
 t_clCreateKernel            gegl_clCreateKernel            = NULL;
 t_clSetKernelArg            gegl_clSetKernelArg            = NULL;
 t_clGetKernelWorkGroupInfo  gegl_clGetKernelWorkGroupInfo  = NULL;
@@ -136,8 +138,10 @@ extern t_clCreateContext           gegl_clCreateContext;
 extern t_clCreateContextFromType   gegl_clCreateContextFromType;
 extern t_clCreateCommandQueue      gegl_clCreateCommandQueue;
 extern t_clCreateProgramWithSource gegl_clCreateProgramWithSource;
+extern t_clCreateProgramWithBinary gegl_clCreateProgramWithBinary;
 extern t_clBuildProgram            gegl_clBuildProgram;
 extern t_clGetProgramBuildInfo     gegl_clGetProgramBuildInfo;
+extern t_clGetProgramInfo          gegl_clGetProgramInfo;
 extern t_clCreateKernel            gegl_clCreateKernel;
 extern t_clSetKernelArg            gegl_clSetKernelArg;
 extern t_clGetKernelWorkGroupInfo  gegl_clGetKernelWorkGroupInfo;
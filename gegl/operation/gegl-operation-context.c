@@ -30,6 +30,7 @@
 #include "gegl-operation-context-private.h"
 #include "gegl-node-private.h"
 #include "gegl-config.h"
+#include "buffer/gegl-buffer-pool.h"
 
 #include "operation/gegl-operation.h"
 
@@ -114,8 +115,20 @@ property_new (const gchar *property_name)
 static void
 property_destroy (Property *property)
 {
+  GeglBuffer *buffer = NULL;
+
   g_free (property->name);
-  g_value_unset (&property->value); /* does an unref */
+
+  /* buffers of ours that nothing else holds on to go back to the pool,
+   * other objects are just let go of
+   */
+  if (G_VALUE_HOLDS_OBJECT (&property->value) &&
+      GEGL_IS_BUFFER (g_value_get_object (&property->value)))
+    buffer = g_object_ref (g_value_get_object (&property->value));
+  g_value_unset (&property->value);
+  if (buffer)
+    gegl_buffer_pool_release (buffer);
+
   g_slice_free (Property, property);
 }
 
@@ -345,7 +358,7 @@ gegl_operation_context_get_target (GeglOperationContext *context,
           if (linear_buffers)
             output = gegl_buffer_linear_new (result, format);
           else
-            output = gegl_buffer_new (result, format);
+            output = gegl_buffer_pool_get (result, format);
         }
     }
   else
@@ -353,7 +366,7 @@ gegl_operation_context_get_target (GeglOperationContext *context,
       if (linear_buffers)
         output = gegl_buffer_linear_new (result, format);
       else
-        output = gegl_buffer_new (result, format);
+        output = gegl_buffer_pool_get (result, format);
     }
 
   gegl_operation_context_take_object (context, padname, G_OBJECT (output));
@@ -0,0 +1,234 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-instrument.h"
+#include "gegl-operation.h"
+#include "gegl-operation-context.h"
+#include "gegl-operation-dispatch.h"
+#include "graph/gegl-node-private.h"
+#include "graph/gegl-pad.h"
+#include "buffer/gegl-buffer-cl-cache.h"
+#include "opencl/gegl-cl.h"
+
+/* fixed cost of running a request on the device, mostly kernel launches
+ * and synchronization
+ */
+#define GEGL_DISPATCH_LAUNCH_USECS          50.0
+
+/* cost of moving a byte between host and device memory */
+#define GEGL_DISPATCH_TRANSFER_USECS        (1.0 / 4096.0)
+
+/* processing costs assumed until an operation type has been measured */
+#define GEGL_DISPATCH_CPU_PIXEL_USECS       0.01
+#define GEGL_DISPATCH_OPENCL_PIXEL_USECS    0.001
+
+/* a device that loses against estimates of the other one still gets this
+ * many requests measured, as long as it is not far off
+ */
+#define GEGL_DISPATCH_MIN_SAMPLES           2
+
+typedef struct
+{
+  gdouble pixel_usecs[2];
+  gint    samples[2];
+} DispatchCosts;
+
+static GMutex      dispatch_mutex;
+static GHashTable *dispatch_costs = NULL;
+static GPrivate    dispatch_current;
+
+/* called with dispatch_mutex held */
+static DispatchCosts *
+dispatch_get_costs (GType type)
+{
+  DispatchCosts *costs;
+
+  if (!dispatch_costs)
+    dispatch_costs = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  costs = g_hash_table_lookup (dispatch_costs, GSIZE_TO_POINTER (type));
+
+  if (!costs)
+    {
+      costs = g_new0 (DispatchCosts, 1);
+      costs->pixel_usecs[FALSE] = GEGL_DISPATCH_CPU_PIXEL_USECS;
+      costs->pixel_usecs[TRUE]  = GEGL_DISPATCH_OPENCL_PIXEL_USECS;
+
+      g_hash_table_insert (dispatch_costs, GSIZE_TO_POINTER (type), costs);
+    }
+
+  return costs;
+}
+
+/* bytes the device has to receive and send back for the request, inputs
+ * left on the device by a previous OpenCL operation are not transferred
+ */
+static gdouble
+dispatch_transfer_bytes (GeglOperation        *operation,
+                         GeglOperationContext *context,
+                         const GeglRectangle  *roi,
+                         glong                 pixels)
+{
+  const Babl *format;
+  gdouble     bytes = 0.0;
+  GSList     *iter;
+
+  for (iter = gegl_node_get_input_pads (operation->node); iter; iter = iter->next)
+    {
+      const gchar *pad_name = gegl_pad_get_name (iter->data);
+      GObject     *input    = gegl_operation_context_get_object (context, pad_name);
+
+      if (!GEGL_IS_BUFFER (input) ||
+          gegl_buffer_cl_cache_contains (GEGL_BUFFER (input), roi))
+        continue;
+
+      format = gegl_operation_get_format (operation, pad_name);
+
+      if (format)
+        bytes += (gdouble) pixels * babl_format_get_bytes_per_pixel (format);
+    }
+
+  format = gegl_operation_get_format (operation, "output");
+
+  if (format)
+    bytes += (gdouble) pixels * babl_format_get_bytes_per_pixel (format);
+
+  return bytes;
+}
+
+gboolean
+gegl_operation_dispatch_choose (GeglOperation *operation,
+                                glong          pixels,
+                                gdouble        transfer_usecs)
+{
+  DispatchCosts *costs;
+  gdouble        cost[2];
+  gint           winner;
+
+  if (!GEGL_OPERATION_GET_CLASS (operation)->opencl_support ||
+      !operation->node->use_opencl)
+    return FALSE;
+
+  g_mutex_lock (&dispatch_mutex);
+
+  costs = dispatch_get_costs (G_OBJECT_TYPE (operation));
+
+  cost[FALSE] = pixels * costs->pixel_usecs[FALSE];
+  cost[TRUE]  = pixels * costs->pixel_usecs[TRUE] +
+                transfer_usecs + GEGL_DISPATCH_LAUNCH_USECS;
+
+  winner = cost[TRUE] < cost[FALSE];
+
+  if (costs->samples[!winner] < GEGL_DISPATCH_MIN_SAMPLES &&
+      cost[!winner] < 2.0 * cost[winner])
+    winner = !winner;
+
+  g_mutex_unlock (&dispatch_mutex);
+
+  return winner;
+}
+
+gboolean
+gegl_operation_dispatch_begin (GeglOperationDispatch *dispatch,
+                               GeglOperation         *operation,
+                               GeglOperationContext  *context,
+                               const GeglRectangle   *roi)
+{
+  if (!GEGL_OPERATION_GET_CLASS (operation)->opencl_support ||
+      !operation->node->use_opencl ||
+      !gegl_cl_is_accelerated ())
+    return FALSE;
+
+  dispatch->operation      = operation;
+  dispatch->pixels         = (glong) roi->width * roi->height;
+  dispatch->transfer_usecs = GEGL_DISPATCH_TRANSFER_USECS *
+                             dispatch_transfer_bytes (operation, context, roi,
+                                                      dispatch->pixels);
+
+  dispatch->use_opencl = gegl_operation_dispatch_choose (operation,
+                                                         dispatch->pixels,
+                                                         dispatch->transfer_usecs);
+  dispatch->prev       = g_private_get (&dispatch_current);
+  dispatch->start      = g_get_monotonic_time ();
+
+  g_private_set (&dispatch_current, dispatch);
+
+  return TRUE;
+}
+
+void
+gegl_operation_dispatch_end (GeglOperationDispatch *dispatch)
+{
+  DispatchCosts *costs;
+  gint64         usecs = g_get_monotonic_time () - dispatch->start;
+  gdouble        pixel_usecs;
+  gint           device = dispatch->use_opencl;
+
+  g_private_set (&dispatch_current, dispatch->prev);
+
+  if (dispatch->pixels <= 0)
+    return;
+
+  pixel_usecs = usecs;
+  if (dispatch->use_opencl)
+    pixel_usecs -= dispatch->transfer_usecs + GEGL_DISPATCH_LAUNCH_USECS;
+  pixel_usecs = MAX (pixel_usecs, 0.0) / dispatch->pixels;
+
+  g_mutex_lock (&dispatch_mutex);
+
+  costs = dispatch_get_costs (G_OBJECT_TYPE (dispatch->operation));
+
+  if (costs->samples[device] == 0)
+    costs->pixel_usecs[device] = pixel_usecs;
+  else
+    costs->pixel_usecs[device] += (pixel_usecs - costs->pixel_usecs[device]) / 4.0;
+
+  costs->samples[device]++;
+
+  g_mutex_unlock (&dispatch_mutex);
+
+  if (gegl_instrument_enabled)
+    {
+      const gchar *device_name = dispatch->use_opencl ? "opencl" : "cpu";
+
+      real_gegl_instrument ("dispatch", device_name, usecs);
+      real_gegl_instrument (device_name,
+                            gegl_operation_get_name (dispatch->operation),
+                            usecs);
+    }
+}
+
+gboolean
+gegl_operation_dispatch_use_opencl (const GeglOperation *operation)
+{
+  GeglOperationDispatch *dispatch;
+
+  for (dispatch = g_private_get (&dispatch_current);
+       dispatch;
+       dispatch = dispatch->prev)
+    {
+      if (dispatch->operation == operation)
+        return dispatch->use_opencl;
+    }
+
+  return TRUE;
+}
@@ -0,0 +1,70 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_OPERATION_DISPATCH_H__
+#define __GEGL_OPERATION_DISPATCH_H__
+
+G_BEGIN_DECLS
+
+/* Every request processed by an operation with OpenCL support is
+ * dispatched either to the OpenCL device or to CPU threads, whichever is
+ * estimated to finish first.  The estimate weighs the number of pixels
+ * against the host to device transfers the request needs, inputs already
+ * held by the device are free, and is refined with the measured time of
+ * the requests each operation type processed so far.
+ */
+
+typedef struct _GeglOperationDispatch GeglOperationDispatch;
+
+struct _GeglOperationDispatch
+{
+  GeglOperation         *operation;
+  gboolean               use_opencl;
+  glong                  pixels;
+  gdouble                transfer_usecs;
+  gint64                 start;
+  GeglOperationDispatch *prev;
+};
+
+/* returns TRUE if a request of @operation for @pixels pixels, whose host
+ * to device transfers take @transfer_usecs, is estimated to finish first
+ * on the OpenCL device; always FALSE when the node of @operation does not
+ * use OpenCL.
+ */
+gboolean gegl_operation_dispatch_choose     (GeglOperation         *operation,
+                                             glong                  pixels,
+                                             gdouble                transfer_usecs);
+
+/* decides where @operation processes @roi and makes the decision current
+ * for the calling thread, returns FALSE, leaving @dispatch unused, if the
+ * operation can only run on the CPU.
+ */
+gboolean gegl_operation_dispatch_begin      (GeglOperationDispatch *dispatch,
+                                             GeglOperation         *operation,
+                                             GeglOperationContext  *context,
+                                             const GeglRectangle   *roi);
+
+/* records the time the request took and ends the decision */
+void     gegl_operation_dispatch_end        (GeglOperationDispatch *dispatch);
+
+/* returns the current decision for @operation, operations outside of
+ * gegl_operation_process () are free to use OpenCL.
+ */
+gboolean gegl_operation_dispatch_use_opencl (const GeglOperation   *operation);
+
+G_END_DECLS
+
+#endif /* __GEGL_OPERATION_DISPATCH_H__ */
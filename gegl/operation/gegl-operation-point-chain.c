@@ -0,0 +1,345 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-parallel.h"
+#include "gegl-operation-point-filter.h"
+#include "gegl-operation-point-composer.h"
+#include "gegl-operation-point-chain.h"
+#include "gegl-operation-point-uniform.h"
+#include "graph/gegl-node-private.h"
+
+typedef struct
+{
+  GeglOperation **operations;
+  gint            n_operations;
+  gint            level;
+  gboolean        success;
+  gint            n_tasks;
+  GeglRectangle   roi;
+
+  guchar         *input;
+  guchar        **aux;
+  guchar         *output;
+  guchar         *tmp[2];
+
+  gint            in_bpp;
+  gint           *aux_bpp;
+  gint           *out_bpp;
+  gint            max_bpp; /* of the pixels in the scratch buffers */
+} ChainData;
+
+gboolean
+gegl_operation_point_chain_accepts (GeglOperation *operation)
+{
+  GeglOperationClass *klass = GEGL_OPERATION_GET_CLASS (operation);
+  GeglOperationClass *base;
+
+  if (! operation->node ||
+      operation->node->passthrough ||
+      gegl_operation_use_opencl (operation))
+    return FALSE;
+
+  /* subclasses overriding the processing of the base class do more than
+   * their point function, they can not be fused */
+  if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+    {
+      base = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_FILTER);
+
+      return GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation)->process &&
+             klass->process == base->process &&
+             GEGL_OPERATION_FILTER_CLASS (klass)->process ==
+             GEGL_OPERATION_FILTER_CLASS (base)->process;
+    }
+  else if (GEGL_IS_OPERATION_POINT_COMPOSER (operation))
+    {
+      base = g_type_class_peek (GEGL_TYPE_OPERATION_POINT_COMPOSER);
+
+      return GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation)->process &&
+             klass->process == base->process &&
+             GEGL_OPERATION_COMPOSER_CLASS (klass)->process ==
+             GEGL_OPERATION_COMPOSER_CLASS (base)->process;
+    }
+
+  return FALSE;
+}
+
+/* runs the j'th band of rows of the current chunk through all operations,
+ * ping-ponging between the two scratch buffers.  The bands keep to the
+ * same place in the scratch buffers for every operation, however large
+ * its pixels are, so that they never write where another band still has
+ * to read.
+ */
+static void
+chain_process_band (gint     j,
+                    gpointer user_data)
+{
+  ChainData     *data = user_data;
+  gint           y0   = data->roi.height * j / data->n_tasks;
+  gint           y1   = data->roi.height * (j + 1) / data->n_tasks;
+  glong          offset = (glong) y0 * data->roi.width;
+  GeglRectangle  roi  = {data->roi.x, data->roi.y + y0,
+                         data->roi.width, y1 - y0};
+  glong          samples = (glong) roi.width * roi.height;
+  guchar        *in;
+  gint           k;
+
+  if (samples <= 0)
+    return;
+
+  in = data->input ? data->input + offset * data->in_bpp : NULL;
+
+  for (k = 0; k < data->n_operations; k++)
+    {
+      GeglOperation *operation = data->operations[k];
+      guchar        *out;
+      gboolean       success;
+
+      if (k == data->n_operations - 1)
+        out = data->output + offset * data->out_bpp[k];
+      else
+        out = data->tmp[k & 1] + offset * data->max_bpp;
+
+      if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+        {
+          success = GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation)->process (
+                      operation, in, out, samples, &roi, data->level);
+        }
+      else
+        {
+          guchar *aux = data->aux[k] ? data->aux[k] + offset * data->aux_bpp[k] : NULL;
+
+          success = GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation)->process (
+                      operation, in, aux, out, samples, &roi, data->level);
+        }
+
+      if (! success)
+        data->success = FALSE;
+
+      in = out;
+    }
+}
+
+static gboolean
+chain_process_rect (GeglOperation      **operations,
+                    GeglBuffer         **aux,
+                    gint                 n_operations,
+                    GeglBuffer          *input,
+                    GeglBuffer          *output,
+                    const GeglRectangle *result,
+                    gint                 level)
+{
+  GeglOperation      *last = operations[n_operations - 1];
+  GeglBufferIterator *i;
+  ChainData           data;
+  gint                read = 0;
+  gint               *aux_index;
+  gboolean            threaded;
+  gint                k;
+
+  data.operations   = operations;
+  data.n_operations = n_operations;
+  data.level        = level;
+  data.success      = TRUE;
+  data.aux          = g_new0 (guchar *, n_operations);
+  data.aux_bpp      = g_new0 (gint, n_operations);
+  data.out_bpp      = g_new0 (gint, n_operations);
+  data.max_bpp      = 0;
+  aux_index         = g_new0 (gint, n_operations);
+
+  /* the buffer iterator does the conversions into the format the first
+   * operation reads and out of the format the last one writes, within
+   * the chain the formats match.
+   */
+  i = gegl_buffer_iterator_new (output, result, level,
+                                gegl_operation_get_format (last, "output"),
+                                GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+
+  data.in_bpp = 0;
+  if (input)
+    {
+      const Babl *in_format = gegl_operation_get_format (operations[0], "input");
+
+      read = gegl_buffer_iterator_add (i, input, result, level, in_format,
+                                       GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+      data.in_bpp = babl_format_get_bytes_per_pixel (in_format);
+    }
+
+  for (k = 0; k < n_operations; k++)
+    {
+      data.out_bpp[k] = babl_format_get_bytes_per_pixel (
+                          gegl_operation_get_format (operations[k], "output"));
+
+      if (aux[k])
+        {
+          const Babl *aux_format = gegl_operation_get_format (operations[k], "aux");
+
+          aux_index[k] = gegl_buffer_iterator_add (i, aux[k], result, level, aux_format,
+                                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+          data.aux_bpp[k] = babl_format_get_bytes_per_pixel (aux_format);
+        }
+
+      if (k < n_operations - 1)
+        data.max_bpp = MAX (data.max_bpp, data.out_bpp[k]);
+    }
+
+  data.tmp[0] = gegl_temp_buffer (0, data.max_bpp * result->width * result->height);
+  data.tmp[1] = gegl_temp_buffer (1, data.max_bpp * result->width * result->height);
+
+  /* the bands run every operation of the chain, all of them have to be
+   * fine with that */
+  threaded = result->height > 1;
+  for (k = 0; k < n_operations; k++)
+    threaded = threaded && gegl_operation_use_threading (operations[k], result);
+
+  while (gegl_buffer_iterator_next (i))
+    {
+      data.roi    = i->roi[0];
+      data.input  = input ? i->data[read] : NULL;
+      data.output = i->data[0];
+
+      for (k = 0; k < n_operations; k++)
+        data.aux[k] = aux[k] ? i->data[aux_index[k]] : NULL;
+
+      if (threaded)
+        {
+          data.n_tasks = MIN (data.roi.height,
+                              gegl_config_threads () * GEGL_PARALLEL_TASKS_PER_THREAD);
+
+          gegl_parallel_for (data.n_tasks, chain_process_band, &data);
+        }
+      else
+        {
+          data.n_tasks = 1;
+
+          chain_process_band (0, &data);
+        }
+    }
+
+  g_free (data.aux);
+  g_free (data.aux_bpp);
+  g_free (data.out_bpp);
+  g_free (aux_index);
+
+  return data.success;
+}
+
+/* runs a single pixel through the chain, @in holds the input pixel
+ * followed by the aux pixel of each operation
+ */
+static gboolean
+chain_uniform_pixel (gpointer             user_data,
+                     gpointer            *in,
+                     gpointer             out,
+                     const GeglRectangle *roi)
+{
+  ChainData *data = user_data;
+  gdouble    tmp[2][GEGL_OPERATION_POINT_UNIFORM_MAX_BPP / sizeof (gdouble)];
+
+  data->success = TRUE;
+  data->n_tasks = 1;
+  data->roi     = *roi;
+  data->input   = in[0];
+  data->aux     = (guchar **) in + 1;
+  data->output  = out;
+  data->tmp[0]  = (guchar *) tmp[0];
+  data->tmp[1]  = (guchar *) tmp[1];
+
+  chain_process_band (0, data);
+
+  return data->success;
+}
+
+gboolean
+gegl_operation_point_chain_process (GeglOperation      **operations,
+                                    GeglBuffer         **aux,
+                                    gint                 n_operations,
+                                    GeglBuffer          *input,
+                                    GeglBuffer          *output,
+                                    const GeglRectangle *result,
+                                    gint                 level)
+{
+  GeglBuffer **inputs;
+  const Babl **formats;
+  ChainData    data = { 0, };
+  GArray      *rest;
+  gboolean     success = TRUE;
+  guint        i;
+  gint         k;
+
+  g_return_val_if_fail (n_operations > 0, FALSE);
+
+  if (result->width <= 0 || result->height <= 0)
+    return TRUE;
+
+  if (! input)
+    return chain_process_rect (operations, aux, n_operations,
+                               input, output, result, level);
+
+  for (k = 0; k < n_operations; k++)
+    if (! gegl_operation_point_uniform_accepts (operations[k]) ||
+        babl_format_get_bytes_per_pixel (
+          gegl_operation_get_format (operations[k], "output")) >
+          GEGL_OPERATION_POINT_UNIFORM_MAX_BPP)
+      return chain_process_rect (operations, aux, n_operations,
+                                 input, output, result, level);
+
+  inputs  = g_new (GeglBuffer *, n_operations + 1);
+  formats = g_new (const Babl *, n_operations + 1);
+
+  inputs[0]  = input;
+  formats[0] = gegl_operation_get_format (operations[0], "input");
+
+  for (k = 0; k < n_operations; k++)
+    {
+      inputs[k + 1]  = aux[k];
+      formats[k + 1] = aux[k] ? gegl_operation_get_format (operations[k], "aux")
+                              : NULL;
+    }
+
+  /* a single pixel starts at offset 0, the sizes are never used */
+  data.operations   = operations;
+  data.n_operations = n_operations;
+  data.level        = level;
+  data.aux_bpp      = g_new0 (gint, n_operations);
+  data.out_bpp      = g_new0 (gint, n_operations);
+
+  /* uniform input tiles are done a pixel each, the rest as usual */
+  rest = gegl_operation_point_uniform_process (inputs, formats, n_operations + 1,
+                                               output,
+                                               gegl_operation_get_format (operations[n_operations - 1], "output"),
+                                               result, level,
+                                               chain_uniform_pixel, &data);
+
+  for (i = 0; i < rest->len; i++)
+    if (! chain_process_rect (operations, aux, n_operations, input, output,
+                              &g_array_index (rest, GeglRectangle, i), level))
+      success = FALSE;
+
+  g_array_free (rest, TRUE);
+  g_free (data.aux_bpp);
+  g_free (data.out_bpp);
+  g_free (formats);
+  g_free (inputs);
+
+  return success;
+}
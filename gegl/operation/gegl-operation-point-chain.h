@@ -0,0 +1,53 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_OPERATION_POINT_CHAIN_H__
+#define __GEGL_OPERATION_POINT_CHAIN_H__
+
+G_BEGIN_DECLS
+
+/* A point chain is a run of point filters and point composers where each
+ * operation reads the output of the previous one through its "input" pad.
+ * Such a run can be processed in a single pass, handing each scanline
+ * chunk from one operation's process function to the next without
+ * intermediate buffers.
+ */
+
+/* the most operations with an aux buffer in a single chain, every aux
+ * buffer takes an iterator slot next to the input and the output.
+ */
+#define GEGL_OPERATION_POINT_CHAIN_MAX_AUX 4
+
+/* returns TRUE if @operation is a point filter or point composer that
+ * uses the generic point processing and can thus be part of a chain.
+ */
+gboolean gegl_operation_point_chain_accepts (GeglOperation        *operation);
+
+/* processes @n_operations operations in one pass, @input is the input of
+ * the first operation, @aux holds the aux buffer of each operation (or
+ * NULL), and @output receives the output of the last one.
+ */
+gboolean gegl_operation_point_chain_process (GeglOperation      **operations,
+                                             GeglBuffer         **aux,
+                                             gint                 n_operations,
+                                             GeglBuffer          *input,
+                                             GeglBuffer          *output,
+                                             const GeglRectangle *result,
+                                             gint                 level);
+
+G_END_DECLS
+
+#endif /* __GEGL_OPERATION_POINT_CHAIN_H__ */
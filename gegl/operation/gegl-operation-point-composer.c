@@ -23,8 +23,10 @@
 
 #include "gegl.h"
 #include "gegl-operation-point-composer.h"
+#include "gegl-operation-point-uniform.h"
 #include "gegl-operation-context.h"
 #include "gegl-config.h"
+#include "gegl-parallel.h"
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
@@ -36,8 +38,13 @@ typedef struct ThreadData
   guchar                          *input;
   guchar                          *aux;
   guchar                          *output;
-  gint                            *pending;
-  gint                            *started;
+  gint                             in_buf_bpp;
+  gint                             aux_buf_bpp;
+  gint                             out_buf_bpp;
+  gint                             in_bpp;
+  gint                             aux_bpp;
+  gint                             out_bpp;
+  gint                             n_tasks;
   gint                             level;
   gboolean                         success;
   GeglRectangle                    roi;
@@ -50,49 +57,50 @@ typedef struct ThreadData
   const Babl *output_fish;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+/* processes the j'th band of rows of the iterator chunk in data->roi, the
+ * temporary conversion buffers are shared and indexed by the band offset.
+ */
+static void thread_process (gint j, gpointer thread_data)
 {
   ThreadData *data = thread_data;
+  gint y0 = data->roi.height * j / data->n_tasks;
+  gint y1 = data->roi.height * (j + 1) / data->n_tasks;
+  glong offset = (glong) y0 * data->roi.width;
+  GeglRectangle roi = {data->roi.x, data->roi.y + y0,
+                       data->roi.width, y1 - y0};
+  glong samples = (glong) roi.width * roi.height;
+
+  guchar *input = data->input ? data->input + offset * data->in_buf_bpp : NULL;
+  guchar *aux = data->aux ? data->aux + offset * data->aux_buf_bpp : NULL;
+  guchar *output = data->output + offset * data->out_buf_bpp;
+  guchar *buf_output = output;
 
-  guchar *input = data->input;
-  guchar *aux = data->aux;
-  guchar *output = data->output;
-  glong samples = data->roi.width * data->roi.height;
+  if (samples <= 0)
+    return;
 
   if (data->input_fish && input)
     {
-      babl_process (data->input_fish, data->input, data->in_tmp, samples);
-      input = data->in_tmp;
+      guchar *in_tmp = data->in_tmp + offset * data->in_bpp;
+      babl_process (data->input_fish, input, in_tmp, samples);
+      input = in_tmp;
     }
   if (data->aux_fish && aux)
     {
-      babl_process (data->aux_fish, data->aux, data->aux_tmp, samples);
-      aux = data->aux_tmp;
+      guchar *aux_tmp = data->aux_tmp + offset * data->aux_bpp;
+      babl_process (data->aux_fish, aux, aux_tmp, samples);
+      aux = aux_tmp;
     }
   if (data->output_fish)
-    output = data->output_tmp;
+    output = data->output_tmp + offset * data->out_bpp;
 
   if (!data->klass->process (data->operation,
                        input, aux,
                        output, samples,
-                       &data->roi, data->level))
+                       &roi, data->level))
     data->success = FALSE;
   
   if (data->output_fish)
-    babl_process (data->output_fish, data->output_tmp, data->output, samples);
-
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
-    }
-  return pool;
+    babl_process (data->output_fish, output, buf_output, samples);
 }
 
 static gboolean
@@ -197,12 +205,12 @@ gegl_operation_point_composer_init (GeglOperationPointComposer *self)
 }
 
 static gboolean
-gegl_operation_point_composer_process (GeglOperation       *operation,
-                                       GeglBuffer          *input,
-                                       GeglBuffer          *aux,
-                                       GeglBuffer          *output,
-                                       const GeglRectangle *result,
-                                       gint                 level)
+gegl_operation_point_composer_process_rect (GeglOperation       *operation,
+                                            GeglBuffer          *input,
+                                            GeglBuffer          *aux,
+                                            GeglBuffer          *output,
+                                            const GeglRectangle *result,
+                                            gint                 level)
 {
   GeglOperationPointComposerClass *point_composer_class = GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation);
   const Babl *in_format   = gegl_operation_get_format (operation, "input");
@@ -218,119 +226,62 @@ gegl_operation_point_composer_process (GeglOperation       *operation,
 
       if (gegl_operation_use_threading (operation, result) && result->height > 1)
       {
-        gint threads = gegl_config_threads ();
-        GThreadPool *pool = thread_pool ();
-        ThreadData thread_data[GEGL_MAX_THREADS];
+        ThreadData data;
         GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, output_buf_format,
                                                           GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
         gint foo = 0, read = 0;
 
-        gint in_bpp = input?babl_format_get_bytes_per_pixel (in_format):0;
-        gint aux_bpp = aux?babl_format_get_bytes_per_pixel (aux_format):0;
-        gint out_bpp = babl_format_get_bytes_per_pixel (out_format);
-
-        gint in_buf_bpp = input?babl_format_get_bytes_per_pixel (in_buf_format):0;
-        gint aux_buf_bpp = aux?babl_format_get_bytes_per_pixel (aux_buf_format):0;
-        gint out_buf_bpp = babl_format_get_bytes_per_pixel (output_buf_format);
-        gint temp_id = 0;
+        data.klass       = point_composer_class;
+        data.operation   = operation;
+        data.level       = level;
+        data.success     = TRUE;
+        data.in_bpp      = input?babl_format_get_bytes_per_pixel (in_format):0;
+        data.aux_bpp     = aux?babl_format_get_bytes_per_pixel (aux_format):0;
+        data.out_bpp     = babl_format_get_bytes_per_pixel (out_format);
+        data.in_buf_bpp  = input?babl_format_get_bytes_per_pixel (in_buf_format):0;
+        data.aux_buf_bpp = aux?babl_format_get_bytes_per_pixel (aux_buf_format):0;
+        data.out_buf_bpp = babl_format_get_bytes_per_pixel (output_buf_format);
+        data.input_fish  = NULL;
+        data.aux_fish    = NULL;
+        data.output_fish = NULL;
 
         if (input)
         {
           read = gegl_buffer_iterator_add (i, input, result, level, in_buf_format,
                                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-          for (gint j = 0; j < threads; j ++)
+          if (in_buf_format != in_format)
           {
-            if (in_buf_format != in_format)
-            {
-              thread_data[j].input_fish = babl_fish (in_buf_format, in_format);
-              thread_data[j].in_tmp = gegl_temp_buffer (temp_id++, in_bpp * result->width * result->height);
-            }
-            else
-            {
-              thread_data[j].input_fish = NULL;
-            }
+            data.input_fish = babl_fish (in_buf_format, in_format);
+            data.in_tmp = gegl_temp_buffer (0, data.in_bpp * result->width * result->height);
           }
         }
-        else
-          for (gint j = 0; j < threads; j ++)
-            thread_data[j].input_fish = NULL;
         if (aux)
         {
           foo = gegl_buffer_iterator_add (i, aux, result, level, aux_buf_format,
                                           GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-          for (gint j = 0; j < threads; j ++)
+          if (aux_buf_format != aux_format)
           {
-            if (aux_buf_format != aux_format)
-            {
-              thread_data[j].aux_fish = babl_fish (aux_buf_format, aux_format);
-              thread_data[j].aux_tmp = gegl_temp_buffer (temp_id++, aux_bpp * result->width * result->height);
-            }
-            else
-            {
-              thread_data[j].aux_fish = NULL;
-            }
+            data.aux_fish = babl_fish (aux_buf_format, aux_format);
+            data.aux_tmp = gegl_temp_buffer (1, data.aux_bpp * result->width * result->height);
           }
         }
-        else
-        {
-          for (gint j = 0; j < threads; j ++)
-            thread_data[j].aux_fish = NULL;
-        }
 
-        for (gint j = 0; j < threads; j ++)
+        if (output_buf_format != out_format)
         {
-          if (output_buf_format != gegl_buffer_get_format (output))
-          {
-            thread_data[j].output_fish = babl_fish (out_format, output_buf_format);
-            thread_data[j].output_tmp = gegl_temp_buffer (temp_id++, out_bpp * result->width * result->height);
-          }
-          else
-          {
-            thread_data[j].output_fish = NULL;
-          }
+          data.output_fish = babl_fish (out_format, output_buf_format);
+          data.output_tmp = gegl_temp_buffer (2, data.out_bpp * result->width * result->height);
         }
 
         while (gegl_buffer_iterator_next (i))
           {
-            gint threads = gegl_config_threads ();
-            gint pending;
-            gint bit;
-
-            if (i->roi[0].height < threads)
-            {
-              threads = i->roi[0].height;
-            }
-
-            bit = i->roi[0].height / threads;
-            pending = threads;
-
-            for (gint j = 0; j < threads; j++)
-            {
-              thread_data[j].roi.x = (i->roi[0]).x;
-              thread_data[j].roi.width = (i->roi[0]).width;
-              thread_data[j].roi.y = (i->roi[0]).y + bit * j;
-              thread_data[j].roi.height = bit;
-            }
-            thread_data[threads-1].roi.height = i->roi[0].height - (bit * (threads-1));
-            
-            for (gint j = 0; j < threads; j++)
-            {
-              thread_data[j].klass = point_composer_class;
-              thread_data[j].operation = operation;
-              thread_data[j].input = input?((guchar*)i->data[read]) + (bit * j * i->roi[0].width * in_buf_bpp):NULL;
-              thread_data[j].aux = aux?((guchar*)i->data[foo]) + (bit * j * i->roi[0].width * aux_buf_bpp):NULL;
-              thread_data[j].output = ((guchar*)i->data[0]) + (bit * j * i->roi[0].width * out_buf_bpp);
-              thread_data[j].pending = &pending;
-              thread_data[j].level = level;
-              thread_data[j].success = TRUE;
-            }
-            pending = threads;
-
-            for (gint j = 1; j < threads; j++)
-              g_thread_pool_push (pool, &thread_data[j], NULL);
-            thread_process (&thread_data[0], NULL);
-
-            while (g_atomic_int_get (&pending)) {};
+            data.roi     = i->roi[0];
+            data.input   = input?(guchar*)i->data[read]:NULL;
+            data.aux     = aux?(guchar*)i->data[foo]:NULL;
+            data.output  = (guchar*)i->data[0];
+            data.n_tasks = MIN (data.roi.height,
+                                gegl_config_threads () * GEGL_PARALLEL_TASKS_PER_THREAD);
+
+            gegl_parallel_for (data.n_tasks, thread_process, &data);
           }
 
         return TRUE;
@@ -356,3 +307,56 @@ gegl_operation_point_composer_process (GeglOperation       *operation,
     }
   return TRUE;
 }
+
+static gboolean
+point_composer_uniform_pixel (gpointer             user_data,
+                              gpointer            *in,
+                              gpointer             out,
+                              const GeglRectangle *roi)
+{
+  GeglOperation *operation = user_data;
+
+  return GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation)->process (
+           operation, in[0], in[1], out, 1, roi, 0);
+}
+
+static gboolean
+gegl_operation_point_composer_process (GeglOperation       *operation,
+                                       GeglBuffer          *input,
+                                       GeglBuffer          *aux,
+                                       GeglBuffer          *output,
+                                       const GeglRectangle *result,
+                                       gint                 level)
+{
+  GeglBuffer *inputs[2];
+  const Babl *formats[2];
+  GArray     *rest;
+  gboolean    success = TRUE;
+  guint       i;
+
+  if (! input || ! gegl_operation_point_uniform_accepts (operation))
+    return gegl_operation_point_composer_process_rect (operation, input, aux,
+                                                       output, result, level);
+
+  inputs[0]  = input;
+  inputs[1]  = aux;
+  formats[0] = gegl_operation_get_format (operation, "input");
+  formats[1] = gegl_operation_get_format (operation, "aux");
+
+  /* uniform input tiles are done a pixel each, the rest as usual */
+  rest = gegl_operation_point_uniform_process (inputs, formats, 2, output,
+                                               gegl_operation_get_format (operation, "output"),
+                                               result, level,
+                                               point_composer_uniform_pixel,
+                                               operation);
+
+  for (i = 0; i < rest->len; i++)
+    if (! gegl_operation_point_composer_process_rect (operation, input, aux, output,
+                                                      &g_array_index (rest, GeglRectangle, i),
+                                                      level))
+      success = FALSE;
+
+  g_array_free (rest, TRUE);
+
+  return success;
+}
@@ -65,7 +65,13 @@ struct _GeglOperationPointComposerClass
                            size_t               global_worksize,
                            const GeglRectangle *roi,
                            gint                 level);
-  gpointer                 pad[4];
+
+  /* set when the result depends on where a pixel is and not only on its
+   * value, the operation is then never run on a single pixel standing in
+   * for a uniform tile
+   */
+  gboolean                 position_dependent;
+  gpointer                 pad[3];
 };
 
 GType gegl_operation_point_composer_get_type (void) G_GNUC_CONST;
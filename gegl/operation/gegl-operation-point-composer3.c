@@ -25,6 +25,7 @@
 #include "gegl-operation-point-composer3.h"
 #include "gegl-operation-context.h"
 #include "gegl-config.h"
+#include "gegl-parallel.h"
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
@@ -37,8 +38,15 @@ typedef struct ThreadData
   guchar                           *aux;
   guchar                           *aux2;
   guchar                           *output;
-  gint                             *pending;
-  gint                             *started;
+  gint                              in_buf_bpp;
+  gint                              aux_buf_bpp;
+  gint                              aux2_buf_bpp;
+  gint                              out_buf_bpp;
+  gint                              in_bpp;
+  gint                              aux_bpp;
+  gint                              aux2_bpp;
+  gint                              out_bpp;
+  gint                              n_tasks;
   gint                              level;
   gboolean                          success;
   GeglRectangle                     roi;
@@ -53,55 +61,57 @@ typedef struct ThreadData
   const Babl *output_fish;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+/* processes the j'th band of rows of the iterator chunk in data->roi, the
+ * temporary conversion buffers are shared and indexed by the band offset.
+ */
+static void thread_process (gint j, gpointer thread_data)
 {
   ThreadData *data = thread_data;
-
-  guchar *input = data->input;
-  guchar *aux = data->aux;
-  guchar *aux2 = data->aux2;
-  guchar *output = data->output;
-  glong samples = data->roi.width * data->roi.height;
+  gint y0 = data->roi.height * j / data->n_tasks;
+  gint y1 = data->roi.height * (j + 1) / data->n_tasks;
+  glong offset = (glong) y0 * data->roi.width;
+  GeglRectangle roi = {data->roi.x, data->roi.y + y0,
+                       data->roi.width, y1 - y0};
+  glong samples = (glong) roi.width * roi.height;
+
+  guchar *input = data->input ? data->input + offset * data->in_buf_bpp : NULL;
+  guchar *aux = data->aux ? data->aux + offset * data->aux_buf_bpp : NULL;
+  guchar *aux2 = data->aux2 ? data->aux2 + offset * data->aux2_buf_bpp : NULL;
+  guchar *output = data->output + offset * data->out_buf_bpp;
+  guchar *buf_output = output;
+
+  if (samples <= 0)
+    return;
 
   if (data->input_fish && input)
     {
-      babl_process (data->input_fish, data->input, data->in_tmp, samples);
-      input = data->in_tmp;
+      guchar *in_tmp = data->in_tmp + offset * data->in_bpp;
+      babl_process (data->input_fish, input, in_tmp, samples);
+      input = in_tmp;
     }
   if (data->aux_fish && aux)
     {
-      babl_process (data->aux_fish, data->aux, data->aux_tmp, samples);
-      aux = data->aux_tmp;
+      guchar *aux_tmp = data->aux_tmp + offset * data->aux_bpp;
+      babl_process (data->aux_fish, aux, aux_tmp, samples);
+      aux = aux_tmp;
     }
   if (data->aux2_fish && aux2)
     {
-      babl_process (data->aux2_fish, data->aux2, data->aux2_tmp, samples);
-      aux2 = data->aux2_tmp;
+      guchar *aux2_tmp = data->aux2_tmp + offset * data->aux2_bpp;
+      babl_process (data->aux2_fish, aux2, aux2_tmp, samples);
+      aux2 = aux2_tmp;
     }
   if (data->output_fish)
-    output = data->output_tmp;
+    output = data->output_tmp + offset * data->out_bpp;
 
   if (!data->klass->process (data->operation,
-                       input, aux, aux2, 
+                       input, aux, aux2,
                        output, samples,
-                       &data->roi, data->level))
+                       &roi, data->level))
     data->success = FALSE;
   
   if (data->output_fish)
-    babl_process (data->output_fish, data->output_tmp, data->output, samples);
-
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
-    }
-  return pool;
+    babl_process (data->output_fish, output, buf_output, samples);
 }
 
 static gboolean
@@ -237,161 +247,94 @@ gegl_operation_point_composer3_process (GeglOperation       *operation,
 
       if (gegl_operation_use_threading (operation, result) && result->height > 1)
       {
-        gint threads = gegl_config_threads ();
-        GThreadPool *pool = thread_pool ();
-        ThreadData thread_data[GEGL_MAX_THREADS];
-        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, output_buf_format, GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
+        ThreadData data;
+        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, output_buf_format,
+                                                          GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
         gint foo = 0, bar = 0, read = 0;
 
-        gint in_bpp = input?babl_format_get_bytes_per_pixel (in_format):0;
-        gint aux_bpp = aux?babl_format_get_bytes_per_pixel (aux_format):0;
-        gint aux2_bpp = aux2?babl_format_get_bytes_per_pixel (aux2_format):0;
-        gint out_bpp = babl_format_get_bytes_per_pixel (out_format);
-
-        gint in_buf_bpp = input?babl_format_get_bytes_per_pixel (in_buf_format):0;
-        gint aux_buf_bpp = aux?babl_format_get_bytes_per_pixel (aux_buf_format):0;
-        gint aux2_buf_bpp = aux2?babl_format_get_bytes_per_pixel (aux2_buf_format):0;
-        gint out_buf_bpp = babl_format_get_bytes_per_pixel (output_buf_format);
-
-        gint temp_id = 0;
+        data.klass        = point_composer3_class;
+        data.operation    = operation;
+        data.level        = level;
+        data.success      = TRUE;
+        data.in_bpp       = input?babl_format_get_bytes_per_pixel (in_format):0;
+        data.aux_bpp      = aux?babl_format_get_bytes_per_pixel (aux_format):0;
+        data.aux2_bpp     = aux2?babl_format_get_bytes_per_pixel (aux2_format):0;
+        data.out_bpp      = babl_format_get_bytes_per_pixel (out_format);
+        data.in_buf_bpp   = input?babl_format_get_bytes_per_pixel (in_buf_format):0;
+        data.aux_buf_bpp  = aux?babl_format_get_bytes_per_pixel (aux_buf_format):0;
+        data.aux2_buf_bpp = aux2?babl_format_get_bytes_per_pixel (aux2_buf_format):0;
+        data.out_buf_bpp  = babl_format_get_bytes_per_pixel (output_buf_format);
+        data.input_fish   = NULL;
+        data.aux_fish     = NULL;
+        data.aux2_fish    = NULL;
+        data.output_fish  = NULL;
 
         if (input)
         {
           if (! babl_format_has_alpha (in_buf_format))
             {
               in_buf_format = in_format;
-              in_buf_bpp = in_bpp;
+              data.in_buf_bpp = data.in_bpp;
             }
 
-          read = gegl_buffer_iterator_add (i, input, result, level, in_buf_format, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-          for (gint j = 0; j < threads; j ++)
+          read = gegl_buffer_iterator_add (i, input, result, level, in_buf_format,
+                                           GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+          if (in_buf_format != in_format)
           {
-            if (in_buf_format != in_format)
-            {
-              thread_data[j].input_fish = babl_fish (in_buf_format, in_format);
-              thread_data[j].in_tmp = gegl_temp_buffer (temp_id++, in_bpp * result->width * result->height);
-            }
-            else
-            {
-              thread_data[j].input_fish = NULL;
-            }
+            data.input_fish = babl_fish (in_buf_format, in_format);
+            data.in_tmp = gegl_temp_buffer (0, data.in_bpp * result->width * result->height);
           }
         }
-        else
-          for (gint j = 0; j < threads; j ++)
-            thread_data[j].input_fish = NULL;
         if (aux)
         {
           if (! babl_format_has_alpha (aux_buf_format))
             {
               aux_buf_format = aux_format;
-              aux_buf_bpp = aux_bpp;
+              data.aux_buf_bpp = data.aux_bpp;
             }
 
           foo = gegl_buffer_iterator_add (i, aux, result, level, aux_buf_format,
                                           GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-          for (gint j = 0; j < threads; j ++)
+          if (aux_buf_format != aux_format)
           {
-            if (aux_buf_format != aux_format)
-            {
-              thread_data[j].aux_fish = babl_fish (aux_buf_format, aux_format);
-              thread_data[j].aux_tmp = gegl_temp_buffer (temp_id++, aux_bpp * result->width * result->height);
-            }
-            else
-            {
-              thread_data[j].aux_fish = NULL;
-            }
+            data.aux_fish = babl_fish (aux_buf_format, aux_format);
+            data.aux_tmp = gegl_temp_buffer (1, data.aux_bpp * result->width * result->height);
           }
         }
-        else
-        {
-          for (gint j = 0; j < threads; j ++)
-            thread_data[j].aux_fish = NULL;
-        }
         if (aux2)
         {
           if (! babl_format_has_alpha (aux2_buf_format))
             {
               aux2_buf_format = aux2_format;
-              aux2_buf_bpp = aux2_bpp;
+              data.aux2_buf_bpp = data.aux2_bpp;
             }
 
           bar = gegl_buffer_iterator_add (i, aux2, result, level, aux2_buf_format,
                                           GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-          for (gint j = 0; j < threads; j ++)
+          if (aux2_buf_format != aux2_format)
           {
-            if (aux2_buf_format != aux2_format)
-            {
-              thread_data[j].aux2_fish = babl_fish (aux2_buf_format, aux2_format);
-              thread_data[j].aux2_tmp = gegl_temp_buffer (temp_id++, aux2_bpp * result->width * result->height);
-            }
-            else
-            {
-              thread_data[j].aux2_fish = NULL;
-            }
+            data.aux2_fish = babl_fish (aux2_buf_format, aux2_format);
+            data.aux2_tmp = gegl_temp_buffer (2, data.aux2_bpp * result->width * result->height);
           }
         }
-        else
-        {
-          for (gint j = 0; j < threads; j ++)
-            thread_data[j].aux2_fish = NULL;
-        }
 
-        for (gint j = 0; j < threads; j ++)
+        if (output_buf_format != out_format)
         {
-          if (output_buf_format != gegl_buffer_get_format (output))
-          {
-            thread_data[j].output_fish = babl_fish (out_format, output_buf_format);
-            thread_data[j].output_tmp = gegl_temp_buffer (temp_id++, out_bpp * result->width * result->height);
-          }
-          else
-          {
-            thread_data[j].output_fish = NULL;
-          }
+          data.output_fish = babl_fish (out_format, output_buf_format);
+          data.output_tmp = gegl_temp_buffer (3, data.out_bpp * result->width * result->height);
         }
 
         while (gegl_buffer_iterator_next (i))
           {
-            gint threads = gegl_config_threads ();
-            gint pending;
-            gint bit;
-
-            if (i->roi[0].height < threads)
-            {
-              threads = i->roi[0].height;
-            }
-
-            bit = i->roi[0].height / threads;
-            pending = threads;
-
-            for (gint j = 0; j < threads; j++)
-            {
-              thread_data[j].roi.x = (i->roi[0]).x;
-              thread_data[j].roi.width = (i->roi[0]).width;
-              thread_data[j].roi.y = (i->roi[0]).y + bit * j;
-              thread_data[j].roi.height = bit;
-            }
-            thread_data[threads-1].roi.height = i->roi[0].height - (bit * (threads-1));
-            
-            for (gint j = 0; j < threads; j++)
-            {
-              thread_data[j].klass = point_composer3_class;
-              thread_data[j].operation = operation;
-              thread_data[j].input = input?((guchar*)i->data[read]) + (bit * j * i->roi[0].width * in_buf_bpp):NULL;
-              thread_data[j].aux = aux?((guchar*)i->data[foo]) + (bit * j * i->roi[0].width * aux_buf_bpp):NULL;
-              thread_data[j].aux2 = aux2?((guchar*)i->data[bar]) + (bit * j * i->roi[0].width * aux2_buf_bpp):NULL;
-              thread_data[j].output = ((guchar*)i->data[0]) + (bit * j * i->roi[0].width * out_buf_bpp);
-              thread_data[j].pending = &pending;
-              thread_data[j].level = level;
-              thread_data[j].success = TRUE;
-            }
-            pending = threads;
-
-            for (gint j = 1; j < threads; j++)
-              g_thread_pool_push (pool, &thread_data[j], NULL);
-            thread_process (&thread_data[0], NULL);
-
-            while (g_atomic_int_get (&pending)) {};
+            data.roi     = i->roi[0];
+            data.input   = input?(guchar*)i->data[read]:NULL;
+            data.aux     = aux?(guchar*)i->data[foo]:NULL;
+            data.aux2    = aux2?(guchar*)i->data[bar]:NULL;
+            data.output  = (guchar*)i->data[0];
+            data.n_tasks = MIN (data.roi.height,
+                                gegl_config_threads () * GEGL_PARALLEL_TASKS_PER_THREAD);
+
+            gegl_parallel_for (data.n_tasks, thread_process, &data);
           }
 
         return TRUE;
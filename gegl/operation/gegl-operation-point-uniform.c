@@ -0,0 +1,224 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-operation-point-filter.h"
+#include "gegl-operation-point-composer.h"
+#include "gegl-operation-point-uniform.h"
+#include "buffer/gegl-buffer-private.h"
+
+gboolean
+gegl_operation_point_uniform_accepts (GeglOperation *operation)
+{
+  /* the pixels would be written behind the back of the OpenCL cache */
+  if (gegl_operation_use_opencl (operation))
+    return FALSE;
+
+  if (GEGL_IS_OPERATION_POINT_FILTER (operation))
+    {
+      GeglOperationPointFilterClass *klass =
+        GEGL_OPERATION_POINT_FILTER_GET_CLASS (operation);
+
+      return klass->process && ! klass->position_dependent;
+    }
+  else if (GEGL_IS_OPERATION_POINT_COMPOSER (operation))
+    {
+      GeglOperationPointComposerClass *klass =
+        GEGL_OPERATION_POINT_COMPOSER_GET_CLASS (operation);
+
+      return klass->process && ! klass->position_dependent;
+    }
+
+  return FALSE;
+}
+
+/* computes @tile from a single pixel if all inputs are uniform there */
+static gboolean
+point_uniform_tile (GeglBuffer           **inputs,
+                    const Babl           **formats,
+                    gint                   n_inputs,
+                    GeglBuffer            *output,
+                    const Babl            *output_format,
+                    const GeglRectangle   *tile,
+                    GeglPointUniformFunc   func,
+                    gpointer               user_data,
+                    gpointer              *in,
+                    guchar                *in_data)
+{
+  gdouble       out[GEGL_OPERATION_POINT_UNIFORM_MAX_BPP / sizeof (gdouble)];
+  GeglRectangle roi = {tile->x, tile->y, 1, 1};
+  gint          k;
+
+  for (k = 0; k < n_inputs; k++)
+    {
+      if (! inputs[k])
+        {
+          in[k] = NULL;
+          continue;
+        }
+
+      in[k] = in_data + k * GEGL_OPERATION_POINT_UNIFORM_MAX_BPP;
+
+      if (! gegl_buffer_get_uniform (inputs[k], tile, formats[k], in[k]))
+        return FALSE;
+    }
+
+  if (! func (user_data, in, out, &roi))
+    return FALSE;
+
+  gegl_buffer_set_color_from_pixel (output, tile, out, output_format);
+
+  return TRUE;
+}
+
+/* appends a rect to be processed normally, merged into the last one when
+ * it continues it downwards; rows without uniform tiles end up as a
+ * single rect.
+ */
+static void
+append_rect (GArray *rest,
+             gint    x,
+             gint    y,
+             gint    width,
+             gint    height)
+{
+  GeglRectangle rect = {x, y, width, height};
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  if (rest->len)
+    {
+      GeglRectangle *last = &g_array_index (rest, GeglRectangle, rest->len - 1);
+
+      if (last->x == x && last->width == width && last->y + last->height == y)
+        {
+          last->height += height;
+          return;
+        }
+    }
+
+  g_array_append_val (rest, rect);
+}
+
+GArray *
+gegl_operation_point_uniform_process (GeglBuffer          **inputs,
+                                      const Babl          **formats,
+                                      gint                  n_inputs,
+                                      GeglBuffer           *output,
+                                      const Babl           *output_format,
+                                      const GeglRectangle  *result,
+                                      gint                  level,
+                                      GeglPointUniformFunc  func,
+                                      gpointer              user_data)
+{
+  GArray   *rest = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+  gpointer *in;
+  guchar   *in_data;
+  gboolean  has_input = FALSE;
+  gint      tile_width, tile_height;
+  gint      shift_x, shift_y;
+  gint      tx0, tx1, ty0, ty1;
+  gint      tx, ty;
+  gint      k;
+
+  /* uniform tiles are only written at the base level, and linear buffers
+   * have their own data
+   */
+  if (level != 0 ||
+      babl_format_get_bytes_per_pixel (output_format) >
+        GEGL_OPERATION_POINT_UNIFORM_MAX_BPP ||
+      g_object_get_data (G_OBJECT (output), "is-linear"))
+    {
+      g_array_append_val (rest, *result);
+      return rest;
+    }
+
+  for (k = 0; k < n_inputs; k++)
+    if (inputs[k])
+      {
+        if (babl_format_get_bytes_per_pixel (formats[k]) >
+              GEGL_OPERATION_POINT_UNIFORM_MAX_BPP)
+          {
+            g_array_append_val (rest, *result);
+            return rest;
+          }
+
+        has_input = TRUE;
+      }
+
+  tile_width  = output->tile_width;
+  tile_height = output->tile_height;
+  shift_x     = output->shift_x;
+  shift_y     = output->shift_y;
+
+  /* the tiles entirely within the result */
+  tx0 = gegl_tile_indice (result->x + shift_x + tile_width - 1, tile_width);
+  ty0 = gegl_tile_indice (result->y + shift_y + tile_height - 1, tile_height);
+  tx1 = gegl_tile_indice (result->x + shift_x + result->width, tile_width);
+  ty1 = gegl_tile_indice (result->y + shift_y + result->height, tile_height);
+
+  if (! has_input || tx0 >= tx1 || ty0 >= ty1)
+    {
+      g_array_append_val (rest, *result);
+      return rest;
+    }
+
+  in      = g_new (gpointer, n_inputs);
+  in_data = g_malloc (n_inputs * GEGL_OPERATION_POINT_UNIFORM_MAX_BPP);
+
+  /* the partial row of tiles above */
+  append_rect (rest, result->x, result->y,
+               result->width, ty0 * tile_height - shift_y - result->y);
+
+  for (ty = ty0; ty < ty1; ty++)
+    {
+      gint y     = ty * tile_height - shift_y;
+      gint run_x = result->x;
+
+      for (tx = tx0; tx < tx1; tx++)
+        {
+          GeglRectangle tile = {tx * tile_width - shift_x, y,
+                                tile_width, tile_height};
+
+          if (point_uniform_tile (inputs, formats, n_inputs,
+                                  output, output_format, &tile,
+                                  func, user_data, in, in_data))
+            {
+              append_rect (rest, run_x, y, tile.x - run_x, tile_height);
+              run_x = tile.x + tile_width;
+            }
+        }
+
+      append_rect (rest, run_x, y,
+                   result->x + result->width - run_x, tile_height);
+    }
+
+  /* and below */
+  append_rect (rest, result->x, ty1 * tile_height - shift_y,
+               result->width,
+               result->y + result->height - (ty1 * tile_height - shift_y));
+
+  g_free (in_data);
+  g_free (in);
+
+  return rest;
+}
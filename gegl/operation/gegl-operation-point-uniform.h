@@ -0,0 +1,61 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_OPERATION_POINT_UNIFORM_H__
+#define __GEGL_OPERATION_POINT_UNIFORM_H__
+
+G_BEGIN_DECLS
+
+/* A point operation maps uniform input to uniform output. Where all its
+ * inputs lie on uniform tiles, a tile of output is computed from a single
+ * pixel and written as a uniform tile, the rest is processed as usual.
+ */
+
+/* the largest pixel a single pixel pass handles */
+#define GEGL_OPERATION_POINT_UNIFORM_MAX_BPP 128
+
+/* computes the pixel @out from the pixels @in, one for each input buffer
+ * passed to gegl_operation_point_uniform_process() and NULL for missing
+ * ones, @roi is the place of the pixel
+ */
+typedef gboolean (* GeglPointUniformFunc) (gpointer             user_data,
+                                           gpointer            *in,
+                                           gpointer             out,
+                                           const GeglRectangle *roi);
+
+/* returns TRUE if @operation is a point filter or point composer whose
+ * result does not depend on the position of the pixels.
+ */
+gboolean gegl_operation_point_uniform_accepts (GeglOperation *operation);
+
+/* computes the tiles of @output within @result whose @n_inputs @inputs
+ * are all uniform there with @func, and returns the rectangles that are
+ * left to be processed, in runs along the rows of tiles merged where
+ * they line up.
+ */
+GArray * gegl_operation_point_uniform_process (GeglBuffer          **inputs,
+                                               const Babl          **formats,
+                                               gint                  n_inputs,
+                                               GeglBuffer           *output,
+                                               const Babl           *output_format,
+                                               const GeglRectangle  *result,
+                                               gint                  level,
+                                               GeglPointUniformFunc  func,
+                                               gpointer              user_data);
+
+G_END_DECLS
+
+#endif /* __GEGL_OPERATION_POINT_UNIFORM_H__ */
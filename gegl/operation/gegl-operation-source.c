@@ -25,6 +25,7 @@
 #include "gegl-operation-source.h"
 #include "gegl-operation-context.h"
 #include "gegl-config.h"
+#include "gegl-parallel.h"
 
 static gboolean gegl_operation_source_process
                              (GeglOperation        *operation,
@@ -85,30 +86,16 @@ typedef struct ThreadData
   GeglOperationSourceClass *klass;
   GeglOperation            *operation;
   GeglBuffer               *output;
-  gint                     *pending;
   gint                      level;
   gboolean                  success;
-  GeglRectangle             roi;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+static void thread_process (const GeglRectangle *roi, gpointer thread_data)
 {
   ThreadData *data = thread_data;
   if (!data->klass->process (data->operation,
-                       data->output, &data->roi, data->level))
+                       data->output, roi, data->level))
     data->success = FALSE;
-  g_atomic_int_add (data->pending, -1);
-}
-
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
-    }
-  return pool;
 }
 
 static gboolean
@@ -133,52 +120,17 @@ gegl_operation_source_process (GeglOperation        *operation,
 
   if (gegl_operation_use_threading (operation, result))
   {
-    gint threads = gegl_config_threads ();
-    GThreadPool *pool = thread_pool ();
-    ThreadData thread_data[GEGL_MAX_THREADS];
-    gint pending = threads;
-
-    if (result->width > result->height)
-    {
-      gint bit = result->width / threads;
-      for (gint j = 0; j < threads; j++)
-      {
-        thread_data[j].roi.y = result->y;
-        thread_data[j].roi.height = result->height;
-        thread_data[j].roi.x = result->x + bit * j;
-        thread_data[j].roi.width = bit;
-      }
-      thread_data[threads-1].roi.width = result->width - (bit * (threads-1));
-    }
-    else
-    {
-      gint bit = result->height / threads;
-      for (gint j = 0; j < threads; j++)
-      {
-        thread_data[j].roi.x = result->x;
-        thread_data[j].roi.width = result->width;
-        thread_data[j].roi.y = result->y + bit * j;
-        thread_data[j].roi.height = bit;
-      }
-      thread_data[threads-1].roi.height = result->height - (bit * (threads-1));
-    }
-    for (gint i = 0; i < threads; i++)
-    {
-      thread_data[i].klass = klass;
-      thread_data[i].operation = operation;
-      thread_data[i].output = output;
-      thread_data[i].pending = &pending;
-      thread_data[i].level = level;
-      thread_data[i].success = TRUE;
-    }
+    ThreadData data;
 
-    for (gint i = 1; i < threads; i++)
-      g_thread_pool_push (pool, &thread_data[i], NULL);
-    thread_process (&thread_data[0], NULL);
+    data.klass     = klass;
+    data.operation = operation;
+    data.output    = output;
+    data.level     = level;
+    data.success   = TRUE;
 
-    while (g_atomic_int_get (&pending)) {};
+    gegl_parallel_for_area (result, thread_process, &data);
 
-    success = thread_data[0].success;
+    success = data.success;
   }
   else
   {
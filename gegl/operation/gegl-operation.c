@@ -27,6 +27,7 @@
 #include "gegl-types-internal.h"
 #include "gegl-operation.h"
 #include "gegl-operation-context.h"
+#include "gegl-operation-dispatch.h"
 #include "gegl-operations-util.h"
 #include "graph/gegl-node-private.h"
 #include "graph/gegl-connection.h"
@@ -169,7 +170,19 @@ gegl_operation_process (GeglOperation        *operation,
 
   g_return_val_if_fail (klass->process, FALSE);
 
-  return klass->process (operation, context, output_pad, result, level);
+  {
+    GeglOperationDispatch dispatch;
+    gboolean              success;
+
+    if (!gegl_operation_dispatch_begin (&dispatch, operation, context, result))
+      return klass->process (operation, context, output_pad, result, level);
+
+    success = klass->process (operation, context, output_pad, result, level);
+
+    gegl_operation_dispatch_end (&dispatch);
+
+    return success;
+  }
 }
 
 /* Calls an extending class' get_bound_box method if defined otherwise
@@ -760,7 +773,8 @@ gboolean
 gegl_operation_use_opencl (const GeglOperation *operation)
 {
   g_return_val_if_fail (operation->node, FALSE);
-  return operation->node->use_opencl && gegl_cl_is_accelerated ();
+  return operation->node->use_opencl && gegl_cl_is_accelerated () &&
+         gegl_operation_dispatch_use_opencl (operation);
 }
 
 const Babl *
@@ -791,7 +805,7 @@ gegl_operation_use_threading (GeglOperation *operation,
     GeglOperationClass       *op_class;
     op_class = GEGL_OPERATION_GET_CLASS (operation);
 
-    if (op_class->opencl_support && gegl_cl_is_accelerated ())
+    if (op_class->opencl_support && gegl_operation_use_opencl (operation))
       return FALSE;
 
     if (op_class->threaded &&
@@ -801,30 +815,59 @@ gegl_operation_use_threading (GeglOperation *operation,
   return FALSE;
 }
 
-static guchar *gegl_temp_alloc[GEGL_MAX_THREADS * 4]={NULL,};
-static gint    gegl_temp_size[GEGL_MAX_THREADS * 4]={0,};
+/* the scratch buffers are kept per thread, so that operations processed
+ * concurrently by different threads do not share them.  They are freed
+ * when their thread exits.  Each thread has as many slots as there were
+ * shared ones, callers may still pick any of them.
+ */
+#define GEGL_TEMP_BUFFERS (GEGL_MAX_THREADS * 4)
+
+typedef struct
+{
+  guchar *alloc[GEGL_TEMP_BUFFERS];
+  gint    size[GEGL_TEMP_BUFFERS];
+} GeglTempBuffers;
+
+static void
+gegl_temp_buffers_destroy (gpointer data)
+{
+  GeglTempBuffers *temp = data;
+  int no;
+  for (no = 0; no < GEGL_TEMP_BUFFERS; no++)
+    if (temp->alloc[no])
+      gegl_free (temp->alloc[no]);
+  g_slice_free (GeglTempBuffers, temp);
+}
+
+static GPrivate gegl_temp_private = G_PRIVATE_INIT (gegl_temp_buffers_destroy);
 
 guchar *gegl_temp_buffer (int no, int size)
 {
-  if (!gegl_temp_alloc[no] || gegl_temp_size[no] < size)
+  GeglTempBuffers *temp = g_private_get (&gegl_temp_private);
+
+  g_return_val_if_fail (no >= 0 && no < GEGL_TEMP_BUFFERS, NULL);
+
+  if (!temp)
+  {
+    temp = g_slice_new0 (GeglTempBuffers);
+    g_private_set (&gegl_temp_private, temp);
+  }
+
+  if (!temp->alloc[no] || temp->size[no] < size)
   {
-    if (gegl_temp_alloc[no])
-      gegl_free (gegl_temp_alloc[no]);
-    gegl_temp_alloc[no] = gegl_malloc (size);
-    gegl_temp_size[no] = size;
+    if (temp->alloc[no])
+      gegl_free (temp->alloc[no]);
+    temp->alloc[no] = gegl_malloc (size);
+    temp->size[no] = size;
   }
-  return gegl_temp_alloc[no];
+  return temp->alloc[no];
 }
 
+/* frees the buffers of the calling thread; called from gegl_exit() once
+ * the worker threads, which free their own on exit, have been joined.
+ */
 void gegl_temp_buffer_free (void);
 void gegl_temp_buffer_free (void)
 {
-  int no;
-  for (no = 0; no < GEGL_MAX_THREADS * 4; no++)
-    if (gegl_temp_alloc[no])
-    {
-      gegl_free (gegl_temp_alloc[no]);
-      gegl_temp_alloc[no] = NULL;
-      gegl_temp_size[no] = 0;
-    }
+  g_private_replace (&gegl_temp_private, NULL);
 }
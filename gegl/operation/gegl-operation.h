@@ -293,8 +293,9 @@ gboolean  gegl_object_get_has_forked      (GObject *object);
 /**
  * gegl_temp_buffer:
  *
- * Returns a singleton scratch buffer for use with multi-threaded processing
- * dispatch.
+ * Returns scratch buffer @no (0 to GEGL_MAX_THREADS * 4 - 1) of at least
+ * @min_size bytes for use with multi-threaded processing dispatch. The buffers are private to the
+ * calling thread.
  */
 guchar    *gegl_temp_buffer (int no, int min_size);
 
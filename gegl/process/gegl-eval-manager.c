@@ -140,6 +140,37 @@ gegl_eval_manager_apply (GeglEvalManager     *self,
   return object;
 }
 
+/* Renders @roi tile by tile, handing the result of each tile to @func,
+ * see gegl_graph_process_tiled(). Returns FALSE without rendering anything
+ * when the graph is better rendered in one go with
+ * gegl_eval_manager_apply().
+ */
+gboolean
+gegl_eval_manager_apply_tiled (GeglEvalManager     *self,
+                               const GeglRectangle *roi,
+                               gint                 level,
+                               GeglGraphTileFunc    func,
+                               gpointer             user_data)
+{
+  gboolean tiled;
+
+  g_return_val_if_fail (GEGL_IS_EVAL_MANAGER (self), FALSE);
+  g_return_val_if_fail (GEGL_IS_NODE (self->node), FALSE);
+
+  if (level >= GEGL_CACHE_VALID_MIPMAPS)
+    level = GEGL_CACHE_VALID_MIPMAPS-1;
+
+  GEGL_INSTRUMENT_START();
+  gegl_eval_manager_prepare (self);
+  GEGL_INSTRUMENT_END ("gegl", "prepare-graph");
+
+  GEGL_INSTRUMENT_START();
+  tiled = gegl_graph_process_tiled (self->traversal, roi, level, func, user_data);
+  GEGL_INSTRUMENT_END ("gegl", "process-tiled");
+
+  return tiled;
+}
+
 GeglEvalManager * gegl_eval_manager_new     (GeglNode    *node,
                                              const gchar *pad_name)
 {
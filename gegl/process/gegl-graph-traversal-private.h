@@ -26,6 +26,10 @@ struct _GeglGraphTraversal
   GList *bfs_path;
   gboolean rects_dirty;
   GeglBuffer *shared_empty;
+  GHashTable *chains;  /* last node of a fused point chain -> GPtrArray of its nodes */
+  GHashTable *fused;   /* the other nodes of fused point chains */
+  GHashTable *keys;    /* node -> key of its results in the result cache */
+  GHashTable *results; /* node -> GeglBuffer fetched from the result cache */
 };
 
 #endif /* __GEGL_GRAPH_TRAVERSAL_PRIVATE_H__ */
@@ -19,14 +19,20 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "gegl-types-internal.h"
 #include "gegl.h"
 #include "gegl-debug.h"
 #include "gegl-instrument.h"
+#include "gegl-config.h"
+#include "gegl-parallel.h"
 
 #include "buffer/gegl-region.h"
+#include "buffer/gegl-cache.h"
+#include "buffer/gegl-result-cache.h"
 
 #include "graph/gegl-node-private.h"
 #include "graph/gegl-pad.h"
@@ -40,6 +46,20 @@
 #include "operation/gegl-operation.h"
 #include "operation/gegl-operation-context.h"
 #include "operation/gegl-operation-context-private.h"
+#include "operation/gegl-operation-point-chain.h"
+
+#include "opencl/gegl-cl.h"
+
+/* size of the tiles gegl_graph_process_tiled() evaluates the graph in,
+ * rounded up to a multiple of the buffer tile size
+ */
+#define GEGL_GRAPH_TILE_SIZE     256
+
+/* the largest ratio of the area rendered by all nodes for a single tile to
+ * the area they would render without overlapping margins, above which
+ * tiled evaluation is not considered worthwhile
+ */
+#define GEGL_GRAPH_TILE_OVERHEAD 2.0
 
 typedef struct
 {
@@ -115,6 +135,10 @@ gegl_graph_rebuild (GeglGraphTraversal *path, GeglNode *node)
   g_list_free (path->dfs_path);
   g_list_free (path->bfs_path);
   g_hash_table_unref (path->contexts);
+  g_clear_pointer (&path->chains, g_hash_table_unref);
+  g_clear_pointer (&path->fused, g_hash_table_unref);
+  g_clear_pointer (&path->keys, g_hash_table_unref);
+  g_clear_pointer (&path->results, g_hash_table_unref);
 
   /* Replaces everything but shared_empty */
   _gegl_graph_do_build (path, node);
@@ -126,12 +150,65 @@ gegl_graph_free (GeglGraphTraversal *path)
   g_list_free (path->dfs_path);
   g_list_free (path->bfs_path);
   g_hash_table_unref (path->contexts);
+  g_clear_pointer (&path->chains, g_hash_table_unref);
+  g_clear_pointer (&path->fused, g_hash_table_unref);
+  g_clear_pointer (&path->keys, g_hash_table_unref);
+  g_clear_pointer (&path->results, g_hash_table_unref);
   if (path->shared_empty)
     g_object_unref (path->shared_empty);
 
   g_free (path);
 }
 
+/**
+ * gegl_graph_dup:
+ * @path: A prepared traversal
+ *
+ * Create a new traversal visiting the same nodes as @path, with fresh
+ * operation contexts. The nodes are expected to be prepared already, this
+ * allows processing different requests of the same graph from several
+ * threads at once.
+ *
+ * Return value: A new #GeglGraphTraversal
+ */
+GeglGraphTraversal *
+gegl_graph_dup (GeglGraphTraversal *path)
+{
+  GeglGraphTraversal *copy = g_new0 (GeglGraphTraversal, 1);
+  GList              *list_iter;
+
+  copy->dfs_path = g_list_copy (path->dfs_path);
+  copy->bfs_path = g_list_copy (path->bfs_path);
+  copy->contexts = g_hash_table_new_full (NULL,
+                                          NULL,
+                                          NULL,
+                                          (GDestroyNotify)gegl_operation_context_destroy);
+  copy->rects_dirty = FALSE;
+
+  if (path->shared_empty)
+    copy->shared_empty = g_object_ref (path->shared_empty);
+
+  /* the chains are not changed once built, gegl_graph_prepare() replaces
+   * them */
+  if (path->chains)
+    copy->chains = g_hash_table_ref (path->chains);
+  if (path->fused)
+    copy->fused = g_hash_table_ref (path->fused);
+  if (path->keys)
+    copy->keys = g_hash_table_ref (path->keys);
+
+  for (list_iter = copy->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+
+      g_hash_table_insert (copy->contexts,
+                           node,
+                           gegl_operation_context_new (node->operation));
+    }
+
+  return copy;
+}
+
 
 /**
  * gegl_graph_get_bounding_box:
@@ -153,6 +230,374 @@ gegl_graph_get_bounding_box (GeglGraphTraversal *path)
   return *GEGL_RECTANGLE(0, 0, 0, 0);
 }
 
+/* Returns TRUE if the output of @source can be handed straight to @sink
+ * within a fused point chain.
+ */
+static gboolean
+gegl_graph_can_fuse (GeglNode *source,
+                     GeglNode *sink)
+{
+  GeglPad *output_pad = gegl_node_get_pad (source, "output");
+
+  /* the output is not kept anywhere, nothing else may need it */
+  if (! output_pad || g_slist_length (gegl_pad_get_connections (output_pad)) != 1)
+    return FALSE;
+
+  if (gegl_operation_get_format (source->operation, "output") !=
+      gegl_operation_get_format (sink->operation, "input"))
+    return FALSE;
+
+  /* outside of its bounding box the output of source is empty, which the
+   * fused chain can not reproduce */
+  if (! gegl_rectangle_contains (&source->have_rect, &sink->have_rect))
+    return FALSE;
+
+  return gegl_operation_point_chain_accepts (source->operation) &&
+         gegl_operation_point_chain_accepts (sink->operation);
+}
+
+static gint
+gegl_graph_chain_n_aux (GPtrArray *chain)
+{
+  gint n_aux = 0;
+  gint i;
+
+  for (i = 0; i < chain->len; i++)
+    if (gegl_node_has_pad (g_ptr_array_index (chain, i), "aux"))
+      n_aux++;
+
+  return n_aux;
+}
+
+/* Finds the runs of point operations where each one only feeds the next,
+ * these are processed in a single pass by the last node of the run.
+ */
+static void
+gegl_graph_fuse_point_chains (GeglGraphTraversal *path)
+{
+  GList *list_iter;
+
+  g_clear_pointer (&path->chains, g_hash_table_unref);
+  g_clear_pointer (&path->fused, g_hash_table_unref);
+
+  path->chains = g_hash_table_new_full (NULL, NULL, NULL,
+                                        (GDestroyNotify) g_ptr_array_unref);
+  path->fused  = g_hash_table_new (NULL, NULL);
+
+  for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode  *node = GEGL_NODE (list_iter->data);
+      GeglPad   *input_pad = gegl_node_get_pad (node, "input");
+      GeglPad   *source_pad;
+      GeglNode  *source;
+      GPtrArray *chain;
+
+      if (! input_pad)
+        continue;
+
+      source_pad = gegl_pad_get_connected_to (input_pad);
+      if (! source_pad)
+        continue;
+
+      source = gegl_pad_get_node (source_pad);
+
+      if (! g_hash_table_contains (path->contexts, source) ||
+          ! gegl_graph_can_fuse (source, node))
+        continue;
+
+      chain = g_hash_table_lookup (path->chains, source);
+      if (chain)
+        {
+          if (gegl_node_has_pad (node, "aux") &&
+              gegl_graph_chain_n_aux (chain) >= GEGL_OPERATION_POINT_CHAIN_MAX_AUX)
+            continue;
+
+          g_ptr_array_ref (chain);
+          g_hash_table_remove (path->chains, source);
+        }
+      else
+        {
+          chain = g_ptr_array_new ();
+          g_ptr_array_add (chain, source);
+        }
+
+      g_ptr_array_add (chain, node);
+      g_hash_table_insert (path->chains, node, chain);
+      g_hash_table_add (path->fused, source);
+
+      GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                 "Fused %s into a point chain of %d nodes ending in %s",
+                 gegl_node_get_debug_name (source),
+                 chain->len,
+                 gegl_node_get_debug_name (node));
+    }
+}
+
+/* Returns TRUE if @node may be processed concurrently with other nodes
+ * and requests, for the last node of a fused chain only if all the nodes
+ * of the chain may.
+ */
+static gboolean
+gegl_graph_node_threaded (GeglGraphTraversal *path,
+                          GeglNode           *node)
+{
+  GPtrArray *chain = NULL;
+  gint       i;
+
+  if (path->chains)
+    chain = g_hash_table_lookup (path->chains, node);
+
+  if (! chain)
+    return GEGL_OPERATION_GET_CLASS (node->operation)->threaded;
+
+  for (i = 0; i < chain->len; i++)
+    {
+      GeglNode *chain_node = g_ptr_array_index (chain, i);
+
+      if (! GEGL_OPERATION_GET_CLASS (chain_node->operation)->threaded)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+#define GEGL_GRAPH_KEY_INIT G_GUINT64_CONSTANT (0xcbf29ce484222325)
+
+/* FNV-1a */
+static guint64
+gegl_graph_hash (guint64       hash,
+                 gconstpointer data,
+                 gsize         size)
+{
+  const guchar *bytes = data;
+  gsize         i;
+
+  for (i = 0; i < size; i++)
+    {
+      hash ^= bytes[i];
+      hash *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+
+  return hash;
+}
+
+static guint64
+gegl_graph_hash_string (guint64      hash,
+                        const gchar *string)
+{
+  /* including the terminator keeps "ab" "c" apart from "a" "bc" */
+  return gegl_graph_hash (hash, string ? string : "", string ? strlen (string) + 1 : 0);
+}
+
+#define HASH_VALUE(ctype, getter)                           \
+  G_STMT_START {                                            \
+    ctype v = getter (value);                               \
+    *hash = gegl_graph_hash (*hash, &v, sizeof (v));        \
+  } G_STMT_END
+
+/* Adds @value to @hash, returns FALSE when it is not a plain value whose
+ * content can be hashed.
+ */
+static gboolean
+gegl_graph_hash_value (guint64      *hash,
+                       const GValue *value)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+      case G_TYPE_BOOLEAN: HASH_VALUE (gboolean, g_value_get_boolean); break;
+      case G_TYPE_CHAR:    HASH_VALUE (gchar,    g_value_get_schar);   break;
+      case G_TYPE_UCHAR:   HASH_VALUE (guchar,   g_value_get_uchar);   break;
+      case G_TYPE_INT:     HASH_VALUE (gint,     g_value_get_int);     break;
+      case G_TYPE_UINT:    HASH_VALUE (guint,    g_value_get_uint);    break;
+      case G_TYPE_LONG:    HASH_VALUE (glong,    g_value_get_long);    break;
+      case G_TYPE_ULONG:   HASH_VALUE (gulong,   g_value_get_ulong);   break;
+      case G_TYPE_INT64:   HASH_VALUE (gint64,   g_value_get_int64);   break;
+      case G_TYPE_UINT64:  HASH_VALUE (guint64,  g_value_get_uint64);  break;
+      case G_TYPE_FLOAT:   HASH_VALUE (gfloat,   g_value_get_float);   break;
+      case G_TYPE_DOUBLE:  HASH_VALUE (gdouble,  g_value_get_double);  break;
+      case G_TYPE_ENUM:    HASH_VALUE (gint,     g_value_get_enum);    break;
+      case G_TYPE_FLAGS:   HASH_VALUE (guint,    g_value_get_flags);   break;
+
+      case G_TYPE_STRING:
+        *hash = gegl_graph_hash_string (*hash, g_value_get_string (value));
+        break;
+
+      case G_TYPE_OBJECT:
+        {
+          GObject *object = g_value_get_object (value);
+          gdouble  rgba[4] = { 0.0, };
+
+          if (object && ! GEGL_IS_COLOR (object))
+            return FALSE;
+
+          if (object)
+            gegl_color_get_rgba (GEGL_COLOR (object),
+                                 &rgba[0], &rgba[1], &rgba[2], &rgba[3]);
+
+          *hash = gegl_graph_hash (*hash, &rgba, sizeof (rgba));
+        }
+        break;
+
+      default:
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+#undef HASH_VALUE
+
+/* The key of the results of @node, a hash of its operation type, the
+ * values of its properties and the keys of its inputs. Results of sources,
+ * and of nodes with properties that are not plain values, like buffers or
+ * paths, can not be described that way; their key is made from the serial
+ * of the node, which is renewed whenever the node is invalidated.
+ */
+static guint64
+gegl_graph_node_key (GeglGraphTraversal *path,
+                     GeglNode           *node)
+{
+  GeglOperation  *operation = node->operation;
+  GParamSpec    **pspecs;
+  guint           n_pspecs;
+  guint64         key    = GEGL_GRAPH_KEY_INIT;
+  gboolean        opaque = node->input_pads == NULL;
+  GSList         *iter;
+  guint           i;
+
+  key = gegl_graph_hash_string (key, G_OBJECT_TYPE_NAME (operation));
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (operation),
+                                           &n_pspecs);
+
+  for (i = 0; i < n_pspecs && ! opaque; i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      if (! (pspecs[i]->flags & G_PARAM_READABLE) ||
+          pspecs[i]->flags & (GEGL_PARAM_PAD_INPUT | GEGL_PARAM_PAD_OUTPUT))
+        continue;
+
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspecs[i]));
+      g_object_get_property (G_OBJECT (operation), pspecs[i]->name, &value);
+
+      key    = gegl_graph_hash_string (key, pspecs[i]->name);
+      opaque = ! gegl_graph_hash_value (&key, &value);
+
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+
+  for (iter = node->input_pads; iter && ! opaque; iter = iter->next)
+    {
+      GeglPad *source_pad = gegl_pad_get_connected_to (iter->data);
+
+      key = gegl_graph_hash_string (key, gegl_pad_get_name (iter->data));
+
+      if (source_pad)
+        {
+          guint64 *source_key = g_hash_table_lookup (path->keys,
+                                                     gegl_pad_get_node (source_pad));
+
+          if (source_key)
+            key = gegl_graph_hash (key, source_key, sizeof (*source_key));
+          else
+            opaque = TRUE;
+        }
+    }
+
+  if (opaque)
+    {
+      gint serial = g_atomic_int_get (&node->serial);
+
+      key = gegl_graph_hash_string (GEGL_GRAPH_KEY_INIT, "node");
+      key = gegl_graph_hash (key, &serial, sizeof (serial));
+    }
+
+  return key;
+}
+
+/* Computes the keys of all nodes of @path, their inputs coming first in
+ * the dfs path.
+ */
+static void
+gegl_graph_compute_keys (GeglGraphTraversal *path)
+{
+  GList *list_iter;
+
+  g_clear_pointer (&path->keys, g_hash_table_unref);
+
+  if (! gegl_config ()->result_cache)
+    return;
+
+  path->keys = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+      guint64  *key  = g_new (guint64, 1);
+
+      *key = gegl_graph_node_key (path, node);
+      g_hash_table_insert (path->keys, node, key);
+    }
+}
+
+/* Returns the key the results of @node are kept under in the result cache,
+ * or NULL if they are not to be kept there, like those of nodes that are
+ * not cached at all, or that are processed as part of a fused chain.
+ */
+static const guint64 *
+gegl_graph_get_key (GeglGraphTraversal *path,
+                    GeglNode           *node)
+{
+  if (! path->keys ||
+      node->dont_cache ||
+      GEGL_OPERATION_GET_CLASS (node->operation)->no_cache ||
+      ! gegl_node_has_pad (node, "output") ||
+      (path->fused && g_hash_table_contains (path->fused, node)))
+    return NULL;
+
+  return g_hash_table_lookup (path->keys, node);
+}
+
+/* Looks up the part of the results of @node needed for @request in the
+ * result cache, keeping the buffer for gegl_graph_process_node() when all
+ * of it is there.
+ */
+static gboolean
+gegl_graph_fetch_result (GeglGraphTraversal  *path,
+                         GeglNode            *node,
+                         const GeglRectangle *request,
+                         gint                 level)
+{
+  const guint64 *key = gegl_graph_get_key (path, node);
+  const Babl    *format;
+  GeglBuffer    *buffer;
+
+  if (! key)
+    return FALSE;
+
+  format = gegl_operation_get_format (node->operation, "output");
+  if (! format)
+    return FALSE;
+
+  buffer = gegl_result_cache_fetch (*key, request, level, format);
+  if (! buffer)
+    return FALSE;
+
+  if (! path->results)
+    path->results = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+
+  g_hash_table_insert (path->results, node, buffer);
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Found the result of %s in the result cache",
+             gegl_node_get_debug_name (node));
+
+  return TRUE;
+}
+
 /**
  * gegl_graph_prepare:
  * @path: The traversal path
@@ -200,6 +645,9 @@ gegl_graph_prepare (GeglGraphTraversal *path)
                              context);
       }
   }
+
+  gegl_graph_fuse_point_chains (path);
+  gegl_graph_compute_keys (path);
 }
 
 /**
@@ -240,6 +688,10 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
 
   path->rects_dirty = TRUE;
 
+  /* the results fetched for the previous request */
+  if (path->results)
+    g_hash_table_remove_all (path->results);
+
   {
     /* Prep the first node */
     GeglNode *node = GEGL_NODE (path->bfs_path->data);
@@ -274,9 +726,15 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
           continue;
         }
       
-      if (node->cache)
+      /* the nodes inside a fused chain produce no output of their own,
+       * so their cache can not stand in for their input */
+      if (node->cache &&
+          ! (path->fused && g_hash_table_contains (path->fused, node)))
         {
           gint i;
+          /* the valid region may be updated by requests being
+           * processed in other threads */
+          g_mutex_lock (&node->cache->mutex);
           for (i = level; i >=0 && !context->cached; i--)
           {
             if (gegl_region_rect_in (node->cache->valid_region[level], request) == GEGL_OVERLAP_RECTANGLE_IN)
@@ -286,10 +744,18 @@ gegl_graph_prepare_request (GeglGraphTraversal  *path,
               gegl_operation_context_set_result_rect (context, &empty_rect);
             }
           }
+          g_mutex_unlock (&node->cache->mutex);
           if (context->cached)
             continue;
         }
 
+      if (gegl_graph_fetch_result (path, node, request, level))
+        {
+          context->cached = TRUE;
+          gegl_operation_context_set_result_rect (context, &empty_rect);
+          continue;
+        }
+
       {
         /* Expand request if the operation has a minimum processing requirement */
         GeglRectangle full_request = gegl_operation_get_cached_region (operation, request);
@@ -373,6 +839,361 @@ gegl_graph_get_shared_empty (GeglGraphTraversal *path)
 }
 
 
+/* Processes the fused point chain ending in the node of @context in a
+ * single pass, from the input of the first node and the aux inputs of each.
+ */
+static void
+gegl_graph_process_chain (GeglGraphTraversal   *path,
+                          GPtrArray            *chain,
+                          GeglOperationContext *context,
+                          gint                  level)
+{
+  GeglOperation        *last       = context->operation;
+  GeglOperation       **operations = g_new (GeglOperation *, chain->len);
+  GeglBuffer          **aux        = g_new0 (GeglBuffer *, chain->len);
+  GeglOperationContext *first;
+  GeglBuffer           *input;
+  GeglBuffer           *output;
+  gint                  i;
+
+  for (i = 0; i < chain->len; i++)
+    {
+      GeglNode *node = g_ptr_array_index (chain, i);
+
+      operations[i] = node->operation;
+
+      if (gegl_node_has_pad (node, "aux"))
+        {
+          GeglOperationContext *node_context = g_hash_table_lookup (path->contexts, node);
+
+          aux[i] = GEGL_BUFFER (gegl_operation_context_get_object (node_context, "aux"));
+        }
+    }
+
+  first = g_hash_table_lookup (path->contexts, g_ptr_array_index (chain, 0));
+  input = GEGL_BUFFER (gegl_operation_context_get_object (first, "input"));
+  if (! input)
+    input = gegl_graph_get_shared_empty (path);
+
+  if (GEGL_OPERATION_GET_CLASS (last)->want_in_place &&
+      gegl_can_do_inplace_processing (last, input, &context->need_rect))
+    {
+      output = g_object_ref (input);
+      gegl_operation_context_take_object (context, "output", G_OBJECT (output));
+    }
+  else
+    {
+      output = gegl_operation_context_get_target (context, "output");
+    }
+
+  gegl_operation_point_chain_process (operations, aux, chain->len,
+                                      input, output, &context->need_rect, level);
+
+  g_free (operations);
+  g_free (aux);
+}
+
+/* Processes a single node of the traversal, returning its output or NULL.
+ * When @lock is given it is held while the operation processes, which
+ * serializes operations that are not safe to run concurrently on
+ * different requests.
+ */
+static GeglBuffer *
+gegl_graph_process_node (GeglGraphTraversal *path,
+                         GeglNode           *node,
+                         gint                level,
+                         GMutex             *lock)
+{
+  GeglOperation        *operation = node->operation;
+  GeglOperationContext *context;
+  GeglBuffer           *operation_result = NULL;
+
+  context = g_hash_table_lookup (path->contexts, node);
+  g_return_val_if_fail (context, NULL);
+
+  /* processed as part of the chain it was fused into */
+  if (path->fused && g_hash_table_contains (path->fused, node))
+    return NULL;
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will process %s result_rect = %d, %d %d×%d",
+             gegl_node_get_debug_name (node),
+             context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
+
+  if (context->need_rect.width > 0 && context->need_rect.height > 0)
+    {
+      if (context->cached)
+        {
+          GEGL_NOTE (GEGL_DEBUG_PROCESS,
+                     "Using cached result for %s",
+                     gegl_node_get_debug_name (node));
+          if (path->results)
+            operation_result = g_hash_table_lookup (path->results, node);
+          if (! operation_result)
+            operation_result = GEGL_BUFFER (node->cache);
+        }
+      else if (path->chains && g_hash_table_contains (path->chains, node))
+        {
+          context->level = level;
+
+          if (lock)
+            g_mutex_lock (lock);
+          gegl_graph_process_chain (path, g_hash_table_lookup (path->chains, node),
+                                    context, level);
+          if (lock)
+            g_mutex_unlock (lock);
+
+          operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+
+          if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
+            gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+        }
+      else
+        {
+          /* Guarantee input pad */
+          if (gegl_node_has_pad (node, "input") &&
+              !gegl_operation_context_get_object (context, "input"))
+            {
+              gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
+            }
+
+          context->level = level;
+
+          if (lock)
+            g_mutex_lock (lock);
+          gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
+          if (lock)
+            g_mutex_unlock (lock);
+
+          operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
+
+          if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
+            gegl_cache_computed (operation->node->cache, &context->need_rect, level);
+        }
+
+      if (operation_result && ! context->cached)
+        {
+          const guint64 *key = gegl_graph_get_key (path, node);
+
+          if (key)
+            gegl_result_cache_store (*key, operation_result,
+                                     &context->need_rect, level);
+        }
+    }
+
+  return operation_result;
+}
+
+static void
+gegl_graph_deliver (GeglGraphTraversal *path,
+                    GeglNode           *node,
+                    GeglBuffer         *operation_result)
+{
+  GeglPad *output_pad = gegl_node_get_pad (node, "output");
+  GList   *targets = gegl_graph_get_connected_output_contexts (path, output_pad);
+  GList   *targets_iter;
+
+  GEGL_NOTE (GEGL_DEBUG_PROCESS,
+             "Will deliver the results of %s:%s to %d targets",
+             gegl_node_get_debug_name (node),
+             "output",
+             g_list_length (targets));
+
+  if (g_list_length (targets) > 1)
+    gegl_object_set_has_forked (G_OBJECT (operation_result));
+
+  for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
+    {
+      ContextConnection *target_con = targets_iter->data;
+      gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
+    }
+
+  g_list_free_full (targets, free_context_connection);
+}
+
+/* Assigns each node of the dfs path to a wave, one past the latest wave of
+ * the nodes it reads from. The nodes within a wave do not depend on each
+ * other and can be processed in any order, or at the same time.
+ */
+static gint *
+gegl_graph_get_waves (GeglGraphTraversal *path,
+                      gint               *n_waves)
+{
+  GHashTable *index = g_hash_table_new (NULL, NULL);
+  gint       *waves = g_new0 (gint, g_list_length (path->dfs_path));
+  GList      *list_iter;
+  gint        i;
+
+  *n_waves = 0;
+
+  for (list_iter = path->dfs_path, i = 0; list_iter; list_iter = list_iter->next, i++)
+    {
+      GeglNode *node = GEGL_NODE (list_iter->data);
+      GSList   *input_pads;
+
+      for (input_pads = node->input_pads; input_pads; input_pads = input_pads->next)
+        {
+          GeglPad *source_pad = gegl_pad_get_connected_to (input_pads->data);
+          gpointer source_index;
+
+          if (source_pad &&
+              g_hash_table_lookup_extended (index, gegl_pad_get_node (source_pad),
+                                            NULL, &source_index))
+            {
+              waves[i] = MAX (waves[i], waves[GPOINTER_TO_INT (source_index)] + 1);
+            }
+        }
+
+      *n_waves = MAX (*n_waves, waves[i] + 1);
+      g_hash_table_insert (index, node, GINT_TO_POINTER (i));
+    }
+
+  g_hash_table_unref (index);
+
+  return waves;
+}
+
+typedef struct
+{
+  GeglGraphTraversal  *path;
+  GeglNode           **nodes;
+  GeglBuffer         **results;
+  GMutex             **locks;
+  gint                 level;
+} WaveData;
+
+static void
+gegl_graph_process_wave_node (gint     i,
+                              gpointer user_data)
+{
+  WaveData *data = user_data;
+
+  GEGL_INSTRUMENT_START();
+
+  data->results[i] = gegl_graph_process_node (data->path, data->nodes[i],
+                                              data->level, data->locks[i]);
+
+  GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (data->nodes[i]));
+}
+
+static GeglBuffer *
+gegl_graph_process_internal (GeglGraphTraversal *path,
+                             gint                level,
+                             GMutex             *locks)
+{
+  GeglBuffer  *result = NULL;
+  GeglNode    *last_node;
+  GeglBuffer  *last_result = NULL;
+  gint         n_nodes = g_list_length (path->dfs_path);
+  gint         n_waves;
+  gint        *waves;
+  GeglNode   **nodes;
+  GeglBuffer **results;
+  GMutex     **node_locks;
+  GList       *list_iter;
+  gint         wave;
+  gint         i;
+
+  g_return_val_if_fail (n_nodes > 0, NULL);
+
+  waves      = gegl_graph_get_waves (path, &n_waves);
+  nodes      = g_new (GeglNode *, n_nodes);
+  results    = g_new (GeglBuffer *, n_nodes);
+  node_locks = g_new (GMutex *, n_nodes);
+  last_node  = GEGL_NODE (g_list_last (path->dfs_path)->data);
+
+  /* created up front, nodes of a wave may ask for it concurrently */
+  gegl_graph_get_shared_empty (path);
+
+  for (wave = 0; wave < n_waves; wave++)
+    {
+      WaveData data;
+      gint     n_concurrent = 0;
+      gint     n_wave = 0;
+
+      /* only operations that may run in several threads at once, which
+       * are the ones splitting their own work over the worker threads,
+       * are processed concurrently; each of them then runs in a single
+       * thread.  The others are processed one after another.
+       */
+      for (list_iter = path->dfs_path, i = 0; list_iter; list_iter = list_iter->next, i++)
+        {
+          GeglNode *node = GEGL_NODE (list_iter->data);
+
+          if (waves[i] == wave && gegl_graph_node_threaded (path, node))
+            {
+              nodes[n_wave]      = node;
+              node_locks[n_wave] = NULL;
+              n_wave++;
+            }
+        }
+
+      n_concurrent = n_wave;
+
+      for (list_iter = path->dfs_path, i = 0; list_iter; list_iter = list_iter->next, i++)
+        {
+          GeglNode *node = GEGL_NODE (list_iter->data);
+
+          if (waves[i] == wave && ! gegl_graph_node_threaded (path, node))
+            {
+              nodes[n_wave]      = node;
+              node_locks[n_wave] = locks ? &locks[i] : NULL;
+              n_wave++;
+            }
+        }
+
+      data.path    = path;
+      data.nodes   = nodes;
+      data.results = results;
+      data.locks   = node_locks;
+      data.level   = level;
+
+      if (n_concurrent > 1)
+        gegl_parallel_for (n_concurrent, gegl_graph_process_wave_node, &data);
+      else
+        n_concurrent = 0;
+
+      for (i = n_concurrent; i < n_wave; i++)
+        gegl_graph_process_wave_node (i, &data);
+
+      for (i = 0; i < n_wave; i++)
+        {
+          if (results[i])
+            gegl_graph_deliver (path, nodes[i], results[i]);
+
+          /* the earlier nodes of a fused chain hold on to their inputs
+           * until the last node is done */
+          if (path->chains && g_hash_table_contains (path->chains, nodes[i]))
+            {
+              GPtrArray *chain = g_hash_table_lookup (path->chains, nodes[i]);
+              gint       j;
+
+              for (j = 0; j < chain->len - 1; j++)
+                gegl_operation_context_purge (g_hash_table_lookup (path->contexts,
+                                                                   g_ptr_array_index (chain, j)));
+            }
+
+          if (nodes[i] == last_node)
+            last_result = results[i];
+          else if (! (path->fused && g_hash_table_contains (path->fused, nodes[i])))
+            gegl_operation_context_purge (g_hash_table_lookup (path->contexts, nodes[i]));
+        }
+    }
+
+  if (last_result)
+    result = g_object_ref (last_result);
+  else if (gegl_node_has_pad (last_node, "output"))
+    result = g_object_ref (gegl_graph_get_shared_empty (path));
+  gegl_operation_context_purge (g_hash_table_lookup (path->contexts, last_node));
+
+  g_free (waves);
+  g_free (nodes);
+  g_free (results);
+  g_free (node_locks);
+
+  return result;
+}
+
 /**
  * gegl_graph_process:
  * @path: The traversal path
@@ -391,102 +1212,200 @@ GeglBuffer *
 gegl_graph_process (GeglGraphTraversal *path,
                     gint                level)
 {
-  GList *list_iter = NULL;
-  GeglBuffer *result = NULL;
-  GeglOperationContext *context = NULL;
-  GeglOperationContext *last_context = NULL;
-  GeglBuffer *operation_result = NULL;
+  return gegl_graph_process_internal (path, level, NULL);
+}
+
+typedef struct
+{
+  GeglGraphTraversal *path;
+  GeglRectangle       roi;
+  gint                level;
+  gint                tile_width;
+  gint                tile_height;
+  gint                first_column;
+  gint                first_row;
+  gint                n_columns;
+  GMutex             *locks;
+  GeglGraphTileFunc   func;
+  gpointer            user_data;
+} TiledData;
+
+static void
+gegl_graph_process_tile (gint     i,
+                         gpointer user_data)
+{
+  TiledData          *data = user_data;
+  GeglGraphTraversal *tile_path;
+  GeglBuffer         *result;
+  GeglRectangle       tile;
+
+  tile.x      = (data->first_column + i % data->n_columns) * data->tile_width;
+  tile.y      = (data->first_row    + i / data->n_columns) * data->tile_height;
+  tile.width  = data->tile_width;
+  tile.height = data->tile_height;
+
+  gegl_rectangle_intersect (&tile, &tile, &data->roi);
+
+  tile_path = gegl_graph_dup (data->path);
+
+  gegl_graph_prepare_request (tile_path, &tile, data->level);
+  result = gegl_graph_process_internal (tile_path, data->level, data->locks);
+
+  if (result)
+    {
+      data->func (result, &tile, data->user_data);
+      g_object_unref (result);
+    }
+
+  gegl_graph_free (tile_path);
+}
+
+static inline gint
+gegl_graph_floor_div (gint a,
+                      gint b)
+{
+  return a >= 0 ? a / b : ((a + 1) / b) - 1;
+}
+
+/* Checks whether rendering @sample on its own takes a reasonable amount of
+ * work, rejecting graphs with large margins, or with nodes that need all of
+ * their input for any part of their output.
+ */
+static gboolean
+gegl_graph_tile_is_cheap (GeglGraphTraversal  *path,
+                          const GeglRectangle *sample,
+                          gint                 level)
+{
+  GList   *list_iter;
+  gdouble  sample_area = (gdouble) sample->width * sample->height;
+  gdouble  area = 0.0;
+  gint     n_nodes = 0;
+
+  gegl_graph_prepare_request (path, sample, level);
 
   for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
     {
-      GeglNode *node = GEGL_NODE (list_iter->data);
-      GeglOperation *operation = node->operation;
-      g_return_val_if_fail (node, NULL);
-      g_return_val_if_fail (operation, NULL);
-      
-      GEGL_INSTRUMENT_START();
+      GeglOperationContext *context = g_hash_table_lookup (path->contexts, list_iter->data);
+      GeglRectangle        *need    = gegl_operation_context_get_need_rect (context);
 
-      operation_result = NULL;
+      if (context->cached || need->width <= 0 || need->height <= 0)
+        continue;
 
-      if (last_context)
-        gegl_operation_context_purge (last_context);
-      
-      context = g_hash_table_lookup (path->contexts, node);
-      g_return_val_if_fail (context, NULL);
+      area += (gdouble) need->width * need->height;
+      n_nodes++;
+    }
+
+  return n_nodes == 0 || area <= GEGL_GRAPH_TILE_OVERHEAD * n_nodes * sample_area;
+}
 
+/**
+ * gegl_graph_process_tiled:
+ * @path: A prepared traversal path
+ * @roi: The area to render
+ * @level: The mipmap level to render at
+ * @func: Function receiving the result of each tile
+ * @user_data: user data passed to @func
+ *
+ * Render @roi in tiles aligned to a fixed grid, each tile being pulled
+ * through the whole graph before the next, so that intermediate results
+ * are only kept for a tile at a time. The tiles are distributed over the
+ * worker threads, @func is called from the thread that rendered the tile
+ * and has to be safe to call concurrently for different tiles.
+ *
+ * Operations that are not marked as threaded never process two tiles at
+ * the same time.
+ *
+ * Return value: FALSE if tiled rendering is not worthwhile for this graph
+ * and request, in which case nothing was rendered.
+ */
+gboolean
+gegl_graph_process_tiled (GeglGraphTraversal  *path,
+                          const GeglRectangle *roi,
+                          gint                 level,
+                          GeglGraphTileFunc    func,
+                          gpointer             user_data)
+{
+  TiledData     data;
+  GeglRectangle request;
+  GeglRectangle sample;
+  GeglNode     *first_node;
+  GList        *list_iter;
+  gint          n_nodes;
+  gint          n_rows;
+  gint          i;
+
+  g_return_val_if_fail (path->bfs_path, FALSE);
+  g_return_val_if_fail (roi != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  /* the OpenCL code paths rely on processing large chunks in one go */
+  if (gegl_cl_is_accelerated ())
+    return FALSE;
+
+  first_node = GEGL_NODE (path->bfs_path->data);
+  if (! gegl_rectangle_intersect (&request, &first_node->have_rect, roi))
+    return FALSE;
+
+  data.tile_width  = gegl_config ()->tile_width;
+  data.tile_height = gegl_config ()->tile_height;
+  data.tile_width  *= MAX (1, (GEGL_GRAPH_TILE_SIZE + data.tile_width  - 1) / data.tile_width);
+  data.tile_height *= MAX (1, (GEGL_GRAPH_TILE_SIZE + data.tile_height - 1) / data.tile_height);
+
+  data.first_column = gegl_graph_floor_div (request.x, data.tile_width);
+  data.first_row    = gegl_graph_floor_div (request.y, data.tile_height);
+  data.n_columns    = gegl_graph_floor_div (request.x + request.width - 1, data.tile_width) -
+                      data.first_column + 1;
+  n_rows            = gegl_graph_floor_div (request.y + request.height - 1, data.tile_height) -
+                      data.first_row + 1;
+
+  if (data.n_columns * n_rows <= 1)
+    return FALSE;
+
+  /* sample the tile at the center of the request */
+  sample.x      = gegl_graph_floor_div (request.x + request.width / 2, data.tile_width) * data.tile_width;
+  sample.y      = gegl_graph_floor_div (request.y + request.height / 2, data.tile_height) * data.tile_height;
+  sample.width  = data.tile_width;
+  sample.height = data.tile_height;
+  gegl_rectangle_intersect (&sample, &sample, &request);
+
+  if (! gegl_graph_tile_is_cheap (path, &sample, level))
+    {
       GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                 "Will process %s result_rect = %d, %d %d×%d",
-                 gegl_node_get_debug_name (node),
-                 context->result_rect.x, context->result_rect.y, context->result_rect.width, context->result_rect.height);
-      
-      if (context->need_rect.width > 0 && context->need_rect.height > 0)
-        {
-          if (context->cached)
-            {
-              GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                         "Using cached result for %s",
-                         gegl_node_get_debug_name (node));
-              operation_result = GEGL_BUFFER (node->cache);
-            }
-          else
-            {
-              /* Guarantee input pad */
-              if (gegl_node_has_pad (node, "input") &&
-                  !gegl_operation_context_get_object (context, "input"))
-                {
-                  gegl_operation_context_set_object (context, "input", G_OBJECT (gegl_graph_get_shared_empty(path)));
-                }
-
-              context->level = level;
-              gegl_operation_process (operation, context, "output", &context->need_rect, context->level);
-              operation_result = GEGL_BUFFER (gegl_operation_context_get_object (context, "output"));
-
-              if (operation_result && operation_result == (GeglBuffer *)operation->node->cache)
-                gegl_cache_computed (operation->node->cache, &context->need_rect, level);
-            }
-        }
-      else
-        {
-          operation_result = NULL;
-        }
+                 "Not rendering %s in tiles, the margins are too large",
+                 gegl_node_get_debug_name (first_node));
+      return FALSE;
+    }
 
-      if (operation_result)
-        {
-          GeglPad *output_pad = gegl_node_get_pad (node, "output");
-          GList   *targets = gegl_graph_get_connected_output_contexts (path, output_pad);
-          GList   *targets_iter;
+  data.path      = path;
+  data.roi       = request;
+  data.level     = level;
+  data.func      = func;
+  data.user_data = user_data;
 
-          GEGL_NOTE (GEGL_DEBUG_PROCESS,
-                     "Will deliver the results of %s:%s to %d targets",
-                     gegl_node_get_debug_name (node),
-                     "output",
-                     g_list_length (targets));
-          
-          if (g_list_length (targets) > 1)
-            gegl_object_set_has_forked (G_OBJECT (operation_result));
+  n_nodes    = g_list_length (path->dfs_path);
+  data.locks = g_new (GMutex, n_nodes);
+  for (i = 0; i < n_nodes; i++)
+    g_mutex_init (&data.locks[i]);
 
-          for (targets_iter = targets; targets_iter; targets_iter = g_list_next (targets_iter))
-            {
-              ContextConnection *target_con = targets_iter->data;
-              gegl_operation_context_set_object (target_con->context, target_con->name, G_OBJECT (operation_result));
-            }
-          
-          g_list_free_full (targets, free_context_connection);
-        }
-      
-      last_context = context;
+  /* make sure the shared empty buffer and the node caches exist before the
+   * tiles race to create them */
+  gegl_graph_get_shared_empty (path);
 
-      GEGL_INSTRUMENT_END ("process", gegl_node_get_operation (node));
-    }
-  
-  if (last_context)
+  for (list_iter = path->dfs_path; list_iter; list_iter = list_iter->next)
     {
-      if (operation_result)
-        result = g_object_ref (operation_result);
-      else if (gegl_node_has_pad (last_context->operation->node, "output"))
-        result = g_object_ref (gegl_graph_get_shared_empty (path));
-      gegl_operation_context_purge (last_context);
+      GeglNode *node = GEGL_NODE (list_iter->data);
+
+      if (! node->dont_cache &&
+          ! GEGL_OPERATION_GET_CLASS (node->operation)->no_cache &&
+          gegl_node_get_pad (node, "output"))
+        gegl_node_get_cache (node);
     }
 
-  return result;
+  gegl_parallel_for (data.n_columns * n_rows, gegl_graph_process_tile, &data);
+
+  for (i = 0; i < n_nodes; i++)
+    g_mutex_clear (&data.locks[i]);
+  g_free (data.locks);
+
+  return TRUE;
 }
@@ -20,10 +20,15 @@
 
 typedef struct _GeglGraphTraversal GeglGraphTraversal;
 
+typedef void (*GeglGraphTileFunc) (GeglBuffer          *result,
+                                   const GeglRectangle *roi,
+                                   gpointer             user_data);
+
 GeglGraphTraversal *gegl_graph_build            (GeglNode            *node);
 void                gegl_graph_rebuild          (GeglGraphTraversal  *path,
                                                  GeglNode            *node);
 void                gegl_graph_free             (GeglGraphTraversal  *path);
+GeglGraphTraversal *gegl_graph_dup              (GeglGraphTraversal  *path);
 
 void                gegl_graph_prepare          (GeglGraphTraversal  *path);
 void                gegl_graph_prepare_request  (GeglGraphTraversal  *path,
@@ -31,6 +36,11 @@ void                gegl_graph_prepare_request  (GeglGraphTraversal  *path,
                                                  gint                 level);
 GeglBuffer         *gegl_graph_process          (GeglGraphTraversal  *path,
                                                  gint                 level);
+gboolean            gegl_graph_process_tiled    (GeglGraphTraversal  *path,
+                                                 const GeglRectangle *roi,
+                                                 gint                 level,
+                                                 GeglGraphTileFunc    func,
+                                                 gpointer             user_data);
 
 GeglRectangle       gegl_graph_get_bounding_box (GeglGraphTraversal  *path);
 
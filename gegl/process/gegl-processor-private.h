@@ -43,6 +43,14 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
                                              const GeglRectangle *rectangle);
 gboolean       gegl_processor_work          (GeglProcessor       *processor,
                                              gdouble             *progress);
+
+/* the number of pixels processors were asked to render, counting the
+ * whole rectangle each time rendering it starts anew, and the number of
+ * pixels they actually rendered
+ */
+guint64        gegl_processor_get_pixels_requested (void);
+guint64        gegl_processor_get_pixels_rendered  (void);
+void           gegl_processor_reset_stats          (void);
 G_END_DECLS
 
 #endif /* __GEGL_PROCESSOR_PRIVATE_H__ */
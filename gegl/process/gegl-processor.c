@@ -63,9 +63,10 @@ static void      gegl_processor_get_property (GObject               *gobject,
                                               GParamSpec            *pspec);
 static void      gegl_processor_set_node     (GeglProcessor         *processor,
                                               GeglNode              *node);
-static void      gegl_processor_constructed  (GObject               *object);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
-static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static void      gegl_processor_invalidated  (GeglNode              *node,
+                                              const GeglRectangle   *rect,
+                                              GeglProcessor         *processor);
 
 
 struct _GeglProcessor
@@ -79,8 +80,8 @@ struct _GeglProcessor
   GeglOperationContext *context;
 
   GeglRegion      *valid_region;     /* used when doing unbuffered rendering */
-  GeglRegion      *queued_region;
-  GSList          *dirty_rectangles;
+  gulong           invalidated_handler;
+  gboolean         rendering;        /* rectangle has been counted as requested */
   gint             chunk_size;
 
   gdouble          progress;
@@ -89,6 +90,11 @@ struct _GeglProcessor
 
 G_DEFINE_TYPE (GeglProcessor, gegl_processor, G_TYPE_OBJECT)
 
+/* totals over all processors, see gegl_stats () */
+static GMutex  stats_mutex;
+static guint64 pixels_requested = 0;
+static guint64 pixels_rendered  = 0;
+
 
 static void
 gegl_processor_class_init (GeglProcessorClass *klass)
@@ -96,7 +102,6 @@ gegl_processor_class_init (GeglProcessorClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->finalize     = gegl_processor_finalize;
-  gobject_class->constructed  = gegl_processor_constructed;
   gobject_class->set_property = gegl_processor_set_property;
   gobject_class->get_property = gegl_processor_get_property;
 
@@ -138,21 +143,11 @@ gegl_processor_init (GeglProcessor *processor)
   processor->real_node        = NULL;
   processor->input            = NULL;
   processor->context          = NULL;
-  processor->queued_region    = NULL;
-  processor->dirty_rectangles = NULL;
+  processor->valid_region     = NULL;
+  processor->rendering        = FALSE;
   processor->chunk_size       = 128 * 128;
 }
 
-static void
-gegl_processor_constructed (GObject *object)
-{
-  GeglProcessor *processor = GEGL_PROCESSOR (object);
-
-  G_OBJECT_CLASS (gegl_processor_parent_class)->constructed (object);
-
-  processor->queued_region = gegl_region_new ();
-}
-
 static void
 gegl_processor_finalize (GObject *self_object)
 {
@@ -170,6 +165,9 @@ gegl_processor_finalize (GObject *self_object)
 
   if (processor->real_node)
     {
+      if (processor->invalidated_handler)
+        g_signal_handler_disconnect (processor->real_node,
+                                     processor->invalidated_handler);
       g_object_unref (processor->real_node);
     }
 
@@ -178,11 +176,6 @@ gegl_processor_finalize (GObject *self_object)
       g_object_unref (processor->input);
     }
 
-  if (processor->queued_region)
-    {
-      gegl_region_destroy (processor->queued_region);
-    }
-
   if (processor->valid_region)
     {
       gegl_region_destroy (processor->valid_region);
@@ -260,8 +253,17 @@ gegl_processor_set_node (GeglProcessor *processor,
   if (processor->node)
     g_object_unref (processor->node);
   if (processor->real_node)
-    g_object_unref (processor->real_node);
+    {
+      if (processor->invalidated_handler)
+        g_signal_handler_disconnect (processor->real_node,
+                                     processor->invalidated_handler);
+      g_object_unref (processor->real_node);
+    }
+  if (processor->valid_region)
+    gegl_region_destroy (processor->valid_region);
 
+  processor->invalidated_handler = 0;
+  processor->valid_region        = NULL;
   processor->node = g_object_ref (node);
 
   /* nodes with meta operations are also graphs and can be sinks, so
@@ -292,6 +294,14 @@ gegl_processor_set_node (GeglProcessor *processor,
       if (!gegl_operation_sink_needs_full (processor->real_node->operation))
         {
           processor->valid_region = gegl_region_new ();
+
+          /* there is no cache keeping track of what became invalid, so
+           * take the damage out of what was rendered ourselves
+           */
+          processor->invalidated_handler =
+            g_signal_connect (processor->real_node, "invalidated",
+                              G_CALLBACK (gegl_processor_invalidated),
+                              processor);
         }
       else
         {
@@ -320,15 +330,13 @@ gegl_processor_set_node (GeglProcessor *processor,
 
 
 /* Sets the processor->rectangle to the given rectangle (or the node
- * bounding box if rectangle is NULL) and removes any
- * dirty_rectangles, then updates node context_id with result rect and
- * need rect
+ * bounding box if rectangle is NULL), then updates node context_id with
+ * result rect and need rect
  */
 void
 gegl_processor_set_rectangle (GeglProcessor       *processor,
                               const GeglRectangle *rectangle)
 {
-  GSList        *iter;
   GeglRectangle  input_bounding_box;
 
   g_return_if_fail (processor->input != NULL);
@@ -344,7 +352,7 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
              rectangle->x, rectangle->y, rectangle->width, rectangle->height);
 
   /* if the processor's rectangle isn't already set to the node's bounding box,
-   * then set it and remove processor->dirty_rectangles (set to NULL)  */
+   * then set it */
   if (! gegl_rectangle_equal (&processor->rectangle, rectangle))
     {
 #if 0
@@ -358,16 +366,8 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       gegl_rectangle_intersect (&processor->rectangle, &processor->rectangle, &bounds);
 #endif
     }
-    {
 
-      /* remove already queued dirty rectangles */
-      for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
-        {
-          g_slice_free (GeglRectangle, iter->data);
-        }
-      g_slist_free (processor->dirty_rectangles);
-      processor->dirty_rectangles = NULL;
-    }
+  processor->rendering = FALSE;
 
   /* if the node's operation is a sink and it needs the full content then
    * a context will be set up together with a cache and
@@ -393,6 +393,7 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
                                               &processor->rectangle);
     }
 
+  /* the sink may write somewhere else now, render everything again */
   if (processor->valid_region)
     {
       gegl_region_destroy (processor->valid_region);
@@ -402,47 +403,167 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
-/* Will generate band_sizes that are adapted to the size of the tiles */
+/* Damage reported for the processed node, in unbuffered rendering, is no
+ * longer valid; it is rendered again by the following calls to
+ * gegl_processor_work ().
+ */
+static void
+gegl_processor_invalidated (GeglNode            *node,
+                            const GeglRectangle *rect,
+                            GeglProcessor       *processor)
+{
+  GeglRectangle damage;
+  gint          scale = 1 << processor->level;
+
+  if (! processor->valid_region || ! rect ||
+      rect->width <= 0 || rect->height <= 0)
+    return;
+
+  /* the valid region is kept in the coordinates of the level rendered */
+  damage.x      = gegl_tile_indice (rect->x, scale);
+  damage.y      = gegl_tile_indice (rect->y, scale);
+  damage.width  = gegl_tile_indice (rect->x + rect->width - 1, scale) -
+                  damage.x + 1;
+  damage.height = gegl_tile_indice (rect->y + rect->height - 1, scale) -
+                  damage.y + 1;
+
+  if (gegl_rectangle_intersect (&damage, &damage, &processor->rectangle))
+    {
+      GeglRegion *region = gegl_region_rectangle (&damage);
+
+      gegl_region_subtract (processor->valid_region, region);
+      gegl_region_destroy (region);
+    }
+}
+
+/* the level of the cache the processor's results are recorded at, the
+ * cache keeps the coarsest levels together like the eval manager does
+ */
 static gint
-gegl_processor_get_band_size (gint size)
+gegl_processor_get_cache_level (GeglProcessor *processor)
+{
+  return MIN (processor->level, GEGL_CACHE_VALID_MIPMAPS - 1);
+}
+
+static GeglRegion *
+gegl_processor_get_valid_region (GeglProcessor *processor)
+{
+  gint level = gegl_processor_get_cache_level (processor);
+
+  if (processor->valid_region)
+    return processor->valid_region;
+
+  return gegl_node_get_cache (processor->input)->valid_region[level];
+}
+
+/* Returns the part of the processor's rectangle that is left to render,
+ * as a new region.  Invalidations since it was last rendered are taken
+ * out of the valid region, by the node's cache or by
+ * gegl_processor_invalidated (), so overlapping damage is only rendered
+ * once and undamaged parts not at all.
+ */
+static GeglRegion *
+gegl_processor_get_dirty_region (GeglProcessor *processor)
 {
-  gint band_size;
+  GeglRegion *dirty = gegl_region_rectangle (&processor->rectangle);
+
+  gegl_region_subtract (dirty, gegl_processor_get_valid_region (processor));
 
-  band_size = size / 2;
+  return dirty;
+}
 
-  /* try to make the rects generated match better with potential 2^n sized
-   * tiles, XXX: should be improved to make the next slice fit as well. */
-  if (band_size <= 128)
+/* Returns a cell size, made of whole tiles, that holds about as many
+ * pixels as are to be rendered at once
+ */
+static void
+gegl_processor_get_cell_size (GeglProcessor *processor,
+                              gint          *cell_width,
+                              gint          *cell_height)
+{
+  const gint64 max_area = (gint64) processor->chunk_size << (2 * processor->level);
+  gint         width    = gegl_config ()->tile_width;
+  gint         height   = gegl_config ()->tile_height;
+
+  while ((gint64) width * height * 2 <= max_area)
     {
-      band_size = MIN(band_size, 64); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      if (width <= height)
+        width *= 2;
+      else
+        height *= 2;
     }
-  else if (band_size <= 256)
+
+  while ((gint64) width * height > max_area && (width > 1 || height > 1))
     {
-      band_size = MIN(band_size, 128); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      if (width >= height)
+        width = (width + 1) / 2;
+      else
+        height = (height + 1) / 2;
     }
-  else if (band_size <= 512)
+
+  *cell_width  = width;
+  *cell_height = height;
+}
+
+/* Picks the next chunk of @dirty to render: the damage within one cell of
+ * a tile aligned grid, starting from the cell closest to the center of
+ * the processor's rectangle, which is the part of a view most likely to
+ * be looked at, and working outwards.
+ */
+static void
+gegl_processor_next_chunk (GeglProcessor *processor,
+                           GeglRegion    *dirty,
+                           GeglRectangle *chunk)
+{
+  GeglRectangle *rectangles;
+  GeglRectangle  cell;
+  GeglRegion    *region;
+  gint           n_rectangles;
+  gint64         center_x;
+  gint64         center_y;
+  gint64         x = 0;
+  gint64         y = 0;
+  gdouble        best_distance = G_MAXDOUBLE;
+  gint           i;
+
+  center_x = processor->rectangle.x + (gint64) processor->rectangle.width / 2;
+  center_y = processor->rectangle.y + (gint64) processor->rectangle.height / 2;
+
+  gegl_region_get_rectangles (dirty, &rectangles, &n_rectangles);
+
+  for (i = 0; i < n_rectangles; i++)
     {
-      band_size = MIN(band_size, 256); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      const GeglRectangle *r  = &rectangles[i];
+      gint64               px = CLAMP (center_x, r->x, (gint64) r->x + r->width - 1);
+      gint64               py = CLAMP (center_y, r->y, (gint64) r->y + r->height - 1);
+      gdouble              dx = px - center_x;
+      gdouble              dy = py - center_y;
+
+      if (dx * dx + dy * dy < best_distance)
+        {
+          best_distance = dx * dx + dy * dy;
+          x = px;
+          y = py;
+        }
     }
 
-  if (band_size < 1)
-    band_size = 1;
+  g_free (rectangles);
+
+  gegl_processor_get_cell_size (processor, &cell.width, &cell.height);
+  cell.x = gegl_tile_indice (x, cell.width) * cell.width;
+  cell.y = gegl_tile_indice (y, cell.height) * cell.height;
 
-  return band_size;
+  region = gegl_region_rectangle (&cell);
+  gegl_region_intersect (region, dirty);
+  gegl_region_get_clipbox (region, chunk);
+  gegl_region_destroy (region);
 }
 
-/* If the processor's dirty rectangle is too big then it will be cut, added
- * to the processor's list of dirty rectangles and TRUE will be returned.
- * If the rectangle is small enough it will be processed, using a buffer or
- * not as appropriate, and will return TRUE if there is more work */
-static gboolean
-render_rectangle (GeglProcessor *processor)
+/* Renders the rectangle @dr, using a buffer or not as appropriate */
+static void
+render_rectangle (GeglProcessor *processor,
+                  GeglRectangle *dr)
 {
   gboolean    buffered;
-  const gint  max_area = processor->chunk_size * (1<<processor->level) * (1<<processor->level);
   GeglCache  *cache    = NULL;
   const Babl *format   = NULL;
   gint        pxsize;
@@ -458,121 +579,77 @@ render_rectangle (GeglProcessor *processor)
       pxsize = babl_format_get_bytes_per_pixel (format);
     }
 
-  if (processor->dirty_rectangles)
+  if (buffered)
     {
-      GeglRectangle *dr = processor->dirty_rectangles->data;
-
-      /* If a dirty rectangle is bigger than the max area, then cut it
-       * to smaller pieces */
-      if (dr->height * dr->width > max_area && 1)
+      gboolean found_full = FALSE;
+      for (gint level = gegl_processor_get_cache_level (processor); level >= 0; level--)
+      {
+        if (gegl_region_rect_in (cache->valid_region[level], dr) == GEGL_OVERLAP_RECTANGLE_IN)
         {
-          gint band_size;
-
-          {
-            GeglRectangle *fragment;
-
-            fragment = g_slice_dup (GeglRectangle, dr);
-
-            /* When splitting a rectangle, we'll do it on the biggest side */
-            if (dr->width > dr->height)
-              {
-                band_size = gegl_processor_get_band_size ( dr->width );
-
-                fragment->width = band_size;
-                dr->width      -= band_size;
-                dr->x          += band_size;
-              }
-            else
-              {
-                band_size = gegl_processor_get_band_size (dr->height);
-
-                fragment->height = band_size;
-                dr->height      -= band_size;
-                dr->y           += band_size;
-              }
-            processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
-          }
-          return TRUE;
+          found_full = TRUE;
+          break;
         }
-      /* remove the rectangle that will be processed from the list of dirty ones */
-      processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
+      }
 
-      if (!dr->width || !dr->height)
+      if (!found_full)
         {
-          g_slice_free (GeglRectangle, dr);
-
-          return TRUE;
-        }
+          /* create a buffer and initialise it */
+          guchar *buf;
 
-      if (buffered)
-        {
-          gboolean found_full = FALSE;
-          for (gint level = processor->level; level >= 0; level--)
-          {
-            if (gegl_region_rect_in (cache->valid_region[level], dr) == GEGL_OVERLAP_RECTANGLE_IN)
-            {
-              found_full = TRUE;
-              break;
-            }
-            /* XXX: dr should be adjusted to be the bounding box of not-found
-             * in cache if there is partial hits
-             */
-          }
+          buf = g_malloc (dr->width * dr->height * pxsize);
+          g_assert (buf);
 
-          if (!found_full)
-            {
-              /* create a buffer and initialise it */
-              guchar *buf;
+          /* FIXME: Check if the node caches naturaly, if so the buffer_set call isn't needed */
 
-              buf = g_malloc (dr->width * dr->height * pxsize);
-              g_assert (buf);
+          /* do the image calculations using the buffer */
+          gegl_node_blit (processor->input, 1.0/(1<<processor->level),
+                          dr, format, buf,
+                          GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
 
-              /* FIXME: Check if the node caches naturaly, if so the buffer_set call isn't needed */
+          /* copy the buffer data into the cache */
+          gegl_buffer_set (GEGL_BUFFER (cache), dr, processor->level, format, buf, GEGL_AUTO_ROWSTRIDE);
 
-              /* do the image calculations using the buffer */
-              gegl_node_blit (processor->input, 1.0/(1<<processor->level),
-                              dr, format, buf,
-                              GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+          /* release the buffer */
+          g_free (buf);
 
-              /* copy the buffer data into the cache */
-              gegl_buffer_set (GEGL_BUFFER (cache), dr, processor->level, format, buf, GEGL_AUTO_ROWSTRIDE);
-
-              /* tells the cache that the rectangle (dr) has been computed */
-              gegl_cache_computed (cache, dr, processor->level);
-
-              /* release the buffer */
-              g_free (buf);
-            }
-          g_slice_free (GeglRectangle, dr);
-        }
-      else
-        {
-           gegl_node_blit (processor->real_node, 1.0/(1<<processor->level),
-                           dr, NULL, NULL,
-                           GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
-           gegl_region_union_with_rect (processor->valid_region, dr);
-           g_slice_free (GeglRectangle, dr);
+          g_mutex_lock (&stats_mutex);
+          pixels_rendered += (guint64) dr->width * dr->height;
+          g_mutex_unlock (&stats_mutex);
         }
+
+      /* tells the cache that the rectangle (dr) has been computed, a
+       * finer level having it is as good, the mipmap is built from it
+       */
+      gegl_cache_computed (cache, dr, gegl_processor_get_cache_level (processor));
     }
+  else
+    {
+       gegl_node_blit (processor->real_node, 1.0/(1<<processor->level),
+                       dr, NULL, NULL,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+       gegl_region_union_with_rect (processor->valid_region, dr);
 
-  return processor->dirty_rectangles != NULL;
+       g_mutex_lock (&stats_mutex);
+       pixels_rendered += (guint64) dr->width * dr->height;
+       g_mutex_unlock (&stats_mutex);
+    }
 }
 
 
-static gint
+static gint64
 rect_area (GeglRectangle *rectangle)
 {
-  return rectangle->width * rectangle->height;
+  return (gint64) rectangle->width * rectangle->height;
 }
 
 /* returns the total area covered by a region */
-static gint
+static gint64
 region_area (GeglRegion *region)
 {
   GeglRectangle *rectangles;
   gint           n_rectangles;
   gint           i;
-  gint           sum = 0;
+  gint64         sum = 0;
 
   gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
 
@@ -585,190 +662,87 @@ region_area (GeglRegion *region)
   return sum;
 }
 
-/* returns the area not covered by the rectangle */
-static gint
-area_left (GeglRegion    *area,
-           GeglRectangle *rectangle)
-{
-  GeglRegion *region;
-  gint        sum = 0;
-
-  region = gegl_region_rectangle (rectangle);
-  gegl_region_subtract (region, area);
-  sum += region_area (region);
-  gegl_region_destroy (region);
-  return sum;
-}
-
-/* returns true if everything is rendered */
-static gboolean
-gegl_processor_is_rendered (GeglProcessor *processor)
-{
-  if (gegl_region_empty (processor->queued_region) &&
-      processor->dirty_rectangles == NULL)
-    return TRUE;
-  return FALSE;
-}
-
 static gdouble
 gegl_processor_progress (GeglProcessor *processor)
 {
-  GeglRegion *valid_region;
-  gint        valid;
-  gint        wanted;
-  gdouble     ret;
+  GeglRegion *dirty;
+  gint64      left;
+  gint64      wanted;
 
   g_return_val_if_fail (processor->input != NULL, 1);
 
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
-
+  dirty  = gegl_processor_get_dirty_region (processor);
+  left   = region_area (dirty);
   wanted = rect_area (&(processor->rectangle));
-  valid  = wanted - area_left (valid_region, &(processor->rectangle));
-  if (wanted == 0)
-    {
-      if (gegl_processor_is_rendered (processor))
-        return 1.0;
-      return 0.999;
-    }
+  gegl_region_destroy (dirty);
 
-  ret = (double) valid / wanted;
-  if (ret>=1.0)
-    {
-      if (!gegl_processor_is_rendered (processor))
-        {
-          return 0.9999;
-        }
-    }
+  if (left == 0)
+    return 1.0;
 
-  return ret;
+  return 1.0 - (gdouble) left / wanted;
 }
 
-/* Processes the rectangle (might be only splitting it to smaller ones) and
- * updates the progress indicator */
+/* Renders the next chunk of what is left of the processor's rectangle and
+ * updates the progress indicator, returns TRUE if there is more to render
+ */
 static gboolean
 gegl_processor_render (GeglProcessor *processor,
-                       GeglRectangle *rectangle,
                        gdouble       *progress)
 {
-  GeglRegion *valid_region;
+  GeglRegion    *dirty;
+  GeglRegion    *region;
+  GeglRectangle  chunk;
+  gboolean       more_work;
 
-  if (processor->valid_region)
-    {
-      valid_region = processor->valid_region;
-    }
-  else
-    {
-      g_return_val_if_fail (processor->input != NULL, FALSE);
-      valid_region = gegl_node_get_cache (processor->input)->valid_region[processor->level];
-    }
-
-  {
-    gboolean more_work = render_rectangle (processor);
-
-    if (more_work == TRUE)
-      {
-        if (progress)
-          {
-            gint valid;
-            gint wanted;
-            if (rectangle)
-              {
-                wanted = rect_area (rectangle);
-                valid  = wanted - area_left (valid_region, rectangle);
-              }
-            else
-              {
-                valid  = region_area (valid_region);
-                wanted = region_area (processor->queued_region);
-              }
-            if (wanted == 0)
-              {
-                *progress = 1.0;
-              }
-            else
-              {
-                *progress = (double) valid / wanted;
-              }
-          }
-
-        return more_work;
-      }
-  }
-
-  if (rectangle)
-    { /* we're asked to work on a specific rectangle thus we only focus
-         on it */
-      GeglRegion    *region = gegl_region_rectangle (rectangle);
-      GeglRectangle *rectangles;
-      gint           n_rectangles;
-      gint           i;
-
-      gegl_region_subtract (region, valid_region);
-      gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
-      gegl_region_destroy (region);
-
-      for (i = 0; i < n_rectangles && i < 1; i++)
-        {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
-          gegl_region_subtract (processor->queued_region, tr);
-          gegl_region_destroy (tr);
+  g_return_val_if_fail (processor->input != NULL, FALSE);
 
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
-        }
+  dirty = gegl_processor_get_dirty_region (processor);
 
-      g_free (rectangles);
+  if (gegl_region_empty (dirty))
+    {
+      gegl_region_destroy (dirty);
+      processor->rendering = FALSE;
 
-      if (n_rectangles != 0)
-        {
-          if (progress)
-            *progress = 1.0 - ((double) area_left (valid_region, rectangle) /
-                               rect_area (rectangle));
-          return TRUE;
-        }
+      if (progress)
+        *progress = 1.0;
 
       return FALSE;
     }
-  else if (!gegl_region_empty (processor->queued_region) &&
-           !processor->dirty_rectangles)
-    { /* XXX: this branch of the else can probably be removed if gegl-processors
-         should only work with rectangular queued regions
-       */
-      GeglRectangle *rectangles;
-      gint           n_rectangles;
-      gint           i;
 
-      gegl_region_get_rectangles (processor->queued_region, &rectangles,
-                                  &n_rectangles);
+  /* a pass over the rectangle starts, either for a new rectangle or for
+   * damage done to a rendered one
+   */
+  if (! processor->rendering)
+    {
+      processor->rendering = TRUE;
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
-        {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
-          gegl_region_subtract (processor->queued_region, tr);
-          gegl_region_destroy (tr);
+      g_mutex_lock (&stats_mutex);
+      pixels_requested += rect_area (&processor->rectangle);
+      g_mutex_unlock (&stats_mutex);
+    }
 
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
-        }
+  gegl_processor_next_chunk (processor, dirty, &chunk);
+  render_rectangle (processor, &chunk);
 
-      g_free (rectangles);
-    }
+  region = gegl_region_rectangle (&chunk);
+  gegl_region_subtract (dirty, region);
+  gegl_region_destroy (region);
+
+  more_work = ! gegl_region_empty (dirty);
 
   if (progress)
     {
-      *progress = 0.69;
+      gint64 wanted = rect_area (&processor->rectangle);
+
+      *progress = wanted ? 1.0 - (gdouble) region_area (dirty) / wanted : 1.0;
     }
 
-  return !gegl_processor_is_rendered (processor);
+  gegl_region_destroy (dirty);
+
+  if (! more_work)
+    processor->rendering = FALSE;
+
+  return more_work;
 }
 
 /* Will call gegl_processor_render and when there is no more work to be done,
@@ -805,7 +779,7 @@ gegl_processor_work (GeglProcessor *processor,
         }
     }
 
-  more_work = gegl_processor_render (processor, &processor->rectangle, progress);
+  more_work = gegl_processor_render (processor, progress);
   if (more_work)
     {
       return TRUE;
@@ -854,3 +828,36 @@ void gegl_processor_set_scale (GeglProcessor *processor,
 {
   processor->level = gegl_level_from_scale (scale);
 }
+
+guint64
+gegl_processor_get_pixels_requested (void)
+{
+  guint64 count;
+
+  g_mutex_lock (&stats_mutex);
+  count = pixels_requested;
+  g_mutex_unlock (&stats_mutex);
+
+  return count;
+}
+
+guint64
+gegl_processor_get_pixels_rendered (void)
+{
+  guint64 count;
+
+  g_mutex_lock (&stats_mutex);
+  count = pixels_rendered;
+  g_mutex_unlock (&stats_mutex);
+
+  return count;
+}
+
+void
+gegl_processor_reset_stats (void)
+{
+  g_mutex_lock (&stats_mutex);
+  pixels_requested = 0;
+  pixels_rendered  = 0;
+  g_mutex_unlock (&stats_mutex);
+}
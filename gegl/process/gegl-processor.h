@@ -29,6 +29,10 @@ G_BEGIN_DECLS
  * non GUI tasks using #gegl_node_blit and #gegl_node_process directly
  * should be sufficient. See #gegl_processor_work for a code sample.
  *
+ * A processor keeps track of what it rendered; when the graph changes,
+ * only the invalidated parts of its rectangle are rendered again, those
+ * closest to the center of the rectangle first.
+ *
  */
 
 /**
@@ -0,0 +1,500 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-render-queue.h"
+
+enum
+{
+  PROGRESS,
+  DONE,
+  LAST_SIGNAL
+};
+
+typedef struct
+{
+  gint           ref_count;
+  guint          id;
+  gint           priority;
+  GeglNode      *node;
+  GeglRectangle  rectangle;
+  gdouble        scale;
+  GCancellable  *cancellable;
+  gboolean       cancelled;        /* by gegl_render_queue_cancel () */
+  gboolean       done;             /* "done" has been scheduled */
+  GeglProcessor *processor;        /* created when rendering starts */
+  gdouble        progress;
+  gboolean       progress_pending; /* a "progress" emission is scheduled */
+} GeglRenderRequest;
+
+typedef struct
+{
+  GeglRenderQueue   *queue;
+  GeglRenderRequest *request;
+  gboolean           completed;
+} GeglRenderNotify;
+
+struct _GeglRenderQueue
+{
+  GObject            parent_instance;
+
+  GMainContext      *context;   /* where signals are emitted */
+  GThread           *thread;
+
+  GMutex             mutex;     /* protects everything below */
+  GCond              cond;
+  GQueue             requests;  /* pending, sorted by priority and id */
+  GeglRenderRequest *current;   /* being rendered a chunk of */
+  guint              next_id;
+  gint               frozen;
+  gboolean           stopping;
+};
+
+typedef struct
+{
+  GObjectClass parent_class;
+} GeglRenderQueueClass;
+
+static void     gegl_render_queue_dispose  (GObject *object);
+static void     gegl_render_queue_finalize (GObject *object);
+static gpointer gegl_render_queue_thread   (gpointer data);
+
+G_DEFINE_TYPE (GeglRenderQueue, gegl_render_queue, G_TYPE_OBJECT)
+
+static guint gegl_render_queue_signals[LAST_SIGNAL] = { 0 };
+
+
+static void
+gegl_render_queue_class_init (GeglRenderQueueClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->dispose  = gegl_render_queue_dispose;
+  gobject_class->finalize = gegl_render_queue_finalize;
+
+  gegl_render_queue_signals[PROGRESS] =
+    g_signal_new ("progress",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_UINT, G_TYPE_DOUBLE);
+
+  gegl_render_queue_signals[DONE] =
+    g_signal_new ("done",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  NULL,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_UINT, G_TYPE_BOOLEAN);
+}
+
+static void
+gegl_render_queue_init (GeglRenderQueue *queue)
+{
+  g_mutex_init (&queue->mutex);
+  g_cond_init (&queue->cond);
+  g_queue_init (&queue->requests);
+
+  queue->context = g_main_context_ref_thread_default ();
+  queue->next_id = 1;
+}
+
+static GeglRenderRequest *
+gegl_render_request_ref (GeglRenderRequest *request)
+{
+  g_atomic_int_inc (&request->ref_count);
+
+  return request;
+}
+
+static void
+gegl_render_request_unref (GeglRenderRequest *request)
+{
+  if (! g_atomic_int_dec_and_test (&request->ref_count))
+    return;
+
+  if (request->processor)
+    g_object_unref (request->processor);
+  if (request->cancellable)
+    g_object_unref (request->cancellable);
+  g_object_unref (request->node);
+
+  g_slice_free (GeglRenderRequest, request);
+}
+
+static gint
+gegl_render_request_compare (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  const GeglRenderRequest *request_a = a;
+  const GeglRenderRequest *request_b = b;
+
+  if (request_a->priority != request_b->priority)
+    return request_a->priority < request_b->priority ? -1 : 1;
+
+  return request_a->id < request_b->id ? -1 : (request_a->id > request_b->id);
+}
+
+/* must be called with the mutex held */
+static gboolean
+gegl_render_request_is_cancelled (GeglRenderRequest *request)
+{
+  return request->cancelled ||
+         (request->cancellable &&
+          g_cancellable_is_cancelled (request->cancellable));
+}
+
+static gboolean
+gegl_render_queue_emit_progress (gpointer data)
+{
+  GeglRenderNotify  *notify  = data;
+  GeglRenderRequest *request = notify->request;
+  gdouble            progress;
+  gboolean           done;
+
+  g_mutex_lock (&notify->queue->mutex);
+  progress                  = request->progress;
+  done                      = request->done;
+  request->progress_pending = FALSE;
+  g_mutex_unlock (&notify->queue->mutex);
+
+  /* "done" follows, which is all there is left to tell */
+  if (! done)
+    g_signal_emit (notify->queue, gegl_render_queue_signals[PROGRESS], 0,
+                   request->id, progress);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gegl_render_queue_emit_done (gpointer data)
+{
+  GeglRenderNotify *notify = data;
+
+  g_signal_emit (notify->queue, gegl_render_queue_signals[DONE], 0,
+                 notify->request->id, notify->completed);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gegl_render_notify_free (gpointer data)
+{
+  GeglRenderNotify *notify = data;
+
+  gegl_render_request_unref (notify->request);
+  g_object_unref (notify->queue);
+
+  g_slice_free (GeglRenderNotify, notify);
+}
+
+/* must be called with the mutex held */
+static void
+gegl_render_queue_schedule (GeglRenderQueue   *queue,
+                            GeglRenderRequest *request,
+                            GSourceFunc        func,
+                            gboolean           completed)
+{
+  GeglRenderNotify *notify = g_slice_new (GeglRenderNotify);
+  GSource          *source;
+
+  notify->queue     = g_object_ref (queue);
+  notify->request   = gegl_render_request_ref (request);
+  notify->completed = completed;
+
+  /* an idle source rather than g_main_context_invoke (), which would run
+   * the callback right here when nobody owns the context
+   */
+  source = g_idle_source_new ();
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, func, notify, gegl_render_notify_free);
+  g_source_attach (source, queue->context);
+  g_source_unref (source);
+}
+
+/* must be called with the mutex held, drops the queue's reference */
+static void
+gegl_render_queue_finish (GeglRenderQueue   *queue,
+                          GeglRenderRequest *request,
+                          gboolean           completed)
+{
+  request->done = TRUE;
+
+  gegl_render_queue_schedule (queue, request,
+                              gegl_render_queue_emit_done, completed);
+  gegl_render_request_unref (request);
+}
+
+static gpointer
+gegl_render_queue_thread (gpointer data)
+{
+  GeglRenderQueue *queue = data;
+
+  g_mutex_lock (&queue->mutex);
+
+  while (! queue->stopping)
+    {
+      GeglRenderRequest *request;
+      gboolean           more_work;
+      gdouble            progress = 0.0;
+
+      if (queue->frozen || g_queue_is_empty (&queue->requests))
+        {
+          g_cond_wait (&queue->cond, &queue->mutex);
+          continue;
+        }
+
+      request = g_queue_pop_head (&queue->requests);
+
+      if (gegl_render_request_is_cancelled (request))
+        {
+          gegl_render_queue_finish (queue, request, FALSE);
+          continue;
+        }
+
+      queue->current = request;
+      g_mutex_unlock (&queue->mutex);
+
+      if (! request->processor)
+        {
+          request->processor = gegl_node_new_processor (request->node,
+                                                        &request->rectangle);
+          gegl_processor_set_scale (request->processor, request->scale);
+        }
+
+      more_work = gegl_processor_work (request->processor, &progress);
+
+      g_mutex_lock (&queue->mutex);
+      queue->current = NULL;
+      g_cond_broadcast (&queue->cond);
+
+      if (gegl_render_request_is_cancelled (request))
+        {
+          gegl_render_queue_finish (queue, request, FALSE);
+        }
+      else if (more_work)
+        {
+          request->progress = progress;
+
+          if (! request->progress_pending)
+            {
+              request->progress_pending = TRUE;
+              gegl_render_queue_schedule (queue, request,
+                                          gegl_render_queue_emit_progress,
+                                          FALSE);
+            }
+
+          /* back in line, behind whatever became more urgent meanwhile */
+          g_queue_insert_sorted (&queue->requests, request,
+                                 gegl_render_request_compare, NULL);
+        }
+      else
+        {
+          gegl_render_queue_finish (queue, request, TRUE);
+        }
+    }
+
+  g_mutex_unlock (&queue->mutex);
+
+  return NULL;
+}
+
+static void
+gegl_render_queue_dispose (GObject *object)
+{
+  GeglRenderQueue   *queue = GEGL_RENDER_QUEUE (object);
+  GeglRenderRequest *request;
+
+  if (queue->thread)
+    {
+      g_mutex_lock (&queue->mutex);
+      queue->stopping = TRUE;
+      g_cond_broadcast (&queue->cond);
+      g_mutex_unlock (&queue->mutex);
+
+      g_thread_join (queue->thread);
+      queue->thread = NULL;
+    }
+
+  /* nobody is left to tell about these */
+  while ((request = g_queue_pop_head (&queue->requests)))
+    gegl_render_request_unref (request);
+
+  G_OBJECT_CLASS (gegl_render_queue_parent_class)->dispose (object);
+}
+
+static void
+gegl_render_queue_finalize (GObject *object)
+{
+  GeglRenderQueue *queue = GEGL_RENDER_QUEUE (object);
+
+  g_main_context_unref (queue->context);
+  g_cond_clear (&queue->cond);
+  g_mutex_clear (&queue->mutex);
+
+  G_OBJECT_CLASS (gegl_render_queue_parent_class)->finalize (object);
+}
+
+GeglRenderQueue *
+gegl_render_queue_new (void)
+{
+  return g_object_new (GEGL_TYPE_RENDER_QUEUE, NULL);
+}
+
+guint
+gegl_render_queue_submit (GeglRenderQueue     *queue,
+                          GeglNode            *node,
+                          const GeglRectangle *rectangle,
+                          gdouble              scale,
+                          gint                 priority,
+                          GCancellable        *cancellable)
+{
+  GeglRenderRequest *request;
+  guint              id;
+
+  g_return_val_if_fail (GEGL_IS_RENDER_QUEUE (queue), 0);
+  g_return_val_if_fail (GEGL_IS_NODE (node), 0);
+  g_return_val_if_fail (rectangle != NULL, 0);
+  g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), 0);
+
+  request = g_slice_new0 (GeglRenderRequest);
+  request->ref_count   = 1;
+  request->priority    = priority;
+  request->node        = g_object_ref (node);
+  request->rectangle   = *rectangle;
+  request->scale       = scale;
+  request->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+
+  g_mutex_lock (&queue->mutex);
+
+  id = request->id = queue->next_id++;
+
+  g_queue_insert_sorted (&queue->requests, request,
+                         gegl_render_request_compare, NULL);
+
+  if (! queue->thread)
+    queue->thread = g_thread_new ("gegl-render-queue",
+                                  gegl_render_queue_thread, queue);
+
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->mutex);
+
+  return id;
+}
+
+/* must be called with the mutex held */
+static void
+gegl_render_queue_cancel_request (GeglRenderQueue   *queue,
+                                  GeglRenderRequest *request)
+{
+  request->cancelled = TRUE;
+
+  /* the one being rendered is finished by the thread, after its chunk */
+  if (request != queue->current)
+    {
+      g_queue_remove (&queue->requests, request);
+      gegl_render_queue_finish (queue, request, FALSE);
+    }
+}
+
+void
+gegl_render_queue_cancel (GeglRenderQueue *queue,
+                          guint            id)
+{
+  GList *iter;
+
+  g_return_if_fail (GEGL_IS_RENDER_QUEUE (queue));
+
+  g_mutex_lock (&queue->mutex);
+
+  if (queue->current && queue->current->id == id)
+    {
+      gegl_render_queue_cancel_request (queue, queue->current);
+    }
+  else
+    {
+      for (iter = queue->requests.head; iter; iter = iter->next)
+        {
+          GeglRenderRequest *request = iter->data;
+
+          if (request->id == id)
+            {
+              gegl_render_queue_cancel_request (queue, request);
+              break;
+            }
+        }
+    }
+
+  g_mutex_unlock (&queue->mutex);
+}
+
+void
+gegl_render_queue_cancel_all (GeglRenderQueue *queue)
+{
+  GeglRenderRequest *request;
+
+  g_return_if_fail (GEGL_IS_RENDER_QUEUE (queue));
+
+  g_mutex_lock (&queue->mutex);
+
+  if (queue->current)
+    queue->current->cancelled = TRUE;
+
+  while ((request = g_queue_peek_head (&queue->requests)))
+    gegl_render_queue_cancel_request (queue, request);
+
+  g_mutex_unlock (&queue->mutex);
+}
+
+void
+gegl_render_queue_freeze (GeglRenderQueue *queue)
+{
+  g_return_if_fail (GEGL_IS_RENDER_QUEUE (queue));
+
+  g_mutex_lock (&queue->mutex);
+
+  queue->frozen++;
+
+  while (queue->current)
+    g_cond_wait (&queue->cond, &queue->mutex);
+
+  g_mutex_unlock (&queue->mutex);
+}
+
+void
+gegl_render_queue_thaw (GeglRenderQueue *queue)
+{
+  g_return_if_fail (GEGL_IS_RENDER_QUEUE (queue));
+
+  g_mutex_lock (&queue->mutex);
+
+  if (queue->frozen > 0 && --queue->frozen == 0)
+    g_cond_broadcast (&queue->cond);
+
+  g_mutex_unlock (&queue->mutex);
+}
@@ -0,0 +1,121 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_RENDER_QUEUE_H__
+#define __GEGL_RENDER_QUEUE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/***
+ * GeglRenderQueue:
+ *
+ * A #GeglRenderQueue renders regions of nodes in the background, the way
+ * a #GeglProcessor does when pumped with #gegl_processor_work, without
+ * blocking the caller. Requests are rendered one chunk at a time on a
+ * thread of the queue's own, the operations spreading each chunk over
+ * the shared worker threads; after every chunk the most urgent request
+ * is picked again, so a request submitted with a higher priority, like
+ * the part of a view at its center, does not wait for larger ones to
+ * finish.
+ *
+ * Requests can be cancelled by id or with a #GCancellable, for instance
+ * when the view is panned and what they render will no longer be seen.
+ * The "progress" and "done" signals are emitted in the thread default
+ * main context of the thread that created the queue.
+ *
+ * Rendering happens concurrently with the caller; the graph must not be
+ * changed, or rendered otherwise, between #gegl_render_queue_freeze and
+ * #gegl_render_queue_thaw. Results are read from the node's cache, with
+ * #gegl_node_blit and GEGL_BLIT_CACHE | GEGL_BLIT_DIRTY, which does not
+ * render.
+ */
+
+/**
+ * gegl_render_queue_new:
+ *
+ * Return value: (transfer full): a new #GeglRenderQueue.
+ */
+GeglRenderQueue *gegl_render_queue_new        (void);
+
+/**
+ * gegl_render_queue_submit:
+ * @queue: a #GeglRenderQueue
+ * @node: the #GeglNode to render
+ * @rectangle: the #GeglRectangle to render, in the coordinates of @scale
+ * @scale: the scale to render at, rounded to a mipmap level like
+ * #gegl_processor_set_scale does
+ * @priority: the priority of the request, lower values are more urgent,
+ * G_PRIORITY_DEFAULT is a good default
+ * @cancellable: (allow-none): a #GCancellable to cancel the request with,
+ * or NULL
+ *
+ * Queues rendering @rectangle of @node into its cache, or processing it
+ * when @node is a sink. Requests of equal priority are served in the
+ * order they were submitted.
+ *
+ * Return value: the id of the request, passed to the "progress" and
+ * "done" signals.
+ */
+guint            gegl_render_queue_submit     (GeglRenderQueue     *queue,
+                                               GeglNode            *node,
+                                               const GeglRectangle *rectangle,
+                                               gdouble              scale,
+                                               gint                 priority,
+                                               GCancellable        *cancellable);
+
+/**
+ * gegl_render_queue_cancel:
+ * @queue: a #GeglRenderQueue
+ * @id: the id of a request
+ *
+ * Cancels the request @id; if it is being rendered, this happens once the
+ * chunk at hand is done. The "done" signal is emitted for it with
+ * completed set to FALSE.
+ */
+void             gegl_render_queue_cancel     (GeglRenderQueue     *queue,
+                                               guint                id);
+
+/**
+ * gegl_render_queue_cancel_all:
+ * @queue: a #GeglRenderQueue
+ *
+ * Cancels all requests of @queue.
+ */
+void             gegl_render_queue_cancel_all (GeglRenderQueue     *queue);
+
+/**
+ * gegl_render_queue_freeze:
+ * @queue: a #GeglRenderQueue
+ *
+ * Waits for the chunk being rendered to be done, and keeps @queue from
+ * rendering until #gegl_render_queue_thaw is called, so that the graph
+ * can be changed. Calls nest.
+ */
+void             gegl_render_queue_freeze     (GeglRenderQueue     *queue);
+
+/**
+ * gegl_render_queue_thaw:
+ * @queue: a #GeglRenderQueue
+ *
+ * Undoes a call to #gegl_render_queue_freeze.
+ */
+void             gegl_render_queue_thaw       (GeglRenderQueue     *queue);
+
+G_END_DECLS
+
+#endif /* __GEGL_RENDER_QUEUE_H__ */
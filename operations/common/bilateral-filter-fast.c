@@ -22,6 +22,10 @@
   *  A Fast Approximation of the Bilateral Filter using a Signal Processing Approach
   *  Sylvain Paris and Frédo Durand
   *  European Conference on Computer Vision (ECCV'06)
+  *
+  * The CPU path filters on the permutohedral lattice shared with
+  * gegl:bilateral-filter, with the colors as one range dimension rather
+  * than each channel on its own grid.
   */
 
 #include "config.h"
@@ -45,11 +49,10 @@ property_int (s_sigma, _("Blur radius"), 8)
 
 #include "gegl-op.h"
 #include <math.h>
+#include "bilateral-lattice.h"
 
-inline static float lerp(float a, float b, float v)
-{
-  return (1.0f - v) * a + v * b;
-}
+/* the pixels further than this many s_sigma away hardly contribute */
+#define SPATIAL_EXTENT 3
 
 static void
 bilateral_filter (GeglBuffer          *src,
@@ -80,17 +83,41 @@ bilateral_get_required_for_output (GeglOperation       *operation,
                                   const gchar         *input_pad,
                                   const GeglRectangle *roi)
 {
-  GeglRectangle result = *gegl_operation_source_get_bounding_box (operation,
-                                                                  "input");
+  GeglProperties *o       = GEGL_PROPERTIES (operation);
+  GeglRectangle  *in_rect = gegl_operation_source_get_bounding_box (operation,
+                                                                    "input");
+  gint            extent  = SPATIAL_EXTENT * o->s_sigma;
+  GeglRectangle   result;
+
+  result.x      = roi->x - extent;
+  result.y      = roi->y - extent;
+  result.width  = roi->width + 2 * extent;
+  result.height = roi->height + 2 * extent;
+
+  /* the pixels beyond the edges are left out rather than filtered in as
+   * transparent
+   */
+  if (in_rect)
+    gegl_rectangle_intersect (&result, &result, in_rect);
+
   return result;
 }
 
-
 static GeglRectangle
-bilateral_get_cached_region (GeglOperation       *operation,
-                            const GeglRectangle *roi)
+bilateral_get_invalidated_by_change (GeglOperation       *operation,
+                                     const gchar         *input_pad,
+                                     const GeglRectangle *input_roi)
 {
-  return *gegl_operation_source_get_bounding_box (operation, "input");
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  gint            extent = SPATIAL_EXTENT * o->s_sigma;
+  GeglRectangle   result;
+
+  result.x      = input_roi->x - extent;
+  result.y      = input_roi->y - extent;
+  result.width  = input_roi->width + 2 * extent;
+  result.height = input_roi->height + 2 * extent;
+
+  return result;
 }
 
 static gboolean
@@ -101,6 +128,7 @@ bilateral_process (GeglOperation       *operation,
                    gint                 level)
 {
   GeglProperties   *o = GEGL_PROPERTIES (operation);
+  GeglRectangle     compute;
 
 #if 0
   if (gegl_operation_use_opencl (operation))
@@ -108,7 +136,10 @@ bilateral_process (GeglOperation       *operation,
       return TRUE;
 #endif
 
-  bilateral_filter (input, result, output, result, o->s_sigma, o->r_sigma/100);
+  compute = gegl_operation_get_required_for_output (operation, "input", result);
+  gegl_rectangle_bounding_box (&compute, &compute, result);
+
+  bilateral_filter (input, &compute, output, result, o->s_sigma, o->r_sigma/100);
 
   return  TRUE;
 }
@@ -121,153 +152,23 @@ bilateral_filter (GeglBuffer          *src,
                   gint                 s_sigma,
                   gfloat               r_sigma)
 {
-  gint c, x, y, z, k, i;
+  gfloat *src_buf;
+  gfloat *dst_buf;
 
-  const gint padding_xy = 2;
-  const gint padding_z  = 2;
-
-  const gint width    = src_rect->width;
-  const gint height   = src_rect->height;
-  const gint channels = 4;
+  src_buf = g_new (gfloat, src_rect->width * src_rect->height * 4);
+  dst_buf = g_new (gfloat, dst_rect->width * dst_rect->height * 4);
 
-  const gint sw = (width -1) / s_sigma + 1 + (2 * padding_xy);
-  const gint sh = (height-1) / s_sigma + 1 + (2 * padding_xy);
-  const gint depth = (int)(1.0f / r_sigma) + 1 + (2 * padding_z);
-
-  /* down-sampling */
-
-  gfloat *grid     = g_new0 (gfloat, sw * sh * depth * channels * 2);
-  gfloat *blurx    = g_new0 (gfloat, sw * sh * depth * channels * 2);
-  gfloat *blury    = g_new0 (gfloat, sw * sh * depth * channels * 2);
-  gfloat *blurz    = g_new0 (gfloat, sw * sh * depth * channels * 2);
-
-  gfloat *input    = g_new0 (gfloat, width * height * channels);
-  gfloat *smoothed = g_new0 (gfloat, width * height * channels);
-
-  #define INPUT(x,y,c) input[c+channels*(x + width * y)]
-
-  #define  GRID(x,y,z,c,i) grid [i+2*(c+channels*(x+sw*(y+z*sh)))]
-  #define BLURX(x,y,z,c,i) blurx[i+2*(c+channels*(x+sw*(y+z*sh)))]
-  #define BLURY(x,y,z,c,i) blury[i+2*(c+channels*(x+sw*(y+z*sh)))]
-  #define BLURZ(x,y,z,c,i) blurz[i+2*(c+channels*(x+sw*(y+z*sh)))]
-
-  gegl_buffer_get (src, src_rect, 1.0, babl_format ("RGBA float"), input, GEGL_AUTO_ROWSTRIDE,
+  gegl_buffer_get (src, src_rect, 1.0, babl_format ("RGBA float"), src_buf, GEGL_AUTO_ROWSTRIDE,
                    GEGL_ABYSS_NONE);
 
-  for (k=0; k < (sw * sh * depth * channels * 2); k++)
-    {
-      grid [k] = 0.0f;
-      blurx[k] = 0.0f;
-      blury[k] = 0.0f;
-      blurz[k] = 0.0f;
-    }
-
-#if 0
-  /* in case we want to normalize the color space */
-
-  gfloat input_min[4] = { FLT_MAX,  FLT_MAX,  FLT_MAX};
-  gfloat input_max[4] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+  bilateral_lattice_filter (src_buf, src_rect, dst_buf, dst_rect,
+                            1.0f / s_sigma, 1.0f / r_sigma);
 
-  for(y = 0; y < height; y++)
-    for(x = 0; x < width; x++)
-      for(c = 0; c < channels; c++)
-        {
-          input_min[c] = MIN(input_min[c], INPUT(x,y,c));
-          input_max[c] = MAX(input_max[c], INPUT(x,y,c));
-        }
-#endif
-
-  /* downsampling */
-
-  for(y = 0; y < height; y++)
-    for(x = 0; x < width; x++)
-      for(c = 0; c < channels; c++)
-        {
-          const float z = INPUT(x,y,c); // - input_min[c];
-
-          const int small_x = (int)((float)(x) / s_sigma + 0.5f) + padding_xy;
-          const int small_y = (int)((float)(y) / s_sigma + 0.5f) + padding_xy;
-          const int small_z = (int)((float)(z) / r_sigma + 0.5f) + padding_z;
-
-          g_assert(small_x >= 0 && small_x < sw);
-          g_assert(small_y >= 0 && small_y < sh);
-          g_assert(small_z >= 0 && small_z < depth);
-
-          GRID(small_x, small_y, small_z, c, 0) += INPUT(x, y, c);
-          GRID(small_x, small_y, small_z, c, 1) += 1.0f;
-        }
-
-  /* blur in x, y and z */
-  /* XXX: we could use less memory, but at expense of code readability */
-
-  for (z = 1; z < depth-1; z++)
-    for (y = 1; y < sh-1; y++)
-      for (x = 1; x < sw-1; x++)
-        for(c = 0; c < channels; c++)
-          for (i=0; i<2; i++)
-            BLURX(x, y, z, c, i) = (GRID (x-1, y, z, c, i) + 2.0f * GRID (x, y, z, c, i) + GRID (x+1, y, z, c, i)) / 4.0f;
-
-  for (z = 1; z < depth-1; z++)
-    for (y = 1; y < sh-1; y++)
-      for (x = 1; x < sw-1; x++)
-        for(c = 0; c < channels; c++)
-          for (i=0; i<2; i++)
-            BLURY(x, y, z, c, i) = (BLURX (x, y-1, z, c, i) + 2.0f * BLURX (x, y, z, c, i) + BLURX (x, y+1, z, c, i)) / 4.0f;
-
-  for (z = 1; z < depth-1; z++)
-    for (y = 1; y < sh-1; y++)
-      for (x = 1; x < sw-1; x++)
-        for(c = 0; c < channels; c++)
-          for (i=0; i<2; i++)
-            BLURZ(x, y, z, c, i) = (BLURY (x, y-1, z, c, i) + 2.0f * BLURY (x, y, z, c, i) + BLURY (x, y+1, z, c, i)) / 4.0f;
-
-  /* trilinear filtering */
-
-  for (y=0; y < height; y++)
-    for (x=0; x < width; x++)
-      for(c = 0; c < channels; c++)
-        {
-          float xf = (float)(x) / s_sigma + padding_xy;
-          float yf = (float)(y) / s_sigma + padding_xy;
-          float zf = INPUT(x,y,c) / r_sigma + padding_z;
-
-          int x1 = CLAMP((int)xf, 0, sw-1);
-          int y1 = CLAMP((int)yf, 0, sh-1);
-          int z1 = CLAMP((int)zf, 0, depth-1);
-
-          int x2 = CLAMP(x1+1, 0, sw-1);
-          int y2 = CLAMP(y1+1, 0, sh-1);
-          int z2 = CLAMP(z1+1, 0, depth-1);
-
-          float x_alpha = xf - x1;
-          float y_alpha = yf - y1;
-          float z_alpha = zf - z1;
-
-          float interpolated[2];
-
-          g_assert(xf >= 0 && xf < sw);
-          g_assert(yf >= 0 && yf < sh);
-          g_assert(zf >= 0 && zf < depth);
-
-          for (i=0; i<2; i++)
-              interpolated[i] =
-              lerp(lerp(lerp(BLURZ(x1, y1, z1, c, i), BLURZ(x2, y1, z1, c, i), x_alpha),
-                        lerp(BLURZ(x1, y2, z1, c, i), BLURZ(x2, y2, z1, c, i), x_alpha), y_alpha),
-                   lerp(lerp(BLURZ(x1, y1, z2, c, i), BLURZ(x2, y1, z2, c, i), x_alpha),
-                        lerp(BLURZ(x1, y2, z2, c, i), BLURZ(x2, y2, z2, c, i), x_alpha), y_alpha), z_alpha);
-
-          smoothed[channels*(y*width+x)+c] = interpolated[0] / interpolated[1];
-        }
-
-  gegl_buffer_set (dst, dst_rect, 0, babl_format ("RGBA float"), smoothed,
+  gegl_buffer_set (dst, dst_rect, 0, babl_format ("RGBA float"), dst_buf,
                    GEGL_AUTO_ROWSTRIDE);
 
-  g_free (grid);
-  g_free (blurx);
-  g_free (blury);
-  g_free (blurz);
-  g_free (input);
-  g_free (smoothed);
+  g_free (src_buf);
+  g_free (dst_buf);
 }
 
 #include "opencl/gegl-cl.h"
@@ -484,18 +385,23 @@ gegl_op_class_init (GeglOpClass *klass)
 
   filter_class->process = bilateral_process;
 
-  operation_class->prepare                 = bilateral_prepare;
-  operation_class->get_required_for_output = bilateral_get_required_for_output;
-  operation_class->get_cached_region       = bilateral_get_cached_region;
+  operation_class->prepare                   = bilateral_prepare;
+  operation_class->get_required_for_output   = bilateral_get_required_for_output;
+  operation_class->get_invalidated_by_change = bilateral_get_invalidated_by_change;
 
   operation_class->opencl_support = FALSE;
 
+  /* the lattice spreads its own work over the threads, splitting the area
+   * would only splat the overlap around every part again
+   */
+  operation_class->threaded       = FALSE;
+
   gegl_operation_class_set_keys (operation_class,
   "name"       , "gegl:bilateral-filter-fast",
   "title"      , _("Bilateral Box Filter"),
   "categories" , "enhance:noise-reduction",
   "description",
-           _("A fast approximation of bilateral filter, using a box-filter instead of a gaussian blur."),
+           _("A fast approximation of bilateral filter, blurring on a permutohedral lattice."),
         NULL);
 }
 
@@ -40,6 +40,12 @@ property_double (edge_preservation, _("Edge preservation"), 8.0)
 
 #include "gegl-op.h"
 #include <math.h>
+#include "bilateral-lattice.h"
+
+/* from this radius on, the permutohedral lattice is faster than weighing
+ * every pixel of the neighbourhood
+ */
+#define LATTICE_RADIUS 5.0
 
 static void
 bilateral_filter (GeglBuffer          *src,
@@ -49,6 +55,14 @@ bilateral_filter (GeglBuffer          *src,
                   gdouble              radius,
                   gdouble              preserve);
 
+static void
+bilateral_filter_lattice (GeglBuffer          *src,
+                          const GeglRectangle *src_rect,
+                          GeglBuffer          *dst,
+                          const GeglRectangle *dst_rect,
+                          gdouble              radius,
+                          gdouble              preserve);
+
 #include <stdio.h>
 
 static void prepare (GeglOperation *operation)
@@ -166,7 +180,11 @@ process (GeglOperation       *operation,
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GeglRectangle compute;
 
-  if (o->blur_radius >= 1.0 && gegl_operation_use_opencl (operation))
+  /* the OpenCL kernel computes the exact filter, which would not match
+   * the lattice
+   */
+  if (o->blur_radius >= 1.0 && o->blur_radius < LATTICE_RADIUS &&
+      gegl_operation_use_opencl (operation))
     if (cl_process (operation, input, output, result))
       return TRUE;
 
@@ -177,6 +195,10 @@ process (GeglOperation       *operation,
       gegl_buffer_copy (input, result, GEGL_ABYSS_NONE,
                         output, result);
     }
+  else if (o->blur_radius >= LATTICE_RADIUS)
+    {
+      bilateral_filter_lattice (input, &compute, output, result, o->blur_radius, o->edge_preservation);
+    }
   else
     {
       bilateral_filter (input, &compute, output, result, o->blur_radius, o->edge_preservation);
@@ -269,6 +291,36 @@ bilateral_filter (GeglBuffer          *src,
   g_free (dst_buf);
 }
 
+static void
+bilateral_filter_lattice (GeglBuffer          *src,
+                          const GeglRectangle *src_rect,
+                          GeglBuffer          *dst,
+                          const GeglRectangle *dst_rect,
+                          gdouble              radius,
+                          gdouble              preserve)
+{
+  gfloat *src_buf;
+  gfloat *dst_buf;
+
+  src_buf = g_new (gfloat, src_rect->width * src_rect->height * 4);
+  dst_buf = g_new (gfloat, dst_rect->width * dst_rect->height * 4);
+
+  gegl_buffer_get (src, src_rect, 1.0, babl_format ("RGBA float"), src_buf, GEGL_AUTO_ROWSTRIDE,
+                   GEGL_ABYSS_NONE);
+
+  /* the same weights as bilateral_filter(), exp (-0.5 * d^2 / radius) for
+   * the distance and exp (-preserve * d^2) for the color difference,
+   * though not cut off at the radius
+   */
+  bilateral_lattice_filter (src_buf, src_rect, dst_buf, dst_rect,
+                            1.0 / sqrt (radius), sqrt (2.0 * preserve));
+
+  gegl_buffer_set (dst, dst_rect, 0, babl_format ("RGBA float"), dst_buf,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_free (src_buf);
+  g_free (dst_buf);
+}
+
 
 static void
 gegl_op_class_init (GeglOpClass *klass)
@@ -0,0 +1,641 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A bilateral filter on the permutohedral lattice, as described in:
+ *
+ *  Fast High-Dimensional Filtering Using the Permutohedral Lattice
+ *  Andrew Adams, Jongmin Baek and Abe Davis
+ *  Eurographics 2010
+ *
+ * Every "RGBA float" pixel is a point in the five dimensional space of
+ * its position and color, scaled so that the filter is a gaussian of
+ * standard deviation 1 there, in both position and color at once.  The
+ * pixels are splatted onto the vertices of the lattice cells enclosing
+ * them, the vertices are blurred along each of the six lattice axes, and
+ * the result is read back at the pixels.  The work is proportional to
+ * the number of pixels and of vertices in use, which only goes down as
+ * the filter gets wider, and each of the three steps is spread over the
+ * worker threads.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "gegl-config.h"
+
+#define BILATERAL_LATTICE_D 5  /* x, y, red, green and blue */
+
+#ifdef __GNUC__
+typedef gfloat bilateral_lattice_v4sf __attribute__ ((vector_size (16)));
+#endif
+
+typedef struct
+{
+  gint    *keys;      /* the first D coordinates of each vertex */
+  gfloat  *values;    /* the summed up RGBA of each vertex */
+  gfloat  *weights;   /* and their weight */
+  gint    *table;     /* open addressing, indices into the above, or -1 */
+  gint     n_vertices;
+  gint     capacity;  /* of keys, values and weights */
+  guint    mask;      /* the size of table minus one */
+} BilateralLattice;
+
+static void
+bilateral_lattice_init (BilateralLattice *lattice,
+                        gint              capacity)
+{
+  guint size = 64;
+
+  /* the table is kept at most half full */
+  while (size < 2 * capacity)
+    size *= 2;
+
+  lattice->capacity   = capacity;
+  lattice->n_vertices = 0;
+  lattice->mask       = size - 1;
+  lattice->keys       = g_new (gint, capacity * BILATERAL_LATTICE_D);
+  lattice->values     = g_new (gfloat, capacity * 4);
+  lattice->weights    = g_new (gfloat, capacity);
+  lattice->table      = g_new (gint, size);
+
+  memset (lattice->table, -1, size * sizeof (gint));
+}
+
+static void
+bilateral_lattice_cleanup (BilateralLattice *lattice)
+{
+  g_free (lattice->keys);
+  g_free (lattice->values);
+  g_free (lattice->weights);
+  g_free (lattice->table);
+}
+
+static inline guint
+bilateral_lattice_hash (const gint *key)
+{
+  guint hash = 0;
+  gint  i;
+
+  for (i = 0; i < BILATERAL_LATTICE_D; i++)
+    {
+      hash += key[i];
+      hash *= 2531011;
+    }
+
+  return hash;
+}
+
+/* doubles the room for vertices, and the table along with it */
+static void
+bilateral_lattice_grow (BilateralLattice *lattice)
+{
+  guint size = 2 * (lattice->mask + 1);
+  gint  i;
+
+  lattice->capacity *= 2;
+  lattice->keys    = g_renew (gint, lattice->keys,
+                              lattice->capacity * BILATERAL_LATTICE_D);
+  lattice->values  = g_renew (gfloat, lattice->values, lattice->capacity * 4);
+  lattice->weights = g_renew (gfloat, lattice->weights, lattice->capacity);
+
+  lattice->mask  = size - 1;
+  lattice->table = g_renew (gint, lattice->table, size);
+  memset (lattice->table, -1, size * sizeof (gint));
+
+  for (i = 0; i < lattice->n_vertices; i++)
+    {
+      guint h = bilateral_lattice_hash (lattice->keys + i * BILATERAL_LATTICE_D) &
+                lattice->mask;
+
+      while (lattice->table[h] >= 0)
+        h = (h + 1) & lattice->mask;
+
+      lattice->table[h] = i;
+    }
+}
+
+/* returns the index of the vertex at @key, adding it if @create is set,
+ * or -1
+ */
+static gint
+bilateral_lattice_lookup (BilateralLattice *lattice,
+                          const gint       *key,
+                          gboolean          create)
+{
+  guint h = bilateral_lattice_hash (key) & lattice->mask;
+
+  while (TRUE)
+    {
+      gint index = lattice->table[h];
+
+      if (index < 0)
+        {
+          if (! create)
+            return -1;
+
+          if (lattice->n_vertices == lattice->capacity)
+            {
+              bilateral_lattice_grow (lattice);
+              return bilateral_lattice_lookup (lattice, key, create);
+            }
+
+          index = lattice->n_vertices++;
+          lattice->table[h] = index;
+
+          memcpy (lattice->keys + index * BILATERAL_LATTICE_D, key,
+                  BILATERAL_LATTICE_D * sizeof (gint));
+          memset (lattice->values + index * 4, 0, 4 * sizeof (gfloat));
+          lattice->weights[index] = 0.0f;
+
+          return index;
+        }
+
+      if (! memcmp (lattice->keys + index * BILATERAL_LATTICE_D, key,
+                    BILATERAL_LATTICE_D * sizeof (gint)))
+        return index;
+
+      h = (h + 1) & lattice->mask;
+    }
+}
+
+/* finds the D + 1 vertices of the simplex enclosing @position, and the
+ * barycentric weights of @position within it
+ */
+static inline void
+bilateral_lattice_simplex (const gfloat *position,
+                           gint          keys[BILATERAL_LATTICE_D + 1][BILATERAL_LATTICE_D],
+                           gfloat        barycentric[BILATERAL_LATTICE_D + 2])
+{
+  const gint d = BILATERAL_LATTICE_D;
+  gfloat     elevated[BILATERAL_LATTICE_D + 1];
+  gint       greedy[BILATERAL_LATTICE_D + 1];
+  gint       rank[BILATERAL_LATTICE_D + 1];
+  gint       sum = 0;
+  gint       i, j, r;
+
+  /* the position on the plane of the lattice, x_0 + ... + x_d = 0, in
+   * which the lattice is the union of d + 1 shifted copies of
+   * (d + 1) Z^(d + 1)
+   */
+  elevated[d] = -d * position[d - 1];
+  for (i = d - 1; i > 0; i--)
+    elevated[i] = elevated[i + 1] - i * position[i - 1] + (i + 2) * position[i];
+  elevated[0] = elevated[1] + 2 * position[0];
+
+  /* the closest point with all coordinates a multiple of d + 1 */
+  for (i = 0; i <= d; i++)
+    {
+      gfloat v    = elevated[i] / (d + 1);
+      gint   up   = ceilf (v) * (d + 1);
+      gint   down = floorf (v) * (d + 1);
+
+      if (up - elevated[i] < elevated[i] - down)
+        greedy[i] = up;
+      else
+        greedy[i] = down;
+
+      sum += greedy[i] / (d + 1);
+    }
+
+  /* orders the coordinates by how far they are from it */
+  memset (rank, 0, sizeof (rank));
+  for (i = 0; i < d; i++)
+    for (j = i + 1; j <= d; j++)
+      {
+        if (elevated[i] - greedy[i] < elevated[j] - greedy[j])
+          rank[i]++;
+        else
+          rank[j]++;
+      }
+
+  /* and moves it back onto the plane */
+  if (sum > 0)
+    {
+      for (i = 0; i <= d; i++)
+        {
+          if (rank[i] >= d + 1 - sum)
+            {
+              greedy[i] -= d + 1;
+              rank[i]   += sum - (d + 1);
+            }
+          else
+            {
+              rank[i] += sum;
+            }
+        }
+    }
+  else if (sum < 0)
+    {
+      for (i = 0; i <= d; i++)
+        {
+          if (rank[i] < -sum)
+            {
+              greedy[i] += d + 1;
+              rank[i]   += (d + 1) + sum;
+            }
+          else
+            {
+              rank[i] += sum;
+            }
+        }
+    }
+
+  memset (barycentric, 0, (d + 2) * sizeof (gfloat));
+  for (i = 0; i <= d; i++)
+    {
+      gfloat delta = (elevated[i] - greedy[i]) / (d + 1);
+
+      barycentric[d - rank[i]]     += delta;
+      barycentric[d + 1 - rank[i]] -= delta;
+    }
+  barycentric[0] += 1.0f + barycentric[d + 1];
+
+  for (r = 0; r <= d; r++)
+    for (i = 0; i < d; i++)
+      keys[r][i] = greedy[i] + (rank[i] <= d - r ? r : r - (d + 1));
+}
+
+/* scales the position and color of a pixel for the lattice */
+static inline void
+bilateral_lattice_position (gfloat       *position,
+                            gint          x,
+                            gint          y,
+                            const gfloat *pixel,
+                            gfloat        spatial_scale,
+                            gfloat        range_scale)
+{
+  /* the lattice blur is a gaussian of this standard deviation, and
+   * every axis is scaled for the elevation to keep distances
+   */
+  const gfloat std_dev = (BILATERAL_LATTICE_D + 1) * sqrtf (2.0f / 3.0f);
+  gint         i;
+
+  position[0] = x * spatial_scale;
+  position[1] = y * spatial_scale;
+  position[2] = pixel[0] * range_scale;
+  position[3] = pixel[1] * range_scale;
+  position[4] = pixel[2] * range_scale;
+
+  for (i = 0; i < BILATERAL_LATTICE_D; i++)
+    position[i] *= std_dev / sqrtf ((i + 1) * (i + 2));
+}
+
+/* @acc += @value * @scale, for the four components of a vertex or pixel */
+static inline void
+bilateral_lattice_madd (gfloat       *acc,
+                        const gfloat *value,
+                        gfloat        scale)
+{
+#ifdef __GNUC__
+  bilateral_lattice_v4sf a, v;
+
+  memcpy (&a, acc, sizeof (a));
+  memcpy (&v, value, sizeof (v));
+  a += v * scale;
+  memcpy (acc, &a, sizeof (a));
+#else
+  gint c;
+
+  for (c = 0; c < 4; c++)
+    acc[c] += value[c] * scale;
+#endif
+}
+
+/* v = 0.5 * v + 0.25 * (a + b), for the RGBA of a vertex */
+static inline void
+bilateral_lattice_blur_vertex (gfloat       *value,
+                               const gfloat *value_a,
+                               const gfloat *value_b,
+                               const gfloat *self)
+{
+#ifdef __GNUC__
+  bilateral_lattice_v4sf a, b, s, v;
+
+  memcpy (&a, value_a, sizeof (a));
+  memcpy (&b, value_b, sizeof (b));
+  memcpy (&s, self, sizeof (s));
+  v = s * 0.5f + (a + b) * 0.25f;
+  memcpy (value, &v, sizeof (v));
+#else
+  gint c;
+
+  for (c = 0; c < 4; c++)
+    value[c] = self[c] * 0.5f + (value_a[c] + value_b[c]) * 0.25f;
+#endif
+}
+
+/* the vertices blurred by one task */
+#define BILATERAL_LATTICE_CHUNK 4096
+
+/* The pixels are splatted onto a lattice per strip of rows, one strip per
+ * thread, and these are merged before the blur.  The blur only looks
+ * vertices up and the slicing only reads them, so both are spread over
+ * the threads as they are.
+ */
+typedef struct
+{
+  const gfloat        *src;
+  const GeglRectangle *src_rect;
+  gfloat              *dst;
+  const GeglRectangle *dst_rect;
+  gfloat               spatial_scale;
+  gfloat               range_scale;
+
+  gint                 n_strips;
+  gint                 strip;        /* rows of src per strip */
+  BilateralLattice    *strips;       /* the lattice of each strip */
+  gint               **remaps;       /* from their vertices to the merged ones */
+
+  gint                *offsets;      /* the D + 1 vertices of each pixel of
+                                      * dst, in the lattice of its strip
+                                      */
+  gfloat              *barycentric;  /* and their weights */
+
+  BilateralLattice     lattice;      /* the merged lattice */
+  gfloat              *blurred_values;
+  gfloat              *blurred_weights;
+  gint                 axis;
+
+  gint                 slice_rows;   /* rows of dst per slicing task */
+} BilateralLatticeData;
+
+static void
+bilateral_lattice_splat_strip (gint     i,
+                               gpointer user_data)
+{
+  BilateralLatticeData *data     = user_data;
+  const gint            d        = BILATERAL_LATTICE_D;
+  const GeglRectangle  *src_rect = data->src_rect;
+  const GeglRectangle  *dst_rect = data->dst_rect;
+  BilateralLattice     *lattice  = &data->strips[i];
+  gint                  y0       = i * data->strip;
+  gint                  y1       = MIN (y0 + data->strip, src_rect->height);
+  gint                  x, y, r;
+
+  /* a guess, the lattice grows as needed */
+  bilateral_lattice_init (lattice, MAX ((y1 - y0) * src_rect->width / 4, 64));
+
+  for (y = y0; y < y1; y++)
+    for (x = 0; x < src_rect->width; x++)
+      {
+        const gfloat *pixel = data->src + (y * src_rect->width + x) * 4;
+        gint          keys[BILATERAL_LATTICE_D + 1][BILATERAL_LATTICE_D];
+        gfloat        barycentric[BILATERAL_LATTICE_D + 2];
+        gfloat        position[BILATERAL_LATTICE_D];
+        gint          dst_x = x + src_rect->x - dst_rect->x;
+        gint          dst_y = y + src_rect->y - dst_rect->y;
+        gboolean      in_dst;
+
+        in_dst = dst_x >= 0 && dst_x < dst_rect->width &&
+                 dst_y >= 0 && dst_y < dst_rect->height;
+
+        bilateral_lattice_position (position,
+                                    x + src_rect->x, y + src_rect->y, pixel,
+                                    data->spatial_scale, data->range_scale);
+        bilateral_lattice_simplex (position, keys, barycentric);
+
+        for (r = 0; r <= d; r++)
+          {
+            gint index = bilateral_lattice_lookup (lattice, keys[r], TRUE);
+
+            bilateral_lattice_madd (lattice->values + index * 4, pixel,
+                                    barycentric[r]);
+            lattice->weights[index] += barycentric[r];
+
+            if (in_dst)
+              {
+                gint j = (dst_y * dst_rect->width + dst_x) * (d + 1) + r;
+
+                data->offsets[j]     = index;
+                data->barycentric[j] = barycentric[r];
+              }
+          }
+      }
+}
+
+static void
+bilateral_lattice_merge (BilateralLatticeData *data)
+{
+  const gint d = BILATERAL_LATTICE_D;
+  gint       n = 0;
+  gint       i, v;
+
+  for (i = 0; i < data->n_strips; i++)
+    n += data->strips[i].n_vertices;
+
+  bilateral_lattice_init (&data->lattice, MAX (n, 64));
+
+  for (i = 0; i < data->n_strips; i++)
+    {
+      BilateralLattice *strip = &data->strips[i];
+
+      data->remaps[i] = g_new (gint, MAX (strip->n_vertices, 1));
+
+      for (v = 0; v < strip->n_vertices; v++)
+        {
+          gint index = bilateral_lattice_lookup (&data->lattice,
+                                                 strip->keys + v * d, TRUE);
+
+          bilateral_lattice_madd (data->lattice.values + index * 4,
+                                  strip->values + v * 4, 1.0f);
+          data->lattice.weights[index] += strip->weights[v];
+
+          data->remaps[i][v] = index;
+        }
+
+      bilateral_lattice_cleanup (strip);
+    }
+}
+
+static void
+bilateral_lattice_blur_chunk (gint     i,
+                              gpointer user_data)
+{
+  BilateralLatticeData *data    = user_data;
+  BilateralLattice     *lattice = &data->lattice;
+  const gint            d       = BILATERAL_LATTICE_D;
+  const gfloat          zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  gint                  v0      = i * BILATERAL_LATTICE_CHUNK;
+  gint                  v1      = MIN (v0 + BILATERAL_LATTICE_CHUNK,
+                                       lattice->n_vertices);
+  gint                  v, j;
+
+  for (v = v0; v < v1; v++)
+    {
+      const gint *key = lattice->keys + v * d;
+      gint        neighbor_a[BILATERAL_LATTICE_D];
+      gint        neighbor_b[BILATERAL_LATTICE_D];
+      gint        a, b;
+
+      /* the neighbors one step along the axis, either way */
+      for (j = 0; j < d; j++)
+        {
+          neighbor_a[j] = key[j] - 1;
+          neighbor_b[j] = key[j] + 1;
+        }
+      if (data->axis < d)
+        {
+          neighbor_a[data->axis] += d + 1;
+          neighbor_b[data->axis] -= d + 1;
+        }
+
+      a = bilateral_lattice_lookup (lattice, neighbor_a, FALSE);
+      b = bilateral_lattice_lookup (lattice, neighbor_b, FALSE);
+
+      bilateral_lattice_blur_vertex (data->blurred_values + v * 4,
+                                     a < 0 ? zero : lattice->values + a * 4,
+                                     b < 0 ? zero : lattice->values + b * 4,
+                                     lattice->values + v * 4);
+
+      data->blurred_weights[v] = lattice->weights[v] * 0.5f +
+                                 ((a < 0 ? 0.0f : lattice->weights[a]) +
+                                  (b < 0 ? 0.0f : lattice->weights[b])) * 0.25f;
+    }
+}
+
+/* blurs the vertices along each of the D + 1 axes of the lattice */
+static void
+bilateral_lattice_blur (BilateralLatticeData *data)
+{
+  BilateralLattice *lattice  = &data->lattice;
+  gint              n        = lattice->n_vertices;
+  gint              n_chunks = (n + BILATERAL_LATTICE_CHUNK - 1) /
+                               BILATERAL_LATTICE_CHUNK;
+
+  data->blurred_values  = g_new (gfloat, MAX (n, 1) * 4);
+  data->blurred_weights = g_new (gfloat, MAX (n, 1));
+
+  for (data->axis = 0; data->axis <= BILATERAL_LATTICE_D; data->axis++)
+    {
+      gfloat *tmp;
+
+      gegl_parallel_for (n_chunks, bilateral_lattice_blur_chunk, data);
+
+      tmp                   = lattice->values;
+      lattice->values       = data->blurred_values;
+      data->blurred_values  = tmp;
+
+      tmp                   = lattice->weights;
+      lattice->weights      = data->blurred_weights;
+      data->blurred_weights = tmp;
+    }
+
+  g_free (data->blurred_values);
+  g_free (data->blurred_weights);
+}
+
+static void
+bilateral_lattice_slice_rows (gint     i,
+                              gpointer user_data)
+{
+  BilateralLatticeData *data     = user_data;
+  const gint            d        = BILATERAL_LATTICE_D;
+  const GeglRectangle  *dst_rect = data->dst_rect;
+  BilateralLattice     *lattice  = &data->lattice;
+  gint                  y0       = i * data->slice_rows;
+  gint                  y1       = MIN (y0 + data->slice_rows, dst_rect->height);
+  gint                  x, y, r;
+
+  for (y = y0; y < y1; y++)
+    {
+      const gint *remap;
+
+      remap = data->remaps[(y + dst_rect->y - data->src_rect->y) / data->strip];
+
+      for (x = 0; x < dst_rect->width; x++)
+        {
+          gint   p        = y * dst_rect->width + x;
+          gfloat value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+          gfloat weight   = 0.0f;
+
+          for (r = 0; r <= d; r++)
+            {
+              gint   index = remap[data->offsets[p * (d + 1) + r]];
+              gfloat b     = data->barycentric[p * (d + 1) + r];
+
+              bilateral_lattice_madd (value, lattice->values + index * 4, b);
+              weight += lattice->weights[index] * b;
+            }
+
+          memset (data->dst + p * 4, 0, 4 * sizeof (gfloat));
+          bilateral_lattice_madd (data->dst + p * 4, value, 1.0f / weight);
+        }
+    }
+}
+
+/* filters the "RGBA float" @src, of @src_rect, into @dst, of @dst_rect,
+ * which must lie within @src_rect.  The filter is a gaussian of the
+ * distance between pixels with their position multiplied by
+ * @spatial_scale and their color by @range_scale, that is, of the
+ * inverse standard deviations.
+ */
+static void
+bilateral_lattice_filter (const gfloat        *src,
+                          const GeglRectangle *src_rect,
+                          gfloat              *dst,
+                          const GeglRectangle *dst_rect,
+                          gfloat               spatial_scale,
+                          gfloat               range_scale)
+{
+  const gint           d       = BILATERAL_LATTICE_D;
+  gint                 n_dst   = dst_rect->width * dst_rect->height;
+  gint                 threads = gegl_config_threads ();
+  BilateralLatticeData data;
+  gint                 i, n_tasks;
+
+  if (n_dst <= 0)
+    return;
+
+  data.src           = src;
+  data.src_rect      = src_rect;
+  data.dst           = dst;
+  data.dst_rect      = dst_rect;
+  data.spatial_scale = spatial_scale;
+  data.range_scale   = range_scale;
+
+  /* every strip adds the cost of merging its lattice, so there are only
+   * as many as there are threads
+   */
+  data.n_strips = CLAMP (threads, 1, src_rect->height);
+  data.strip    = (src_rect->height + data.n_strips - 1) / data.n_strips;
+  data.n_strips = (src_rect->height + data.strip - 1) / data.strip;
+
+  data.strips      = g_new0 (BilateralLattice, data.n_strips);
+  data.remaps      = g_new0 (gint *, data.n_strips);
+  data.offsets     = g_new (gint, n_dst * (d + 1));
+  data.barycentric = g_new (gfloat, n_dst * (d + 1));
+
+  gegl_parallel_for (data.n_strips, bilateral_lattice_splat_strip, &data);
+
+  bilateral_lattice_merge (&data);
+
+  bilateral_lattice_blur (&data);
+
+  n_tasks = MIN (dst_rect->height, threads * GEGL_PARALLEL_TASKS_PER_THREAD);
+  data.slice_rows = (dst_rect->height + n_tasks - 1) / n_tasks;
+  n_tasks = (dst_rect->height + data.slice_rows - 1) / data.slice_rows;
+
+  gegl_parallel_for (n_tasks, bilateral_lattice_slice_rows, &data);
+
+  for (i = 0; i < data.n_strips; i++)
+    g_free (data.remaps[i]);
+
+  bilateral_lattice_cleanup (&data.lattice);
+  g_free (data.strips);
+  g_free (data.remaps);
+  g_free (data.offsets);
+  g_free (data.barycentric);
+}
@@ -37,130 +37,7 @@ property_int (radius, _("Radius"), 4)
 #include <stdio.h>
 #include <math.h>
 
-#define SRC_OFFSET (row + u + radius * 2) * 4
-
-static void
-hor_blur (GeglBuffer          *src,
-          const GeglRectangle *src_rect,
-          GeglBuffer          *dst,
-          const GeglRectangle *dst_rect,
-          gint                 radius)
-{
-  gint u,v;
-  gint i;
-  gint offset;
-  gint src_offset;
-  gint prev_rad = radius * 4 + 4;
-  gint next_rad = radius * 4;
-  gint row;
-  gfloat *src_buf;
-  gfloat *dst_buf;
-  gfloat rad1 = 1.0 / (gfloat)(radius * 2 + 1);
-
-  src_buf = g_new0 (gfloat, src_rect->width * src_rect->height * 4);
-  dst_buf = g_new0 (gfloat, dst_rect->width * dst_rect->height * 4);
-
-  gegl_buffer_get (src, src_rect, 1.0, babl_format ("RaGaBaA float"),
-                   src_buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  offset = 0;
-  for (v = 0; v < dst_rect->height; v++)
-    {
-      /* here just radius, not radius * 2 as in ver_blur beacuse
-       * we enlarged dst_buf by y earlier */
-      row = (v + radius) * src_rect->width;
-      /* prepare - set first column of pixels */
-      for (u = -radius; u <= radius; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-            dst_buf[offset + i] += src_buf[src_offset + i] * rad1;
-        }
-      offset += 4;
-      /* iterate other pixels by moving a window - very fast */
-      for (u = 1; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-          {
-            dst_buf[offset] = dst_buf[offset - 4]
-                            - src_buf[src_offset - prev_rad] * rad1
-                            + src_buf[src_offset + next_rad] * rad1;
-            src_offset++;
-            offset++;
-          }
-        }
-    }
-
-  gegl_buffer_set (dst, dst_rect, 0, babl_format ("RaGaBaA float"),
-                   dst_buf, GEGL_AUTO_ROWSTRIDE);
-
-  g_free (src_buf);
-  g_free (dst_buf);
-}
-
-static void
-ver_blur (GeglBuffer          *src,
-          const GeglRectangle *src_rect,
-          GeglBuffer          *dst,
-          const GeglRectangle *dst_rect,
-          gint                 radius)
-{
-  gint u, v;
-  gint i;
-  gint offset;
-  gint src_offset;
-  gint prev_rad = (radius * 4 + 4) * src_rect->width;
-  gint next_rad = (radius * 4) * src_rect->width;
-  gint row;
-  gfloat *src_buf;
-  gfloat *dst_buf;
-  gfloat rad1 = 1.0 / (gfloat)(radius * 2 + 1);
-
-  src_buf = g_new0 (gfloat, src_rect->width * src_rect->height * 4);
-  dst_buf = g_new0 (gfloat, dst_rect->width * dst_rect->height * 4);
-
-  gegl_buffer_get (src, src_rect, 1.0, babl_format ("RaGaBaA float"),
-                   src_buf, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  /* prepare: set first row of pixels */
-  for (v = -radius; v <= radius; v++)
-    {
-      row = (v + radius * 2) * src_rect->width;
-      for (u = 0; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-            dst_buf[u * 4 + i] += src_buf[src_offset + i] * rad1;
-        }
-    }
-  /* skip first row */
-  offset = dst_rect->width * 4;
-  for (v = 1; v < dst_rect->height; v++)
-    {
-      row = (v + radius * 2) * src_rect->width;
-      for (u = 0; u < dst_rect->width; u++)
-        {
-          src_offset = SRC_OFFSET;
-          for (i = 0; i < 4; i++)
-          {
-            dst_buf[offset] = dst_buf[offset - 4 * dst_rect->width]
-                            - src_buf[src_offset - prev_rad] * rad1
-                            + src_buf[src_offset + next_rad] * rad1;
-            src_offset++;
-            offset++;
-          }
-        }
-    }
-
-  gegl_buffer_set (dst, dst_rect, 0, babl_format ("RaGaBaA float"),
-                   dst_buf, GEGL_AUTO_ROWSTRIDE);
-
-  g_free (src_buf);
-  g_free (dst_buf);
-}
-
-#undef SRC_OFFSET
+#include "box-filter.h"
 
 static void prepare (GeglOperation *operation)
 {
@@ -340,34 +217,24 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  GeglRectangle rect;
   GeglRectangle tmprect;
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GeglBuffer *temp;
-  GeglOperationAreaFilter *op_area;
-  op_area = GEGL_OPERATION_AREA_FILTER (operation);
 
   if (gegl_operation_use_opencl (operation))
     if (cl_process (operation, input, output, result))
       return TRUE;
 
-  rect = *result;
+  /* the vertical pass needs radius more rows above and below */
   tmprect = *result;
-
-  rect.x       -= op_area->left * 2;
-  rect.y       -= op_area->top * 2;
-  rect.width   += (op_area->left + op_area->right) * 2;
-  rect.height  += (op_area->top + op_area->bottom) * 2;
-  /* very tricky: enlarge temp buffer to avoid seams in second pass */
   tmprect.y      -= o->radius;
   tmprect.height += o->radius * 2;
 
   temp  = gegl_buffer_new (&tmprect,
                            babl_format ("RaGaBaA float"));
 
-  /* doing second pass in separate gegl op may be significantly faster */
-  hor_blur (input, &rect, temp, &tmprect, o->radius);
-  ver_blur (temp, &rect, output, result, o->radius);
+  box_filter_hor (input, temp, &tmprect, o->radius, GEGL_ABYSS_CLAMP);
+  box_filter_ver (temp, output, result, o->radius, GEGL_ABYSS_CLAMP);
 
   g_object_unref (temp);
   return  TRUE;
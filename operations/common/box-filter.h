@@ -0,0 +1,311 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* One dimensional box filter passes on "RaGaBaA float" buffers, for the
+ * operations that average over a rectangular neighbourhood, or that
+ * approximate a gaussian with a few box passes.
+ *
+ * A pass moves a running sum along the rows or columns of @dst_rect.
+ * Rather than fetching the whole area at once, it works on strips of
+ * rows or columns that fit in the cache, and the strips are spread over
+ * the worker threads.  Reads outside of @src are handled by @abyss_policy.
+ */
+
+#include <string.h>
+
+/* the number of bytes of input a strip aims for */
+#define BOX_FILTER_STRIP_SIZE (256 * 1024)
+
+#ifdef __GNUC__
+typedef gfloat box_filter_v4sf __attribute__ ((vector_size (16)));
+#endif
+
+typedef struct
+{
+  GeglBuffer      *src;
+  GeglBuffer      *dst;
+  GeglRectangle    rect;
+  gint             radius;
+  GeglAbyssPolicy  abyss_policy;
+  gint             strip;
+} BoxFilterData;
+
+/* @n output pixels from the @n + 2 * @radius pixels of @in, which are
+ * @in_stride floats apart
+ */
+static inline void
+box_filter_row (const gfloat *in,
+                gfloat       *out,
+                gint          n,
+                gint          radius,
+                gint          in_stride)
+{
+  const gint    window = 2 * radius + 1;
+  const gfloat  scale  = 1.0f / window;
+  const gfloat *add    = in + window * in_stride;
+  gint          x;
+
+#ifdef __GNUC__
+  box_filter_v4sf sum = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+  for (x = 0; x < window; x++)
+    {
+      box_filter_v4sf v;
+
+      memcpy (&v, in + x * in_stride, sizeof (v));
+      sum += v;
+    }
+
+  for (x = 0; x < n; x++)
+    {
+      box_filter_v4sf result = sum * scale;
+
+      memcpy (out + x * 4, &result, sizeof (result));
+
+      if (x + 1 < n)
+        {
+          box_filter_v4sf a, s;
+
+          memcpy (&a, add + x * in_stride, sizeof (a));
+          memcpy (&s, in + x * in_stride, sizeof (s));
+          sum += a - s;
+        }
+    }
+#else
+  gfloat sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  gint   c;
+
+  for (x = 0; x < window; x++)
+    for (c = 0; c < 4; c++)
+      sum[c] += in[x * in_stride + c];
+
+  for (x = 0; x < n; x++)
+    {
+      for (c = 0; c < 4; c++)
+        out[x * 4 + c] = sum[c] * scale;
+
+      if (x + 1 < n)
+        for (c = 0; c < 4; c++)
+          sum[c] += add[x * in_stride + c] - in[x * in_stride + c];
+    }
+#endif
+}
+
+/* moves the running sums of a strip of @width floats one row down, all
+ * columns of the strip at once
+ */
+static inline void
+box_filter_slide (gfloat       *sum,
+                  const gfloat *add,
+                  const gfloat *sub,
+                  gint          width)
+{
+  gint i = 0;
+
+#ifdef __GNUC__
+  for (; i + 4 <= width; i += 4)
+    {
+      box_filter_v4sf s, a, d;
+
+      memcpy (&s, sum + i, sizeof (s));
+      memcpy (&a, add + i, sizeof (a));
+      memcpy (&d, sub + i, sizeof (d));
+      s += a - d;
+      memcpy (sum + i, &s, sizeof (s));
+    }
+#endif
+
+  for (; i < width; i++)
+    sum[i] += add[i] - sub[i];
+}
+
+static void
+box_filter_hor_strip (gint     i,
+                      gpointer user_data)
+{
+  const BoxFilterData *data   = user_data;
+  const Babl          *format = babl_format ("RaGaBaA float");
+  GeglRectangle        out_rect;
+  GeglRectangle        in_rect;
+  gfloat              *in_buf;
+  gfloat              *out_buf;
+  gint                 y;
+
+  out_rect.x      = data->rect.x;
+  out_rect.y      = data->rect.y + i * data->strip;
+  out_rect.width  = data->rect.width;
+  out_rect.height = MIN (data->strip, data->rect.y + data->rect.height - out_rect.y);
+
+  in_rect        = out_rect;
+  in_rect.x     -= data->radius;
+  in_rect.width += 2 * data->radius;
+
+  in_buf  = gegl_malloc (in_rect.width * in_rect.height * 4 * sizeof (gfloat));
+  out_buf = gegl_malloc (out_rect.width * out_rect.height * 4 * sizeof (gfloat));
+
+  gegl_buffer_get (data->src, &in_rect, 1.0, format, in_buf,
+                   GEGL_AUTO_ROWSTRIDE, data->abyss_policy);
+
+  for (y = 0; y < out_rect.height; y++)
+    box_filter_row (in_buf + y * in_rect.width * 4,
+                    out_buf + y * out_rect.width * 4,
+                    out_rect.width, data->radius, 4);
+
+  gegl_buffer_set (data->dst, &out_rect, 0, format, out_buf,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gegl_free (in_buf);
+  gegl_free (out_buf);
+}
+
+static void
+box_filter_ver_strip (gint     i,
+                      gpointer user_data)
+{
+  const BoxFilterData *data   = user_data;
+  const Babl          *format = babl_format ("RaGaBaA float");
+  const gint           window = 2 * data->radius + 1;
+  const gfloat         scale  = 1.0f / window;
+  GeglRectangle        out_rect;
+  GeglRectangle        in_rect;
+  gfloat              *in_buf;
+  gfloat              *out_buf;
+  gfloat              *sum;
+  gint                 row;
+  gint                 x, y;
+
+  out_rect.x      = data->rect.x + i * data->strip;
+  out_rect.y      = data->rect.y;
+  out_rect.width  = MIN (data->strip, data->rect.x + data->rect.width - out_rect.x);
+  out_rect.height = data->rect.height;
+
+  in_rect         = out_rect;
+  in_rect.y      -= data->radius;
+  in_rect.height += 2 * data->radius;
+
+  row = out_rect.width * 4;
+
+  in_buf  = gegl_malloc (in_rect.height * row * sizeof (gfloat));
+  out_buf = gegl_malloc (out_rect.height * row * sizeof (gfloat));
+  sum     = gegl_malloc (row * sizeof (gfloat));
+
+  gegl_buffer_get (data->src, &in_rect, 1.0, format, in_buf,
+                   GEGL_AUTO_ROWSTRIDE, data->abyss_policy);
+
+  /* the columns are summed up a row at a time, which keeps the inner
+   * loops contiguous
+   */
+  memset (sum, 0, row * sizeof (gfloat));
+  for (y = 0; y < window; y++)
+    for (x = 0; x < row; x++)
+      sum[x] += in_buf[y * row + x];
+
+  for (y = 0; y < out_rect.height; y++)
+    {
+      gfloat *out = out_buf + y * row;
+
+      for (x = 0; x < row; x++)
+        out[x] = sum[x] * scale;
+
+      if (y + 1 < out_rect.height)
+        box_filter_slide (sum,
+                          in_buf + (y + window) * row,
+                          in_buf + y * row,
+                          row);
+    }
+
+  gegl_buffer_set (data->dst, &out_rect, 0, format, out_buf,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  gegl_free (in_buf);
+  gegl_free (out_buf);
+  gegl_free (sum);
+}
+
+static inline void
+box_filter_run (GeglBuffer          *src,
+                GeglBuffer          *dst,
+                const GeglRectangle *dst_rect,
+                gint                 radius,
+                GeglAbyssPolicy      abyss_policy,
+                gboolean             horizontal)
+{
+  BoxFilterData data;
+  gint          length;
+  gint          n_strips;
+  gint          tile_width;
+
+  if (dst_rect->width <= 0 || dst_rect->height <= 0)
+    return;
+
+  data.src          = src;
+  data.dst          = dst;
+  data.rect         = *dst_rect;
+  data.radius       = MAX (radius, 0);
+  data.abyss_policy = abyss_policy;
+
+  /* the length of the rows or columns the running sums move along */
+  length = horizontal ? dst_rect->width : dst_rect->height;
+  length += 2 * data.radius;
+
+  data.strip = BOX_FILTER_STRIP_SIZE / (length * 4 * sizeof (gfloat));
+
+  if (horizontal)
+    {
+      data.strip = CLAMP (data.strip, 1, dst_rect->height);
+      n_strips   = (dst_rect->height + data.strip - 1) / data.strip;
+
+      gegl_parallel_for (n_strips, box_filter_hor_strip, &data);
+    }
+  else
+    {
+      /* whole tiles across, so that few tiles are written by two strips */
+      g_object_get (dst, "tile-width", &tile_width, NULL);
+
+      data.strip = MAX (data.strip, 1);
+      data.strip = (data.strip + tile_width - 1) / tile_width * tile_width;
+      data.strip = MIN (data.strip, dst_rect->width);
+      n_strips   = (dst_rect->width + data.strip - 1) / data.strip;
+
+      gegl_parallel_for (n_strips, box_filter_ver_strip, &data);
+    }
+}
+
+/* sets each pixel of @dst_rect in @dst to the average of the 2 * @radius + 1
+ * pixels of @src around it on the same row
+ */
+static inline void
+box_filter_hor (GeglBuffer          *src,
+                GeglBuffer          *dst,
+                const GeglRectangle *dst_rect,
+                gint                 radius,
+                GeglAbyssPolicy      abyss_policy)
+{
+  box_filter_run (src, dst, dst_rect, radius, abyss_policy, TRUE);
+}
+
+/* sets each pixel of @dst_rect in @dst to the average of the 2 * @radius + 1
+ * pixels of @src around it in the same column
+ */
+static inline void
+box_filter_ver (GeglBuffer          *src,
+                GeglBuffer          *dst,
+                const GeglRectangle *dst_rect,
+                gint                 radius,
+                GeglAbyssPolicy      abyss_policy)
+{
+  box_filter_run (src, dst, dst_rect, radius, abyss_policy, FALSE);
+}
@@ -44,6 +44,11 @@ property_int (iterations, _("Iterations"), 10)
   value_range (1, 1000)
   ui_range (1, 30)
 
+property_boolean (mipmap, _("Mipmap sampling"), FALSE)
+  description(_("Take samples far from the pixel from lower resolution "
+                "versions of the image, faster with large radii at some "
+                "loss of precision"))
+
 /*
 property_double (rgamma, _("Radial Gamma"), 0.0, 8.0, 2.0,
                 _("Gamma applied to radial distribution"))
@@ -56,6 +61,7 @@ property_double (rgamma, _("Radial Gamma"), 0.0, 8.0, 2.0,
 #include "gegl-op.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "envelopes.h"
 
 #define RGAMMA 2.0
@@ -67,16 +73,17 @@ static void c2g (GeglBuffer          *src,
                  gint                 radius,
                  gint                 samples,
                  gint                 iterations,
+                 gboolean             mipmap,
                  gdouble              rgamma,
                  gint                 level)
 {
-  const Babl *format = babl_format ("RGBA float");
-
   if (dst_rect->width > 0 && dst_rect->height > 0)
   {
     GeglBufferIterator *i = gegl_buffer_iterator_new (dst, dst_rect, 0, babl_format("YA float"),
                                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-    GeglSampler *sampler = gegl_buffer_sampler_new_at_level (src, format, GEGL_SAMPLER_NEAREST, level);
+    Envelopes envelopes;
+
+    envelopes_init (&envelopes, src, dst_rect, radius, mipmap, level);
 
     while (gegl_buffer_iterator_next (i))
     {
@@ -92,13 +99,13 @@ static void c2g (GeglBuffer          *src,
               gfloat  max[4];
               gfloat  pixel[4];
 
-              compute_envelopes (src, sampler,
+              compute_envelopes (&envelopes,
                                  x, y,
                                  radius, samples,
                                  iterations,
                                  FALSE, /* same spray */
                                  rgamma,
-                                 min, max, pixel, format);
+                                 min, max, pixel);
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -134,7 +141,7 @@ static void c2g (GeglBuffer          *src,
             }
           }
     }
-    g_object_unref (sampler);
+    envelopes_cleanup (&envelopes);
   }
 }
 
@@ -331,6 +338,7 @@ process (GeglOperation       *operation,
        o->radius,
        o->samples,
        o->iterations,
+       o->mipmap,
        /*o->rgamma*/RGAMMA,
        level);
 
@@ -371,6 +379,8 @@ gegl_op_class_init (GeglOpClass *klass)
    * yielding correct edge behavior.
    */
   operation_class->get_bounding_box = get_bounding_box;
+  /* the samples only depend on the position of the pixel */
+  operation_class->threaded         = TRUE;
 
   operation_class->opencl_support = TRUE;
 
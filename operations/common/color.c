@@ -71,17 +71,42 @@ gegl_color_op_process (GeglOperation       *operation,
   return TRUE;
 }
 
+/* the whole tiles of the output share a single uniform tile */
+static gboolean
+gegl_color_op_source_process (GeglOperation       *operation,
+                              GeglBuffer          *output,
+                              const GeglRectangle *result,
+                              gint                 level)
+{
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+  const Babl *out_format = gegl_operation_get_format (operation, "output");
+  gint        pixel_size = babl_format_get_bytes_per_pixel (out_format);
+  void       *out_color  = alloca(pixel_size);
+
+  if (level != 0)
+    return GEGL_OPERATION_SOURCE_CLASS (gegl_op_parent_class)->process (
+             operation, output, result, level);
+
+  gegl_color_get_pixel (o->value, out_format, out_color);
+
+  gegl_buffer_set_color_from_pixel (output, result, out_color, out_format);
+
+  return TRUE;
+}
 
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass            *operation_class;
+  GeglOperationSourceClass      *source_class;
   GeglOperationPointRenderClass *point_render_class;
 
   operation_class    = GEGL_OPERATION_CLASS (klass);
+  source_class       = GEGL_OPERATION_SOURCE_CLASS (klass);
   point_render_class = GEGL_OPERATION_POINT_RENDER_CLASS (klass);
 
   point_render_class->process       = gegl_color_op_process;
+  source_class->process             = gegl_color_op_source_process;
   operation_class->get_bounding_box = gegl_color_op_get_bounding_box;
   operation_class->prepare          = gegl_color_op_prepare;
 
@@ -17,24 +17,36 @@
 #define ANGLE_PRIME  95273 /* the lookuptables are sized as primes to ensure */
 #define RADIUS_PRIME 29537 /* as good as possible variation when using both */
 
+/* samples closer to the pixel than this are taken from the full resolution
+ * image in mipmap mode, the distance covered by each coarser level doubles
+ */
+#define ENVELOPES_MIPMAP_RADIUS 32
+#define ENVELOPES_MAX_LEVELS    8
+
+/* a sample position that falls outside the image or on a transparent pixel
+ * is replaced by the next one in the spray, up to this many times
+ */
+#define ENVELOPES_MAX_RETRIES   64
+
 static gfloat   lut_cos[ANGLE_PRIME];
 static gfloat   lut_sin[ANGLE_PRIME];
 static gfloat   radiuses[RADIUS_PRIME];
-static gdouble  luts_computed = 0.0;
-static gint     angle_no=0;
-static gint     radius_no=0;
 
+/* the lookup tables are shared by all threads, and only ever computed
+ * once; rgamma is the same for all users.
+ */
 static void compute_luts(gdouble rgamma)
 {
+  static gsize luts_computed = 0;
   gint i;
   GRand *rand;
   gfloat golden_angle = G_PI * (3-sqrt(5.0)); /* http://en.wikipedia.org/wiki/Golden_angle */
   gfloat angle = 0.0;
 
-  if (luts_computed==rgamma)
+  if (! g_once_init_enter (&luts_computed))
     return;
-  luts_computed = rgamma;
-  rand = g_rand_new();
+
+  rand = g_rand_new_with_seed (42);
 
   for (i=0;i<ANGLE_PRIME;i++)
     {
@@ -49,25 +61,147 @@ static void compute_luts(gdouble rgamma)
 
   g_rand_free(rand);
 
+  g_once_init_leave (&luts_computed, 1);
+}
+
+/* the pixels around a rectangle of output, at full resolution and, in
+ * mipmap mode, at successively halved resolutions for samples further
+ * away.
+ */
+typedef struct
+{
+  gfloat        *data;    /* RGBA float */
+  GeglRectangle  rect;    /* area of data, in the coordinates of the level */
+  GeglRectangle  extent;  /* the valid image area at this level */
+} EnvelopesLevel;
+
+typedef struct
+{
+  GeglRandom     *rand;
+  gint            n_levels;
+  EnvelopesLevel  levels[ENVELOPES_MAX_LEVELS];
+} Envelopes;
+
+/* scales @rect down by 2^@shift, covering all pixels it touches */
+static inline GeglRectangle
+envelopes_scale_rect (const GeglRectangle *rect,
+                      gint                 shift)
+{
+  gint          factor = 1 << shift;
+  gint          x0     = floor ((gdouble) rect->x / factor);
+  gint          y0     = floor ((gdouble) rect->y / factor);
+  gint          x1     = ceil ((gdouble) (rect->x + rect->width) / factor);
+  gint          y1     = ceil ((gdouble) (rect->y + rect->height) / factor);
+  GeglRectangle result = {x0, y0, x1 - x0, y1 - y0};
+
+  return result;
+}
+
+/* fetches what compute_envelopes() needs for the pixels of @roi of @src,
+ * @level is the level the operation is processing at.
+ */
+static void
+envelopes_init (Envelopes           *envelopes,
+                GeglBuffer          *src,
+                const GeglRectangle *roi,
+                gint                 radius,
+                gboolean             mipmap,
+                gint                 level)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglRectangle  extent;
+  gint           l;
+
+  /* per pixel sample positions, independent of the order pixels are
+   * processed in and of how the output is split up
+   */
+  envelopes->rand = gegl_random_new_with_seed (0);
+
+  extent = envelopes_scale_rect (gegl_buffer_get_extent (src), level);
+
+  envelopes->n_levels = 1;
+  if (mipmap)
+    while (envelopes->n_levels < ENVELOPES_MAX_LEVELS &&
+           (ENVELOPES_MIPMAP_RADIUS << (envelopes->n_levels - 1)) < radius)
+      envelopes->n_levels++;
+
+  for (l = 0; l < envelopes->n_levels; l++)
+    {
+      EnvelopesLevel *el    = &envelopes->levels[l];
+      gint            reach = radius;
+      GeglRectangle   rect;
+
+      /* the level is used for samples up to this far away */
+      if (l < envelopes->n_levels - 1)
+        reach = MIN (radius, ENVELOPES_MIPMAP_RADIUS << l);
+
+      rect.x      = roi->x - reach;
+      rect.y      = roi->y - reach;
+      rect.width  = roi->width + 2 * reach;
+      rect.height = roi->height + 2 * reach;
+
+      el->rect   = envelopes_scale_rect (&rect, l);
+      el->extent = envelopes_scale_rect (&extent, l);
+      el->data   = NULL;
+
+      /* a large radius reaches far beyond the image, where there is
+       * nothing to sample; a roi outside of it leaves nothing at all
+       */
+      if (! gegl_rectangle_intersect (&el->rect, &el->rect, &el->extent))
+        continue;
+
+      el->data = g_new (gfloat, el->rect.width * el->rect.height * 4);
+
+      gegl_buffer_get (src, &el->rect, 1.0 / (1 << (level + l)), format,
+                       el->data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+}
+
+static void
+envelopes_cleanup (Envelopes *envelopes)
+{
+  gint l;
+
+  for (l = 0; l < envelopes->n_levels; l++)
+    g_free (envelopes->levels[l].data);
+
+  gegl_random_free (envelopes->rand);
+}
+
+/* returns the pixel at @x, @y of @level, or NULL if it is not within the
+ * image
+ */
+static inline const gfloat *
+envelopes_get_pixel (const Envelopes *envelopes,
+                     gint             level,
+                     gint             x,
+                     gint             y)
+{
+  const EnvelopesLevel *el = &envelopes->levels[level];
+
+  if (x <  el->extent.x || x >= el->extent.x + el->extent.width  ||
+      y <  el->extent.y || y >= el->extent.y + el->extent.height ||
+      x <  el->rect.x   || x >= el->rect.x   + el->rect.width    ||
+      y <  el->rect.y   || y >= el->rect.y   + el->rect.height)
+    return NULL;
+
+  return el->data + ((y - el->rect.y) * el->rect.width + (x - el->rect.x)) * 4;
 }
 
 static inline void
-sample_min_max (GeglBuffer  *buffer,
-                GeglSampler *sampler,
-                gint         x,
-                gint         y,
-                gint         radius,
-                gint         samples,
-                gfloat      *min,
-                gfloat      *max,
-                gfloat      *pixel,
-                const Babl  *format)
+sample_min_max (const Envelopes *envelopes,
+                gint             x,
+                gint             y,
+                gint             radius,
+                gint             samples,
+                gint            *angle_no,
+                gint            *radius_no,
+                gfloat          *min,
+                gfloat          *max,
+                gfloat          *pixel)
 {
   gfloat best_min[3];
   gfloat best_max[3];
-  gint width = gegl_buffer_get_width (buffer);
-  gint height = gegl_buffer_get_height (buffer);
-  
   gint i, c;
 
   for (c=0;c<3;c++)
@@ -78,51 +212,52 @@ sample_min_max (GeglBuffer  *buffer,
 
   for (i=0; i<samples; i++)
     {
-      gint u, v;
-      gint angle;
-      gfloat rmag;
-retry:                      /* if we've sampled outside the valid image
-                               area, we grab another sample instead, this
-                               should potentially work better than mirroring
-                               or extending the image
-                             */
-      angle = angle_no++;
-      rmag = radiuses[radius_no++] * radius;
-
-      if (angle_no>=ANGLE_PRIME)
-        angle_no=0;
-      if (radius_no>=RADIUS_PRIME)
-        radius_no=0;
-
-      u = x + rmag * lut_cos[angle];
-      v = y + rmag * lut_sin[angle];
-
-      if (u>=width ||
-          u<0 ||
-          v>=height ||
-          v<0)
-        goto retry;
+      gint retries;
 
-      {
-        gfloat pixel[4];
-        gegl_sampler_get (sampler, u, v, NULL, (void*)(&pixel[0]), GEGL_ABYSS_CLAMP);
-
-        if (pixel[3]>0.0) /* ignore fully transparent pixels */
-          {
-            for (c=0;c<3;c++)
-              {
-                if (pixel[c]<best_min[c])
-                  best_min[c]=pixel[c];
-
-                if (pixel[c]>best_max[c])
-                  best_max[c]=pixel[c];
-              }
-          }
-        else
-          {
-            goto retry;
-          }
-      }
+      /* if we've sampled outside the valid image area, we grab another
+       * sample instead, this should potentially work better than mirroring
+       * or extending the image
+       */
+      for (retries = 0; retries < ENVELOPES_MAX_RETRIES; retries++)
+        {
+          const gfloat *sample;
+          gint          angle;
+          gfloat        rmag;
+          gint          level = 0;
+          gfloat        u, v;
+
+          angle = (*angle_no)++;
+          rmag = radiuses[(*radius_no)++] * radius;
+
+          if (*angle_no>=ANGLE_PRIME)
+            *angle_no=0;
+          if (*radius_no>=RADIUS_PRIME)
+            *radius_no=0;
+
+          u = x + rmag * lut_cos[angle];
+          v = y + rmag * lut_sin[angle];
+
+          while (level < envelopes->n_levels - 1 &&
+                 rmag >= (ENVELOPES_MIPMAP_RADIUS << level))
+            level++;
+
+          sample = envelopes_get_pixel (envelopes, level,
+                                        floorf (u / (1 << level)),
+                                        floorf (v / (1 << level)));
+
+          if (sample && sample[3]>0.0) /* ignore fully transparent pixels */
+            {
+              for (c=0;c<3;c++)
+                {
+                  if (sample[c]<best_min[c])
+                    best_min[c]=sample[c];
+
+                  if (sample[c]>best_max[c])
+                    best_max[c]=sample[c];
+                }
+              break;
+            }
+        }
     }
   for (c=0;c<3;c++)
     {
@@ -131,8 +266,11 @@ retry:                      /* if we've sampled outside the valid image
     }
 }
 
-static inline void compute_envelopes (GeglBuffer *buffer,
-                                      GeglSampler *sampler,
+/* computes the envelopes of the pixel @x, @y, which must be within the
+ * rectangle @envelopes was initialized for; the result only depends on
+ * the position of the pixel, not on the order pixels are computed in.
+ */
+static inline void compute_envelopes (const Envelopes *envelopes,
                                       gint     x,
                                       gint     y,
                                       gint     radius,
@@ -142,35 +280,42 @@ static inline void compute_envelopes (GeglBuffer *buffer,
                                       gdouble  rgamma,
                                       gfloat  *min_envelope,
                                       gfloat  *max_envelope,
-                                      gfloat  *pixel,
-                                      const Babl *format)
+                                      gfloat  *pixel)
 {
   gint    i;
   gint    c;
+  gint    angle_no  = 0;
+  gint    radius_no = 0;
   gfloat  range_sum[4]               = {0,0,0,0};
   gfloat  relative_brightness_sum[4] = {0,0,0,0};
+  const gfloat *center = envelopes_get_pixel (envelopes, 0, x, y);
 
-  gegl_sampler_get (sampler, x, y, NULL, (void*)(&pixel[0]), GEGL_ABYSS_CLAMP);
+  if (center)
+    memcpy (pixel, center, 4 * sizeof (gfloat));
+  else
+    memset (pixel, 0, 4 * sizeof (gfloat));
 
   /* compute lookuptables for the gamma, currently not used/exposed
    * as a tweakable property */
   compute_luts(rgamma);
 
-  if (same_spray)
+  if (! same_spray)
     {
-      angle_no = 0;
-      radius_no = 0;
+      angle_no  = gegl_random_int_range (envelopes->rand, x, y, 0, 0,
+                                         0, ANGLE_PRIME);
+      radius_no = gegl_random_int_range (envelopes->rand, x, y, 0, 1,
+                                         0, RADIUS_PRIME);
     }
 
   for (i=0;i<iterations;i++)
     {
       gfloat min[3], max[3];
 
-      sample_min_max (buffer,
-                      sampler,
+      sample_min_max (envelopes,
                       x, y,
                       radius, samples,
-                      min, max, pixel, format);
+                      &angle_no, &radius_no,
+                      min, max, pixel);
 
       for (c=0;c<3;c++)
         {
@@ -196,7 +341,7 @@ static inline void compute_envelopes (GeglBuffer *buffer,
       {
         gfloat relative_brightness = relative_brightness_sum[c] / iterations;
         gfloat range               = range_sum[c] / iterations;
-        
+
         if (max_envelope)
           max_envelope[c] = pixel[c] + (1.0 - relative_brightness) * range;
         if (min_envelope)
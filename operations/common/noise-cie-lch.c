@@ -186,6 +186,7 @@ gegl_op_class_init (GeglOpClass *klass)
 
   operation_class->prepare    = prepare;
   point_filter_class->process = process;
+  point_filter_class->position_dependent = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "gegl:noise-cie-lch",
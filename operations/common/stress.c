@@ -41,6 +41,9 @@ property_int (iterations, _("Iterations"), 5)
     value_range (1, 1000)
     ui_range    (1, 30)
 
+property_boolean (mipmap, _("Mipmap sampling"), FALSE)
+    description(_("Take samples far from the pixel from lower resolution versions of the image, faster with large radii at some loss of precision"))
+
 /*
 
 property_double (rgamma, _("Radial Gamma"), 0.0, 8.0, 2.0,
@@ -62,6 +65,7 @@ property_double (rgamma, _("Radial Gamma"), 0.0, 8.0, 2.0,
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "envelopes.h"
 
 static void stress (GeglBuffer          *src,
@@ -71,16 +75,17 @@ static void stress (GeglBuffer          *src,
                     gint                 radius,
                     gint                 samples,
                     gint                 iterations,
+                    gboolean             mipmap,
                     gdouble              rgamma,
                     gint                 level)
 {
-  const Babl *format = babl_format ("RGBA float");
-
   if (dst_rect->width > 0 && dst_rect->height > 0)
   {
     GeglBufferIterator *i = gegl_buffer_iterator_new (dst, dst_rect, 0, babl_format("RaGaBaA float"),
                                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
-    GeglSampler *sampler = gegl_buffer_sampler_new_at_level (src, format, GEGL_SAMPLER_NEAREST, level);
+    Envelopes envelopes;
+
+    envelopes_init (&envelopes, src, dst_rect, radius, mipmap, level);
 
     while (gegl_buffer_iterator_next (i))
     {
@@ -96,13 +101,13 @@ static void stress (GeglBuffer          *src,
               gfloat  max[4];
               gfloat  pixel[4];
 
-              compute_envelopes (src, sampler,
+              compute_envelopes (&envelopes,
                                  x, y,
                                  radius, samples,
                                  iterations,
                                  FALSE, /* same spray */
                                  rgamma,
-                                 min, max, pixel, format);
+                                 min, max, pixel);
               {
                 /* this should be replaced with a better/faster projection of
                  * pixel onto the vector spanned by min -> max, currently
@@ -131,7 +136,7 @@ static void stress (GeglBuffer          *src,
             }
           }
     }
-    g_object_unref (sampler);
+    envelopes_cleanup (&envelopes);
   }
 }
 
@@ -171,6 +176,7 @@ process (GeglOperation       *operation,
           o->radius,
           o->samples,
           o->iterations,
+          o->mipmap,
           RGAMMA /*o->rgamma,*/, level);
 
   return  TRUE;
@@ -209,6 +215,8 @@ gegl_op_class_init (GeglOpClass *klass)
    * yielding correct edge behavior.
    */
   operation_class->get_bounding_box = get_bounding_box;
+  /* the samples only depend on the position of the pixel */
+  operation_class->threaded         = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
     "name",                  "gegl:stress",
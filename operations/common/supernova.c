@@ -334,6 +334,7 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->opencl_support = FALSE;
 
   filter_class->process    = process;
+  filter_class->position_dependent = TRUE;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "gegl:supernova",
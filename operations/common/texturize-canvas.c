@@ -4370,6 +4370,7 @@ gegl_op_class_init (GeglOpClass *klass)
   point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
 
   point_filter_class->process = process;
+  point_filter_class->position_dependent = TRUE;
   point_filter_class->cl_process = cl_process;
   operation_class->prepare = prepare;
 
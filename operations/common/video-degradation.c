@@ -311,6 +311,7 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->prepare = prepare;
 
   filter_class->process    = process;
+  filter_class->position_dependent = TRUE;
   filter_class->cl_process = cl_process;
 
   gegl_operation_class_set_keys (operation_class,
@@ -373,6 +373,7 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->opencl_support = TRUE;
 
   point_filter_class->process    = process;
+  point_filter_class->position_dependent = TRUE;
   point_filter_class->cl_process = cl_process;
 
   gegl_operation_class_set_keys (operation_class,
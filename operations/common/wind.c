@@ -82,32 +82,37 @@ typedef struct ThreadData
   GeglOperation            *operation;
   GeglBuffer               *input;
   GeglBuffer               *output;
-  gint                     *pending;
   gint                      level;
   gboolean                  success;
+  gboolean                  horizontal;
+  gint                      n_tasks;
   GeglRectangle             roi;
 } ThreadData;
 
+/* the wind streaks run along the wind direction, so the result is split in
+ * bands across it.
+ */
 static void
-thread_process (gpointer thread_data, gpointer unused)
+thread_process (gint     j,
+                gpointer thread_data)
 {
-  ThreadData *data = thread_data;
-  if (!data->klass->process (data->operation,
-                       data->input, data->output, &data->roi, data->level))
-    data->success = FALSE;
-  g_atomic_int_add (data->pending, -1);
-}
+  ThreadData    *data = thread_data;
+  GeglRectangle  roi  = data->roi;
 
-static GThreadPool *
-thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
+  if (data->horizontal)
     {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads (),
-                                 FALSE, NULL);
+      roi.y      = data->roi.y + data->roi.height * j / data->n_tasks;
+      roi.height = data->roi.y + data->roi.height * (j + 1) / data->n_tasks - roi.y;
     }
-  return pool;
+  else
+    {
+      roi.x     = data->roi.x + data->roi.width * j / data->n_tasks;
+      roi.width = data->roi.x + data->roi.width * (j + 1) / data->n_tasks - roi.x;
+    }
+
+  if (!data->klass->process (data->operation,
+                       data->input, data->output, &roi, data->level))
+    data->success = FALSE;
 }
 
 static void
@@ -469,54 +474,23 @@ operation_process (GeglOperation        *operation,
 
   if (gegl_operation_use_threading (operation, result))
   {
-    gint threads = gegl_config_threads ();
-    GThreadPool *pool = thread_pool ();
-    ThreadData thread_data[GEGL_MAX_THREADS];
-    gint pending = threads;
-
-    if (o->direction == GEGL_WIND_DIRECTION_LEFT ||
-        o->direction == GEGL_WIND_DIRECTION_RIGHT)
-    {
-      gint bit = result->height / threads;
-      for (gint j = 0; j < threads; j++)
-      {
-        thread_data[j].roi.x = result->x;
-        thread_data[j].roi.width = result->width;
-        thread_data[j].roi.y = result->y + bit * j;
-        thread_data[j].roi.height = bit;
-      }
-      thread_data[threads-1].roi.height = result->height - (bit * (threads-1));
-    }
-    else
-    {
-      gint bit = result->width / threads;
-      for (gint j = 0; j < threads; j++)
-      {
-        thread_data[j].roi.y = result->y;
-        thread_data[j].roi.height = result->height;
-        thread_data[j].roi.x = result->x + bit * j;
-        thread_data[j].roi.width = bit;
-      }
-      thread_data[threads-1].roi.width = result->width - (bit * (threads-1));
-    }
-    for (gint i = 0; i < threads; i++)
-    {
-      thread_data[i].klass = klass;
-      thread_data[i].operation = operation;
-      thread_data[i].input = input;
-      thread_data[i].output = output;
-      thread_data[i].pending = &pending;
-      thread_data[i].level = level;
-      thread_data[i].success = TRUE;
-    }
-
-    for (gint i = 1; i < threads; i++)
-      g_thread_pool_push (pool, &thread_data[i], NULL);
-    thread_process (&thread_data[0], NULL);
+    ThreadData data;
+
+    data.klass      = klass;
+    data.operation  = operation;
+    data.input      = input;
+    data.output     = output;
+    data.level      = level;
+    data.success    = TRUE;
+    data.roi        = *result;
+    data.horizontal = (o->direction == GEGL_WIND_DIRECTION_LEFT ||
+                       o->direction == GEGL_WIND_DIRECTION_RIGHT);
+    data.n_tasks    = MIN (data.horizontal ? result->height : result->width,
+                           gegl_config_threads () * GEGL_PARALLEL_TASKS_PER_THREAD);
 
-    while (g_atomic_int_get (&pending)) {};
+    gegl_parallel_for (data.n_tasks, thread_process, &data);
 
-    success = thread_data[0].success;
+    success = data.success;
   }
   else
   {
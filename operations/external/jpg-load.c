@@ -212,6 +212,8 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
                                  gint         dest_y)
 {
   gint row_stride;
+  gint strip_height;
+  gint i;
   struct jpeg_decompress_struct  cinfo;
   struct jpeg_error_mgr          jerr;
   struct jpeg_source_mgr         src;
@@ -250,14 +252,25 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
   if ((row_stride) % 2)
     (row_stride)++;
 
+  /* rows are decoded a strip of tile rows at a time, and each strip is
+   * written to the buffer at once
+   */
+  g_object_get (gegl_buffer, "tile-height", &strip_height, NULL);
+  strip_height = MIN (MAX (strip_height, 1), (gint) cinfo.output_height);
+
   /* allocated with the jpeg library, and freed with the decompress context */
-  buffer = (*cinfo.mem->alloc_sarray)
-    ((j_common_ptr) &cinfo, JPOOL_IMAGE, row_stride, 1);
+  buffer = (*cinfo.mem->alloc_small)
+    ((j_common_ptr) &cinfo, JPOOL_IMAGE, strip_height * sizeof (JSAMPROW));
+  buffer[0] = (*cinfo.mem->alloc_large)
+    ((j_common_ptr) &cinfo, JPOOL_IMAGE, (size_t) row_stride * strip_height);
+
+  for (i = 1; i < strip_height; i++)
+    buffer[i] = buffer[0] + (size_t) i * row_stride;
 
   write_rect.x = dest_x;
   write_rect.y = dest_y;
   write_rect.width  = cinfo.output_width;
-  write_rect.height = 1;
+  write_rect.height = 0;
 
   // Most CMYK JPEG files are produced by Adobe Photoshop. Each component is stored where 0 means 100% ink
   // However this might not be case for all. Gory details: https://bugzilla.mozilla.org/show_bug.cgi?id=674619
@@ -265,19 +278,27 @@ gegl_jpg_load_buffer_import_jpg (GeglBuffer  *gegl_buffer,
 
   while (cinfo.output_scanline < cinfo.output_height)
     {
-      jpeg_read_scanlines (&cinfo, buffer, 1);
+      gint n_rows = 0;
+
+      /* the decoder hands out a few rows at a time */
+      while (n_rows < strip_height &&
+             cinfo.output_scanline < cinfo.output_height)
+        n_rows += jpeg_read_scanlines (&cinfo, buffer + n_rows,
+                                       strip_height - n_rows);
 
       if (is_inverted_cmyk) {
-        for (int i=0; i<row_stride; i++) {
+        for (i=0; i<row_stride * n_rows; i++) {
             buffer[0][i] = 255-buffer[0][i];
         }
       }
 
+      write_rect.height = n_rows;
+
       gegl_buffer_set (gegl_buffer, &write_rect, 0,
                        format, buffer[0],
-                       GEGL_AUTO_ROWSTRIDE);
+                       row_stride);
 
-      write_rect.y += 1;
+      write_rect.y += n_rows;
     }
 
   jpeg_destroy_decompress (&cinfo);
@@ -171,16 +171,18 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
   gint           bit_depth;
   gint           bpp;
   gint           number_of_passes=1;
+  gint           strip_height;
   png_uint_32    w;
   png_uint_32    h;
   png_structp    load_png_ptr;
   png_infop      load_info_ptr;
-  guchar        *pixels;
+  /* volatile, they are set after the setjmp and freed after a longjmp */
+  guchar        *volatile pixels = NULL;
   /*png_bytep     *rows;*/
 
 
   unsigned   int i;
-  png_bytep  *row_p = NULL;
+  png_bytep  *volatile row_p = NULL;
 
   g_return_val_if_fail(stream, -1);
 
@@ -206,8 +208,8 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
   if (setjmp (png_jmpbuf (load_png_ptr)))
     {
       png_destroy_read_struct (&load_png_ptr, &load_info_ptr, NULL);
-     if (row_p)
-        g_free (row_p);
+      g_free (row_p);
+      g_free (pixels);
       return -1;
     }
 
@@ -301,7 +303,17 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
     png_read_update_info (load_png_ptr, load_info_ptr);
   }
 
-  pixels = g_malloc0 (width*bpp);
+  /* rows are decoded a strip of tile rows at a time, and each strip is
+   * written to the buffer at once
+   */
+  g_object_get (gegl_buffer, "tile-height", &strip_height, NULL);
+  strip_height = MIN (MAX (strip_height, 1), h);
+
+  pixels = g_malloc0 ((gsize) width * bpp * strip_height);
+  row_p  = g_new (png_bytep, strip_height);
+
+  for (i = 0; i < strip_height; i++)
+    row_p[i] = pixels + (gsize) i * width * bpp;
 
   {
     gint           pass;
@@ -309,16 +321,18 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
 
     for (pass=0; pass<number_of_passes; pass++)
       {
-        for(i=0; i<h; i++)
+        for(i=0; i<h; i+=rect.height)
           {
-            gegl_rectangle_set (&rect, 0, i, width, 1);
+            gegl_rectangle_set (&rect, 0, i, width, MIN (strip_height, h - i));
 
+            /* the later passes of an interlaced image fill in the rows of
+             * the earlier ones */
             if (pass != 0)
-              gegl_buffer_get (gegl_buffer, &rect, 1.0, format, pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+              gegl_buffer_get (gegl_buffer, &rect, 1.0, format, pixels, width * bpp, GEGL_ABYSS_NONE);
 
-            png_read_rows (load_png_ptr, &pixels, NULL, 1);
+            png_read_rows (load_png_ptr, row_p, NULL, rect.height);
             gegl_buffer_set (gegl_buffer, &rect, 0, format, pixels,
-                             GEGL_AUTO_ROWSTRIDE);
+                             width * bpp);
           }
       }
   }
@@ -327,6 +341,7 @@ gegl_buffer_import_png (GeglBuffer  *gegl_buffer,
   png_read_end (load_png_ptr, NULL);
   png_destroy_read_struct (&load_png_ptr, &load_info_ptr, NULL);
 
+  g_free (row_p);
   g_free (pixels);
 
   return 0;
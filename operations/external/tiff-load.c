@@ -505,49 +505,77 @@ query_tiff(GeglOperation *operation)
   return 0;
 }
 
+/* scanlines are read a strip of tile rows at a time, and each strip is
+ * written to the output at once
+ */
+static gint
+get_strip_height(GeglBuffer *output,
+                 gint        height)
+{
+  gint strip_height;
+
+  g_object_get(output, "tile-height", &strip_height, NULL);
+
+  return MIN(MAX(strip_height, 1), MAX(height, 1));
+}
+
 static gint
 load_RGBA(GeglOperation *operation,
           GeglBuffer    *output)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   Priv *p = (Priv*) o->user_data;
+  GeglRectangle rect = { 0, 0, p->width, p->height };
   guint32 *buffer;
-  gint row;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
-  buffer = g_try_new(guint32, p->width * p->height * sizeof(guint32));
+  buffer = g_try_new(guint32, (gsize) p->width * p->height);
 
   g_assert(buffer != NULL);
 
-  if (!TIFFReadRGBAImage(p->tiff, p->width, p->height, buffer, 0))
+  /* top to bottom, so that the whole image goes in with one set */
+  if (!TIFFReadRGBAImageOriented(p->tiff, p->width, p->height, buffer,
+                                 ORIENTATION_TOPLEFT, 0))
     {
       g_message("unsupported layout, RGBA loader failed");
       g_free(buffer);
       return -1;
     }
 
-  for (row = 0; row < p->height; row++)
-    {
-      GeglRectangle line = { 0, p->height - row - 1, p->width, 1 };
 #if G_BYTE_ORDER != G_LITTLE_ENDIAN
-      guint row_start = row * p->width;
-      guint row_end = row * p->width + p->width;
-      guint i;
+  {
+    gsize i;
 
-      for (i = row_start; i < row_end; i++)
-        buffer[i] = GUINT32_TO_LE(buffer[i]);
+    for (i = 0; i < (gsize) p->width * p->height; i++)
+      buffer[i] = GUINT32_TO_LE(buffer[i]);
+  }
 #endif
 
-      gegl_buffer_set(output, &line, 0, p->format,
-                      ((guchar *) buffer) + (row * p->width * 4),
-                      GEGL_AUTO_ROWSTRIDE);
-    }
+  gegl_buffer_set(output, &rect, 0, p->format,
+                  (guchar *) buffer, p->width * 4);
 
   g_free(buffer);
   return 0;
 }
 
+/* reads @rows scanlines starting at @y of @sample into @buffer,
+ * @rowstride apart
+ */
+static void
+read_strip(TIFF   *tiff,
+           guchar *buffer,
+           gint    rowstride,
+           gint    y,
+           gint    rows,
+           gint    sample)
+{
+  gint row;
+
+  for (row = 0; row < rows; row++)
+    TIFFReadScanline(tiff, buffer + (gsize) row * rowstride, y + row, sample);
+}
+
 static gint
 load_contiguous(GeglOperation *operation,
                 GeglBuffer    *output)
@@ -556,13 +584,19 @@ load_contiguous(GeglOperation *operation,
   Priv *p = (Priv*) o->user_data;
   guint32 tile_width = (guint32) p->width;
   guint32 tile_height = 1;
+  gint rowstride = GEGL_AUTO_ROWSTRIDE;
   guchar *buffer;
   gint x, y;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
   if (!TIFFIsTiled(p->tiff))
-      buffer = g_try_new(guchar, TIFFScanlineSize(p->tiff));
+    {
+      tile_height = get_strip_height(output, p->height);
+      rowstride = TIFFScanlineSize(p->tiff);
+
+      buffer = g_try_new(guchar, (gsize) rowstride * tile_height);
+    }
   else
     {
       TIFFGetField(p->tiff, TIFFTAG_TILEWIDTH, &tile_width);
@@ -582,11 +616,14 @@ load_contiguous(GeglOperation *operation,
           if (TIFFIsTiled(p->tiff))
             TIFFReadTile(p->tiff, buffer, x, y, 0, 0);
           else
-            TIFFReadScanline(p->tiff, buffer, y, 0);
+            {
+              tile.height = MIN(tile_height, p->height - y);
+              read_strip(p->tiff, buffer, rowstride, y, tile.height, 0);
+            }
 
           gegl_buffer_set(output, &tile, 0, p->format,
                           (guchar *) buffer,
-                          GEGL_AUTO_ROWSTRIDE);
+                          rowstride);
         }
     }
 
@@ -604,13 +641,19 @@ load_separated(GeglOperation *operation,
   guint32 tile_height = 1;
   gint output_bytes_per_pixel;
   gint nb_components, offset = 0;
+  gint rowstride = GEGL_AUTO_ROWSTRIDE;
   guchar *buffer;
   gint i;
 
   g_return_val_if_fail(p->tiff != NULL, -1);
 
   if (!TIFFIsTiled(p->tiff))
-    buffer = g_try_new(guchar, TIFFScanlineSize(p->tiff));
+    {
+      tile_height = get_strip_height(output, p->height);
+      rowstride = TIFFScanlineSize(p->tiff);
+
+      buffer = g_try_new(guchar, (gsize) rowstride * tile_height);
+    }
   else
     {
       TIFFGetField(p->tiff, TIFFTAG_TILEWIDTH, &tile_width);
@@ -649,11 +692,16 @@ load_separated(GeglOperation *operation,
               if (TIFFIsTiled(p->tiff))
                 TIFFReadTile(p->tiff, buffer, x, y, 0, i);
               else
-                TIFFReadScanline(p->tiff, buffer, y, i);
+                {
+                  output_tile.height = MIN(tile_height, p->height - y);
+                  plane_tile.height = output_tile.height;
+                  read_strip(p->tiff, buffer, rowstride, y,
+                             plane_tile.height, i);
+                }
 
               linear = gegl_buffer_linear_new_from_data(buffer, plane_format,
                                                         &plane_tile,
-                                                        GEGL_AUTO_ROWSTRIDE,
+                                                        rowstride,
                                                         NULL, NULL);
 
               iterator = gegl_buffer_iterator_new(linear, &plane_tile,
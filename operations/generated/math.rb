@@ -1,6 +1,8 @@
 #!/usr/bin/env ruby
 # -*- coding: utf-8 -*-
 
+require_relative 'simd'
+
 copyright = '
 /* !!!! AUTOGENERATED FILE generated by math.rb !!!!!
  *
@@ -47,6 +49,7 @@ a.each do
     capitalized = name.capitalize
     swapcased   = name.swapcase
     formula     = item[1]
+    simd        = simd_vectorizable? formula
 
     file.write copyright
     file.write "
@@ -66,7 +69,10 @@ property_double (value, _(\"Value\"), #{item[2]})
 #define GEGL_OP_C_FILE       \"#{filename}\"
 
 #include \"gegl-op.h\"
-
+"
+    file.write "#include \"simd.h\"
+" if simd
+    file.write "
 #include <math.h>
 #ifdef _MSC_VER
 #define powf(a,b) ((gfloat)pow(a,b))
@@ -81,7 +87,40 @@ static void prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, \"aux\", babl_format (\"RGB float\"));
   gegl_operation_set_format (operation, \"output\", format);
 }
-
+"
+    if simd
+      file.write simd_kernels('process_value',
+                              ['const gfloat *in',
+                               'gfloat        value',
+                               'gfloat       *out',
+                               'glong         n_pixels']) { |vf, vi, pixels, floats| "\
+      #{vf} input, result;
+
+      memcpy (&input, in + 4 * i, sizeof (input));
+      #{formula};
+      result = GEGL_SIMD_SELECT (alpha, input, result);
+      memcpy (out + 4 * i, &result, sizeof (result));" }
+
+      file.write simd_kernels('process_aux',
+                              ['const gfloat *in',
+                               'const gfloat *aux',
+                               'gfloat       *out',
+                               'glong         n_pixels']) { |vf, vi, pixels, floats| "\
+      const gfloat *a = aux + 3 * i;
+      #{vf} input, value, result;
+
+      memcpy (&input, in + 4 * i, sizeof (input));
+      value = (#{vf}) {#{(0...pixels).map { |p| "a[#{3 * p}], a[#{3 * p + 1}], a[#{3 * p + 2}], 0.0f" }.join(",\n" + ' ' * (vf.length + 18))}};
+      #{formula};
+      result = GEGL_SIMD_SELECT (alpha, input, result);
+      memcpy (out + 4 * i, &result, sizeof (result));" }
+
+      file.write "
+static glong (* process_value_simd) (const gfloat *, gfloat, gfloat *, glong);
+static glong (* process_aux_simd)   (const gfloat *, const gfloat *, gfloat *, glong);
+"
+    end
+    file.write "
 static gboolean
 process (GeglOperation       *op,
          void                *in_buf,
@@ -99,6 +138,10 @@ process (GeglOperation       *op,
   if (aux == NULL)
     {
       gfloat value = GEGL_PROPERTIES (op)->value;
+"
+    file.write "\n" + simd_call(6, 'process_value_simd', 'in, value, out, n_pixels',
+                                'in' => 4, 'out' => 4) if simd
+    file.write "\
       for (i=0; i<n_pixels; i++)
         {
           gint   j;
@@ -116,6 +159,10 @@ process (GeglOperation       *op,
     }
   else
     {
+"
+    file.write simd_call(6, 'process_aux_simd', 'in, aux, out, n_pixels',
+                         'in' => 4, 'aux' => 3, 'out' => 4) if simd
+    file.write "\
       for (i=0; i<n_pixels; i++)
         {
           gint   j;
@@ -149,7 +196,12 @@ gegl_op_class_init (GeglOpClass *klass)
 
   point_composer_class->process = process;
   operation_class->prepare = prepare;
-
+"
+    file.write "
+  process_value_simd = GEGL_SIMD_KERNEL (process_value);
+  process_aux_simd   = GEGL_SIMD_KERNEL (process_aux);
+" if simd
+    file.write "
   gegl_operation_class_set_keys (operation_class,
   \"name\"        , \"gegl:#{name}\",
   \"title\"       , \"#{name.capitalize}\",
@@ -0,0 +1,103 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_GENERATED_SIMD_H__
+#define __GEGL_GENERATED_SIMD_H__
+
+/* Helpers for the SIMD kernels the generators in this directory emit
+ * next to the scalar loops.  The kernels are written once with GCC vector
+ * extensions and compiled for each instruction set through the target
+ * attribute, so no special compiler flags are needed; which one runs is
+ * picked at class init from gegl_cpu_accel_get_support ().
+ *
+ * A vector holds one, two or four RGBA pixels, the kernels process whole
+ * vectors and return the number of pixels done, the scalar loop does the
+ * rest.
+ */
+
+#include <string.h>
+
+#include "gegl-cpuaccel.h"
+
+#if (defined (__x86_64__) || defined (__i386__)) &&                      \
+    (defined (__clang__) ||                                              \
+     (defined (__GNUC__) &&                                              \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define GEGL_SIMD_X86 1
+#endif
+
+#ifdef GEGL_SIMD_X86
+
+typedef gfloat gegl_v4sf  __attribute__ ((vector_size (16)));
+typedef gint32 gegl_v4si  __attribute__ ((vector_size (16)));
+typedef gfloat gegl_v8sf  __attribute__ ((vector_size (32)));
+typedef gint32 gegl_v8si  __attribute__ ((vector_size (32)));
+typedef gfloat gegl_v16sf __attribute__ ((vector_size (64)));
+typedef gint32 gegl_v16si __attribute__ ((vector_size (64)));
+
+#define GEGL_SIMD_TARGET(isa) __attribute__ ((target (isa)))
+
+/* the alpha of each pixel, in all four of its components */
+#ifdef __clang__
+#define GEGL_SIMD_ALPHA4(v)  __builtin_shufflevector ((v), (v), 3, 3, 3, 3)
+#define GEGL_SIMD_ALPHA8(v)  __builtin_shufflevector ((v), (v), 3, 3, 3, 3, \
+                                                      7, 7, 7, 7)
+#define GEGL_SIMD_ALPHA16(v) __builtin_shufflevector ((v), (v), 3, 3, 3, 3, \
+                                                      7, 7, 7, 7,           \
+                                                      11, 11, 11, 11,       \
+                                                      15, 15, 15, 15)
+#else
+#define GEGL_SIMD_ALPHA4(v)  __builtin_shuffle ((v), (gegl_v4si) {3, 3, 3, 3})
+#define GEGL_SIMD_ALPHA8(v)  __builtin_shuffle ((v), (gegl_v8si) {3, 3, 3, 3, \
+                                                                  7, 7, 7, 7})
+#define GEGL_SIMD_ALPHA16(v) __builtin_shuffle ((v), (gegl_v16si) {3, 3, 3, 3, \
+                                                                   7, 7, 7, 7, \
+                                                                   11, 11, 11, 11, \
+                                                                   15, 15, 15, 15})
+#endif
+
+/* @s, a scalar or a vector, as a vector of the type of @v */
+#define GEGL_SIMD_VEC(v, s) ((__typeof__ (v)) {0} + (s))
+
+/* the components of @a where @mask is set and of @b elsewhere */
+#define GEGL_SIMD_SELECT(mask, a, b)                                      \
+  ((__typeof__ (a)) (((mask) & (__typeof__ (mask)) (a)) |                 \
+                     (~(mask) & (__typeof__ (mask)) (b))))
+
+/* vector versions of MIN (), MAX () and CLAMP (), the first argument
+ * has to be a vector
+ */
+#define GEGL_SIMD_MIN(a, b)                                               \
+  GEGL_SIMD_SELECT ((a) < GEGL_SIMD_VEC (a, b), (a), GEGL_SIMD_VEC (a, b))
+#define GEGL_SIMD_MAX(a, b)                                               \
+  GEGL_SIMD_SELECT ((a) > GEGL_SIMD_VEC (a, b), (a), GEGL_SIMD_VEC (a, b))
+#define GEGL_SIMD_CLAMP(x, low, high)                                     \
+  GEGL_SIMD_MIN (GEGL_SIMD_MAX (x, low), high)
+
+/* the widest variant of kernel @name the CPU supports, or NULL */
+#define GEGL_SIMD_KERNEL(name)                                                  \
+  ((gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_AVX512F) ? name##_avx512 : \
+   (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_AVX2)    ? name##_avx2   : \
+   (gegl_cpu_accel_get_support () & GEGL_CPU_ACCEL_X86_SSE2)    ? name##_sse2   : \
+                                                                  NULL)
+
+#else
+
+#define GEGL_SIMD_KERNEL(name) NULL
+
+#endif
+
+#endif /* __GEGL_GENERATED_SIMD_H__ */
@@ -0,0 +1,82 @@
+# -*- coding: utf-8 -*-
+#
+# Shared by the generators in this directory, emits the SIMD kernels of
+# an operation, see simd.h.
+
+# instruction set suffix, target attribute, pixels per vector
+SIMD_VARIANTS = [
+  ['sse2',   'sse2',    1],
+  ['avx2',   'avx2',    2],
+  ['avx512', 'avx512f', 4]
+]
+
+# formulas with branches or calls stay scalar only
+def simd_vectorizable? (*formulas)
+  formulas.none? { |formula| formula =~ /\?|sqrt|pow/ }
+end
+
+# the vector form of a scalar formula
+def simd_formula (formula)
+  formula.gsub(/\bMIN\b/, 'GEGL_SIMD_MIN').
+          gsub(/\bMAX\b/, 'GEGL_SIMD_MAX').
+          gsub(/\bCLAMP\b/, 'GEGL_SIMD_CLAMP')
+end
+
+# emits a kernel called name_<suffix> for every variant, the block gets
+# the vector types, the pixels per vector and the floats per vector and
+# returns the body of the loop over the vectors, with i indexing the
+# first pixel of the vector.
+def simd_kernels (name, args)
+  code = "
+#ifdef GEGL_SIMD_X86
+"
+  SIMD_VARIANTS.each do
+    |suffix, target, pixels|
+
+    floats = pixels * 4
+    vf     = "gegl_v#{floats}sf"
+    vi     = "gegl_v#{floats}si"
+    mask   = (['0, 0, 0, -1'] * pixels).join(', ')
+    params = args.join(",\n" + ' ' * (name.length + suffix.length + 3))
+
+    code += "
+GEGL_SIMD_TARGET (\"#{target}\") static glong
+#{name}_#{suffix} (#{params})
+{
+  const #{vi} alpha = {#{mask}};
+  glong #{' ' * vi.length} i;
+
+  for (i = 0; i + #{pixels} <= n_pixels; i += #{pixels})
+    {
+#{yield vf, vi, pixels, floats}
+    }
+
+  return i;
+}
+"
+  end
+  code + "
+#endif
+"
+end
+
+# the call of a kernel from the scalar loop, which then continues past
+# the pixels the kernel did, strides holds the floats per pixel of each
+# buffer.
+def simd_call (indent, kernel, args, strides)
+  pad     = ' ' * indent
+  width   = strides.keys.map(&:length).push('n_pixels'.length).max
+  advance = strides.map { |buffer, stride|
+    "#{pad}    #{buffer.ljust(width)} += #{stride} * done;\n"
+  }.join
+
+  "\
+#{pad}if (#{kernel})
+#{pad}  {
+#{pad}    glong done = #{kernel} (#{args});
+
+#{advance}#{pad}    #{'n_pixels'.ljust(width)} -= done;
+#{pad}  }
+
+"
+end
@@ -1,6 +1,8 @@
 #!/usr/bin/env ruby
 # -*- coding: utf-8 -*-
 
+require_relative 'simd'
+
 copyright = '
 /* !!!! AUTOGENERATED FILE generated by svg-12-blend.rb !!!!!
  *
@@ -145,7 +147,9 @@ static gboolean operation_process (GeglOperation        *operation,
    */
   return operation_class->process (operation, context, output_prop, result, level);
 }
+'
 
+file_head3 = '
 static gboolean
 process (GeglOperation       *op,
          void                *in_buf,
@@ -188,6 +192,34 @@ file_tail2 = '  gegl_operation_class_set_key (operation_class, "categories", "co
 #endif
 '
 
+# the SIMD kernels of a blend, c_formula and a_formula are vector
+# expressions of cA, cB, aA and aB
+def simd_blend_kernels (c_formula, a_formula)
+  simd_kernels('process',
+               ['const gfloat *in',
+                'const gfloat *aux',
+                'gfloat       *out',
+                'glong         n_pixels']) { |vf, vi, pixels, floats| "\
+      #{vf} cA, cB, aA, aB, aD, cD;
+
+      memcpy (&cB, in + 4 * i, sizeof (cB));
+      memcpy (&cA, aux + 4 * i, sizeof (cA));
+      aB = GEGL_SIMD_ALPHA#{floats} (cB);
+      aA = GEGL_SIMD_ALPHA#{floats} (cA);
+      aD = #{a_formula};
+      cD = #{c_formula};
+      cD = GEGL_SIMD_SELECT (alpha, aD, cD);
+      memcpy (out + 4 * i, &cD, sizeof (cD));" } + "
+static glong (* process_simd) (const gfloat *, const gfloat *, gfloat *, glong);
+"
+end
+
+simd_blend_call = "\n" + simd_call(2, 'process_simd', 'in, aux, out, n_pixels',
+                                   'in' => 4, 'aux' => 4, 'out' => 4).chomp
+simd_blend_init = "
+  process_simd = GEGL_SIMD_KERNEL (process);
+"
+
 a.each do
     |item|
 
@@ -203,6 +235,7 @@ a.each do
     capitalized = name.capitalize
     swapcased   = name.swapcase
     formula1    = item[1]
+    simd        = simd_vectorizable? formula1
 
     file.write copyright
     file.write file_head1
@@ -212,7 +245,13 @@ a.each do
 
 #include \"gegl-op.h\"
 "
+    file.write "#include \"simd.h\"
+" if simd
     file.write file_head2
+    file.write simd_blend_kernels("GEGL_SIMD_CLAMP (#{simd_formula formula1}, 0, aD)",
+                                  'aA + aB - aA * aB') if simd
+    file.write file_head3
+    file.write simd_blend_call if simd
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -238,6 +277,7 @@ a.each do
     }
 "
   file.write file_tail1
+  file.write simd_blend_init if simd
   file.write "
   gegl_operation_class_set_keys (operation_class,
   \"name\"        , \"svg:#{name}\",
@@ -265,6 +305,7 @@ b.each do
     cond1       = item[1]
     formula1    = item[2]
     formula2    = item[3]
+    simd        = simd_vectorizable? cond1, formula1, formula2
 
     file.write copyright
     file.write file_head1
@@ -274,7 +315,15 @@ b.each do
 
 #include \"gegl-op.h\"
 "
+    file.write "#include \"simd.h\"
+" if simd
     file.write file_head2
+    file.write simd_blend_kernels("GEGL_SIMD_SELECT (#{cond1},
+                             GEGL_SIMD_CLAMP (#{simd_formula formula1}, 0, aD),
+                             GEGL_SIMD_CLAMP (#{simd_formula formula2}, 0, aD))",
+                                  'aA + aB - aA * aB') if simd
+    file.write file_head3
+    file.write simd_blend_call if simd
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -303,6 +352,7 @@ b.each do
     }
 "
   file.write file_tail1
+  file.write simd_blend_init if simd
   file.write "
   gegl_operation_class_set_keys (operation_class,
   \"name\"        , \"svg:#{name}\",
@@ -344,6 +394,7 @@ c.each do
 #include <math.h>
 "
     file.write file_head2
+    file.write file_head3
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -400,6 +451,7 @@ d.each do
     swapcased   = name.swapcase
     formula1    = item[1]
     formula2    = item[2]
+    simd        = simd_vectorizable? formula1, formula2
 
     file.write copyright
     file.write file_head1
@@ -409,7 +461,13 @@ d.each do
 
 #include \"gegl-op.h\"
 "
+    file.write "#include \"simd.h\"
+" if simd
     file.write file_head2
+    file.write simd_blend_kernels("GEGL_SIMD_CLAMP (#{simd_formula formula1}, 0, aD)",
+                                  simd_formula(formula2)) if simd
+    file.write file_head3
+    file.write simd_blend_call if simd
     file.write "
   for (i = 0; i < n_pixels; i++)
     {
@@ -435,6 +493,7 @@ d.each do
     }
 "
   file.write file_tail1
+  file.write simd_blend_init if simd
   file.write "
 
   gegl_operation_class_set_keys (operation_class,
@@ -1,6 +1,8 @@
 #!/usr/bin/env ruby
 # encoding: utf-8
 
+require_relative 'simd'
+
 copyright = '
 /* !!!! AUTOGENERATED FILE generated by svg-12-porter-duff.rb !!!!!
  *
@@ -100,7 +102,9 @@ static void prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, "aux", format);
   gegl_operation_set_format (operation, "output", format);
 }
+'
 
+file_head3 = '
 static gboolean
 process (GeglOperation        *op,
          void                *in_buf,
@@ -139,6 +143,37 @@ file_tail2 = '
 #endif
 '
 
+# the SIMD kernels of the aux path, constant formulas are widened to
+# vectors
+def simd_porter_duff_kernels (c_formula, a_formula)
+  c_formula, a_formula = [c_formula, a_formula].map { |formula|
+    formula =~ /\b[ca][AB]\b/ ? formula : "GEGL_SIMD_VEC (cB, #{formula})"
+  }
+
+  simd_kernels('process',
+               ['const gfloat *in',
+                'const gfloat *aux',
+                'gfloat       *out',
+                'glong         n_pixels']) { |vf, vi, pixels, floats| "\
+      #{vf} cA G_GNUC_UNUSED, cB G_GNUC_UNUSED, aA G_GNUC_UNUSED, aB G_GNUC_UNUSED;
+      #{vf} aD, cD;
+
+      memcpy (&cB, in + 4 * i, sizeof (cB));
+      memcpy (&cA, aux + 4 * i, sizeof (cA));
+      aB = GEGL_SIMD_ALPHA#{floats} (cB);
+      aA = GEGL_SIMD_ALPHA#{floats} (cA);
+      aD = #{a_formula};
+      cD = #{c_formula};
+      cD = GEGL_SIMD_SELECT (alpha, aD, cD);
+      memcpy (out + 4 * i, &cD, sizeof (cD));" } + "
+static glong (* process_simd) (const gfloat *, const gfloat *, gfloat *, glong);
+"
+end
+
+simd_porter_duff_init = "
+  process_simd = GEGL_SIMD_KERNEL (process);
+"
+
 a.each do
     |item|
 
@@ -153,6 +188,7 @@ a.each do
     swapcased   = name.swapcase
     c_formula   = item[1]
     a_formula   = item[2]
+    simd        = simd_vectorizable? c_formula, a_formula
 
     file.write copyright
     file.write file_head1
@@ -162,7 +198,11 @@ a.each do
 
 #include \"gegl-op.h\"
 "
+    file.write "#include \"simd.h\"
+" if simd
     file.write file_head2
+    file.write simd_porter_duff_kernels(c_formula, a_formula) if simd
+    file.write file_head3
 
     if item[3]
       file.write "
@@ -199,7 +239,10 @@ a.each do
     end
 
     file.write "
-    {
+    {"
+    file.write "\n" + simd_call(6, 'process_simd', 'in, aux, out, n_pixels',
+                                'in' => 4, 'aux' => 4, 'out' => 4).chomp if simd
+    file.write "
       for (i = 0; i < n_pixels; i++)
         {
           gint   j;
@@ -227,6 +270,7 @@ a.each do
 }
 "
   file.write file_tail1
+  file.write simd_porter_duff_init if simd
   file.write "
   gegl_operation_class_set_keys (operation_class,
     \"name\"       , \"svg:#{name}\",
@@ -259,6 +303,7 @@ b.each do
     swapcased   = name.swapcase
     c_formula   = item[1]
     a_formula   = item[2]
+    simd        = simd_vectorizable? c_formula, a_formula
 
     file.write copyright
     file.write file_head1
@@ -268,11 +313,18 @@ b.each do
 
 #include \"gegl-op.h\"
 "
+    file.write "#include \"simd.h\"
+" if simd
     file.write file_head2
+    file.write simd_porter_duff_kernels(c_formula, a_formula) if simd
+    file.write file_head3
     file.write "
   if (!aux)
     return TRUE;
-
+"
+    file.write "\n" + simd_call(2, 'process_simd', 'in, aux, out, n_pixels',
+                                'in' => 4, 'aux' => 4, 'out' => 4).chomp if simd
+    file.write "
   for (i = 0; i < n_pixels; i++)
     {
       gint   j;
@@ -307,6 +359,7 @@ static GeglRectangle get_bounding_box (GeglOperation *self)
 
 "
   file.write file_tail1
+  file.write simd_porter_duff_init if simd
   file.write "
   operation_class->get_bounding_box = get_bounding_box;
 
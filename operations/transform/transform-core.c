@@ -713,31 +713,22 @@ typedef struct ThreadData
   GeglOperation            *operation;
   GeglBuffer               *input;
   GeglBuffer               *output;
-  gint                     *pending;
   GeglMatrix3              *matrix;
   gint                      level;
-  gboolean                  success;
-  GeglRectangle             roi;
 } ThreadData;
 
-static void thread_process (gpointer thread_data, gpointer unused)
+static void thread_process (const GeglRectangle *roi, gpointer thread_data)
 {
   ThreadData *data = thread_data;
+  /* the transform functions render the extent of dest, hand each task a
+   * sub-buffer so they only render their own part of the result.
+   */
+  GeglBuffer *output = gegl_buffer_create_sub_buffer (data->output, roi);
+
   data->func (data->operation,
-                   data->output, data->input, data->matrix, data->level);
-    data->success = FALSE;
-  g_atomic_int_add (data->pending, -1);
-}
+              output, data->input, data->matrix, data->level);
 
-static GThreadPool *thread_pool (void)
-{
-  static GThreadPool *pool = NULL;
-  if (!pool)
-    {
-      pool =  g_thread_pool_new (thread_process, NULL, gegl_config_threads(),
-                                 FALSE, NULL);
-    }
-  return pool;
+  g_object_unref (output);
 }
 
 
@@ -1271,53 +1262,16 @@ gegl_transform_process (GeglOperation        *operation,
 
       if (gegl_operation_use_threading (operation, result))
       {
-        gint threads = gegl_config_threads ();
-        GThreadPool *pool = thread_pool ();
-        ThreadData thread_data[GEGL_MAX_THREADS];
-        gint pending = threads;
-
-        if (result->width > result->height)
-        {
-          gint bit = result->width / threads;
-          for (gint j = 0; j < threads; j++)
-          {
-            thread_data[j].roi.y = result->y;
-            thread_data[j].roi.height = result->height;
-            thread_data[j].roi.x = result->x + bit * j;
-            thread_data[j].roi.width = bit;
-          }
-          thread_data[threads-1].roi.width = result->width - (bit * (threads-1));
-        }
-        else
-        {
-          gint bit = result->height / threads;
-          for (gint j = 0; j < threads; j++)
-          {
-            thread_data[j].roi.x = result->x;
-            thread_data[j].roi.width = result->width;
-            thread_data[j].roi.y = result->y + bit * j;
-            thread_data[j].roi.height = bit;
-          }
-          thread_data[threads-1].roi.height = result->height - (bit * (threads-1));
-        }
-
-        for (gint i = 0; i < threads; i++)
-        {
-          thread_data[i].func = func;
-          thread_data[i].matrix = &matrix;
-          thread_data[i].operation = operation;
-          thread_data[i].input = input;
-          thread_data[i].output = output;
-          thread_data[i].pending = &pending;
-          thread_data[i].level = level;
-          thread_data[i].success = TRUE;
-        }
+        ThreadData data;
 
-        for (gint i = 1; i < threads; i++)
-          g_thread_pool_push (pool, &thread_data[i], NULL);
-        thread_process (&thread_data[0], NULL);
+        data.func      = func;
+        data.matrix    = &matrix;
+        data.operation = operation;
+        data.input     = input;
+        data.output    = output;
+        data.level     = level;
 
-        while (g_atomic_int_get (&pending)) {};
+        gegl_parallel_for_area (result, thread_process, &data);
       }
       else
       {
@@ -1413,6 +1413,7 @@ gegl_op_class_init (GeglOpClass *klass)
 
   gobject_class->finalize = finalize;
   point_filter_class->process = process;
+  point_filter_class->position_dependent = TRUE;
   operation_class->prepare = prepare;
 
   gegl_operation_class_set_keys (operation_class,
@@ -20,6 +20,7 @@
 #include "config.h"
 #include <glib/gi18n-lib.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef GEGL_PROPERTIES
 
@@ -34,179 +35,326 @@ property_int  (radius, _("Radius"), 3)
 
 #include "gegl-op.h"
 
-#define N_BINS  1024
+/* The median of every channel is found with the constant time algorithm
+ * of Perreault and Hébert, "Median Filtering in Constant Time": every
+ * column of the input keeps a histogram of the 2 * radius + 1 pixels
+ * above and below the current row, and the histogram of the window is
+ * moved along the row by adding one column histogram and removing one.
+ *
+ * The histograms have two levels, a coarse one counting groups of
+ * 1 << shift bins, and the fine one.  The median is looked up in the
+ * coarse histogram of the window first, and only the fine bins of that
+ * group are then brought up to date and searched.
+ *
+ * The output is processed in strips of rows, which are spread over the
+ * worker threads.
+ */
+
+#define N_BINS_U8     256   /* 16 coarse bins of 16 */
+#define SHIFT_U8      4
+#define N_BINS_FLOAT  1024  /* 32 coarse bins of 32 */
+#define SHIFT_FLOAT   5
 
 typedef struct
 {
-  gint       elems[3][N_BINS]; 
-  gint       count;
-  gint       xmin;
-  gint       ymin;
-  gint       xmax;
-  gint       ymax;
-} Histogram; 
-
-typedef enum
+  gint     radius;
+  gint     n_bins;
+  gint     shift;
+  gint     width;       /* the number of columns */
+  guint16 *col_coarse;  /* width * n_coarse */
+  guint16 *col_fine;    /* width * n_bins */
+  guint16 *coarse;      /* n_coarse, of the window */
+  guint16 *fine;        /* n_bins, of the window */
+  gint    *luc;         /* n_coarse, the column each fine group of the
+                         * window has last been updated up to
+                         */
+} Histogram;
+
+typedef struct
 {
-  LEFT_TO_RIGHT,
-  RIGHT_TO_LEFT,
-  TOP_TO_BOTTOM
-} Direction;
+  GeglBuffer    *input;
+  GeglBuffer    *output;
+  const Babl    *format;
+  GeglRectangle  roi;
+  gint           radius;
+  gint           strip;
+  gboolean       is_u8;
+} MedianData;
 
-static inline gfloat
-histogram_get_median (Histogram *hist, gint component)
+static void
+histogram_init (Histogram *hist,
+                gint       radius,
+                gint       n_bins,
+                gint       shift,
+                gint       width)
 {
-  gint count = hist->count;
-  gint i;
-  gint sum = 0;
+  gint n_coarse = n_bins >> shift;
+
+  hist->radius     = radius;
+  hist->n_bins     = n_bins;
+  hist->shift      = shift;
+  hist->width      = width;
+  hist->col_coarse = gegl_malloc (width * n_coarse * sizeof (guint16));
+  hist->col_fine   = gegl_malloc (width * n_bins * sizeof (guint16));
+  hist->coarse     = gegl_malloc (n_coarse * sizeof (guint16));
+  hist->fine       = gegl_malloc (n_bins * sizeof (guint16));
+  hist->luc        = gegl_malloc (n_coarse * sizeof (gint));
+}
 
-  count = (count + 1) / 2;
+static void
+histogram_cleanup (Histogram *hist)
+{
+  gegl_free (hist->col_coarse);
+  gegl_free (hist->col_fine);
+  gegl_free (hist->coarse);
+  gegl_free (hist->fine);
+  gegl_free (hist->luc);
+}
 
-  i = 0;
-  while ((sum += hist->elems[component][i]) < count)
-    i++;
+static void
+histogram_clear_columns (Histogram *hist)
+{
+  gint n_coarse = hist->n_bins >> hist->shift;
 
-  return (gfloat) i / (gfloat) N_BINS;
+  memset (hist->col_coarse, 0, hist->width * n_coarse * sizeof (guint16));
+  memset (hist->col_fine, 0, hist->width * hist->n_bins * sizeof (guint16));
 }
 
+/* adds the bins of a row of input to the column histograms, or removes
+ * them for a @delta of -1
+ */
 static inline void
-histogram_add_val (Histogram     *hist,
-                   const gfloat  *src,
-                   GeglRectangle *rect,
-                   gint           bpp,
-                   gint           x,
-                   gint           y)
+histogram_update_columns (Histogram     *hist,
+                          const guint16 *row,
+                          gint           delta)
 {
-  const gint pos = (x + y * rect->width) * bpp;
-  gint c;
+  gint n_coarse = hist->n_bins >> hist->shift;
+  gint x;
 
-  for (c = 0; c < 3; c++)
+  for (x = 0; x < hist->width; x++)
     {
-      gfloat value = *(src + pos + c);
-      gint idx     = (gint) (CLAMP (value, 0.0, 1.0) * (N_BINS - 1));
-      hist->elems[c][idx]++;
+      gint bin = row[x];
+
+      hist->col_coarse[x * n_coarse + (bin >> hist->shift)] += delta;
+      hist->col_fine[x * hist->n_bins + bin]                += delta;
     }
-  hist->count++;
 }
 
-static inline void
-histogram_del_val (Histogram     *hist,
-                   const gfloat  *src,
-                   GeglRectangle *rect,
-                   gint           bpp,
-                   gint           x,
-                   gint           y)
+/* computes the median bins of a row of @width pixels from the column
+ * histograms, which must hold the rows around it
+ */
+static void
+histogram_median_row (Histogram *hist,
+                      guint16   *medians,
+                      gint       width)
 {
-  const gint pos = (x + y * rect->width) * bpp;
-  gint c;
+  const gint diameter = 2 * hist->radius + 1;
+  const gint half     = (diameter * diameter + 1) / 2;
+  const gint n_coarse = hist->n_bins >> hist->shift;
+  const gint n_fine   = 1 << hist->shift;
+  gint       x, i, k;
 
-  for (c = 0; c < 3; c++)
+  memset (hist->coarse, 0, n_coarse * sizeof (guint16));
+
+  for (k = 0; k < n_coarse; k++)
+    hist->luc[k] = 0;
+
+  for (i = 0; i < diameter; i++)
+    for (k = 0; k < n_coarse; k++)
+      hist->coarse[k] += hist->col_coarse[i * n_coarse + k];
+
+  for (x = 0; x < width; x++)
     {
-      gfloat value = *(src + pos + c);
-      gint idx     = (gint) (CLAMP (value, 0.0, 1.0) * (N_BINS - 1));
-      hist->elems[c][idx]--;
+      guint16 *fine;
+      gint     sum = 0;
+      gint     bin = 0;
+
+      if (x > 0)
+        {
+          const guint16 *del = hist->col_coarse + (x - 1) * n_coarse;
+          const guint16 *add = hist->col_coarse + (x + diameter - 1) * n_coarse;
+
+          for (k = 0; k < n_coarse; k++)
+            hist->coarse[k] += add[k] - del[k];
+        }
+
+      k = 0;
+      while (sum + hist->coarse[k] < half)
+        sum += hist->coarse[k++];
+
+      /* brings the fine bins of group k up to date with the window, from
+       * scratch if none of the columns they were last computed for are
+       * still within it
+       */
+      fine = hist->fine + k * n_fine;
+
+      if (hist->luc[k] <= x)
+        {
+          memset (fine, 0, n_fine * sizeof (guint16));
+
+          for (i = x; i < x + diameter; i++)
+            {
+              const guint16 *col = hist->col_fine + i * hist->n_bins + k * n_fine;
+
+              for (bin = 0; bin < n_fine; bin++)
+                fine[bin] += col[bin];
+            }
+        }
+      else
+        {
+          for (i = hist->luc[k]; i < x + diameter; i++)
+            {
+              const guint16 *add = hist->col_fine + i * hist->n_bins + k * n_fine;
+              const guint16 *del = add - diameter * hist->n_bins;
+
+              for (bin = 0; bin < n_fine; bin++)
+                fine[bin] += add[bin] - del[bin];
+            }
+        }
+
+      hist->luc[k] = x + diameter;
+
+      bin = 0;
+      while (sum + fine[bin] < half)
+        sum += fine[bin++];
+
+      medians[x] = k * n_fine + bin;
     }
-  hist->count--;
 }
 
-static inline void
-histogram_add_vals (Histogram     *hist,
-                    const gfloat  *src,
-                    GeglRectangle *rect,
-                    gint           bpp,
-                    gint           xmin,
-                    gint           ymin,
-                    gint           xmax,
-                    gint           ymax)
+/* fills @bins with the histogram bins of component @c of @n_pixels */
+static void
+quantize_component (const guchar *src,
+                    guint16      *bins,
+                    gint          n_pixels,
+                    gint          n_components,
+                    gint          c,
+                    gboolean      is_u8)
 {
-  gint x;
-  gint y;
-
-  if (xmin > xmax)
-    return;
+  gint i;
 
-  for (y = ymin; y <= ymax; y++)
+  if (is_u8)
     {
-      for (x = xmin; x <= xmax; x++)
+      for (i = 0; i < n_pixels; i++)
+        bins[i] = src[i * n_components + c];
+    }
+  else
+    {
+      const gfloat *fsrc = (const gfloat *) src;
+
+      for (i = 0; i < n_pixels; i++)
         {
-          histogram_add_val (hist, src, rect, bpp, x, y);
+          gfloat value = fsrc[i * n_components + c];
+
+          bins[i] = (gint) (CLAMP (value, 0.0, 1.0) * (N_BINS_FLOAT - 1));
         }
     }
 }
 
-static inline void
-histogram_del_vals (Histogram     *hist,
-                    const gfloat  *src,
-                    GeglRectangle *rect,
-                    gint           bpp,
-                    gint           xmin,
-                    gint           ymin,
-                    gint           xmax,
-                    gint           ymax)
+static void
+median_strip (gint     i,
+              gpointer user_data)
 {
-  gint x;
-  gint y;
+  MedianData    *data         = user_data;
+  const gint     radius       = data->radius;
+  const gint     diameter     = 2 * radius + 1;
+  const gint     n_components = babl_format_get_n_components (data->format);
+  const gint     bpp          = babl_format_get_bytes_per_pixel (data->format);
+  const gint     bpc          = bpp / n_components;
+  GeglRectangle  out_rect;
+  GeglRectangle  in_rect;
+  Histogram      hist;
+  guchar        *in_buf;
+  guchar        *out_buf;
+  guint16       *bins;
+  guint16       *medians;
+  gint           x, y, c;
+
+  out_rect.x      = data->roi.x;
+  out_rect.y      = data->roi.y + i * data->strip;
+  out_rect.width  = data->roi.width;
+  out_rect.height = MIN (data->strip,
+                         data->roi.y + data->roi.height - out_rect.y);
+
+  in_rect.x      = out_rect.x - radius;
+  in_rect.y      = out_rect.y - radius;
+  in_rect.width  = out_rect.width + 2 * radius;
+  in_rect.height = out_rect.height + 2 * radius;
+
+  in_buf  = gegl_malloc (in_rect.width * in_rect.height * bpp);
+  out_buf = gegl_malloc (out_rect.width * out_rect.height * bpp);
+  bins    = gegl_malloc (in_rect.width * in_rect.height * sizeof (guint16));
+  medians = gegl_malloc (out_rect.width * sizeof (guint16));
+
+  gegl_buffer_get (data->input, &in_rect, 1.0, data->format, in_buf,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
 
-  if (xmin > xmax)
-    return;
+  if (data->is_u8)
+    histogram_init (&hist, radius, N_BINS_U8, SHIFT_U8, in_rect.width);
+  else
+    histogram_init (&hist, radius, N_BINS_FLOAT, SHIFT_FLOAT, in_rect.width);
 
-  for (y = ymin; y <= ymax; y++)
+  for (c = 0; c < 3; c++)
     {
-      for (x = xmin; x <= xmax; x++)
+      quantize_component (in_buf, bins, in_rect.width * in_rect.height,
+                          n_components, c, data->is_u8);
+
+      histogram_clear_columns (&hist);
+
+      for (y = 0; y < diameter - 1; y++)
+        histogram_update_columns (&hist, bins + y * in_rect.width, 1);
+
+      for (y = 0; y < out_rect.height; y++)
         {
-          histogram_del_val (hist, src, rect, bpp, x, y);
+          histogram_update_columns (&hist,
+                                    bins + (y + diameter - 1) * in_rect.width,
+                                    1);
+
+          histogram_median_row (&hist, medians, out_rect.width);
+
+          histogram_update_columns (&hist, bins + y * in_rect.width, -1);
+
+          if (data->is_u8)
+            {
+              guchar *dst = out_buf + y * out_rect.width * n_components;
+
+              for (x = 0; x < out_rect.width; x++)
+                dst[x * n_components + c] = medians[x];
+            }
+          else
+            {
+              gfloat *dst = (gfloat *) out_buf + y * out_rect.width * n_components;
+
+              for (x = 0; x < out_rect.width; x++)
+                dst[x * n_components + c] = (gfloat) medians[x] /
+                                            (gfloat) N_BINS_FLOAT;
+            }
         }
     }
-}
 
-static inline void
-histogram_update (Histogram     *hist,
-                  const gfloat  *src,
-                  GeglRectangle *rect,
-                  gint           bpp,
-                  gint           xmin,
-                  gint           ymin,
-                  gint           xmax,
-                  gint           ymax,
-                  Direction      dir)
-{
-  switch (dir)
+  /* alpha is taken from the pixel itself */
+  if (n_components == 4)
     {
-      case LEFT_TO_RIGHT:
-        histogram_del_vals (hist, src, rect, bpp,
-                            hist->xmin, hist->ymin,
-                            hist->xmin, hist->ymax);
-
-        histogram_add_vals (hist, src, rect, bpp,
-                            xmax, ymin,
-                            xmax, ymax);
-        break;
-
-      case RIGHT_TO_LEFT:
-        histogram_del_vals (hist, src, rect, bpp,
-                            hist->xmax, hist->ymin,
-                            hist->xmax, hist->ymax);
-
-        histogram_add_vals (hist, src, rect, bpp,
-                            xmin, ymin,
-                            xmin, ymax);
-        break;
-
-      case TOP_TO_BOTTOM:
-        histogram_del_vals (hist, src, rect, bpp,
-                            hist->xmin, hist->ymin,
-                            hist->xmax, hist->ymin);
-
-        histogram_add_vals (hist, src, rect, bpp,
-                            xmin, ymax,
-                            xmax, ymax);
-        break;
+      for (y = 0; y < out_rect.height; y++)
+        for (x = 0; x < out_rect.width; x++)
+          {
+            gint src_idx = (y + radius) * in_rect.width + x + radius;
+            gint dst_idx = y * out_rect.width + x;
+
+            memcpy (out_buf + dst_idx * bpp + 3 * bpc,
+                    in_buf + src_idx * bpp + 3 * bpc,
+                    bpc);
+          }
     }
 
-  hist->xmin = xmin;
-  hist->ymin = ymin;
-  hist->xmax = xmax;
-  hist->ymax = ymax;
+  gegl_buffer_set (data->output, &out_rect, 0, data->format, out_buf,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  histogram_cleanup (&hist);
+  gegl_free (in_buf);
+  gegl_free (out_buf);
+  gegl_free (bins);
+  gegl_free (medians);
 }
 
 static void
@@ -215,7 +363,7 @@ prepare (GeglOperation *operation)
   GeglOperationAreaFilter *area = GEGL_OPERATION_AREA_FILTER (operation);
   GeglProperties     *o         = GEGL_PROPERTIES (operation);
   const Babl         *in_format = gegl_operation_get_source_format (operation, "input");
-  const Babl         *format    = babl_format ("RGB float");;
+  const Babl         *format    = babl_format ("RGB float");
 
   area->left   =
   area->right  =
@@ -224,8 +372,15 @@ prepare (GeglOperation *operation)
 
   if (in_format)
     {
+      gboolean is_u8 = babl_format_get_type (in_format, 0) == babl_type ("u8");
+
+      /* the median commutes with the encoding, 8 bit input is filtered
+       * as it is stored, in 256 bins
+       */
       if (babl_format_has_alpha (in_format))
-        format = babl_format ("RGBA float");
+        format = babl_format (is_u8 ? "R'G'B'A u8" : "RGBA float");
+      else if (is_u8)
+        format = babl_format ("R'G'B' u8");
     }
 
   gegl_operation_set_format (operation, "input", format);
@@ -254,139 +409,33 @@ process (GeglOperation       *operation,
          const GeglRectangle *roi,
          gint                 level)
 {
-  GeglProperties *o  = GEGL_PROPERTIES (operation);
-  const Babl *format = gegl_operation_get_format (operation, "input");
-  gint n_components  = babl_format_get_n_components (format);
-  gboolean has_alpha = babl_format_has_alpha (format);
-
-  gfloat *src_buf;
-  gfloat *dst_buf;
-  gint    n_pixels;
-  GeglRectangle src_rect; 
-
-  Histogram *hist;
-  Direction  dir;
-  
-  gint src_x, src_y;
-  gint dst_x, dst_y;
-  gint dst_idx, src_idx;
-  gint xmin, ymin, xmax, ymax;
-
-  src_rect = gegl_operation_get_required_for_output (operation, "input", roi);
-  n_pixels = roi->width * roi->height;
-  dst_buf = g_new0 (gfloat, n_pixels * n_components);
-  src_buf = g_new0 (gfloat, src_rect.width * src_rect.height * n_components);
-
-  gegl_buffer_get (input, &src_rect, 1.0, format, src_buf,
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
-
-  hist = g_slice_new0 (Histogram);
+  GeglProperties *o      = GEGL_PROPERTIES (operation);
+  const Babl     *format = gegl_operation_get_format (operation, "output");
+  MedianData      data;
+  gint            tile_height;
+  gint            n_strips;
 
-  dst_x = 0;
-  dst_y = 0;
-  src_x = o->radius;
-  src_y = o->radius;
+  if (roi->width <= 0 || roi->height <= 0)
+    return TRUE;
 
-  /* compute the first window */
+  g_object_get (output, "tile-height", &tile_height, NULL);
 
-  hist->xmin = src_x - o->radius;
-  hist->ymin = src_y - o->radius;
-  hist->xmax = src_x + o->radius;
-  hist->ymax = src_y + o->radius;
+  data.input  = input;
+  data.output = output;
+  data.format = format;
+  data.roi    = *roi;
+  data.radius = o->radius;
+  data.is_u8  = babl_format_get_type (format, 0) == babl_type ("u8");
 
-  histogram_add_vals (hist, src_buf, &src_rect, n_components,
-                      hist->xmin, hist->ymin,
-                      hist->xmax, hist->ymax);
+  /* strips of whole tiles, tall enough that setting up the column
+   * histograms stays a fraction of the work
+   */
+  data.strip = MAX (tile_height, 2 * o->radius + 1);
+  data.strip = MIN (data.strip, roi->height);
+  n_strips   = (roi->height + data.strip - 1) / data.strip;
 
-  dst_idx = (dst_x + dst_y * roi->width) * n_components;
+  gegl_parallel_for (n_strips, median_strip, &data);
 
-  dst_buf[dst_idx]     = histogram_get_median (hist, 0);
-  dst_buf[dst_idx + 1] = histogram_get_median (hist, 1);
-  dst_buf[dst_idx + 2] = histogram_get_median (hist, 2);
- 
-  if (has_alpha)
-    {
-      src_idx = (src_x + src_y * src_rect.width) * n_components;
-      dst_buf[dst_idx + 3] = src_buf[src_idx + 3];
-    }
-
-  n_pixels--;
-  dir = LEFT_TO_RIGHT;
-
-  while (n_pixels--)
-    {
-      /* move the src coords based on current direction and positions */
-      if (dir == LEFT_TO_RIGHT)
-        {
-          if (dst_x != roi->width - 1)
-            {
-              src_x++;
-              dst_x++;
-            }
-          else
-            {
-              src_y++;
-              dst_y++;
-              dir = TOP_TO_BOTTOM; 
-            }
-        }
-      else if (dir == TOP_TO_BOTTOM)
-        {
-          if (dst_x == 0)
-            {
-              src_x++;
-              dst_x++;
-              dir = LEFT_TO_RIGHT;
-            }
-          else
-            {
-              src_x--;
-              dst_x--;
-              dir = RIGHT_TO_LEFT;
-            }
-        }
-      else if (dir == RIGHT_TO_LEFT)
-        {
-          if (dst_x != 0)
-            {
-              src_x--;
-              dst_x--;
-            }
-          else
-            {
-              src_y++;
-              dst_y++;
-              dir = TOP_TO_BOTTOM; 
-            }
-        }
-
-      xmin = src_x - o->radius;
-      ymin = src_y - o->radius;
-      xmax = src_x + o->radius;
-      ymax = src_y + o->radius;
-
-      histogram_update (hist, src_buf, &src_rect, n_components,
-                        xmin, ymin, xmax, ymax, dir);
-
-      dst_idx = (dst_x + dst_y * roi->width) * n_components;
-
-      dst_buf[dst_idx]     = histogram_get_median (hist, 0);
-      dst_buf[dst_idx + 1] = histogram_get_median (hist, 1);
-      dst_buf[dst_idx + 2] = histogram_get_median (hist, 2);
-     
-      if (has_alpha)
-        {
-          src_idx = (src_x + src_y * src_rect.width) * n_components;
-          dst_buf[dst_idx + 3] = src_buf[src_idx + 3];
-        }
-    }
-
-  gegl_buffer_set (output, roi, 0, format, dst_buf, GEGL_AUTO_ROWSTRIDE);
-  
-  g_free (src_buf);
-  g_free (dst_buf);
-  g_slice_free (Histogram, hist);
- 
   return TRUE;
 }
 
@@ -403,6 +452,9 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class->prepare          = prepare;
   operation_class->get_bounding_box = get_bounding_box;
 
+  /* process() spreads strips of rows over the threads itself */
+  operation_class->threaded         = FALSE;
+
   gegl_operation_class_set_keys (operation_class,
     "name",        "gegl:median-blur",
     "title",       _("Median Blur"),
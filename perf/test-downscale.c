@@ -0,0 +1,123 @@
+#include "test-common.h"
+#include "gegl-algorithms.h"
+#include "gegl-cpuaccel-private.h"
+
+/* The resamplers of gegl-algorithms.c on their own, as used when
+ * rendering mipmap levels and zoomed out views, with and without the
+ * vector versions.
+ */
+
+#define SIZE       1024
+#define ITERATIONS 16
+#define LEVELS     4
+
+static void
+test_end_mpix (const gchar *id,
+               const gchar *suffix,
+               gdouble      pixels)
+{
+  long ticks = babl_ticks () - ticks_start;
+
+  g_print ("@ %s%s: %.2f megapixels/second\n",
+           id, suffix, (pixels / 1000000.0) / (ticks / 1000000.0));
+}
+
+static guchar *
+test_data (const Babl *format)
+{
+  gint    bpp  = babl_format_get_bytes_per_pixel (format);
+  gfloat *rgba = g_new (gfloat, SIZE * SIZE * 4);
+  guchar *data = g_malloc (SIZE * SIZE * bpp);
+  gint    i;
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    rgba[i] = g_random_double_range (0.0, 1.0);
+
+  babl_process (babl_fish (babl_format ("RGBA float"), format),
+                rgba, data, SIZE * SIZE);
+
+  g_free (rgba);
+
+  return data;
+}
+
+static void
+bench_format (const Babl  *format,
+              const gchar *suffix)
+{
+  const gchar *name = babl_get_name (format);
+  gint         bpp  = babl_format_get_bytes_per_pixel (format);
+  guchar      *src  = test_data (format);
+  guchar      *dst  = g_malloc (SIZE * SIZE * bpp);
+  gint         level;
+  gint         i;
+
+  /* level n halves a buffer of SIZE >> (n - 1) pixels square */
+  for (level = 1; level <= LEVELS; level++)
+    {
+      gint   size = SIZE >> (level - 1);
+      gchar *id   = g_strdup_printf ("downscale-2x2 %s level %d", name, level);
+
+      gegl_downscale_2x2 (format, size, size, src, size * bpp,
+                          dst, size / 2 * bpp);
+
+      test_start ();
+      for (i = 0; i < ITERATIONS; i++)
+        gegl_downscale_2x2 (format, size, size, src, size * bpp,
+                            dst, size / 2 * bpp);
+      test_end_mpix (id, suffix, (gdouble) size * size * ITERATIONS);
+
+      g_free (id);
+    }
+
+  /* what is left to scale after picking the mipmap level */
+  {
+    GeglRectangle src_rect = {0, 0, SIZE, SIZE};
+    GeglRectangle dst_rect = {1, 1, SIZE * 3 / 4 - 4, SIZE * 3 / 4 - 4};
+    gchar        *id;
+
+    id = g_strdup_printf ("boxfilter %s", name);
+    test_start ();
+    for (i = 0; i < ITERATIONS; i++)
+      gegl_resample_boxfilter (dst, src, &dst_rect, &src_rect, SIZE * bpp,
+                               0.75, format, dst_rect.width * bpp);
+    test_end_mpix (id, suffix,
+                   (gdouble) dst_rect.width * dst_rect.height * ITERATIONS);
+    g_free (id);
+
+    id = g_strdup_printf ("bilinear %s", name);
+    test_start ();
+    for (i = 0; i < ITERATIONS; i++)
+      gegl_resample_bilinear (dst, src, &dst_rect, &src_rect, SIZE * bpp,
+                              0.75, format, dst_rect.width * bpp);
+    test_end_mpix (id, suffix,
+                   (gdouble) dst_rect.width * dst_rect.height * ITERATIONS);
+    g_free (id);
+  }
+
+  g_free (src);
+  g_free (dst);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  const gchar *formats[] = {"RGBA float", "RaGaBaA float",
+                            "R'G'B'A u8", "Y float"};
+  gint         i;
+
+  gegl_init (&argc, &argv);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      gegl_cpu_accel_set_use (TRUE);
+      bench_format (babl_format (formats[i]), "");
+
+      gegl_cpu_accel_set_use (FALSE);
+      bench_format (babl_format (formats[i]), " (scalar)");
+    }
+
+  gegl_exit ();
+  return 0;
+}
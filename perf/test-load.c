@@ -0,0 +1,114 @@
+#include <glib/gstdio.h>
+
+#include "test-common.h"
+
+/* Measures how fast the file loaders get an image into a buffer. The
+ * image is saved with the matching saver first, into a temporary file.
+ */
+
+#define SIZE   2048
+#define ROUNDS 4
+
+typedef struct
+{
+  const gchar *suffix;
+  const gchar *load;
+  const gchar *save;
+} Loader;
+
+static const Loader loaders[] =
+{
+  { ".png",  "gegl:png-load",  "gegl:png-save"  },
+  { ".jpg",  "gegl:jpg-load",  "gegl:jpg-save"  },
+  { ".tiff", "gegl:tiff-load", "gegl:tiff-save" }
+};
+
+static gboolean
+save_image (GeglBuffer   *buffer,
+            const Loader *loader,
+            const gchar  *path)
+{
+  GeglNode *graph, *source, *save;
+
+  if (! gegl_has_operation (loader->load) ||
+      ! gegl_has_operation (loader->save))
+    return FALSE;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  save   = gegl_node_new_child (graph,
+                                "operation", loader->save,
+                                "path",      path,
+                                NULL);
+  gegl_node_link (source, save);
+  gegl_node_process (save);
+  g_object_unref (graph);
+
+  return g_file_test (path, G_FILE_TEST_EXISTS);
+}
+
+static void
+load_image (const Loader *loader,
+            const gchar  *path)
+{
+  GeglNode   *graph, *load, *sink;
+  GeglBuffer *buffer = NULL;
+
+  graph = gegl_node_new ();
+  load  = gegl_node_new_child (graph,
+                               "operation", loader->load,
+                               "path",      path,
+                               NULL);
+  sink  = gegl_node_new_child (graph,
+                               "operation", "gegl:buffer-sink",
+                               "buffer",    &buffer,
+                               NULL);
+  gegl_node_link (load, sink);
+  gegl_node_process (sink);
+  g_object_unref (graph);
+
+  g_clear_object (&buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("R'G'B'A u8"));
+
+  for (i = 0; i < G_N_ELEMENTS (loaders); i++)
+    {
+      gchar *name = g_strconcat ("gegl-test-load", loaders[i].suffix, NULL);
+      gchar *path = g_build_filename (g_get_tmp_dir (), name, NULL);
+      gchar *id   = g_strdup_printf ("load %s", loaders[i].suffix + 1);
+      gint   round;
+
+      if (save_image (buffer, &loaders[i], path))
+        {
+          test_start ();
+          for (round = 0; round < ROUNDS; round++)
+            load_image (&loaders[i], path);
+          test_end (id, (glong) ROUNDS * SIZE * SIZE * 4);
+
+          g_unlink (path);
+        }
+
+      g_free (id);
+      g_free (path);
+      g_free (name);
+    }
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return 0;
+}
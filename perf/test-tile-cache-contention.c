@@ -0,0 +1,78 @@
+#include "test-common.h"
+
+/* Measures the throughput of tile cache lookups when several threads
+ * access their own buffers concurrently; every 16x16 read touches a
+ * single tile, which makes the cache lookup the dominant cost.
+ */
+
+#define BPP        16
+#define SIZE       1024
+#define LOOKUPS    200000
+#define MAX_THREADS 16
+
+typedef struct
+{
+  GeglBuffer *buffer;
+  gint        seed;
+} ThreadData;
+
+static gpointer
+lookup_thread (gpointer data)
+{
+  ThreadData *td   = data;
+  GRand      *rand = g_rand_new_with_seed (td->seed);
+  gfloat      buf[16 * 16 * 4];
+  gint        i;
+
+  for (i = 0; i < LOOKUPS; i++)
+    {
+      GeglRectangle rect = {g_rand_int_range (rand, 0, SIZE / 16) * 16,
+                            g_rand_int_range (rand, 0, SIZE / 16) * 16,
+                            16, 16};
+
+      gegl_buffer_get (td->buffer, &rect, 1.0, NULL, buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  g_rand_free (rand);
+  return NULL;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  ThreadData  data[MAX_THREADS];
+  GThread    *threads[MAX_THREADS];
+  gint        n_threads;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  for (i = 0; i < MAX_THREADS; i++)
+    {
+      data[i].buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+      data[i].seed   = i;
+    }
+
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+    {
+      gchar *id = g_strdup_printf ("tile-cache-contention %i threads", n_threads);
+
+      test_start ();
+      for (i = 0; i < n_threads; i++)
+        threads[i] = g_thread_new (NULL, lookup_thread, &data[i]);
+      for (i = 0; i < n_threads; i++)
+        g_thread_join (threads[i]);
+      test_end (id, (glong) n_threads * LOOKUPS * 16 * 16 * BPP);
+
+      g_free (id);
+    }
+
+  for (i = 0; i < MAX_THREADS; i++)
+    g_object_unref (data[i].buffer);
+
+  gegl_exit ();
+
+  return 0;
+}
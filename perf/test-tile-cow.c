@@ -0,0 +1,129 @@
+#include "test-common.h"
+
+/* Measures the throughput of copy-on-write tile sharing when several
+ * threads copy the same buffer and write to their copies concurrently;
+ * gegl_buffer_copy shares whole tiles, and the first write to each of
+ * them gives it a copy of its own. The copies are checked, a thread
+ * seeing another one's writes fails the test.
+ */
+
+#define BPP         16
+#define SIZE        512
+#define ROUNDS      50
+#define MAX_THREADS 16
+
+typedef struct
+{
+  GeglBuffer *source;
+  GeglBuffer *copy;
+  GeglColor  *color;
+  gfloat      value;
+  gint        tile_width;
+  gint        tile_height;
+  gboolean    failed;
+} ThreadData;
+
+static gpointer
+cow_thread (gpointer data)
+{
+  ThreadData    *td   = data;
+  GeglRectangle  rect = {0, 0, SIZE, SIZE};
+  gint           i;
+
+  for (i = 0; i < ROUNDS; i++)
+    {
+      gint x, y;
+
+      gegl_buffer_copy (td->source, &rect, GEGL_ABYSS_NONE, td->copy, &rect);
+
+      /* a pixel in every tile */
+      for (y = 0; y < SIZE; y += td->tile_height)
+        for (x = 0; x < SIZE; x += td->tile_width)
+          {
+            GeglRectangle pixel = {x, y, 1, 1};
+            gfloat        value[4];
+
+            gegl_buffer_set_color (td->copy, &pixel, td->color);
+
+            gegl_buffer_get (td->copy, &pixel, 1.0, babl_format ("RGBA float"),
+                             value, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+            if (value[0] != td->value)
+              td->failed = TRUE;
+
+            pixel.x++;
+            gegl_buffer_get (td->copy, &pixel, 1.0, babl_format ("RGBA float"),
+                             value, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+            if (value[0] != 0.0)
+              td->failed = TRUE;
+          }
+    }
+
+  return NULL;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglRectangle  rect = {0, 0, SIZE, SIZE};
+  GeglBuffer    *source;
+  GeglColor     *black;
+  ThreadData     data[MAX_THREADS];
+  GThread       *threads[MAX_THREADS];
+  gboolean       failed = FALSE;
+  gint           n_threads;
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  source = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  black  = gegl_color_new ("black");
+  gegl_buffer_set_color (source, &rect, black);
+
+  for (i = 0; i < MAX_THREADS; i++)
+    {
+      data[i].source = source;
+      data[i].copy   = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+      data[i].value  = (i + 1.0) / MAX_THREADS;
+      data[i].color  = gegl_color_new (NULL);
+      data[i].failed = FALSE;
+      g_object_get (data[i].copy,
+                    "tile-width",  &data[i].tile_width,
+                    "tile-height", &data[i].tile_height,
+                    NULL);
+      gegl_color_set_rgba (data[i].color, data[i].value, 0.0, 0.0, 1.0);
+    }
+
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+    {
+      gchar *id = g_strdup_printf ("tile-cow %i threads", n_threads);
+
+      test_start ();
+      for (i = 0; i < n_threads; i++)
+        threads[i] = g_thread_new (NULL, cow_thread, &data[i]);
+      for (i = 0; i < n_threads; i++)
+        g_thread_join (threads[i]);
+      test_end (id, (glong) n_threads * ROUNDS * SIZE * SIZE * BPP);
+
+      g_free (id);
+    }
+
+  for (i = 0; i < MAX_THREADS; i++)
+    {
+      if (data[i].failed)
+        {
+          g_printerr ("thread %i saw pixels it did not write\n", i);
+          failed = TRUE;
+        }
+
+      g_object_unref (data[i].copy);
+      g_object_unref (data[i].color);
+    }
+
+  g_object_unref (source);
+  g_object_unref (black);
+
+  gegl_exit ();
+
+  return failed ? 1 : 0;
+}
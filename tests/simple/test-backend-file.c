@@ -17,6 +17,7 @@
 #include "gegl.h"
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend-file.h"
+#include "gegl-tile-backend-mmap.h"
 
 #include <glib/gstdio.h>
 
@@ -209,6 +210,162 @@ test_buffer_load (void)
   return result;
 }
 
+static gboolean
+test_buffer_load_mmap (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglBuffer      *buf_b = NULL;
+  GeglTileBackend *backend_b = NULL;
+  const Babl      *format = babl_format ("Y u8");
+  GeglRectangle    roi = {0, 0, 200, 150};
+  guchar          *data_a;
+  guchar          *data_b;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_path = g_build_filename (tmpdir, "buf.gegl", NULL);
+
+  data_a = g_malloc (roi.width * roi.height);
+  data_b = g_malloc (roi.width * roi.height);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    data_a[i] = (i * 7) & 0xff;
+
+  buf_a = gegl_buffer_new (&roi, format);
+  gegl_buffer_set (buf_a, &roi, 0, format, data_a, GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_save (buf_a, buf_path, &roi);
+  g_object_unref (buf_a);
+
+  buf_b = gegl_buffer_load (buf_path);
+  g_object_get (buf_b, "backend", &backend_b, NULL);
+
+  if (!GEGL_IS_TILE_BACKEND_MMAP (backend_b))
+    {
+      printf ("Buffer was not loaded through a mapping\n");
+      result = FALSE;
+    }
+
+  gegl_buffer_get (buf_b, &roi, 1.0, format, data_b,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (memcmp (data_a, data_b, roi.width * roi.height))
+    {
+      printf ("Loaded data does not match\n");
+      result = FALSE;
+    }
+
+  /* writing to the loaded buffer must not reach the file */
+  memset (data_b, 0, roi.width * roi.height);
+  gegl_buffer_set (buf_b, &roi, 0, format, data_b, GEGL_AUTO_ROWSTRIDE);
+
+  buf_a = gegl_buffer_load (buf_path);
+  gegl_buffer_get (buf_a, &roi, 1.0, format, data_b,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (memcmp (data_a, data_b, roi.width * roi.height))
+    {
+      printf ("Writing to a loaded buffer modified the file\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_a);
+  g_object_unref (backend_b);
+  g_object_unref (buf_b);
+
+  g_unlink (buf_path);
+  g_remove (tmpdir);
+
+  g_free (data_a);
+  g_free (data_b);
+  g_free (tmpdir);
+  g_free (buf_path);
+
+  return result;
+}
+
+static gboolean
+test_buffer_load_mmap_copy (void)
+{
+  gboolean         result = TRUE;
+  gchar           *tmpdir = NULL;
+  gchar           *buf_path = NULL;
+  GeglBuffer      *buf_a = NULL;
+  GeglBuffer      *buf_b = NULL;
+  const Babl      *format = babl_format ("Y u8");
+  GeglRectangle    roi = {0, 0, 200, 150};
+  guchar          *data_a;
+  guchar          *data_b;
+  guchar           pixel = 0x55;
+  gint             i;
+
+  tmpdir = g_dir_make_tmp ("test-backend-file-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FALSE);
+
+  buf_path = g_build_filename (tmpdir, "buf.gegl", NULL);
+
+  data_a = g_malloc (roi.width * roi.height);
+  data_b = g_malloc (roi.width * roi.height);
+
+  for (i = 0; i < roi.width * roi.height; i++)
+    data_a[i] = (i * 13) & 0xff;
+
+  buf_a = gegl_buffer_new (&roi, format);
+  gegl_buffer_set (buf_a, &roi, 0, format, data_a, GEGL_AUTO_ROWSTRIDE);
+  gegl_buffer_save (buf_a, buf_path, &roi);
+  g_object_unref (buf_a);
+
+  /* the copy shares the tiles of the mapping, and is left holding the
+   * last of them once the loaded buffer is gone
+   */
+  buf_a = gegl_buffer_load (buf_path);
+  buf_b = gegl_buffer_new (&roi, format);
+  gegl_buffer_copy (buf_a, &roi, GEGL_ABYSS_NONE, buf_b, &roi);
+  g_object_unref (buf_a);
+
+  gegl_buffer_set (buf_b, GEGL_RECTANGLE (0, 0, 1, 1), 0, format,
+                   &pixel, GEGL_AUTO_ROWSTRIDE);
+  data_a[0] = pixel;
+
+  gegl_buffer_get (buf_b, &roi, 1.0, format, data_b,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (memcmp (data_a, data_b, roi.width * roi.height))
+    {
+      printf ("Copy of a loaded buffer does not match\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_b);
+
+  /* nor did the write reach the file */
+  buf_a = gegl_buffer_load (buf_path);
+  gegl_buffer_get (buf_a, GEGL_RECTANGLE (0, 0, 1, 1), 1.0, format, &pixel,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (pixel != 0)
+    {
+      printf ("Writing to a copy of a loaded buffer modified the file\n");
+      result = FALSE;
+    }
+
+  g_object_unref (buf_a);
+
+  g_unlink (buf_path);
+  g_remove (tmpdir);
+
+  g_free (data_a);
+  g_free (data_b);
+  g_free (tmpdir);
+  g_free (buf_path);
+
+  return result;
+}
+
 static gboolean
 test_buffer_same_path (void)
 {
@@ -439,6 +596,8 @@ int main(int argc, char **argv)
   RUN_TEST (test_buffer_path)
   RUN_TEST (test_buffer_path_from_backend)
   RUN_TEST (test_buffer_load)
+  RUN_TEST (test_buffer_load_mmap)
+  RUN_TEST (test_buffer_load_mmap_copy)
   RUN_TEST (test_buffer_same_path)
   RUN_TEST (test_buffer_open)
   RUN_TEST (test_buffer_change_extent)
@@ -0,0 +1,234 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks gegl:bilateral-filter against weighing every pixel of the
+ * neighbourhood: exactly for the small radii it computes that way, and
+ * within the error of the permutohedral lattice for larger ones.  Also
+ * checks that gegl:bilateral-filter-fast leaves a flat image as it is.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     96
+
+/* the exact filter, computed the way the operation does */
+static void
+reference_filter (const gfloat *src,
+                  gfloat       *dst,
+                  gint          radius,
+                  gfloat        preserve)
+{
+  gint x, y, u, v, c;
+
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        const gfloat *center = src + (y * SIZE + x) * 4;
+        gfloat        sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+        gfloat        total  = 0.0;
+
+        for (v = -radius; v <= radius; v++)
+          for (u = -radius; u <= radius; u++)
+            {
+              /* transparent black beyond the edges */
+              const gfloat  none[4] = { 0.0, 0.0, 0.0, 0.0 };
+              const gfloat *pixel   = none;
+              gfloat        diff    = 0.0;
+              gfloat        weight;
+
+              if (x + u >= 0 && x + u < SIZE && y + v >= 0 && y + v < SIZE)
+                pixel = src + ((y + v) * SIZE + x + u) * 4;
+
+              for (c = 0; c < 3; c++)
+                diff += (center[c] - pixel[c]) * (center[c] - pixel[c]);
+
+              weight = exp (-0.5 * (u * u + v * v) / radius) *
+                       exp (-diff * preserve);
+
+              for (c = 0; c < 4; c++)
+                sum[c] += pixel[c] * weight;
+              total += weight;
+            }
+
+        for (c = 0; c < 4; c++)
+          dst[(y * SIZE + x) * 4 + c] = sum[c] / total;
+      }
+}
+
+static gfloat *
+render (GeglBuffer  *input,
+        const gchar *operation,
+        const gchar *first_property,
+        ...)
+{
+  gfloat   *pixels = g_new (gfloat, SIZE * SIZE * 4);
+  GeglNode *graph, *source, *node;
+  va_list   var_args;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  node   = gegl_node_new_child (graph,
+                                "operation", operation,
+                                NULL);
+
+  va_start (var_args, first_property);
+  gegl_node_set_valist (node, first_property, var_args);
+  va_end (var_args);
+
+  gegl_node_link (source, node);
+
+  gegl_node_blit (node, 1.0, GEGL_RECTANGLE (0, 0, SIZE, SIZE),
+                  babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+
+  return pixels;
+}
+
+static gboolean
+check_filter (GeglBuffer   *input,
+              const gfloat *src,
+              gint          radius,
+              gfloat        preserve,
+              gfloat        max_error,
+              gfloat        mean_error)
+{
+  gfloat   *expected = g_new (gfloat, SIZE * SIZE * 4);
+  gfloat   *result;
+  gdouble   sum      = 0.0;
+  gfloat    max      = 0.0;
+  gboolean  success  = TRUE;
+  gint      i;
+
+  reference_filter (src, expected, radius, preserve);
+
+  result = render (input, "gegl:bilateral-filter",
+                   "blur-radius",       (gdouble) radius,
+                   "edge-preservation", (gdouble) preserve,
+                   NULL);
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    {
+      gfloat error = fabs (result[i] - expected[i]);
+
+      sum += error;
+      max  = MAX (max, error);
+    }
+
+  if (max > max_error || sum / (SIZE * SIZE * 4) > mean_error)
+    {
+      printf ("radius %d, edge preservation %g: error %f, mean %f\n",
+              radius, preserve, max, sum / (SIZE * SIZE * 4));
+      success = FALSE;
+    }
+
+  g_free (expected);
+  g_free (result);
+
+  return success;
+}
+
+static gboolean
+check_flat (GeglBuffer  *input,
+            const gchar *operation,
+            const gchar *property,
+            gint         value)
+{
+  gfloat   *result  = render (input, operation, property, value, NULL);
+  gboolean  success = TRUE;
+  gint      i;
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    if (fabs (result[i] - (i % 4 == 3 ? 1.0 : 0.25)) > 0.0001)
+      {
+        printf ("%s: flat image changed to %f\n", operation, result[i]);
+        success = FALSE;
+        break;
+      }
+
+  g_free (result);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglRectangle  rect   = {0, 0, SIZE, SIZE};
+  GeglBuffer    *input;
+  GeglColor     *gray;
+  GRand         *rand;
+  gfloat        *pixels;
+  gboolean       success = TRUE;
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  input  = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  pixels = g_new (gfloat, SIZE * SIZE * 4);
+  rand   = g_rand_new_with_seed (1);
+
+  /* noisy patches of different colors, with a gradient across */
+  for (i = 0; i < SIZE * SIZE; i++)
+    {
+      gint x     = i % SIZE;
+      gint y     = i / SIZE;
+      gint patch = (x / 30 + y / 40) % 3;
+
+      pixels[i * 4 + 0] = (patch == 0 ? 0.8 : patch == 1 ? 0.2 : 0.5) +
+                          g_rand_double_range (rand, -0.025, 0.025);
+      pixels[i * 4 + 1] = (patch == 0 ? 0.3 : patch == 1 ? 0.7 : 0.5) +
+                          g_rand_double_range (rand, -0.025, 0.025);
+      pixels[i * 4 + 2] = (gfloat) x / SIZE;
+      pixels[i * 4 + 3] = 1.0;
+    }
+
+  gegl_buffer_set (input, &rect, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  /* exact */
+  success &= check_filter (input, pixels, 2,  8.0,  0.0001, 0.0001);
+  success &= check_filter (input, pixels, 4,  8.0,  0.0001, 0.0001);
+
+  /* on the lattice */
+  success &= check_filter (input, pixels, 6,  8.0,  0.1,    0.005);
+  success &= check_filter (input, pixels, 10, 8.0,  0.1,    0.005);
+  success &= check_filter (input, pixels, 10, 0.0,  0.1,    0.005);
+  success &= check_filter (input, pixels, 10, 50.0, 0.1,    0.005);
+
+  gray = gegl_color_new (NULL);
+  gegl_color_set_rgba (gray, 0.25, 0.25, 0.25, 1.0);
+  gegl_buffer_set_color (input, &rect, gray);
+
+  success &= check_flat (input, "gegl:bilateral-filter-fast", "s-sigma", 8);
+
+  g_object_unref (gray);
+  g_rand_free (rand);
+  g_free (pixels);
+  g_object_unref (input);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,173 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that node output buffers are recycled between renders, and that
+ * a recycled buffer comes back empty and with the extent asked for.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "gegl.h"
+#include "buffer/gegl-buffer-pool.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     64
+
+static gboolean
+test_recycle (void)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglRectangle  first  = {0, 0, SIZE, SIZE};
+  GeglRectangle  second = {10, -20, SIZE / 2, SIZE * 2};
+  GeglBuffer    *buffer;
+  GeglBuffer    *recycled;
+  GeglBuffer    *kept;
+  GeglColor     *white  = gegl_color_new ("white");
+  gfloat         pixel[4];
+  guint64        hits;
+  gboolean       success = TRUE;
+
+  buffer = gegl_buffer_pool_get (&first, format);
+  gegl_buffer_set_color (buffer, &first, white);
+  gegl_buffer_pool_release (buffer);
+
+  hits = gegl_buffer_pool_get_hits ();
+  recycled = gegl_buffer_pool_get (&second, format);
+
+  if (recycled != buffer || gegl_buffer_pool_get_hits () != hits + 1)
+    {
+      printf ("released buffer was not recycled\n");
+      success = FALSE;
+    }
+
+  if (! gegl_rectangle_equal (gegl_buffer_get_extent (recycled), &second))
+    {
+      printf ("recycled buffer has the wrong extent\n");
+      success = FALSE;
+    }
+
+  gegl_buffer_sample (recycled, 20, 10, NULL, pixel, format,
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+  if (pixel[0] != 0.0 || pixel[3] != 0.0)
+    {
+      printf ("recycled buffer is not empty\n");
+      success = FALSE;
+    }
+
+  /* a buffer still in use elsewhere must not be handed out again */
+  kept = g_object_ref (recycled);
+  gegl_buffer_pool_release (recycled);
+
+  buffer = gegl_buffer_pool_get (&first, format);
+  if (buffer == kept)
+    {
+      printf ("buffer in use was recycled\n");
+      success = FALSE;
+    }
+
+  gegl_buffer_pool_release (buffer);
+  g_object_unref (kept);
+  g_object_unref (white);
+
+  return success;
+}
+
+static gboolean
+test_graph (void)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglRectangle  rect   = {0, 0, SIZE, SIZE};
+  GeglBuffer    *input  = gegl_buffer_new (&rect, format);
+  gfloat        *src    = g_new (gfloat, SIZE * SIZE * 4);
+  gfloat        *dst    = g_new (gfloat, SIZE * SIZE * 4);
+  GeglNode      *graph, *source, *invert1, *blur, *invert2;
+  guint64        hits;
+  gboolean       success = TRUE;
+  gint           i;
+
+  /* opaque, the blur works on premultiplied pixels */
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    src[i] = i % 4 == 3 ? 1.0 : (i % 97) / 96.0;
+  gegl_buffer_set (input, &rect, 0, format, src, GEGL_AUTO_ROWSTRIDE);
+
+  graph   = gegl_node_new ();
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:buffer-source",
+                                 "buffer",    input,
+                                 NULL);
+  invert1 = gegl_node_new_child (graph,
+                                 "operation",  "gegl:invert-linear",
+                                 "dont-cache", TRUE,
+                                 NULL);
+  /* keeps the inverts from being fused into a single pass */
+  blur    = gegl_node_new_child (graph,
+                                 "operation",  "gegl:box-blur",
+                                 "radius",     0,
+                                 "dont-cache", TRUE,
+                                 NULL);
+  invert2 = gegl_node_new_child (graph,
+                                 "operation",  "gegl:invert-linear",
+                                 "dont-cache", TRUE,
+                                 NULL);
+  gegl_node_link_many (source, invert1, blur, invert2, NULL);
+
+  gegl_node_blit (invert2, 1.0, &rect, format, dst,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  hits = gegl_buffer_pool_get_hits ();
+
+  memset (dst, 0, SIZE * SIZE * 4 * sizeof (gfloat));
+  gegl_node_blit (invert2, 1.0, &rect, format, dst,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  if (gegl_buffer_pool_get_hits () == hits)
+    {
+      printf ("second render did not reuse any buffers\n");
+      success = FALSE;
+    }
+
+  for (i = 0; i < SIZE * SIZE * 4; i++)
+    if (fabs (dst[i] - src[i]) > 1e-5)
+      {
+        printf ("wrong result at %d: %f != %f\n", i, dst[i], src[i]);
+        success = FALSE;
+        break;
+      }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_free (src);
+  g_free (dst);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  gboolean success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  success &= test_recycle ();
+  success &= test_graph ();
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
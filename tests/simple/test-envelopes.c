@@ -0,0 +1,145 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that the stochastic sampling of gegl:c2g and gegl:stress gives
+ * the same result for a pixel, whether the output is rendered at once or
+ * in pieces, with or without mipmap sampling.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH    200
+#define HEIGHT   150
+#define PIECE    50
+
+static GeglBuffer *
+make_input (void)
+{
+  GeglRectangle  rect   = {0, 0, WIDTH, HEIGHT};
+  GeglBuffer    *buffer = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  gfloat        *pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  gint           i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      gint x = i % WIDTH;
+      gint y = i / WIDTH;
+
+      pixels[i * 4 + 0] = (x % 37) / 37.0;
+      pixels[i * 4 + 1] = (y % 23) / 23.0;
+      pixels[i * 4 + 2] = ((x + y) % 11) / 11.0;
+      pixels[i * 4 + 3] = 1.0;
+    }
+
+  gegl_buffer_set (buffer, &rect, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  return buffer;
+}
+
+/* renders @operation on @input, in pieces of @piece pixels if nonzero */
+static gfloat *
+render (GeglBuffer  *input,
+        const gchar *operation,
+        gboolean     mipmap,
+        gint         piece)
+{
+  gfloat   *pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  GeglNode *graph, *source, *node;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  node   = gegl_node_new_child (graph,
+                                "operation", operation,
+                                "radius",    40,
+                                "mipmap",    mipmap,
+                                NULL);
+  gegl_node_link (source, node);
+
+  if (piece)
+    {
+      gint x, y;
+
+      for (y = 0; y < HEIGHT; y += piece)
+        for (x = 0; x < WIDTH; x += piece)
+          gegl_node_blit (node, 1.0, GEGL_RECTANGLE (x, y, piece, piece),
+                          babl_format ("RGBA float"),
+                          pixels + (y * WIDTH + x) * 4,
+                          WIDTH * 4 * sizeof (gfloat), GEGL_BLIT_DEFAULT);
+    }
+  else
+    {
+      gegl_node_blit (node, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                      babl_format ("RGBA float"), pixels,
+                      GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+    }
+
+  g_object_unref (graph);
+
+  return pixels;
+}
+
+static gboolean
+check_operation (GeglBuffer  *input,
+                 const gchar *operation,
+                 gboolean     mipmap)
+{
+  gfloat   *whole  = render (input, operation, mipmap, 0);
+  gfloat   *pieces = render (input, operation, mipmap, PIECE);
+  gboolean  success = TRUE;
+
+  if (memcmp (whole, pieces, WIDTH * HEIGHT * 4 * sizeof (gfloat)))
+    {
+      printf ("%s%s: rendering in pieces changes the result\n",
+              operation, mipmap ? " (mipmap)" : "");
+      success = FALSE;
+    }
+
+  g_free (whole);
+  g_free (pieces);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglBuffer *input;
+  gboolean    success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  input = make_input ();
+
+  success &= check_operation (input, "gegl:c2g",    FALSE);
+  success &= check_operation (input, "gegl:c2g",    TRUE);
+  success &= check_operation (input, "gegl:stress", FALSE);
+  success &= check_operation (input, "gegl:stress", TRUE);
+
+  g_object_unref (input);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,163 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Renders a graph with independent branches, one of them not threaded,
+ * in a single thread and compares the result with rendering it on several
+ * threads, where the nodes of a wave run concurrently, and with rendering
+ * it tile by tile on the worker threads.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH    600
+#define HEIGHT   500
+#define PIECE    256 /* one tile of the tiled renderer, which it skips */
+
+static gfloat *
+render (GeglBuffer *input,
+        gint        threads,
+        gboolean    in_pieces)
+{
+  gfloat   *pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  GeglNode *graph, *source, *blur, *invert, *over, *smooth, *multiply;
+  gint      x, y;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  /* a new graph every time, so that nothing is taken from the caches */
+  graph    = gegl_node_new ();
+  source   = gegl_node_new_child (graph,
+                                  "operation", "gegl:buffer-source",
+                                  "buffer",    input,
+                                  NULL);
+  blur     = gegl_node_new_child (graph,
+                                  "operation", "gegl:box-blur",
+                                  "radius",    4,
+                                  NULL);
+  invert   = gegl_node_new_child (graph,
+                                  "operation", "gegl:invert-linear",
+                                  NULL);
+  over     = gegl_node_new_child (graph,
+                                  "operation", "gegl:over",
+                                  NULL);
+  smooth   = gegl_node_new_child (graph,
+                                  "operation", "gegl:bilateral-filter-fast",
+                                  "s-sigma",   4,
+                                  NULL);
+  multiply = gegl_node_new_child (graph,
+                                  "operation", "gegl:multiply",
+                                  NULL);
+
+  gegl_node_link (source, blur);
+  gegl_node_link (source, invert);
+  gegl_node_link (source, smooth);
+  gegl_node_link (invert, over);
+  gegl_node_connect_to (blur, "output", over, "aux");
+  gegl_node_link (over, multiply);
+  gegl_node_connect_to (smooth, "output", multiply, "aux");
+
+  for (y = 0; y < HEIGHT; y += in_pieces ? PIECE : HEIGHT)
+    for (x = 0; x < WIDTH; x += in_pieces ? PIECE : WIDTH)
+      {
+        GeglRectangle roi = { x, y, WIDTH - x, HEIGHT - y };
+
+        if (in_pieces)
+          {
+            roi.width  = MIN (roi.width,  PIECE);
+            roi.height = MIN (roi.height, PIECE);
+          }
+
+        gegl_node_blit (multiply, 1.0, &roi, babl_format ("RGBA float"),
+                        pixels + (y * WIDTH + x) * 4,
+                        WIDTH * 4 * sizeof (gfloat), GEGL_BLIT_DEFAULT);
+      }
+
+  g_object_unref (graph);
+
+  return pixels;
+}
+
+static gboolean
+compare (const gchar  *what,
+         const gfloat *expected,
+         const gfloat *result)
+{
+  gint i;
+
+  /* the lattice of the bilateral filter sums up in a different order
+   * depending on the number of threads
+   */
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    if (fabs (expected[i] - result[i]) > 0.0001)
+      {
+        printf ("%s: pixel %d, %d component %d is %f, expected %f\n",
+                what, i / 4 % WIDTH, i / 4 / WIDTH, i % 4,
+                result[i], expected[i]);
+        return FALSE;
+      }
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglBuffer *input;
+  gfloat     *pixels;
+  gfloat     *serial;
+  gfloat     *result;
+  GRand      *rand;
+  gboolean    success = TRUE;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+  g_object_set (gegl_config (), "use-opencl", FALSE, NULL);
+
+  input  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+  pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  rand   = g_rand_new_with_seed (4);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    pixels[i] = g_rand_double (rand);
+
+  gegl_buffer_set (input, NULL, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  /* a single thread and no tiles, one node after another */
+  serial = render (input, 1, TRUE);
+
+  result = render (input, 4, TRUE);
+  success &= compare ("waves", serial, result);
+  g_free (result);
+
+  result = render (input, 4, FALSE);
+  success &= compare ("tiles", serial, result);
+  g_free (result);
+
+  g_free (serial);
+  g_free (pixels);
+  g_rand_free (rand);
+  g_object_unref (input);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
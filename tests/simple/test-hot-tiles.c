@@ -0,0 +1,187 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that tiles fetched again are taken from the per-thread hot
+ * tiles, and that these never hand out stale tiles: not after the tiles
+ * of a buffer have been replaced, nor after they have been evicted from
+ * a tile cache too small for the buffer.  Also checks that using a tile
+ * through the hot tiles counts as a cache hit, and keeps it from being
+ * evicted like one.
+ */
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     512
+#define TILE     64
+
+static guint64
+get_stat (const gchar *name)
+{
+  guint64 value;
+
+  g_object_get (gegl_stats (), name, &value, NULL);
+
+  return value;
+}
+
+/* checks that every tile of @buffer holds the value @base plus its index */
+static gboolean
+check_tiles (const gchar *what,
+             GeglBuffer  *buffer,
+             gint         base)
+{
+  GeglRectangle  rect = {0, 0, SIZE, SIZE};
+  guchar        *pixels = g_new (guchar, SIZE * SIZE);
+  gboolean       success = TRUE;
+  gint           x, y;
+
+  gegl_buffer_get (buffer, &rect, 1.0, babl_format ("Y u8"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < SIZE && success; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        guchar expected = base + (y / TILE) * (SIZE / TILE) + x / TILE;
+
+        if (pixels[y * SIZE + x] != expected)
+          {
+            printf ("%s: pixel %d, %d is %d, expected %d\n",
+                    what, x, y, pixels[y * SIZE + x], expected);
+            success = FALSE;
+            break;
+          }
+      }
+
+  g_free (pixels);
+
+  return success;
+}
+
+/* reads the first pixel of tile @index of @buffer */
+static guchar
+read_tile (GeglBuffer *buffer,
+           gint        index)
+{
+  GeglRectangle rect = {index % (SIZE / TILE) * TILE,
+                        index / (SIZE / TILE) * TILE, 1, 1};
+  guchar        value;
+
+  gegl_buffer_get (buffer, &rect, 1.0, babl_format ("Y u8"), &value,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  return value;
+}
+
+/* fills every tile of @buffer with @base plus its index */
+static void
+fill_tiles (GeglBuffer *buffer,
+            gint        base)
+{
+  gint x, y;
+
+  for (y = 0; y < SIZE / TILE; y++)
+    for (x = 0; x < SIZE / TILE; x++)
+      {
+        GeglRectangle rect  = {x * TILE, y * TILE, TILE, TILE};
+        guchar        value = base + y * (SIZE / TILE) + x;
+        GeglColor    *color = gegl_color_new (NULL);
+
+        gegl_color_set_pixel (color, babl_format ("Y u8"), &value);
+        gegl_buffer_set_color (buffer, &rect, color);
+        g_object_unref (color);
+      }
+}
+
+int main(int argc, char *argv[])
+{
+  GeglRectangle  rect    = {0, 0, SIZE, SIZE};
+  GeglBuffer    *buffer;
+  gboolean       success = TRUE;
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = g_object_new (GEGL_TYPE_BUFFER,
+                         "x",           rect.x,
+                         "y",           rect.y,
+                         "width",       rect.width,
+                         "height",      rect.height,
+                         "tile-width",  TILE,
+                         "tile-height", TILE,
+                         "format",      babl_format ("Y u8"),
+                         NULL);
+
+  fill_tiles (buffer, 0);
+  success &= check_tiles ("filled", buffer, 0);
+
+  gegl_stats_reset (gegl_stats ());
+  success &= check_tiles ("read again", buffer, 0);
+
+  if (get_stat ("tile-cache-hot-hits") == 0)
+    {
+      printf ("read again: no hot tile hits\n");
+      success = FALSE;
+    }
+
+  if (get_stat ("tile-cache-hits") < get_stat ("tile-cache-hot-hits"))
+    {
+      printf ("read again: hot tile hits not counted as cache hits\n");
+      success = FALSE;
+    }
+
+  /* replaces the tiles in the cache */
+  fill_tiles (buffer, 100);
+  success &= check_tiles ("replaced", buffer, 100);
+
+  /* evicts the tiles, and has them read back from the backend */
+  g_object_set (gegl_config (), "tile-cache-size", (guint64) TILE * TILE * 4,
+                NULL);
+  fill_tiles (buffer, 50);
+  success &= check_tiles ("evicted", buffer, 50);
+  success &= check_tiles ("evicted again", buffer, 50);
+
+  /* a tile read between all others stays in the cache of 4 tiles, even
+   * when it is only ever taken from the hot tiles
+   */
+  g_object_set (gegl_config (), "tile-cache-policy", GEGL_TILE_CACHE_POLICY_LRU,
+                NULL);
+  read_tile (buffer, 0);
+
+  for (i = 1; i < (SIZE / TILE) * (SIZE / TILE); i++)
+    {
+      guint64 misses;
+
+      read_tile (buffer, i);
+
+      misses = get_stat ("tile-cache-misses");
+      if (read_tile (buffer, 0) != 50 || get_stat ("tile-cache-misses") != misses)
+        {
+          printf ("used tile: evicted after reading tile %d\n", i);
+          success = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,224 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks gegl:median-blur against the median computed by sorting the
+ * neighbourhood of every pixel, for 8 bit and float input, rendered at
+ * once and in pieces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH    160
+#define HEIGHT   300
+#define PIECE    70
+#define N_BINS   1024
+
+/* the bin of @value in the histograms of the float path */
+static gint
+float_bin (gfloat value)
+{
+  return (gint) (CLAMP (value, 0.0, 1.0) * (N_BINS - 1));
+}
+
+static gint
+compare_ints (gconstpointer a,
+              gconstpointer b)
+{
+  return *(const gint *) a - *(const gint *) b;
+}
+
+/* the median bin of component @c around @x, @y, the edges extended */
+static gint
+reference_median (const guchar *pixels,
+                  gboolean      is_u8,
+                  gint          x,
+                  gint          y,
+                  gint          c,
+                  gint          radius)
+{
+  gint  diameter = 2 * radius + 1;
+  gint *values   = g_new (gint, diameter * diameter);
+  gint  n        = 0;
+  gint  median;
+  gint  i, j;
+
+  for (j = y - radius; j <= y + radius; j++)
+    for (i = x - radius; i <= x + radius; i++)
+      {
+        gint idx = CLAMP (j, 0, HEIGHT - 1) * WIDTH + CLAMP (i, 0, WIDTH - 1);
+
+        if (is_u8)
+          values[n++] = pixels[idx * 4 + c];
+        else
+          values[n++] = float_bin (((const gfloat *) pixels)[idx * 4 + c]);
+      }
+
+  qsort (values, n, sizeof (gint), compare_ints);
+  median = values[(n - 1) / 2];
+
+  g_free (values);
+
+  return median;
+}
+
+/* renders the median of @input, in pieces of @piece pixels if nonzero */
+static guchar *
+render (GeglBuffer *input,
+        const Babl *format,
+        gint        radius,
+        gint        piece)
+{
+  gint      bpp    = babl_format_get_bytes_per_pixel (format);
+  guchar   *pixels = g_malloc (WIDTH * HEIGHT * bpp);
+  GeglNode *graph, *source, *node;
+  gint      x, y;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  node   = gegl_node_new_child (graph,
+                                "operation", "gegl:median-blur",
+                                "radius",    radius,
+                                NULL);
+  gegl_node_link (source, node);
+
+  if (! piece)
+    piece = MAX (WIDTH, HEIGHT);
+
+  for (y = 0; y < HEIGHT; y += piece)
+    for (x = 0; x < WIDTH; x += piece)
+      gegl_node_blit (node, 1.0,
+                      GEGL_RECTANGLE (x, y,
+                                      MIN (piece, WIDTH - x),
+                                      MIN (piece, HEIGHT - y)),
+                      format, pixels + (y * WIDTH + x) * bpp,
+                      WIDTH * bpp, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+
+  return pixels;
+}
+
+static gboolean
+check_median (const gchar *what,
+              const Babl  *format,
+              gint         radius,
+              gint         piece)
+{
+  gboolean    is_u8  = babl_format_get_type (format, 0) == babl_type ("u8");
+  gint        bpp    = babl_format_get_bytes_per_pixel (format);
+  GeglBuffer *input  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                                        format);
+  guchar     *pixels = g_malloc (WIDTH * HEIGHT * bpp);
+  guchar     *output;
+  GRand      *rand   = g_rand_new_with_seed (radius);
+  gboolean    success = TRUE;
+  gint        i, c;
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    {
+      /* few distinct values in places, for ties */
+      gint x     = i / 4 % WIDTH;
+      gint value = x < WIDTH / 2 ? g_rand_int_range (rand, 0, 256)
+                                 : g_rand_int_range (rand, 0, 4) * 64;
+
+      if (i % 4 == 3)
+        value = 255;
+
+      if (is_u8)
+        pixels[i] = value;
+      else
+        ((gfloat *) pixels)[i] = value / 255.0;
+    }
+
+  gegl_buffer_set (input, NULL, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  output = render (input, format, radius, piece);
+
+  for (i = 0; i < WIDTH * HEIGHT && success; i++)
+    for (c = 0; c < 3; c++)
+      {
+        gint expected = reference_median (pixels, is_u8,
+                                          i % WIDTH, i / WIDTH, c, radius);
+        gint result;
+
+        if (is_u8)
+          {
+            result = output[i * 4 + c];
+          }
+        else
+          {
+            gfloat value = ((gfloat *) output)[i * 4 + c];
+
+            result   = value * N_BINS + 0.5;
+            if (value != (gfloat) result / N_BINS)
+              result = -1;
+          }
+
+        if (result != expected)
+          {
+            printf ("%s, radius %d: pixel %d, %d component %d is %d, "
+                    "expected %d\n", what, radius,
+                    i % WIDTH, i / WIDTH, c, result, expected);
+            success = FALSE;
+            break;
+          }
+      }
+
+  g_rand_free (rand);
+  g_free (output);
+  g_free (pixels);
+  g_object_unref (input);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  const Babl *u8_format, *float_format;
+  gboolean    success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  /* only built along with the workshop operations */
+  if (! gegl_has_operation ("gegl:median-blur"))
+    {
+      gegl_exit ();
+      return SUCCESS;
+    }
+
+  u8_format    = babl_format ("R'G'B'A u8");
+  float_format = babl_format ("RGBA float");
+
+  success &= check_median ("u8",           u8_format,    1,  0);
+  success &= check_median ("u8",           u8_format,    7,  0);
+  success &= check_median ("u8 pieces",    u8_format,    7,  PIECE);
+  success &= check_median ("u8",           u8_format,    40, 0);
+  success &= check_median ("float",        float_format, 3,  0);
+  success &= check_median ("float pieces", float_format, 12, PIECE);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
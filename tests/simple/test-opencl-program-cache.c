@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Built programs only get reused by a new process, so the test runs
+ * itself with --compile a few times against a private cache directory.
+ * Run it with GEGL_USE_OPENCL=cpu to test on a CPU implementation such
+ * as pocl.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <glib/gstdio.h>
+
+#include "gegl.h"
+#include "opencl/gegl-cl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+#define SKIP     77
+
+static const char *cache_test_source =
+"__kernel void cache_test (__global float *out)                     \n"
+"{                                                                  \n"
+"  out[get_global_id (0)] = 1.0f;                                   \n"
+"}                                                                  \n";
+
+static gint
+compile (void)
+{
+  static const char *kernel_name[] = {"cache_test", NULL};
+  gint               result;
+
+  gegl_init (NULL, NULL);
+
+  if (!gegl_cl_is_accelerated ())
+    result = SKIP;
+  else if (gegl_cl_compile_and_build (cache_test_source, kernel_name))
+    result = SUCCESS;
+  else
+    result = FAILURE;
+
+  gegl_exit ();
+
+  return result;
+}
+
+static gint
+run_child (const gchar *self)
+{
+  gchar  *argv[] = {(gchar *) self, "--compile", NULL};
+  gint    status = -1;
+  gint    result;
+  GError *error = NULL;
+
+  if (!g_spawn_sync (NULL, argv, NULL, G_SPAWN_DEFAULT,
+                     NULL, NULL, NULL, NULL, &status, &error))
+    {
+      printf ("Could not run %s: %s\n", self, error->message);
+      g_error_free (error);
+      return FAILURE;
+    }
+
+  if (g_spawn_check_exit_status (status, &error))
+    return SUCCESS;
+
+  result = g_error_matches (error, G_SPAWN_EXIT_ERROR, SKIP) ? SKIP : FAILURE;
+  g_error_free (error);
+
+  return result;
+}
+
+/* maps the name of every cached program to the inode of its file, a
+ * program written again by the child gets a new inode.
+ */
+static GHashTable *
+list_cache (const gchar *dir)
+{
+  GHashTable  *files = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+  GDir        *gdir  = g_dir_open (dir, 0, NULL);
+  const gchar *name;
+
+  while (gdir && (name = g_dir_read_name (gdir)))
+    {
+      gchar     *path = g_build_filename (dir, name, NULL);
+      GStatBuf   st;
+
+      if (g_stat (path, &st) == 0)
+        g_hash_table_insert (files, g_strdup (name),
+                             GSIZE_TO_POINTER ((gsize) st.st_ino));
+
+      g_free (path);
+    }
+
+  if (gdir)
+    g_dir_close (gdir);
+
+  return files;
+}
+
+static void
+clear_cache (const gchar *dir)
+{
+  GHashTable     *files = list_cache (dir);
+  GHashTableIter  iter;
+  gpointer        name;
+
+  g_hash_table_iter_init (&iter, files);
+  while (g_hash_table_iter_next (&iter, &name, NULL))
+    {
+      gchar *path = g_build_filename (dir, name, NULL);
+
+      g_unlink (path);
+      g_free (path);
+    }
+
+  g_hash_table_unref (files);
+  g_rmdir (dir);
+}
+
+int main(int argc, char *argv[])
+{
+  gchar          *tmpdir;
+  GHashTable     *first;
+  GHashTable     *second;
+  GHashTableIter  iter;
+  gpointer        name;
+  gpointer        inode;
+  gint            result;
+
+  if (argc > 1 && !strcmp (argv[1], "--compile"))
+    return compile ();
+
+  tmpdir = g_dir_make_tmp ("test-opencl-program-cache-XXXXXX", NULL);
+  g_return_val_if_fail (tmpdir, FAILURE);
+
+  g_setenv ("GEGL_CL_CACHE", tmpdir, TRUE);
+
+  /* an empty cache gets filled */
+  result = run_child (argv[0]);
+  first  = list_cache (tmpdir);
+
+  if (result == SUCCESS && g_hash_table_size (first) == 0)
+    {
+      printf ("No programs were cached\n");
+      result = FAILURE;
+    }
+
+  /* corrupt binaries are compiled again from source and replaced */
+  if (result == SUCCESS)
+    {
+      g_hash_table_iter_init (&iter, first);
+      while (g_hash_table_iter_next (&iter, &name, NULL))
+        {
+          gchar *path = g_build_filename (tmpdir, name, NULL);
+
+          g_file_set_contents (path, "garbage", -1, NULL);
+          g_free (path);
+        }
+
+      result = run_child (argv[0]);
+    }
+
+  second = list_cache (tmpdir);
+
+  if (result == SUCCESS && g_hash_table_size (second) != g_hash_table_size (first))
+    {
+      printf ("Corrupt programs were not replaced\n");
+      result = FAILURE;
+    }
+
+  /* and valid binaries are used as they are */
+  if (result == SUCCESS)
+    result = run_child (argv[0]);
+
+  if (result == SUCCESS)
+    {
+      GHashTable *third = list_cache (tmpdir);
+
+      g_hash_table_iter_init (&iter, second);
+      while (g_hash_table_iter_next (&iter, &name, &inode))
+        {
+          if (g_hash_table_lookup (third, name) != inode)
+            {
+              printf ("Cached program %s was built again\n", (gchar *) name);
+              result = FAILURE;
+            }
+        }
+
+      g_hash_table_unref (third);
+    }
+
+  if (result == SKIP)
+    printf ("OpenCL disabled, skipping tests\n");
+
+  g_hash_table_unref (first);
+  g_hash_table_unref (second);
+
+  clear_cache (tmpdir);
+  g_free (tmpdir);
+
+  return result;
+}
@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks where the dispatcher sends requests of an operation with OpenCL
+ * support before any of them were measured: small ones and ones with a
+ * lot to transfer to the CPU, large ones to the device, and everything
+ * to the CPU for a node not using OpenCL.  Only the estimates are
+ * checked, no OpenCL device is needed.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "gegl.h"
+#include "gegl-plugin.h"
+#include "operation/gegl-operation-dispatch.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+static gboolean
+check_choice (const gchar   *what,
+              GeglOperation *operation,
+              glong          pixels,
+              gdouble        transfer_usecs,
+              gboolean       expected)
+{
+  gboolean use_opencl = gegl_operation_dispatch_choose (operation, pixels,
+                                                        transfer_usecs);
+
+  if (use_opencl != expected)
+    {
+      printf ("%s: %ld pixels went to the %s\n",
+              what, pixels, use_opencl ? "device" : "CPU");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglNode      *graph;
+  GeglNode      *node;
+  GeglOperation *operation;
+  gboolean       success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  graph     = gegl_node_new ();
+  node      = gegl_node_new_child (graph,
+                                   "operation", "gegl:exposure",
+                                   NULL);
+  operation = gegl_node_get_gegl_operation (node);
+
+  /* the launch costs more than processing it all on the CPU */
+  success &= check_choice ("small", operation, 32 * 32, 0.0, FALSE);
+
+  /* inputs already on the device */
+  success &= check_choice ("large", operation, 4096 * 4096, 0.0, TRUE);
+
+  /* inputs to be uploaded first */
+  success &= check_choice ("transfers", operation, 4096 * 4096, 1e6, FALSE);
+
+  g_object_set (node, "use-opencl", FALSE, NULL);
+
+  success &= check_choice ("no opencl", operation, 4096 * 4096, 0.0, FALSE);
+
+  g_object_unref (graph);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
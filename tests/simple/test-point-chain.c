@@ -0,0 +1,179 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Renders a chain of point filters and a point composer fused into a
+ * single pass, and with every node processed on its own, on one thread
+ * and on several, and checks that all of them give the same pixels.  The
+ * pixels get smaller along the chain, from RGBA to YA.
+ */
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define WIDTH    300
+#define HEIGHT   200
+
+static gfloat *
+render (GeglBuffer *input,
+        GeglBuffer *aux,
+        gint        threads,
+        gboolean    fused)
+{
+  gfloat   *pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  GeglNode *graph, *source, *aux_source, *invert, *contrast, *multiply;
+  GeglNode *mono, *grey;
+
+  g_object_set (gegl_config (), "threads", threads, NULL);
+
+  graph      = gegl_node_new ();
+  source     = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    input,
+                                    NULL);
+  aux_source = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer",    aux,
+                                    NULL);
+  invert     = gegl_node_new_child (graph,
+                                    "operation", "gegl:invert-linear",
+                                    NULL);
+  contrast   = gegl_node_new_child (graph,
+                                    "operation",  "gegl:brightness-contrast",
+                                    "contrast",   1.5,
+                                    "brightness", 0.1,
+                                    NULL);
+  multiply   = gegl_node_new_child (graph,
+                                    "operation", "gegl:multiply",
+                                    NULL);
+  mono       = gegl_node_new_child (graph,
+                                    "operation", "gegl:mono-mixer",
+                                    NULL);
+  grey       = gegl_node_new_child (graph,
+                                    "operation", "gegl:gray",
+                                    NULL);
+
+  gegl_node_link_many (source, invert, contrast, multiply, mono, grey, NULL);
+  gegl_node_connect_to (aux_source, "output", multiply, "aux");
+
+  /* only outputs used by a single node are fused, a second user that is
+   * never rendered keeps every node on its own
+   */
+  if (! fused)
+    {
+      GeglNode *nodes[] = { invert, contrast, multiply, mono };
+      gint      i;
+
+      for (i = 0; i < G_N_ELEMENTS (nodes); i++)
+        {
+          GeglNode *nop = gegl_node_new_child (graph,
+                                               "operation", "gegl:nop",
+                                               NULL);
+
+          gegl_node_link (nodes[i], nop);
+        }
+    }
+
+  gegl_node_blit (grey, 1.0, GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                  babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+
+  return pixels;
+}
+
+static gboolean
+compare (const gchar  *what,
+         const gfloat *expected,
+         const gfloat *result)
+{
+  gint i;
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    if (expected[i] != result[i])
+      {
+        printf ("%s: pixel %d, %d component %d is %f, expected %f\n",
+                what, i / 4 % WIDTH, i / 4 / WIDTH, i % 4,
+                result[i], expected[i]);
+        return FALSE;
+      }
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglBuffer *input;
+  GeglBuffer *aux;
+  gfloat     *pixels;
+  gfloat     *expected;
+  gfloat     *result;
+  GRand      *rand;
+  gboolean    success = TRUE;
+  gint        i;
+
+  gegl_init (&argc, &argv);
+
+  /* nothing may be taken from what an earlier render stored */
+  g_object_set (gegl_config (),
+                "use-opencl",   FALSE,
+                "result-cache", FALSE,
+                NULL);
+
+  input  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGBA float"));
+  aux    = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                            babl_format ("RGB float"));
+  pixels = g_new (gfloat, WIDTH * HEIGHT * 4);
+  rand   = g_rand_new_with_seed (5);
+
+  for (i = 0; i < WIDTH * HEIGHT * 4; i++)
+    pixels[i] = g_rand_double (rand);
+  gegl_buffer_set (input, NULL, 0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  for (i = 0; i < WIDTH * HEIGHT * 3; i++)
+    pixels[i] = g_rand_double (rand);
+  gegl_buffer_set (aux, NULL, 0, babl_format ("RGB float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  expected = render (input, aux, 1, FALSE);
+
+  result = render (input, aux, 1, TRUE);
+  success &= compare ("fused", expected, result);
+  g_free (result);
+
+  result = render (input, aux, 4, FALSE);
+  success &= compare ("threads", expected, result);
+  g_free (result);
+
+  result = render (input, aux, 4, TRUE);
+  success &= compare ("fused threads", expected, result);
+  g_free (result);
+
+  g_free (expected);
+  g_free (pixels);
+  g_rand_free (rand);
+  g_object_unref (aux);
+  g_object_unref (input);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
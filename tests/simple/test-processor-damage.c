@@ -0,0 +1,203 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that a processor, after its graph changed, only renders the
+ * damaged part of its rectangle again, both when rendering into a node's
+ * cache and when processing a sink without one.
+ */
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     256
+
+static guint64
+get_stat (const gchar *name)
+{
+  guint64 value;
+
+  g_object_get (gegl_stats (), name, &value, NULL);
+
+  return value;
+}
+
+static void
+run (GeglProcessor *processor)
+{
+  gdouble progress;
+
+  while (gegl_processor_work (processor, &progress));
+}
+
+static gboolean
+check_pixel (GeglBuffer  *buffer,
+             GeglNode    *node,
+             gint         x,
+             gint         y,
+             gfloat       expected)
+{
+  GeglRectangle rect = {x, y, 1, 1};
+  gfloat        pixel[4];
+
+  if (buffer)
+    gegl_buffer_get (buffer, &rect, 1.0, babl_format ("RGBA float"), pixel,
+                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  else
+    gegl_node_blit (node, 1.0, &rect, babl_format ("RGBA float"), pixel,
+                    GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+  if (pixel[0] != expected)
+    {
+      printf ("pixel at %d,%d is %f, expected %f\n", x, y, pixel[0], expected);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* renders @node (the sink writing to @output, when given), damages part
+ * of @input, and renders again
+ */
+static gboolean
+test_damage (GeglNode   *node,
+             GeglBuffer *input,
+             GeglBuffer *output)
+{
+  GeglRectangle  rect    = {0, 0, SIZE, SIZE};
+  GeglRectangle  damage1 = {100, 100, 10, 10};
+  GeglRectangle  damage2 = {105, 105, 10, 10};
+  GeglColor     *white   = gegl_color_new ("white");
+  GeglProcessor *processor;
+  guint64        rendered;
+  gboolean       success = TRUE;
+
+  processor = gegl_node_new_processor (node, &rect);
+
+  gegl_stats_reset (gegl_stats ());
+  run (processor);
+
+  if (get_stat ("processor-pixels-rendered") < SIZE * SIZE)
+    {
+      printf ("first pass rendered %" G_GUINT64_FORMAT " pixels\n",
+              get_stat ("processor-pixels-rendered"));
+      success = FALSE;
+    }
+
+  /* overlapping damage */
+  gegl_buffer_set_color (input, &damage1, white);
+  gegl_buffer_set_color (input, &damage2, white);
+
+  gegl_stats_reset (gegl_stats ());
+  run (processor);
+
+  rendered = get_stat ("processor-pixels-rendered");
+
+  if (get_stat ("processor-pixels-requested") != SIZE * SIZE)
+    {
+      printf ("second pass requested %" G_GUINT64_FORMAT " pixels\n",
+              get_stat ("processor-pixels-requested"));
+      success = FALSE;
+    }
+
+  if (rendered < 15 * 15 || rendered > 32 * 32)
+    {
+      printf ("second pass rendered %" G_GUINT64_FORMAT " pixels\n", rendered);
+      success = FALSE;
+    }
+
+  success &= check_pixel (output, node, 50, 50, 1.0);
+  success &= check_pixel (output, node, 100, 100, 0.0);
+  success &= check_pixel (output, node, 114, 114, 0.0);
+
+  /* nothing changed, nothing to do */
+  gegl_stats_reset (gegl_stats ());
+  run (processor);
+
+  if (get_stat ("processor-pixels-rendered") != 0)
+    {
+      printf ("undamaged pass rendered %" G_GUINT64_FORMAT " pixels\n",
+              get_stat ("processor-pixels-rendered"));
+      success = FALSE;
+    }
+
+  g_object_unref (processor);
+  g_object_unref (white);
+
+  return success;
+}
+
+static gboolean
+test (gboolean sink)
+{
+  GeglRectangle  rect   = {0, 0, SIZE, SIZE};
+  GeglBuffer    *input  = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  GeglBuffer    *output = NULL;
+  GeglColor     *black  = gegl_color_new ("black");
+  GeglNode      *graph, *source, *invert, *write;
+  gboolean       success;
+
+  gegl_buffer_set_color (input, &rect, black);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+  gegl_node_link (source, invert);
+
+  if (sink)
+    {
+      output = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+      write  = gegl_node_new_child (graph,
+                                    "operation", "gegl:write-buffer",
+                                    "buffer",    output,
+                                    NULL);
+      gegl_node_link (invert, write);
+
+      success = test_damage (write, input, output);
+      g_object_unref (output);
+    }
+  else
+    {
+      success = test_damage (invert, input, NULL);
+    }
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (black);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  gboolean success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  success &= test (FALSE);
+  success &= test (TRUE);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,190 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that a render queue serves urgent requests first, reports
+ * progress, honours cancellation, and leaves the rendered pixels in the
+ * node's cache.
+ */
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     2048
+
+typedef struct
+{
+  GMainLoop *loop;
+  guint      order[3];
+  gboolean   completed[3];
+  guint      ids[3];
+  gint       n_done;
+  gint       n_progress;
+} TestData;
+
+static gint
+request_index (TestData *data,
+               guint     id)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (data->ids); i++)
+    if (data->ids[i] == id)
+      return i;
+
+  return -1;
+}
+
+static void
+progress_cb (GeglRenderQueue *queue,
+             guint            id,
+             gdouble          progress,
+             TestData        *data)
+{
+  data->n_progress++;
+}
+
+static void
+done_cb (GeglRenderQueue *queue,
+         guint            id,
+         gboolean         completed,
+         TestData        *data)
+{
+  gint i = request_index (data, id);
+
+  if (i >= 0)
+    {
+      data->order[data->n_done] = i;
+      data->completed[i]        = completed;
+    }
+
+  if (++data->n_done == G_N_ELEMENTS (data->ids))
+    g_main_loop_quit (data->loop);
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  TestData *data = user_data;
+
+  printf ("timed out\n");
+  g_main_loop_quit (data->loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglRectangle    whole     = {0, 0, SIZE, SIZE};
+  GeglRectangle    view      = {SIZE / 2, SIZE / 2, 64, 64};
+  GeglRectangle    panned    = {0, 0, 64, 64};
+  GeglRectangle    pixel     = {SIZE / 2 + 10, SIZE / 2 + 10, 1, 1};
+  GeglBuffer      *input;
+  GeglColor       *black;
+  GeglNode        *graph, *source, *invert;
+  GeglRenderQueue *queue;
+  GCancellable    *cancellable;
+  TestData         data      = { NULL, };
+  gfloat           value[4]  = { 0, };
+  gboolean         success   = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  input = gegl_buffer_new (&whole, babl_format ("RGBA float"));
+  black = gegl_color_new ("black");
+  gegl_buffer_set_color (input, &whole, black);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert-linear",
+                                NULL);
+  gegl_node_link (source, invert);
+
+  data.loop   = g_main_loop_new (NULL, FALSE);
+  queue       = gegl_render_queue_new ();
+  cancellable = g_cancellable_new ();
+
+  g_signal_connect (queue, "progress", G_CALLBACK (progress_cb), &data);
+  g_signal_connect (queue, "done", G_CALLBACK (done_cb), &data);
+
+  /* the whole document first, then the view on top of it, and a request
+   * superseded by panning before it got to run
+   */
+  gegl_render_queue_freeze (queue);
+  data.ids[0] = gegl_render_queue_submit (queue, invert, &whole, 1.0,
+                                          G_PRIORITY_LOW, NULL);
+  data.ids[1] = gegl_render_queue_submit (queue, invert, &view, 1.0,
+                                          G_PRIORITY_HIGH, NULL);
+  data.ids[2] = gegl_render_queue_submit (queue, invert, &panned, 1.0,
+                                          G_PRIORITY_HIGH, cancellable);
+  g_cancellable_cancel (cancellable);
+  gegl_render_queue_thaw (queue);
+
+  g_timeout_add_seconds (60, timeout_cb, &data);
+  g_main_loop_run (data.loop);
+
+  if (data.n_done != 3)
+    {
+      printf ("%d requests done, expected 3\n", data.n_done);
+      success = FALSE;
+    }
+  else
+    {
+      if (data.completed[2] || ! data.completed[0] || ! data.completed[1])
+        {
+          printf ("wrong completion states\n");
+          success = FALSE;
+        }
+
+      if (data.order[2] != 0)
+        {
+          printf ("the low priority request did not finish last\n");
+          success = FALSE;
+        }
+    }
+
+  if (data.n_progress == 0)
+    {
+      printf ("no progress reported\n");
+      success = FALSE;
+    }
+
+  gegl_node_blit (invert, 1.0, &pixel, babl_format ("RGBA float"), value,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE | GEGL_BLIT_DIRTY);
+
+  if (value[0] != 1.0)
+    {
+      printf ("cache holds %f, expected 1.0\n", value[0]);
+      success = FALSE;
+    }
+
+  g_object_unref (queue);
+  g_object_unref (cancellable);
+  g_main_loop_unref (data.loop);
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (black);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
@@ -0,0 +1,174 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the resamplers of gegl-algorithms.c, which use the vector
+ * versions where the CPU has them, with the plain C ones.  The 2x2
+ * downscales sum in the same order, so only -ffast-math can make them
+ * differ at all.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "gegl.h"
+#include "gegl-algorithms.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* odd, so the vector loops leave pixels over */
+#define WIDTH    69
+#define HEIGHT   21
+#define PADDING  4
+
+typedef void (* DownscaleFunc) (gint    bpp,
+                                gint    src_width,
+                                gint    src_height,
+                                guchar *src_data,
+                                gint    src_rowstride,
+                                guchar *dst_data,
+                                gint    dst_rowstride);
+
+typedef void (* ResampleFunc) (guchar              *dest_buf,
+                               const guchar        *source_buf,
+                               const GeglRectangle *dst_rect,
+                               const GeglRectangle *src_rect,
+                               gint                 s_rowstride,
+                               gdouble              scale,
+                               gint                 bpp,
+                               gint                 d_rowstride);
+
+static gboolean
+compare (const gchar *test,
+         const Babl  *format,
+         guchar      *expected,
+         guchar      *actual,
+         gint         size,
+         gdouble      tolerance)
+{
+  gint i;
+
+  if (babl_format_get_type (format, 0) == babl_type ("float"))
+    {
+      for (i = 0; i < size / sizeof (gfloat); i++)
+        {
+          gfloat e = ((gfloat *) expected)[i];
+          gfloat a = ((gfloat *) actual)[i];
+
+          if (fabs (e - a) > tolerance)
+            {
+              printf ("%s of %s differs at %d: %f != %f\n",
+                      test, babl_get_name (format), i, a, e);
+              return FALSE;
+            }
+        }
+    }
+  else
+    {
+      for (i = 0; i < size; i++)
+        {
+          if (abs (expected[i] - actual[i]) > tolerance)
+            {
+              printf ("%s of %s differs at %d: %d != %d\n",
+                      test, babl_get_name (format), i, actual[i], expected[i]);
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+test_format (const Babl    *format,
+             DownscaleFunc  downscale,
+             ResampleFunc   boxfilter,
+             ResampleFunc   bilinear)
+{
+  GeglRectangle  src_rect  = {0, 0, WIDTH, HEIGHT};
+  GeglRectangle  dst_rect  = {2, 1, 25, 7};
+  gint           bpp       = babl_format_get_bytes_per_pixel (format);
+  gint           rowstride = (WIDTH + PADDING) * bpp;
+  gint           size      = rowstride * (HEIGHT + PADDING);
+  gfloat        *rgba      = g_new (gfloat, size);
+  guchar        *src       = g_malloc (size);
+  guchar        *expected  = g_malloc0 (size);
+  guchar        *actual    = g_malloc0 (size);
+  const guchar  *origin    = src + 2 * rowstride + 2 * bpp;
+  GRand         *rand      = g_rand_new_with_seed (42);
+  gboolean       success   = TRUE;
+  gint           i;
+
+  for (i = 0; i < size; i++)
+    rgba[i] = g_rand_double (rand);
+
+  babl_process (babl_fish (babl_format ("RGBA float"), format),
+                rgba, src, size / bpp);
+
+  downscale (bpp, WIDTH, HEIGHT, src, rowstride, expected, rowstride);
+  gegl_downscale_2x2 (format, WIDTH, HEIGHT, src, rowstride, actual, rowstride);
+  success &= compare ("downscale", format, expected, actual, size, 1e-6);
+
+  memset (expected, 0, size);
+  memset (actual, 0, size);
+  boxfilter (expected, origin, &dst_rect, &src_rect, rowstride, 0.63, bpp, rowstride);
+  gegl_resample_boxfilter (actual, origin, &dst_rect, &src_rect, rowstride, 0.63,
+                           format, rowstride);
+  success &= compare ("boxfilter", format, expected, actual, size, 1e-5);
+
+  memset (expected, 0, size);
+  memset (actual, 0, size);
+  bilinear (expected, origin, &dst_rect, &src_rect, rowstride, 0.63, bpp, rowstride);
+  gegl_resample_bilinear (actual, origin, &dst_rect, &src_rect, rowstride, 0.63,
+                          format, rowstride);
+  success &= compare ("bilinear", format, expected, actual, size, 1e-5);
+
+  g_rand_free (rand);
+  g_free (rgba);
+  g_free (src);
+  g_free (expected);
+  g_free (actual);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  gboolean success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  success &= test_format (babl_format ("RGBA float"),
+                          gegl_downscale_2x2_float,
+                          gegl_resample_boxfilter_float,
+                          gegl_resample_bilinear_float);
+  success &= test_format (babl_format ("RaGaBaA float"),
+                          gegl_downscale_2x2_float,
+                          gegl_resample_boxfilter_float,
+                          gegl_resample_bilinear_float);
+  success &= test_format (babl_format ("Y float"),
+                          gegl_downscale_2x2_float,
+                          gegl_resample_boxfilter_float,
+                          gegl_resample_bilinear_float);
+  success &= test_format (babl_format ("R'G'B'A u8"),
+                          gegl_downscale_2x2_u8,
+                          gegl_resample_boxfilter_u8,
+                          gegl_resample_bilinear_u8);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
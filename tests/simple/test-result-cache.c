@@ -0,0 +1,137 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that a node computing the same thing as another node, with the
+ * same operation and properties on the same source, takes its results
+ * from the result cache, and that changed properties or a changed source
+ * are rendered anew.
+ */
+
+#include <stdio.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     256
+
+static guint64
+get_stat (const gchar *name)
+{
+  guint64 value;
+
+  g_object_get (gegl_stats (), name, &value, NULL);
+
+  return value;
+}
+
+/* renders @node, checking the result and whether it came from the result
+ * cache
+ */
+static gboolean
+check_render (const gchar *what,
+              GeglNode    *node,
+              gfloat       expected,
+              gboolean     expect_hit)
+{
+  GeglRectangle  rect = {0, 0, SIZE, SIZE};
+  gfloat        *pixels = g_new (gfloat, SIZE * SIZE * 4);
+  gboolean       success = TRUE;
+  gboolean       hit;
+  gint           i;
+
+  gegl_stats_reset (gegl_stats ());
+
+  gegl_node_blit (node, 1.0, &rect, babl_format ("RGBA float"), pixels,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  hit = get_stat ("result-cache-hits") > 0;
+
+  if (hit != expect_hit)
+    {
+      printf ("%s: %s the result cache\n", what,
+              hit ? "unexpectedly hit" : "missed");
+      success = FALSE;
+    }
+
+  for (i = 0; i < SIZE * SIZE; i++)
+    if (pixels[i * 4] != expected)
+      {
+        printf ("%s: pixel %d is %f, expected %f\n",
+                what, i, pixels[i * 4], expected);
+        success = FALSE;
+        break;
+      }
+
+  g_free (pixels);
+
+  return success;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglRectangle  rect    = {0, 0, SIZE, SIZE};
+  GeglBuffer    *input;
+  GeglColor     *black, *white;
+  GeglNode      *graph, *source, *first, *second;
+  gboolean       success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  input = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  black = gegl_color_new ("black");
+  white = gegl_color_new ("white");
+  gegl_buffer_set_color (input, &rect, black);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+
+  /* two separate chains, doing the same on the same source */
+  first  = gegl_node_new_child (graph,
+                                "operation",  "gegl:brightness-contrast",
+                                "brightness", 0.25,
+                                NULL);
+  second = gegl_node_new_child (graph,
+                                "operation",  "gegl:brightness-contrast",
+                                "brightness", 0.25,
+                                NULL);
+  gegl_node_link (source, first);
+  gegl_node_link (source, second);
+
+  success &= check_render ("first", first, 0.25, FALSE);
+  success &= check_render ("second", second, 0.25, TRUE);
+
+  gegl_node_set (second, "brightness", 0.5, NULL);
+  success &= check_render ("changed", second, 0.5, FALSE);
+
+  gegl_node_set (second, "brightness", 0.25, NULL);
+  success &= check_render ("restored", second, 0.25, TRUE);
+
+  gegl_buffer_set_color (input, &rect, white);
+  success &= check_render ("new source", second, 1.25, FALSE);
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (black);
+  g_object_unref (white);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
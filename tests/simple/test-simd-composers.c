@@ -0,0 +1,226 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The generated composers pick their SIMD kernels once, at class init,
+ * so the scalar results come from a child run with --scalar, which turns
+ * CPU acceleration off before any operation class exists and writes its
+ * results to stdout.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "gegl.h"
+#include "gegl-cpuaccel-private.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+/* odd, so the kernels leave pixels to the scalar loops */
+#define WIDTH     67
+#define HEIGHT    3
+#define N_FLOATS  (WIDTH * HEIGHT * 4)
+
+#define TOLERANCE 1e-5
+
+static const gchar *value_ops[] =
+{
+  "gegl:add", "gegl:subtract", "gegl:multiply"
+};
+
+static const gchar *aux_ops[] =
+{
+  "gegl:add", "gegl:subtract", "gegl:multiply",
+  "svg:darken", "svg:difference", "svg:exclusion", "svg:hard-light",
+  "svg:lighten", "svg:multiply", "svg:overlay", "svg:plus", "svg:screen",
+  "svg:clear", "svg:dst", "svg:dst-atop", "svg:dst-in", "svg:dst-out",
+  "svg:dst-over", "svg:src", "svg:src-atop", "svg:src-in", "svg:src-out",
+  "svg:xor"
+};
+
+#define N_RESULTS (G_N_ELEMENTS (value_ops) + G_N_ELEMENTS (aux_ops))
+
+static GeglBuffer *
+make_buffer (guint32 seed)
+{
+  const Babl    *format = babl_format ("RaGaBaA float");
+  GeglRectangle  rect   = {0, 0, WIDTH, HEIGHT};
+  GeglBuffer    *buffer = gegl_buffer_new (&rect, format);
+  GRand         *rand   = g_rand_new_with_seed (seed);
+  gfloat        *pixels = g_new (gfloat, N_FLOATS);
+  gint           i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      gfloat alpha = g_rand_double (rand);
+
+      pixels[4 * i + 0] = alpha * g_rand_double (rand);
+      pixels[4 * i + 1] = alpha * g_rand_double (rand);
+      pixels[4 * i + 2] = alpha * g_rand_double (rand);
+      pixels[4 * i + 3] = alpha;
+    }
+
+  gegl_buffer_set (buffer, &rect, 0, format, pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static void
+render_op (GeglBuffer  *input,
+           GeglBuffer  *aux,
+           const gchar *operation,
+           gfloat      *result)
+{
+  GeglRectangle  rect = {0, 0, WIDTH, HEIGHT};
+  GeglNode      *graph;
+  GeglNode      *input_node;
+  GeglNode      *op_node;
+
+  graph      = gegl_node_new ();
+  input_node = gegl_node_new_child (graph,
+                                    "operation", "gegl:buffer-source",
+                                    "buffer", input,
+                                    NULL);
+  op_node    = gegl_node_new_child (graph,
+                                    "operation", operation,
+                                    NULL);
+
+  gegl_node_connect_to (input_node, "output", op_node, "input");
+
+  if (aux)
+    {
+      GeglNode *aux_node = gegl_node_new_child (graph,
+                                                "operation", "gegl:buffer-source",
+                                                "buffer", aux,
+                                                NULL);
+
+      gegl_node_connect_to (aux_node, "output", op_node, "aux");
+    }
+  else
+    {
+      gegl_node_set (op_node, "value", 0.37, NULL);
+    }
+
+  gegl_node_blit (op_node, 1.0, &rect, babl_format ("RaGaBaA float"),
+                  result, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_object_unref (graph);
+}
+
+/* the results of all operations, one after the other */
+static gfloat *
+render (void)
+{
+  GeglBuffer *input   = make_buffer (1);
+  GeglBuffer *aux     = make_buffer (2);
+  gfloat     *results = g_new0 (gfloat, N_RESULTS * N_FLOATS);
+  gint        i;
+
+  for (i = 0; i < G_N_ELEMENTS (value_ops); i++)
+    render_op (input, NULL, value_ops[i], results + i * N_FLOATS);
+
+  for (i = 0; i < G_N_ELEMENTS (aux_ops); i++)
+    render_op (input, aux, aux_ops[i],
+               results + (G_N_ELEMENTS (value_ops) + i) * N_FLOATS);
+
+  g_object_unref (input);
+  g_object_unref (aux);
+
+  return results;
+}
+
+static gint
+render_scalar (void)
+{
+  gfloat *results;
+  gsize   size = N_RESULTS * N_FLOATS * sizeof (gfloat);
+  gint    result;
+
+  gegl_cpu_accel_set_use (FALSE);
+  gegl_init (NULL, NULL);
+
+  results = render ();
+  result  = fwrite (results, 1, size, stdout) == size ? SUCCESS : FAILURE;
+
+  g_free (results);
+  gegl_exit ();
+
+  return result;
+}
+
+static const gchar *
+result_name (gint n)
+{
+  if (n < G_N_ELEMENTS (value_ops))
+    return value_ops[n];
+  else
+    return aux_ops[n - G_N_ELEMENTS (value_ops)];
+}
+
+int main(int argc, char *argv[])
+{
+  gchar  *child_argv[] = {argv[0], "--scalar", NULL};
+  gchar  *scalar       = NULL;
+  gint    status       = -1;
+  gfloat *simd;
+  GError *error        = NULL;
+  gint    result       = SUCCESS;
+  gint    i, j;
+
+  if (argc > 1 && !strcmp (argv[1], "--scalar"))
+    return render_scalar ();
+
+  if (!g_spawn_sync (NULL, child_argv, NULL, G_SPAWN_DEFAULT,
+                     NULL, NULL, &scalar, NULL, &status, &error) ||
+      !g_spawn_check_exit_status (status, &error))
+    {
+      printf ("Could not render the scalar results: %s\n", error->message);
+      g_error_free (error);
+      g_free (scalar);
+      return FAILURE;
+    }
+
+  gegl_init (&argc, &argv);
+
+  simd = render ();
+
+  for (i = 0; i < N_RESULTS; i++)
+    {
+      const gfloat *expected = (const gfloat *) scalar + i * N_FLOATS;
+      const gfloat *actual   = simd + i * N_FLOATS;
+
+      for (j = 0; j < N_FLOATS; j++)
+        {
+          if (fabs (actual[j] - expected[j]) > TOLERANCE)
+            {
+              printf ("%s differs at pixel %d: %f != %f\n",
+                      result_name (i), j / 4, actual[j], expected[j]);
+              result = FAILURE;
+              break;
+            }
+        }
+    }
+
+  g_free (simd);
+  g_free (scalar);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the tile data allocator: alignment, reuse of freed blocks,
+ * cleared allocations, and that trimming gives free blocks back while
+ * they remain usable, also the ones kept by a thread for itself.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "gegl.h"
+#include "buffer/gegl-tile-alloc.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_BLOCKS 64
+
+static const gsize sizes[] = { 100, 128 * 64 * 4, 128 * 64 * 12,
+                               128 * 64 * 16, 1024 * 1024 * 4 };
+
+static gboolean
+test_alloc (void)
+{
+  gboolean success = TRUE;
+  gint     i;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      guchar *data = gegl_tile_alloc0 (sizes[i]);
+      gsize   j;
+
+      if ((guintptr) data % GEGL_TILE_ALLOC_ALIGN)
+        {
+          printf ("%" G_GSIZE_FORMAT " bytes not aligned\n", sizes[i]);
+          success = FALSE;
+        }
+
+      for (j = 0; j < sizes[i]; j++)
+        if (data[j])
+          {
+            printf ("%" G_GSIZE_FORMAT " bytes not cleared\n", sizes[i]);
+            success = FALSE;
+            break;
+          }
+
+      memset (data, 0xff, sizes[i]);
+      gegl_tile_free (data);
+    }
+
+  return success;
+}
+
+static gboolean
+test_reuse (void)
+{
+  gpointer first;
+  gpointer second;
+
+  first = gegl_tile_alloc (128 * 64 * 16);
+  gegl_tile_free (first);
+  second = gegl_tile_alloc (128 * 64 * 16);
+  gegl_tile_free (second);
+
+  if (first != second)
+    {
+      printf ("freed block was not reused\n");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gpointer
+churn_thread (gpointer data)
+{
+  gpointer blocks[N_BLOCKS] = { NULL, };
+  gint     i;
+
+  for (i = 0; i < 100 * N_BLOCKS; i++)
+    {
+      gint slot = i % N_BLOCKS;
+
+      gegl_tile_free (blocks[slot]);
+      blocks[slot] = gegl_tile_alloc (sizes[1 + i % 3]);
+      memset (blocks[slot], slot, sizes[1 + i % 3]);
+    }
+
+  for (i = 0; i < N_BLOCKS; i++)
+    gegl_tile_free (blocks[i]);
+
+  return NULL;
+}
+
+static gboolean
+test_trim (void)
+{
+  GThread  *threads[4];
+  guint64   in_use = gegl_tile_alloc_get_in_use ();
+  guchar   *data;
+  gboolean  success = TRUE;
+  gint      i;
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("churn", churn_thread, NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  if (gegl_tile_alloc_get_in_use () != in_use)
+    {
+      printf ("in-use bytes %" G_GUINT64_FORMAT " != %" G_GUINT64_FORMAT "\n",
+              gegl_tile_alloc_get_in_use (), in_use);
+      success = FALSE;
+    }
+
+  /* the blocks of the exited threads are free now */
+  gegl_tile_alloc_trim (0);
+
+  if (gegl_tile_alloc_get_released () == 0)
+    {
+      printf ("trimming released nothing\n");
+      success = FALSE;
+    }
+
+  data = gegl_tile_alloc0 (sizes[3]);
+  for (i = 0; i < sizes[3]; i++)
+    if (data[i])
+      {
+        printf ("released block not cleared\n");
+        success = FALSE;
+        break;
+      }
+  gegl_tile_free (data);
+
+  return success;
+}
+
+static gpointer
+free_one_thread (gpointer data)
+{
+  gegl_tile_free (gegl_tile_alloc (sizes[1]));
+
+  return NULL;
+}
+
+static gboolean
+test_trim_thread_cache (void)
+{
+  gpointer blocks[4];
+  guint64  released;
+  gint     i;
+
+  /* few enough to stay in the cache of this thread */
+  for (i = 0; i < G_N_ELEMENTS (blocks); i++)
+    blocks[i] = gegl_tile_alloc (sizes[2]);
+  for (i = 0; i < G_N_ELEMENTS (blocks); i++)
+    gegl_tile_free (blocks[i]);
+
+  /* the block of the exited thread gives the trim something to release,
+   * only then the threads flush their caches
+   */
+  g_thread_join (g_thread_new ("free-one", free_one_thread, NULL));
+  gegl_tile_alloc_trim (0);
+  released = gegl_tile_alloc_get_released ();
+
+  /* the next allocation hands the cached blocks to the next trim */
+  gegl_tile_free (gegl_tile_alloc (sizes[0]));
+  gegl_tile_alloc_trim (0);
+
+  if (gegl_tile_alloc_get_released () < released + G_N_ELEMENTS (blocks) * sizes[2])
+    {
+      printf ("trimming left the blocks cached by the thread\n");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+  gboolean success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  success &= test_alloc ();
+  success &= test_reuse ();
+  success &= test_trim ();
+  success &= test_trim_thread_cache ();
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}
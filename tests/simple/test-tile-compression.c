@@ -0,0 +1,142 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include "buffer/gegl-tile-compression.h"
+
+
+#define ADD_TEST(function) g_test_add_func ("/tile-compression/" #function, function);
+
+#define TILE_SIZE (128 * 64 * 16)
+
+
+static void
+round_trip (const guchar *data,
+            gboolean      must_compress)
+{
+  GeglTileCompression compression;
+
+  for (compression = GEGL_TILE_COMPRESSION_RLE;
+       compression <= GEGL_TILE_COMPRESSION_ZLIB;
+       compression++)
+    {
+      guchar   *compressed   = g_malloc (TILE_SIZE);
+      guchar   *decompressed = g_malloc0 (TILE_SIZE);
+      gsize     compressed_size;
+      gboolean  success;
+
+      success = gegl_tile_compress (compression, 16, data, TILE_SIZE,
+                                    compressed, &compressed_size);
+
+      g_assert (success || ! must_compress);
+
+      if (success)
+        {
+          g_assert_cmpuint (compressed_size, <, TILE_SIZE);
+          g_assert (gegl_tile_decompress (compression, 16,
+                                          compressed, compressed_size,
+                                          decompressed, TILE_SIZE));
+          g_assert (memcmp (data, decompressed, TILE_SIZE) == 0);
+        }
+
+      g_free (compressed);
+      g_free (decompressed);
+    }
+}
+
+/* a flat color compresses with every method */
+static void
+flat (void)
+{
+  gfloat *data = g_new (gfloat, TILE_SIZE / sizeof (gfloat));
+  gint    i;
+
+  for (i = 0; i < TILE_SIZE / sizeof (gfloat); i++)
+    data[i] = (i % 4 == 3) ? 1.0 : 0.25;
+
+  round_trip ((guchar *) data, TRUE);
+
+  g_free (data);
+}
+
+/* 8 bit data stored as float */
+static void
+quantized (void)
+{
+  gfloat *data = g_new (gfloat, TILE_SIZE / sizeof (gfloat));
+  GRand  *rand = g_rand_new_with_seed (42);
+  gint    i;
+
+  for (i = 0; i < TILE_SIZE / sizeof (gfloat); i++)
+    data[i] = g_rand_int_range (rand, 0, 256) / 255.0;
+
+  round_trip ((guchar *) data, FALSE);
+
+  g_rand_free (rand);
+  g_free (data);
+}
+
+/* noise does not compress, but must not be corrupted either */
+static void
+noise (void)
+{
+  guchar *data = g_malloc (TILE_SIZE);
+  GRand  *rand = g_rand_new_with_seed (42);
+  gint    i;
+
+  for (i = 0; i < TILE_SIZE; i++)
+    data[i] = g_rand_int (rand);
+
+  round_trip (data, FALSE);
+
+  g_rand_free (rand);
+  g_free (data);
+}
+
+/* corrupt input is rejected rather than overflowing the tile */
+static void
+corrupt (void)
+{
+  guchar  compressed[64];
+  guchar *data = g_malloc (TILE_SIZE);
+
+  memset (compressed, 0xff, sizeof (compressed));
+
+  g_assert (! gegl_tile_decompress (GEGL_TILE_COMPRESSION_RLE, 16,
+                                    compressed, sizeof (compressed),
+                                    data, TILE_SIZE));
+  g_assert (! gegl_tile_decompress (GEGL_TILE_COMPRESSION_FAST, 16,
+                                    compressed, sizeof (compressed),
+                                    data, TILE_SIZE));
+
+  g_free (data);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gegl_init (&argc, &argv);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (flat);
+  ADD_TEST (quantized);
+  ADD_TEST (noise);
+  ADD_TEST (corrupt);
+
+  return g_test_run ();
+}
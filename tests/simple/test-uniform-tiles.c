@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that buffers filled with a single color read back right, also
+ * after writing into one of their shared tiles, and that point operations
+ * taking their single pixel shortcut on them compute the same as when
+ * processing every pixel.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define SIZE     512
+#define EPSILON  0.0001
+
+/* checks that @rect of @buffer is @value in the color components and
+ * opaque, or reports the first pixel that is not
+ */
+static gboolean
+check_rect (const gchar         *what,
+            GeglBuffer          *buffer,
+            const GeglRectangle *rect,
+            gfloat               value)
+{
+  gfloat   *pixels = g_new (gfloat, rect->width * rect->height * 4);
+  gboolean  success = TRUE;
+  gint      i;
+
+  gegl_buffer_get (buffer, rect, 1.0, babl_format ("RGBA float"), pixels,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (i = 0; i < rect->width * rect->height * 4; i++)
+    {
+      gfloat expected = i % 4 == 3 ? 1.0 : value;
+
+      if (fabs (pixels[i] - expected) > EPSILON)
+        {
+          printf ("%s: pixel %d, %d is %f, expected %f\n", what,
+                  rect->x + i / 4 % rect->width,
+                  rect->y + i / 4 / rect->width,
+                  pixels[i], expected);
+          success = FALSE;
+          break;
+        }
+    }
+
+  g_free (pixels);
+
+  return success;
+}
+
+static GeglNode *
+render (GeglNode    *graph,
+        GeglBuffer  *input,
+        GeglBuffer  *aux,
+        const gchar *operation)
+{
+  GeglNode *source, *node;
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    input,
+                                NULL);
+  node   = gegl_node_new_child (graph,
+                                "operation", operation,
+                                NULL);
+  gegl_node_link (source, node);
+
+  if (aux)
+    {
+      GeglNode *aux_source;
+
+      aux_source = gegl_node_new_child (graph,
+                                        "operation", "gegl:buffer-source",
+                                        "buffer",    aux,
+                                        NULL);
+      gegl_node_connect_to (aux_source, "output", node, "aux");
+    }
+
+  return node;
+}
+
+/* renders @node into a new buffer */
+static GeglBuffer *
+process (GeglNode *node)
+{
+  GeglBuffer *output = NULL;
+  GeglNode   *sink;
+
+  sink = gegl_node_new_child (gegl_node_get_parent (node),
+                              "operation", "gegl:buffer-sink",
+                              "buffer",    &output,
+                              NULL);
+  gegl_node_link (node, sink);
+  gegl_node_process (sink);
+
+  return output;
+}
+
+int main(int argc, char *argv[])
+{
+  GeglRectangle  rect    = {0, 0, SIZE, SIZE};
+  GeglRectangle  partial = {37, 61, 300, 200};
+  GeglRectangle  pixel   = {200, 200, 1, 1};
+  GeglBuffer    *input, *aux;
+  GeglColor     *gray, *white;
+  GeglNode      *graph;
+  GeglBuffer    *output;
+  gfloat         one[4]  = {1.0, 1.0, 1.0, 1.0};
+  gfloat         first[4], last[4];
+  gboolean       success = TRUE;
+
+  gegl_init (&argc, &argv);
+
+  input = gegl_buffer_new (&rect, babl_format ("RGBA float"));
+  aux   = gegl_buffer_new (&rect, babl_format ("RGBA u16"));
+  gray  = gegl_color_new (NULL);
+  white = gegl_color_new ("white");
+  gegl_color_set_rgba (gray, 0.25, 0.25, 0.25, 1.0);
+
+  gegl_buffer_set_color (input, &rect, gray);
+  success &= check_rect ("filled", input, &rect, 0.25);
+
+  /* a fill not aligned to the tiles */
+  gegl_buffer_set_color (input, &partial, white);
+  success &= check_rect ("partial", input, &partial, 1.0);
+  success &= check_rect ("above partial", input,
+                         GEGL_RECTANGLE (0, 0, SIZE, partial.y), 0.25);
+  success &= check_rect ("left of partial", input,
+                         GEGL_RECTANGLE (0, partial.y,
+                                         partial.x, partial.height), 0.25);
+
+  /* writing into a tile shared with others */
+  gegl_buffer_set_color (input, &rect, gray);
+  gegl_buffer_set (input, &pixel, 0, babl_format ("RGBA float"), one,
+                   GEGL_AUTO_ROWSTRIDE);
+  success &= check_rect ("written", input, &pixel, 1.0);
+  success &= check_rect ("next to written", input,
+                         GEGL_RECTANGLE (0, 0, SIZE, pixel.y), 0.25);
+  gegl_buffer_set_color (input, &rect, gray);
+
+  gegl_buffer_set_color (aux, &rect, gray);
+
+  graph = gegl_node_new ();
+
+  output = process (render (graph, input, NULL, "gegl:invert-linear"));
+  success &= check_rect ("point filter", output, &rect, 0.75);
+  g_object_unref (output);
+
+  output = process (render (graph, input, aux, "gegl:add"));
+  success &= check_rect ("point composer", output, &rect, 0.5);
+  g_object_unref (output);
+
+  /* only partly uniform input */
+  gegl_buffer_set (input, &pixel, 0, babl_format ("RGBA float"), one,
+                   GEGL_AUTO_ROWSTRIDE);
+  output = process (render (graph, input, NULL, "gegl:invert-linear"));
+  success &= check_rect ("partly uniform", output, &pixel, 0.0);
+  success &= check_rect ("partly uniform elsewhere", output,
+                         GEGL_RECTANGLE (0, 0, SIZE, pixel.y), 0.75);
+  g_object_unref (output);
+  gegl_buffer_set_color (input, &rect, gray);
+
+  /* operations depending on the position must not take the shortcut */
+  output = process (render (graph, input, NULL, "gegl:noise-rgb"));
+  gegl_buffer_get (output, GEGL_RECTANGLE (0, 0, 1, 1), 1.0,
+                   babl_format ("RGBA float"), first,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (output, GEGL_RECTANGLE (SIZE - 1, SIZE - 1, 1, 1), 1.0,
+                   babl_format ("RGBA float"), last,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  if (! memcmp (first, last, sizeof (first)))
+    {
+      printf ("position dependent: noise is uniform\n");
+      success = FALSE;
+    }
+  g_object_unref (output);
+
+  g_object_unref (graph);
+  g_object_unref (input);
+  g_object_unref (aux);
+  g_object_unref (gray);
+  g_object_unref (white);
+
+  gegl_exit ();
+
+  return success ? SUCCESS : FAILURE;
+}